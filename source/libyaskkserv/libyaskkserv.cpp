@@ -0,0 +1,273 @@
+/*
+  Copyright (C) 2005-2021 Tadashi Watanabe <twacc2020@gmail.com>
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "skk_dictionary.hpp"
+#include "skk_lookup.hpp"
+#include "skk_simple_string.hpp"
+#include "skk_utility.hpp"
+#include "yaskkserv.h"
+
+struct yaskkserv_dictionary_set
+{
+        YaSkkServ::SkkDictionary *skk_dictionary;
+        int skk_dictionary_length;
+};
+
+namespace YaSkkServ
+{
+namespace
+{
+enum
+{
+// ФϺǤ 510 ХȤǤ
+        MIDASI_SIZE_MAXIMUM = 510,
+// ڡ \0 ʬǤ
+        MIDASI_BUFFER_SIZE = MIDASI_SIZE_MAXIMUM + 2
+};
+
+#ifdef YASKKSERV_CONFIG_HAVE_PTHREAD
+pthread_once_t initialize_once = PTHREAD_ONCE_INIT;
+#endif  // YASKKSERV_CONFIG_HAVE_PTHREAD
+
+void initialize_scan()
+{
+        SkkUtility::initializeScan();
+}
+
+/// ǽ 1 ٤ SkkUtility::initializeScan() ƤӤޤ
+void initialize()
+{
+#ifdef YASKKSERV_CONFIG_HAVE_PTHREAD
+        pthread_once(&initialize_once, initialize_scan);
+#else  // YASKKSERV_CONFIG_HAVE_PTHREAD
+        initialize_scan();
+#endif  // YASKKSERV_CONFIG_HAVE_PTHREAD
+}
+
+/// \\0 ޤϥڡǽü줿 midasi 򥹥ڡǽüľ buffer ˥ԡޤڡ֤ޤ midasi ʤ 0 Ĺ -1 ֤ޤ
+int get_midasi(const char *midasi, char *buffer)
+{
+        for (int i = 0; i <= MIDASI_SIZE_MAXIMUM; ++i)
+        {
+                const char c = *(midasi + i);
+                if ((c == '\0') || (c == ' '))
+                {
+                        *(buffer + i) = ' ';
+                        *(buffer + i + 1) = '\0';
+                        return i;
+                }
+                *(buffer + i) = c;
+        }
+        return -1;
+}
+
+/// size ХȤ p  \\0 ǽü buffer ˥ԡޤ size ֤ޤ buffer ­ʤ -1 ֤ޤ
+int copy_result(const char *p, int size, char *buffer, int buffer_size)
+{
+        const int terminator_size = 1;
+        if (size + terminator_size > buffer_size)
+        {
+                return -1;
+        }
+        memcpy(buffer, p, static_cast<size_t>(size));
+        *(buffer + size) = '\0';
+        return size;
+}
+
+bool is_argument_valid(const yaskkserv_dictionary_set *set, const char *midasi, const char *buffer, int buffer_size)
+{
+        return (set != 0) && (midasi != 0) && (buffer != 0) && (buffer_size > 0);
+}
+
+yaskkserv_dictionary_set *create_core(int skk_dictionary_length)
+{
+        yaskkserv_dictionary_set *set = new yaskkserv_dictionary_set;
+        set->skk_dictionary = new SkkDictionary[skk_dictionary_length];
+        set->skk_dictionary_length = skk_dictionary_length;
+        return set;
+}
+
+void close_core(yaskkserv_dictionary_set *set)
+{
+        delete[] set->skk_dictionary;
+        delete set;
+}
+
+yaskkserv_dictionary_set *open_core(const char * const *filename_table, int filename_length)
+{
+        if ((filename_table == 0) || (filename_length < 1))
+        {
+                return 0;
+        }
+        initialize();
+        yaskkserv_dictionary_set *set = create_core(filename_length);
+        for (int i = 0; i != filename_length; ++i)
+        {
+                if ((*(filename_table + i) == 0) ||
+                    (**(filename_table + i) == '\0') ||
+                    !(set->skk_dictionary + i)->open(*(filename_table + i)))
+                {
+                        close_core(set);
+                        return 0;
+                }
+        }
+        return set;
+}
+
+/// set ƱΥ᡼ͭ뿷Ȥ֤ޤեϳľޤ
+yaskkserv_dictionary_set *clone_core(const yaskkserv_dictionary_set *set)
+{
+        yaskkserv_dictionary_set *result = create_core(set->skk_dictionary_length);
+        for (int i = 0; i != set->skk_dictionary_length; ++i)
+        {
+                if (!(result->skk_dictionary + i)->share(*(set->skk_dictionary + i)))
+                {
+                        close_core(result);
+                        return 0;
+                }
+        }
+        return result;
+}
+}
+}
+
+using namespace YaSkkServ;
+
+extern "C" yaskkserv_dictionary_set *yaskkserv_open(const char * const *filename_table, int filename_length)
+{
+        return open_core(filename_table, filename_length);
+}
+
+extern "C" yaskkserv_dictionary_set *yaskkserv_clone(const yaskkserv_dictionary_set *set)
+{
+        if (set == 0)
+        {
+                return 0;
+        }
+        return clone_core(set);
+}
+
+extern "C" void yaskkserv_close(yaskkserv_dictionary_set *set)
+{
+        if (set)
+        {
+                close_core(set);
+        }
+}
+
+extern "C" int yaskkserv_get_dictionary_length(const yaskkserv_dictionary_set *set)
+{
+        return (set == 0) ? 0 : set->skk_dictionary_length;
+}
+
+extern "C" int yaskkserv_search(yaskkserv_dictionary_set *set, const char *midasi, char *buffer, int buffer_size)
+{
+        if (!is_argument_valid(set, midasi, buffer, buffer_size))
+        {
+                return -1;
+        }
+        *buffer = '\0';
+        char midasi_buffer[MIDASI_BUFFER_SIZE];
+        const int midasi_size = get_midasi(midasi, midasi_buffer);
+        if (midasi_size <= 0)
+        {
+                return midasi_size;
+        }
+
+        SkkLookup lookup(set->skk_dictionary, set->skk_dictionary_length);
+        const int found_times = lookup.search(midasi_buffer);
+        if (found_times == 0)
+        {
+                return 0;
+        }
+        if (found_times == 1)
+        {
+                const SkkDictionary *skk_dictionary = lookup.getFoundDictionary();
+                return copy_result(skk_dictionary->getHenkanmojiretsuPointer(),
+                                   skk_dictionary->getHenkanmojiretsuSize(),
+                                   buffer,
+                                   buffer_size);
+        }
+
+        SkkSimpleString string(lookup.getTotalHenkanmojiretsuSize() + SkkSimpleString::MARGIN_SIZE * 2);
+        if (!lookup.appendMergedHenkanmojiretsu(string))
+        {
+                return -1;
+        }
+        return copy_result(string.getBuffer(), string.getSize(), buffer, buffer_size);
+}
+
+extern "C" int yaskkserv_search_dictionary(yaskkserv_dictionary_set *set, int index, const char *midasi, char *buffer, int buffer_size)
+{
+        if (!is_argument_valid(set, midasi, buffer, buffer_size) ||
+            (index < 0) ||
+            (index >= set->skk_dictionary_length))
+        {
+                return -1;
+        }
+        *buffer = '\0';
+        char midasi_buffer[MIDASI_BUFFER_SIZE];
+        const int midasi_size = get_midasi(midasi, midasi_buffer);
+        if (midasi_size <= 0)
+        {
+                return midasi_size;
+        }
+
+        SkkDictionary *skk_dictionary = set->skk_dictionary + index;
+        if (!skk_dictionary->search(midasi_buffer))
+        {
+                return 0;
+        }
+        return copy_result(skk_dictionary->getHenkanmojiretsuPointer(),
+                           skk_dictionary->getHenkanmojiretsuSize(),
+                           buffer,
+                           buffer_size);
+}
+
+extern "C" int yaskkserv_complete(yaskkserv_dictionary_set *set, const char *midasi, int midasi_length, char *buffer, int buffer_size)
+{
+        if (!is_argument_valid(set, midasi, buffer, buffer_size) || (midasi_length < 1))
+        {
+                return -1;
+        }
+        *buffer = '\0';
+        char midasi_buffer[MIDASI_BUFFER_SIZE];
+        const int midasi_size = get_midasi(midasi, midasi_buffer);
+        if (midasi_size <= 0)
+        {
+                return midasi_size;
+        }
+
+// string  \\0 ޤ᤿̤ buffer_size ˹碌ޤ
+        SkkSimpleString string(buffer_size + SkkSimpleString::MARGIN_SIZE * 2);
+        SkkLookup lookup(set->skk_dictionary, set->skk_dictionary_length);
+        int length;
+        if (!lookup.appendCompletion(midasi_buffer, midasi_size, midasi_length, '/', string, length))
+        {
+                return -1;
+        }
+        if (length == 0)
+        {
+                return 0;
+        }
+        if (copy_result(string.getBuffer(), string.getSize(), buffer, buffer_size) < 0)
+        {
+                return -1;
+        }
+        return length;
+}
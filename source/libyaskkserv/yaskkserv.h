@@ -0,0 +1,160 @@
+/*
+  Copyright (C) 2005-2021 Tadashi Watanabe <twacc2020@gmail.com>
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#ifndef YASKKSERV_H
+#define YASKKSERV_H
+
+/*
+ * libyaskkserv ϥФƱ񥯥饹õȤץ
+ * ľõ뤿Υ饤֥Ǥ
+ *
+ *  yaskkserv_make_dictionary Ѵ SKK 񤽤Τ
+ * ΤɤȤޤָФפȷ̤ʸϼƱ󥳡
+ * (̾ EUC-JP) Ǥ
+ *
+ * 1 ĤΥϥɥʣΥåɤƱ˻ȤäƤϤʤޤ󡣥
+ * ɤȤ yaskkserv_clone() ʣϥɥȤäƤʣ
+ * ϥɥϼΥǥåȥǡ򸵤Υϥɥȶͭõ
+ * ξ֤ĤΤǡåɤοʣƤϤۤȤ
+ * ޤ
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif  /* __cplusplus */
+
+/** ȤΥϥɥǤ */
+typedef struct yaskkserv_dictionary_set yaskkserv_dictionary_set;
+
+/** filename_table  filename_length Ĥμ򳫤ޤԤ 0 ֤ޤ */
+yaskkserv_dictionary_set *yaskkserv_open(const char * const *filename_table, int filename_length);
+
+/**
+ * set Ʊͭ뿷ϥɥ֤ޤԤ 0
+ * ֤ޤϺǸΥϥɥĤȤ˲Τǡ set 
+ * ĤƤ⤫ޤޤ
+ */
+yaskkserv_dictionary_set *yaskkserv_clone(const yaskkserv_dictionary_set *set);
+
+/** set Ĥޤ set  0 ʤв⤷ޤ */
+void yaskkserv_close(yaskkserv_dictionary_set *set);
+
+/** set μο֤ޤ */
+int yaskkserv_get_dictionary_length(const yaskkserv_dictionary_set *set);
+
+/**
+ * Ƥμ \0 ǽü줿 midasi õդäѴʸ
+ *  candidate νʣϢ뤷 /candidate0/candidate1/ η
+ * buffer  \0 ǽü֤ޤ
+ *
+ * ͤ \0 Ǥդʤ 0  buffer ­
+ * ʤʤɼԤ -1 ֤ޤ
+ */
+int yaskkserv_search(yaskkserv_dictionary_set *set, const char *midasi, char *buffer, int buffer_size);
+
+/** index ܤμ midasi õޤͤ buffer  yaskkserv_search() ƱǤ */
+int yaskkserv_search_dictionary(yaskkserv_dictionary_set *set, int index, const char *midasi, char *buffer, int buffer_size);
+
+/**
+ * midasi ǻϤޤʤפΡָФפ midasi_length ġ
+ * Ƥμ񤫤ʣƽᡢ /midasi0/midasi1/ η buffer  \0
+ * ǽü֤ޤ
+ *
+ * ͤϸդäָФפοǤ midasi ꤢפξ
+ * ȸդʤ 0  buffer ­ʤʤɼԤ -1
+ * ֤ޤ
+ */
+int yaskkserv_complete(yaskkserv_dictionary_set *set, const char *midasi, int midasi_length, char *buffer, int buffer_size);
+
+#ifdef __cplusplus
+}
+
+namespace YaSkkServ
+{
+/// yaskkserv_dictionary_set ݻ C++ ѤΥ饹Ǥ
+/**
+ * ǥȥ饯ǼĤޤ clone() η̤ϸƤӽФ¦ delete
+ * ɬפޤ
+ */
+class SkkDictionarySet
+{
+        SkkDictionarySet(SkkDictionarySet &source);
+        SkkDictionarySet& operator=(SkkDictionarySet &source);
+
+public:
+        virtual ~SkkDictionarySet()
+        {
+                yaskkserv_close(set_);
+        }
+
+        SkkDictionarySet() :
+                set_(0)
+        {
+        }
+
+        bool open(const char * const *filename_table, int filename_length)
+        {
+                yaskkserv_close(set_);
+                set_ = yaskkserv_open(filename_table, filename_length);
+                return set_ != 0;
+        }
+
+        bool isOpen() const
+        {
+                return set_ != 0;
+        }
+
+/// Ʊͭ뿷֥Ȥ֤ޤԤ 0 ֤ޤ
+        SkkDictionarySet *clone() const
+        {
+                yaskkserv_dictionary_set *set = yaskkserv_clone(set_);
+                if (set == 0)
+                {
+                        return 0;
+                }
+                SkkDictionarySet *result = new SkkDictionarySet();
+                result->set_ = set;
+                return result;
+        }
+
+        int getDictionaryLength() const
+        {
+                return yaskkserv_get_dictionary_length(set_);
+        }
+
+        int search(const char *midasi, char *buffer, int buffer_size)
+        {
+                return yaskkserv_search(set_, midasi, buffer, buffer_size);
+        }
+
+        int searchDictionary(int index, const char *midasi, char *buffer, int buffer_size)
+        {
+                return yaskkserv_search_dictionary(set_, index, midasi, buffer, buffer_size);
+        }
+
+        int complete(const char *midasi, int midasi_length, char *buffer, int buffer_size)
+        {
+                return yaskkserv_complete(set_, midasi, midasi_length, buffer, buffer_size);
+        }
+
+private:
+        yaskkserv_dictionary_set *set_;
+};
+}
+#endif  /* __cplusplus */
+
+#endif  /* YASKKSERV_H */
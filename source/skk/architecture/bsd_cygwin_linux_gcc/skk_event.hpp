@@ -0,0 +1,274 @@
+/*
+  Copyright (C) 2005-2021 Tadashi Watanabe <twacc2020@gmail.com>
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#ifndef SKK_EVENT_HPP
+#define SKK_EVENT_HPP
+
+#include "skk_gcc.hpp"
+
+namespace YaSkkServ
+{
+/// ʥեǥץǼ륯饹Ǥ
+/**
+ * YASKKSERV_CONFIG_HAVE_SIGNALFD ƤХʥ֥å
+ *  signalfd ǡƤʤХʥϥɥ餫ѥפ˽
+ * Ǽޤɤξ getFileDescriptor()  select()
+ * ˲äƤСʥޤ select() ޤ
+ *
+ * \attention
+ * ʥ֥åΤǡåɤ initialize() ɬ
+ * ޤѥפȤ 1 ĤΥ֥ȤȤޤ
+ */
+class SkkSignalEvent
+{
+        SkkSignalEvent(SkkSignalEvent &source);
+        SkkSignalEvent& operator=(SkkSignalEvent &source);
+
+public:
+        virtual ~SkkSignalEvent()
+        {
+                if (file_descriptor_ != -1)
+                {
+                        close(file_descriptor_);
+                }
+#ifndef YASKKSERV_CONFIG_HAVE_SIGNALFD
+                if (get_write_file_descriptor() != -1)
+                {
+                        signal(signal_number_, SIG_IGN);
+                        close(get_write_file_descriptor());
+                        get_write_file_descriptor() = -1;
+                }
+#endif  // YASKKSERV_CONFIG_HAVE_SIGNALFD
+        }
+
+        SkkSignalEvent() :
+                signal_number_(0),
+                file_descriptor_(-1)
+        {
+        }
+
+/// signal_number Υʥ褦ˤޤԤϵ֤ޤ
+        bool initialize(int signal_number)
+        {
+                if (file_descriptor_ != -1)
+                {
+                        return false;
+                }
+                signal_number_ = signal_number;
+#ifdef YASKKSERV_CONFIG_HAVE_SIGNALFD
+                sigset_t sigset;
+                sigemptyset(&sigset);
+                sigaddset(&sigset, signal_number);
+#ifdef YASKKSERV_CONFIG_HAVE_PTHREAD
+                pthread_sigmask(SIG_BLOCK, &sigset, 0);
+#else  // YASKKSERV_CONFIG_HAVE_PTHREAD
+                sigprocmask(SIG_BLOCK, &sigset, 0);
+#endif  // YASKKSERV_CONFIG_HAVE_PTHREAD
+                file_descriptor_ = signalfd(-1, &sigset, SFD_NONBLOCK | SFD_CLOEXEC);
+                return file_descriptor_ != -1;
+#else  // YASKKSERV_CONFIG_HAVE_SIGNALFD
+                int pipe_file_descriptor[2];
+                if ((get_write_file_descriptor() != -1) || (pipe(pipe_file_descriptor) == -1))
+                {
+                        return false;
+                }
+                fcntl(pipe_file_descriptor[0], F_SETFL, O_NONBLOCK);
+                fcntl(pipe_file_descriptor[1], F_SETFL, O_NONBLOCK);
+                file_descriptor_ = pipe_file_descriptor[0];
+                get_write_file_descriptor() = pipe_file_descriptor[1];
+                struct sigaction action;
+                memset(&action, 0, sizeof(action));
+                action.sa_handler = handler;
+                action.sa_flags = SA_RESTART;
+                sigemptyset(&action.sa_mask);
+                return sigaction(signal_number, &action, 0) == 0;
+#endif  // YASKKSERV_CONFIG_HAVE_SIGNALFD
+        }
+
+/// select() ˲äեǥץ֤ޤ initialize()  -1 ֤ޤ
+        int getFileDescriptor() const
+        {
+                return file_descriptor_;
+        }
+
+/// fd_set_read ΤίޤäΤ򤹤٤ɤߡʥƤп֤ޤ֥åޤ
+        bool isCaught(const fd_set &fd_set_read)
+        {
+                bool result = false;
+                if ((file_descriptor_ != -1) && FD_ISSET(file_descriptor_, &fd_set_read))
+                {
+#ifdef YASKKSERV_CONFIG_HAVE_SIGNALFD
+                        struct signalfd_siginfo buffer[4];
+#else  // YASKKSERV_CONFIG_HAVE_SIGNALFD
+                        char buffer[64];
+#endif  // YASKKSERV_CONFIG_HAVE_SIGNALFD
+                        while (read(file_descriptor_, buffer, sizeof(buffer)) > 0)
+                        {
+                                result = true;
+                        }
+                }
+                return result;
+        }
+
+private:
+#ifndef YASKKSERV_CONFIG_HAVE_SIGNALFD
+        static int &get_write_file_descriptor()
+        {
+                static int file_descriptor = -1;
+                return file_descriptor;
+        }
+
+        static void handler(int signum)
+        {
+                (void)signum;
+                const int backup_errno = errno;
+                const char tmp = 1;
+                if (write(get_write_file_descriptor(), &tmp, 1) == -1)
+                {
+// ѥפդʤдκѤߤǤ
+                }
+                errno = backup_errno;
+        }
+#endif  // YASKKSERV_CONFIG_HAVE_SIGNALFD
+
+        int signal_number_;
+        int file_descriptor_;
+};
+
+/// δֳ֤Ǵ¤륿ޡǤ
+/**
+ * YASKKSERV_CONFIG_HAVE_TIMERFD Ƥ timerfd 
+ * getFileDescriptor()  select() ˲äޤƤʤ
+ * getTimeout() Ǽδ¤ޤǤλ֤ select() ΥॢȤˤޤ
+ * initialize() ƤʤСɤξ select() 򵯤ޤ
+ */
+class SkkTimerEvent
+{
+        SkkTimerEvent(SkkTimerEvent &source);
+        SkkTimerEvent& operator=(SkkTimerEvent &source);
+
+public:
+        virtual ~SkkTimerEvent()
+        {
+                if (file_descriptor_ != -1)
+                {
+                        close(file_descriptor_);
+                }
+        }
+
+        SkkTimerEvent() :
+                next_time_(0),
+                interval_second_(0),
+                file_descriptor_(-1)
+        {
+        }
+
+/// interval_second äȤ˴¤褦ˤޤԤϵ֤ޤ
+        bool initialize(int interval_second)
+        {
+                if ((interval_second_ != 0) || (interval_second <= 0))
+                {
+                        return false;
+                }
+#ifdef YASKKSERV_CONFIG_HAVE_TIMERFD
+                file_descriptor_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+                if (file_descriptor_ == -1)
+                {
+                        return false;
+                }
+                struct itimerspec value;
+                value.it_interval.tv_sec = interval_second;
+                value.it_interval.tv_nsec = 0;
+                value.it_value.tv_sec = interval_second;
+                value.it_value.tv_nsec = 0;
+                if (timerfd_settime(file_descriptor_, 0, &value, 0) == -1)
+                {
+                        close(file_descriptor_);
+                        file_descriptor_ = -1;
+                        return false;
+                }
+#else  // YASKKSERV_CONFIG_HAVE_TIMERFD
+                next_time_ = get_time() + interval_second;
+#endif  // YASKKSERV_CONFIG_HAVE_TIMERFD
+                interval_second_ = interval_second;
+                return true;
+        }
+
+/// select() ˲äեǥץ֤ޤ timerfd Ȥʤ -1 ֤ޤ
+        int getFileDescriptor() const
+        {
+                return file_descriptor_;
+        }
+
+/// select() ΥॢȤ timeout ֤ޤॢȤפʾϵ֤ޤ
+        bool getTimeout(struct timeval &timeout) const
+        {
+                if ((interval_second_ == 0) || (file_descriptor_ != -1))
+                {
+                        return false;
+                }
+                const time_t now = get_time();
+                timeout.tv_sec = (next_time_ > now) ? next_time_ - now : 0;
+                timeout.tv_usec = 0;
+                return true;
+        }
+
+/// ¤Ƥп֤ޤ֥åޤ
+        bool isExpired(const fd_set &fd_set_read)
+        {
+                bool result = false;
+                if (file_descriptor_ != -1)
+                {
+                        if (FD_ISSET(file_descriptor_, &fd_set_read))
+                        {
+                                uint64_t expiration;
+                                if (read(file_descriptor_, &expiration, sizeof(expiration)) == static_cast<ssize_t>(sizeof(expiration)))
+                                {
+                                        result = true;
+                                }
+                        }
+                }
+                else if (interval_second_ != 0)
+                {
+                        const time_t now = get_time();
+                        if (now >= next_time_)
+                        {
+                                result = true;
+                                while (next_time_ <= now)
+                                {
+                                        next_time_ += interval_second_;
+                                }
+                        }
+                }
+                return result;
+        }
+
+private:
+        static time_t get_time()
+        {
+                struct timespec ts;
+                clock_gettime(CLOCK_MONOTONIC, &ts);
+                return ts.tv_sec;
+        }
+
+        time_t next_time_;
+        int interval_second_;
+        int file_descriptor_;
+};
+}
+
+#endif  // SKK_EVENT_HPP
@@ -21,16 +21,6 @@
 namespace YaSkkServ
 {
 int global_sighup_flag = 0;
-int local_main(int argc, char *argv[]);
-
-namespace
-{
-void signal_dictionary_update_handler(int signum)
-{
-        global_sighup_flag = 1;
-        signum = 0;             // KILLWARNING
-}
-}
 
 #ifdef YASKKSERV_DEBUG
 
@@ -134,6 +124,19 @@ skk_debug_new_t skk_debug_new_buffer[YASKKSERV_INTERNAL_DEBUG_NEW_BUFFER_LENGTH]
 // extern skk_debug_new_t skk_debug_new_buffer[YASKKSERV_INTERNAL_DEBUG_NEW_BUFFER_LENGTH];
 // #pragma GCC diagnostic pop
 
+void skk_debug_new_initialize_first()
+{
+        for (int i = 0; i != YASKKSERV_INTERNAL_DEBUG_NEW_BUFFER_LENGTH; ++i)
+        {
+                skk_debug_new_buffer[i].p = 0;
+                skk_debug_new_buffer[i].size = 0;
+                skk_debug_new_buffer[i].filename[0] = '\0';
+                skk_debug_new_buffer[i].line = 0;
+        }
+        skk_debug_new_first_flag = false;
+}
+}
+
 void skk_debug_new_check_leak()
 {
         YaSkkServ::Debug::printf_core(__FILE__, __LINE__,
@@ -153,19 +156,6 @@ void skk_debug_new_check_leak()
         }
 }
 
-void skk_debug_new_initialize_first()
-{
-        for (int i = 0; i != YASKKSERV_INTERNAL_DEBUG_NEW_BUFFER_LENGTH; ++i)
-        {
-                skk_debug_new_buffer[i].p = 0;
-                skk_debug_new_buffer[i].size = 0;
-                skk_debug_new_buffer[i].filename[0] = '\0';
-                skk_debug_new_buffer[i].line = 0;
-        }
-        skk_debug_new_first_flag = false;
-}
-}
-
 void *operator new(size_t size)
 {
         if (skk_debug_new_first_flag)
@@ -403,16 +393,3 @@ FOUND:
 }
 
 #endif  // YASKKSERV_INTERNAL_DEBUG_NEW
-
-
-
-
-int main(int argc, char *argv[])
-{
-        signal(SIGHUP, YaSkkServ::signal_dictionary_update_handler);
-        int result = YaSkkServ::local_main(argc, argv);
-#ifdef YASKKSERV_INTERNAL_DEBUG_NEW
-        skk_debug_new_check_leak();
-#endif  // YASKKSERV_INTERNAL_DEBUG_NEW
-        return result;
-}
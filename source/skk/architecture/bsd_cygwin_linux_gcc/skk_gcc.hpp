@@ -230,6 +230,8 @@ void *operator new[](size_t size, const char *filename, int line);
 void operator delete[](void *p);
 #pragma GCC diagnostic pop
 
+void skk_debug_new_check_leak();
+
 #define new new(__FILE__, __LINE__)
 #define delete DEBUG_PRINTF("delete:%s:%d\n", __FILE__, __LINE__), delete
 
@@ -0,0 +1,48 @@
+/*
+  Copyright (C) 2005-2021 Tadashi Watanabe <twacc2020@gmail.com>
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "skk_gcc.hpp"
+#include "skk_utility_scan.hpp"
+
+// main() ɬפȤΤϼ¹ԥեʤΤǡ饤֥
+// skk_gcc_main.o ƥ󥯤ޤ
+
+namespace YaSkkServ
+{
+int local_main(int argc, char *argv[]);
+
+namespace
+{
+void signal_dictionary_update_handler(int signum)
+{
+        global_sighup_flag = 1;
+        signum = 0;             // KILLWARNING
+}
+}
+}
+
+int main(int argc, char *argv[])
+{
+        signal(SIGHUP, YaSkkServ::signal_dictionary_update_handler);
+        YaSkkServ::SkkUtility::initializeScan();
+        int result = YaSkkServ::local_main(argc, argv);
+#ifdef YASKKSERV_INTERNAL_DEBUG_NEW
+        skk_debug_new_check_leak();
+#endif  // YASKKSERV_INTERNAL_DEBUG_NEW
+        return result;
+}
@@ -0,0 +1,388 @@
+/*
+  Copyright (C) 2005-2021 Tadashi Watanabe <twacc2020@gmail.com>
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#ifndef SKK_IO_URING_HPP
+#define SKK_IO_URING_HPP
+
+#include "skk_gcc.hpp"
+
+#ifdef YASKKSERV_CONFIG_HAVE_IO_URING
+
+namespace YaSkkServ
+{
+/// io_uring κǾ¤ΥåѤǤ
+/**
+ * liburing ϻȤ鷺ƥॳľܥ󥰤򰷤ޤȤΤ
+ * SkkServer μɬפǤ
+ *
+ * prepare*() Ǻä׵ submitAndWait() ǤޤȤƥͥϤ
+ * λ peekCompletion()  advanceCompletion()  1 ĤļФ
+ * 󥰤 1 ĤΥåɤΤ߰ޤ
+ *
+ * initializeBuffer() ϤХåեϡδλȤ˥ͥ뤬 1
+ * ǻȤޤȤХåե provideBuffer() ֤ɬפ
+ * ޤХåե֤׵ƤⴰλʤΤǡ
+ * λ 1 ĤˤĤλ 1 ĤǤ
+ */
+class SkkIoUring
+{
+        SkkIoUring(SkkIoUring &source);
+        SkkIoUring& operator=(SkkIoUring &source);
+
+public:
+        virtual ~SkkIoUring()
+        {
+                finalize();
+        }
+
+        SkkIoUring() :
+                sq_ring_(0),
+                cq_ring_(0),
+                sqes_(0),
+                sq_head_(0),
+                sq_tail_(0),
+                sq_array_(0),
+                cq_head_(0),
+                cq_tail_(0),
+                cqes_(0),
+                buffer_(0),
+                buffer_user_data_(0),
+                sq_ring_size_(0),
+                cq_ring_size_(0),
+                sqes_size_(0),
+                sq_mask_(0),
+                sq_entries_(0),
+                sq_local_tail_(0),
+                cq_mask_(0),
+                buffer_size_(0),
+                buffer_group_(0),
+                file_descriptor_(-1)
+        {
+        }
+
+/// entries Ĥ׵Ƥ󥰤ޤͥ뤬 io_uring Ȥʤе֤ޤ
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wold-style-cast"
+        bool initialize(unsigned int entries)
+        {
+                if (file_descriptor_ != -1)
+                {
+                        return false;
+                }
+                struct io_uring_params params;
+                memset(&params, 0, sizeof(params));
+                file_descriptor_ = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+                if (file_descriptor_ == -1)
+                {
+                        return false;
+                }
+// submitAndWait() ΥॢȤ IORING_ENTER_EXT_ARG Ȥޤ
+                if (!(params.features & IORING_FEAT_EXT_ARG))
+                {
+                        finalize();
+                        return false;
+                }
+                sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+                cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+                if (params.features & IORING_FEAT_SINGLE_MMAP)
+                {
+                        if (cq_ring_size_ > sq_ring_size_)
+                        {
+                                sq_ring_size_ = cq_ring_size_;
+                        }
+                        cq_ring_size_ = 0;
+                }
+                sq_ring_ = static_cast<char*>(mmap(0, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, file_descriptor_, IORING_OFF_SQ_RING));
+                if (sq_ring_ == MAP_FAILED)
+                {
+                        sq_ring_ = 0;
+                        finalize();
+                        return false;
+                }
+                if (cq_ring_size_ == 0)
+                {
+                        cq_ring_ = sq_ring_;
+                }
+                else
+                {
+                        cq_ring_ = static_cast<char*>(mmap(0, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, file_descriptor_, IORING_OFF_CQ_RING));
+                        if (cq_ring_ == MAP_FAILED)
+                        {
+                                cq_ring_ = 0;
+                                finalize();
+                                return false;
+                        }
+                }
+                sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+                sqes_ = static_cast<struct io_uring_sqe*>(mmap(0, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, file_descriptor_, IORING_OFF_SQES));
+                if (sqes_ == MAP_FAILED)
+                {
+                        sqes_ = 0;
+                        finalize();
+                        return false;
+                }
+                sq_head_ = reinterpret_cast<unsigned int*>(sq_ring_ + params.sq_off.head);
+                sq_tail_ = reinterpret_cast<unsigned int*>(sq_ring_ + params.sq_off.tail);
+                sq_array_ = reinterpret_cast<unsigned int*>(sq_ring_ + params.sq_off.array);
+                sq_mask_ = *reinterpret_cast<unsigned int*>(sq_ring_ + params.sq_off.ring_mask);
+                sq_entries_ = params.sq_entries;
+                sq_local_tail_ = *sq_tail_;
+                cq_head_ = reinterpret_cast<unsigned int*>(cq_ring_ + params.cq_off.head);
+                cq_tail_ = reinterpret_cast<unsigned int*>(cq_ring_ + params.cq_off.tail);
+                cq_mask_ = *reinterpret_cast<unsigned int*>(cq_ring_ + params.cq_off.ring_mask);
+                cqes_ = reinterpret_cast<struct io_uring_cqe*>(cq_ring_ + params.cq_off.cqes);
+// ׵ϥ󥰤ν¤٤ΤǡϹǸǤ
+                for (unsigned int i = 0; i != sq_entries_; ++i)
+                {
+                        *(sq_array_ + i) = i;
+                }
+                return true;
+        }
+
+/// size ХȤΥХåե count ĤХåե롼 group ȤƥͥϤ׵ޤ
+/**
+ * ϤΤϼ submitAndWait() ǤԤ user_data δλ
+ * ֤ޤ
+ */
+        bool initializeBuffer(unsigned short group, unsigned int count, unsigned int size, uint64_t user_data)
+        {
+                if ((file_descriptor_ == -1) || buffer_ || (count == 0) || (count > 65536))
+                {
+                        return false;
+                }
+                buffer_ = new char[count * size];
+                buffer_group_ = group;
+                buffer_size_ = size;
+                buffer_user_data_ = user_data;
+                prepare_provide_buffer(0, count);
+                return true;
+        }
+#pragma GCC diagnostic pop
+
+/// 󥰤Υեǥץ֤ޤ initialize()  -1 ֤ޤ
+        int getFileDescriptor() const
+        {
+                return file_descriptor_;
+        }
+
+/// ȤХåե buffer_id 򥫡֤ͥ׵ޤ
+        void provideBuffer(unsigned short buffer_id)
+        {
+                prepare_provide_buffer(buffer_id, 1);
+        }
+
+/// Хåե buffer_id Ƭ֤ޤ
+        const char *getBuffer(unsigned short buffer_id) const
+        {
+                return buffer_ + static_cast<unsigned int>(buffer_id) * buffer_size_;
+        }
+
+/// ϿХåե 1 ĤΥ֤ޤ
+        unsigned int getBufferSize() const
+        {
+                return buffer_size_;
+        }
+
+/// listen Ƥ륽åȤؤ multishot accept ޤդåȤ close-on-exec Ǥ
+        void prepareAccept(int file_descriptor, uint64_t user_data)
+        {
+                struct io_uring_sqe *sqe = get_sqe();
+                sqe->opcode = IORING_OP_ACCEPT;
+                sqe->fd = file_descriptor;
+                sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+                sqe->accept_flags = SOCK_CLOEXEC;
+                sqe->user_data = user_data;
+        }
+
+/// Хåե롼 group Хåե multishot recv ޤ
+        void prepareReceive(int file_descriptor, unsigned short group, uint64_t user_data)
+        {
+                struct io_uring_sqe *sqe = get_sqe();
+                sqe->opcode = IORING_OP_RECV;
+                sqe->flags = IOSQE_BUFFER_SELECT;
+                sqe->fd = file_descriptor;
+                sqe->ioprio = IORING_RECV_MULTISHOT;
+                sqe->buf_group = group;
+                sqe->user_data = user_data;
+        }
+
+/// send ޤ data ϴλޤǽ񤭴ƤϤޤ
+        void prepareSend(int file_descriptor, const void *data, int data_size, uint64_t user_data)
+        {
+                struct io_uring_sqe *sqe = get_sqe();
+                sqe->opcode = IORING_OP_SEND;
+                sqe->fd = file_descriptor;
+                sqe->addr = reinterpret_cast<uint64_t>(data);
+                sqe->len = static_cast<unsigned int>(data_size);
+#ifdef MSG_NOSIGNAL
+                sqe->msg_flags = MSG_NOSIGNAL;
+#endif  // MSG_NOSIGNAL
+                sqe->user_data = user_data;
+        }
+
+/// ɤ߹߲ǽˤʤΤ 1 ٤Ԥ poll ޤ
+        void preparePoll(int file_descriptor, uint64_t user_data)
+        {
+                struct io_uring_sqe *sqe = get_sqe();
+                sqe->opcode = IORING_OP_POLL_ADD;
+                sqe->fd = file_descriptor;
+                sqe->poll32_events = POLLIN;
+                sqe->user_data = user_data;
+        }
+
+/// user_data  target ׵μäޤ
+        void prepareCancel(uint64_t target, uint64_t user_data)
+        {
+                struct io_uring_sqe *sqe = get_sqe();
+                sqe->opcode = IORING_OP_ASYNC_CANCEL;
+                sqe->fd = -1;
+                sqe->addr = target;
+                sqe->user_data = user_data;
+        }
+
+/// ׵򤹤٤Ϥ wait_number ĤδλԤޤ 1  io_uring_enter() ǤԤ -1 ֤ޤ
+        int submitAndWait(unsigned int wait_number)
+        {
+                __atomic_store_n(sq_tail_, sq_local_tail_, __ATOMIC_RELEASE);
+                const unsigned int submit = sq_local_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+                return static_cast<int>(syscall(__NR_io_uring_enter,
+                                                file_descriptor_,
+                                                submit,
+                                                wait_number,
+                                                (wait_number > 0) ? IORING_ENTER_GETEVENTS : 0,
+                                                0,
+                                                0));
+        }
+
+/// submitAndWait() ƱǤ timeout  0 Ǥʤ timeout ԤĤΤޤॢȤ errno  ETIME ˤ -1 ֤ޤ
+        int submitAndWait(unsigned int wait_number, const struct __kernel_timespec *timeout)
+        {
+                if (!timeout || (wait_number == 0))
+                {
+                        return submitAndWait(wait_number);
+                }
+                __atomic_store_n(sq_tail_, sq_local_tail_, __ATOMIC_RELEASE);
+                const unsigned int submit = sq_local_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+                struct io_uring_getevents_arg argument;
+                memset(&argument, 0, sizeof(argument));
+                argument.ts = reinterpret_cast<uint64_t>(timeout);
+                return static_cast<int>(syscall(__NR_io_uring_enter,
+                                                file_descriptor_,
+                                                submit,
+                                                wait_number,
+                                                IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG,
+                                                &argument,
+                                                sizeof(argument)));
+        }
+
+/// δλ֤ޤʤ 0 ֤ޤ
+        const struct io_uring_cqe *peekCompletion() const
+        {
+                const unsigned int head = *cq_head_;
+                if (head == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE))
+                {
+                        return 0;
+                }
+                return cqes_ + (head & cq_mask_);
+        }
+
+/// peekCompletion() ֤λΤƤޤ
+        void advanceCompletion()
+        {
+                __atomic_store_n(cq_head_, *cq_head_ + 1, __ATOMIC_RELEASE);
+        }
+
+private:
+        void prepare_provide_buffer(unsigned int buffer_id, unsigned int count)
+        {
+                struct io_uring_sqe *sqe = get_sqe();
+                sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+                sqe->flags = IOSQE_CQE_SKIP_SUCCESS;
+                sqe->fd = static_cast<int>(count);
+                sqe->addr = reinterpret_cast<uint64_t>(buffer_ + buffer_id * buffer_size_);
+                sqe->len = buffer_size_;
+                sqe->off = buffer_id;
+                sqe->buf_group = buffer_group_;
+                sqe->user_data = buffer_user_data_;
+        }
+
+        struct io_uring_sqe *get_sqe()
+        {
+// 󥰤դʤСίޤä׵Ϥޤ
+                while (sq_local_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) >= sq_entries_)
+                {
+                        submitAndWait(0);
+                }
+                struct io_uring_sqe *sqe = sqes_ + (sq_local_tail_ & sq_mask_);
+                ++sq_local_tail_;
+                memset(sqe, 0, sizeof(*sqe));
+                return sqe;
+        }
+
+        void finalize()
+        {
+                delete[] buffer_;
+                buffer_ = 0;
+                if (sqes_)
+                {
+                        munmap(sqes_, sqes_size_);
+                        sqes_ = 0;
+                }
+                if (cq_ring_ && (cq_ring_ != sq_ring_))
+                {
+                        munmap(cq_ring_, cq_ring_size_);
+                }
+                cq_ring_ = 0;
+                if (sq_ring_)
+                {
+                        munmap(sq_ring_, sq_ring_size_);
+                        sq_ring_ = 0;
+                }
+                if (file_descriptor_ != -1)
+                {
+                        close(file_descriptor_);
+                        file_descriptor_ = -1;
+                }
+        }
+
+        char *sq_ring_;
+        char *cq_ring_;
+        struct io_uring_sqe *sqes_;
+        unsigned int *sq_head_;
+        unsigned int *sq_tail_;
+        unsigned int *sq_array_;
+        unsigned int *cq_head_;
+        unsigned int *cq_tail_;
+        struct io_uring_cqe *cqes_;
+        char *buffer_;
+        uint64_t buffer_user_data_;
+        size_t sq_ring_size_;
+        size_t cq_ring_size_;
+        size_t sqes_size_;
+        unsigned int sq_mask_;
+        unsigned int sq_entries_;
+        unsigned int sq_local_tail_;
+        unsigned int cq_mask_;
+        unsigned int buffer_size_;
+        unsigned short buffer_group_;
+        int file_descriptor_;
+};
+}
+
+#endif  // YASKKSERV_CONFIG_HAVE_IO_URING
+
+#endif  // SKK_IO_URING_HPP
@@ -0,0 +1,642 @@
+/*
+  Copyright (C) 2005-2021 Tadashi Watanabe <twacc2020@gmail.com>
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#ifndef SKK_SHARED_RING_HPP
+#define SKK_SHARED_RING_HPP
+
+#include "skk_gcc.hpp"
+
+#ifdef YASKKSERV_CONFIG_HAVE_SHARED_RING
+
+namespace YaSkkServ
+{
+/// memfd ζ֤ͭФȥ饤 1  1 ׵ȱΥ󥰤Ǥ
+/**
+ * ͭƬ Header ׵Υ󥰡Υ󥰤ν¤Ӥ
+ * 󥰤Ϥɤ񤭹¦ɤ߹¦ 1 ĤĤΥХǡ
+ * 4 ХȤΥ³׵ޤϱ 1 Ĥޤ head 
+ * tail ³֤ǡ󥰤Υǳä;꤬ºݤΰ֤Ǥ
+ *
+ * Ф create() Ǻä󥰤Υեǥץ
+ * sendFileDescriptor() ǥ饤ȤϤ饤Ȥ
+ * receiveFileDescriptor() Ǽä attach() ޤ
+ *
+ * ͭϥ饤Ȥ񤭴Τǡʬ񤭹
+ * ֤ϼ긵˻ΰ֤ɤिӤϰϤΤޤ礭
+ * seal ǸꤹΤǡ饤Ȥ̤뤳ȤϤǤޤ
+ *
+ * Ԥĥ饤Ȥ response_tail  futex ԤФ
+ * waitResponse() Ƥ륯饤Ȥ wakeClient() ǵ
+ * Ф select()  io_uring ԤĤΤ futex ǤԤƤޤ
+ * ФԤ prepareSleep() ǰդ򸫤饤
+ *  isServerSleeping() ǰäƥåȤ 1 ХȽ񤤤Ƶ
+ * 
+ */
+class SkkSharedRing
+{
+        SkkSharedRing(SkkSharedRing &source);
+        SkkSharedRing& operator=(SkkSharedRing &source);
+
+public:
+        enum
+        {
+                MAGIC = 0x534b4b52,
+// ֤礭Ǥ
+                FRAME_HEADER_SIZE = 4,
+// popRequest()  popResponse() ǼФΤʤͤǤ
+                POP_EMPTY = -1,
+// popRequest()  popResponse() ǥ󥰤ƤͤǤ
+                POP_BROKEN = -2
+        };
+
+        enum ServerSleep
+        {
+                SERVER_SLEEP_NONE,
+// ׵ԤäƤޤ
+                SERVER_SLEEP_REQUEST,
+// Υ󥰤ΤԤäƤޤ
+                SERVER_SLEEP_RESPONSE
+        };
+
+        virtual ~SkkSharedRing()
+        {
+                finalize();
+        }
+
+        SkkSharedRing() :
+                header_(0),
+                request_(0),
+                response_(0),
+                map_size_(0),
+                request_size_(0),
+                response_size_(0),
+                request_position_(0),
+                response_position_(0),
+                response_frame_(0),
+                file_descriptor_(-1)
+        {
+        }
+
+/// ׵ request_size Хȡ response_size ХȤΥ󥰤ޤ 2 ѤǤʤФʤޤ
+        bool create(uint32_t request_size, uint32_t response_size)
+        {
+                if (header_ || !is_power_of_2(request_size) || !is_power_of_2(response_size))
+                {
+                        return false;
+                }
+                file_descriptor_ = memfd_create("yaskkserv", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+                if (file_descriptor_ == -1)
+                {
+                        return false;
+                }
+                const size_t size = sizeof(Header) + request_size + response_size;
+                if ((ftruncate(file_descriptor_, static_cast<off_t>(size)) == -1) ||
+                    (fcntl(file_descriptor_, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) == -1) ||
+                    !map(size))
+                {
+                        finalize();
+                        return false;
+                }
+                header_->magic = MAGIC;
+                header_->request_size = request_size;
+                header_->response_size = response_size;
+                request_size_ = request_size;
+                response_size_ = response_size;
+                response_ = request_ + request_size_;
+                return true;
+        }
+
+/// create() 󥰤 file_descriptor Ϥ줿ΤȤƻȤޤ file_descriptor Ĥޤ
+        bool attach(int file_descriptor)
+        {
+                struct stat stat_buffer;
+                if (header_ || (fstat(file_descriptor, &stat_buffer) == -1) || (stat_buffer.st_size < static_cast<off_t>(sizeof(Header))))
+                {
+                        return false;
+                }
+                file_descriptor_ = file_descriptor;
+                if (!map(static_cast<size_t>(stat_buffer.st_size)) ||
+                    (header_->magic != MAGIC) ||
+                    !is_power_of_2(header_->request_size) ||
+                    !is_power_of_2(header_->response_size) ||
+                    (sizeof(Header) + header_->request_size + header_->response_size != map_size_))
+                {
+                        file_descriptor_ = -1;
+                        unmap();
+                        return false;
+                }
+                request_size_ = header_->request_size;
+                response_size_ = header_->response_size;
+                response_ = request_ + request_size_;
+                request_position_ = __atomic_load_n(&header_->request_tail, __ATOMIC_ACQUIRE);
+                response_position_ = __atomic_load_n(&header_->response_head, __ATOMIC_ACQUIRE);
+                closeFileDescriptor();
+                return true;
+        }
+
+/// ͭϤΤޤޤǡ create() ǺäեǥץĤޤ
+        void closeFileDescriptor()
+        {
+                if (file_descriptor_ != -1)
+                {
+                        close(file_descriptor_);
+                        file_descriptor_ = -1;
+                }
+        }
+
+        void finalize()
+        {
+                closeFileDescriptor();
+                unmap();
+        }
+
+/// create() Ǻäեǥץ֤ޤ
+        int getFileDescriptor() const
+        {
+                return file_descriptor_;
+        }
+
+/// 饤Ȥ data ׵ 1 ޤ꤭ʤе֤ޤ
+        bool pushRequest(const void *data, int data_size)
+        {
+// request_head ϥФ񤭴ΤǡƤн񤭹ߤޤ
+                const uint32_t used = request_position_ - __atomic_load_n(&header_->request_head, __ATOMIC_ACQUIRE);
+                if ((used > request_size_) ||
+                    (request_size_ - used < FRAME_HEADER_SIZE + static_cast<uint32_t>(data_size)))
+                {
+                        return false;
+                }
+                const uint32_t size = static_cast<uint32_t>(data_size);
+                copy_to_ring(request_, request_size_, request_position_, &size, FRAME_HEADER_SIZE);
+                copy_to_ring(request_, request_size_, request_position_ + FRAME_HEADER_SIZE, data, size);
+                request_position_ += FRAME_HEADER_SIZE + size;
+                __atomic_store_n(&header_->request_tail, request_position_, __ATOMIC_RELEASE);
+                return true;
+        }
+
+/// Ф׵ 1 ļФ buffer  buffer_size ХȤޤɤ߹ߤޤ
+/**
+ * ͤ׵Υǡ buffer_size 礭ޤǤ
+ * ߹ߤޤ׵᤬ʤ POP_EMPTY 򡢥󥰤Ƥ
+ * POP_BROKEN ֤ޤ
+ */
+        int popRequest(char *buffer, int buffer_size)
+        {
+                const uint32_t tail = __atomic_load_n(&header_->request_tail, __ATOMIC_ACQUIRE);
+                return pop(request_, request_size_, request_position_, tail, &header_->request_head, buffer, buffer_size);
+        }
+
+/// ФǼФƤʤ׵᤬п֤ޤ
+        bool isRequest() const
+        {
+                return __atomic_load_n(&header_->request_tail, __ATOMIC_ACQUIRE) != request_position_;
+        }
+
+/// ФǱΥ󥰤˽񤭹Хȿ֤ޤ󥰤Ƥ 0 ֤ޤ
+        uint32_t getResponseSpace() const
+        {
+                const uint32_t used = response_position_ - __atomic_load_n(&header_->response_head, __ATOMIC_ACQUIRE);
+                if (used > response_size_)
+                {
+                        return 0;
+                }
+                return response_size_ - used;
+        }
+
+/// ФǱ񤭻Ϥޤ׵ 1 ĤˤĤ commitResponse() ޤǤ˽񤤤ʬ 1 ĤǤ
+        void beginResponse()
+        {
+                response_frame_ = response_position_;
+                response_position_ += FRAME_HEADER_SIZE;
+        }
+
+/// Фǽ񤭻Ϥ᤿ data äޤ꤭ʤе֤ޤ
+        bool appendResponse(const void *data, int data_size)
+        {
+// response_head ϥ饤Ȥ񤭴ΤǡƤн񤭹ߤޤ
+                const uint32_t used = response_position_ - __atomic_load_n(&header_->response_head, __ATOMIC_ACQUIRE);
+                if ((used > response_size_) ||
+                    (response_size_ - used < static_cast<uint32_t>(data_size)))
+                {
+                        return false;
+                }
+                copy_to_ring(response_, response_size_, response_position_, data, static_cast<uint32_t>(data_size));
+                response_position_ += static_cast<uint32_t>(data_size);
+                return true;
+        }
+
+/// Фǽ񤭽򥯥饤Ȥɤ褦ˤޤ
+        void commitResponse()
+        {
+                const uint32_t size = response_position_ - response_frame_ - FRAME_HEADER_SIZE;
+                copy_to_ring(response_, response_size_, response_frame_, &size, FRAME_HEADER_SIZE);
+                __atomic_store_n(&header_->response_tail, response_position_, __ATOMIC_RELEASE);
+        }
+
+/// 饤ȤǱ 1 ļФ buffer  buffer_size ХȤޤɤ߹ߤޤͤ popRequest() ƱǤ
+        int popResponse(char *buffer, int buffer_size)
+        {
+                const uint32_t tail = __atomic_load_n(&header_->response_tail, __ATOMIC_ACQUIRE);
+                return pop(response_, response_size_, response_position_, tail, &header_->response_head, buffer, buffer_size);
+        }
+
+/// 饤ȤǱޤǺ timeout ߥԤޤп֤ޤ
+/**
+ *  spin Ĵ٤ʤԤǤʤ futex ̲
+ * ޤϤդĤޥäΤǡ̲餺˺ѤХФ
+ * futex ǵɬפޤ
+ */
+        bool waitResponse(int spin, int timeout)
+        {
+                for (int i = 0; i != spin; ++i)
+                {
+                        if (is_response())
+                        {
+                                return true;
+                        }
+                        relax();
+                }
+                const uint32_t tail = __atomic_load_n(&header_->response_tail, __ATOMIC_ACQUIRE);
+                if (tail != response_position_)
+                {
+                        return true;
+                }
+                __atomic_store_n(&header_->client_wait_flag, 1, __ATOMIC_SEQ_CST);
+                if (__atomic_load_n(&header_->response_tail, __ATOMIC_SEQ_CST) == tail)
+                {
+                        struct timespec ts;
+                        ts.tv_sec = timeout / 1000;
+                        ts.tv_nsec = (timeout % 1000) * 1000 * 1000;
+                        syscall(SYS_futex, &header_->response_tail, FUTEX_WAIT, tail, &ts, 0, 0);
+                }
+                __atomic_store_n(&header_->client_wait_flag, 0, __ATOMIC_RELAXED);
+                return is_response();
+        }
+
+/// ФǱԤä̲äƤ륯饤Ȥ򵯤ޤ
+        void wakeClient()
+        {
+                if (__atomic_load_n(&header_->client_wait_flag, __ATOMIC_SEQ_CST))
+                {
+                        syscall(SYS_futex, &header_->response_tail, FUTEX_WAKE, 1, 0, 0, 0);
+                }
+        }
+
+/// ФԤ˸ƤӡԤ˽Ǥ׵᤬п֤ޤ
+/**
+ * Υ󥰤ζ response_reserve Х̤δ֤׵
+ * ʤΤǡΤԤޤ
+ */
+        bool prepareSleep(uint32_t response_reserve)
+        {
+                const bool response_flag = (getResponseSpace() < response_reserve);
+                __atomic_store_n(&header_->server_sleep, response_flag ? SERVER_SLEEP_RESPONSE : SERVER_SLEEP_REQUEST, __ATOMIC_SEQ_CST);
+                if (response_flag)
+                {
+                        return getResponseSpace() >= response_reserve;
+                }
+                return __atomic_load_n(&header_->request_tail, __ATOMIC_SEQ_CST) != request_position_;
+        }
+
+/// Фǵ˸Ƥӡ prepareSleep() ΰäޤ
+        void wakeServer()
+        {
+                __atomic_store_n(&header_->server_sleep, SERVER_SLEEP_NONE, __ATOMIC_RELAXED);
+        }
+
+/// 饤Ȥ sleep Ԥä̲äƤ륵Фΰä٤ʤп֤ޤ
+        bool isServerSleeping(ServerSleep sleep)
+        {
+                uint32_t expected = static_cast<uint32_t>(sleep);
+                return __atomic_compare_exchange_n(&header_->server_sleep, &expected, SERVER_SLEEP_NONE, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+        }
+
+/// ԤäƲ̣п֤ޤ CPU  1 ĤʤСäƤ֤꤬ưޤ
+        static bool isSpinAvailable()
+        {
+                return sysconf(_SC_NPROCESSORS_ONLN) > 1;
+        }
+
+/// ԤäƲ롼פ 1 ʬ CPU ٤ޤޤ
+        static void relax()
+        {
+#if defined(__x86_64__) || defined(__i386__)
+                __builtin_ia32_pause();
+#endif  // defined(__x86_64__) || defined(__i386__)
+        }
+
+/// socket  1 ХȤ command ȥեǥץ file_descriptor  SCM_RIGHTS ޤ
+        static bool sendFileDescriptor(int socket, char command, int file_descriptor)
+        {
+                struct iovec iov;
+                iov.iov_base = &command;
+                iov.iov_len = 1;
+                union
+                {
+                        struct cmsghdr align;
+                        char buffer[CMSG_SPACE(sizeof(int))];
+                } control;
+                memset(&control, 0, sizeof(control));
+                struct msghdr message;
+                memset(&message, 0, sizeof(message));
+                message.msg_iov = &iov;
+                message.msg_iovlen = 1;
+                message.msg_control = control.buffer;
+                message.msg_controllen = sizeof(control.buffer);
+                struct cmsghdr *cmsg = CMSG_FIRSTHDR(&message);
+                cmsg->cmsg_level = SOL_SOCKET;
+                cmsg->cmsg_type = SCM_RIGHTS;
+                cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+                memcpy(CMSG_DATA(cmsg), &file_descriptor, sizeof(int));
+                return sendmsg(socket, &message, MSG_NOSIGNAL) == 1;
+        }
+
+/// socket  sendFileDescriptor() äΤޤեǥץʤ -1 ֤ޤ
+        static int receiveFileDescriptor(int socket, char &command)
+        {
+                struct iovec iov;
+                iov.iov_base = &command;
+                iov.iov_len = 1;
+                union
+                {
+                        struct cmsghdr align;
+                        char buffer[CMSG_SPACE(sizeof(int))];
+                } control;
+                struct msghdr message;
+                memset(&message, 0, sizeof(message));
+                message.msg_iov = &iov;
+                message.msg_iovlen = 1;
+                message.msg_control = control.buffer;
+                message.msg_controllen = sizeof(control.buffer);
+                if (recvmsg(socket, &message, MSG_CMSG_CLOEXEC) != 1)
+                {
+                        return -1;
+                }
+                struct cmsghdr *cmsg = CMSG_FIRSTHDR(&message);
+                if ((cmsg == 0) || (cmsg->cmsg_level != SOL_SOCKET) || (cmsg->cmsg_type != SCM_RIGHTS) || (cmsg->cmsg_len != CMSG_LEN(sizeof(int))))
+                {
+                        return -1;
+                }
+                int result;
+                memcpy(&result, CMSG_DATA(cmsg), sizeof(int));
+                return result;
+        }
+
+private:
+/// ͭƬǤ񤭹¦ۤʤ֤ϡ̤Υå饤֤ޤ
+        struct Header
+        {
+                uint32_t magic;
+                uint32_t request_size;
+                uint32_t response_size;
+                uint32_t padding_0[13];
+                uint32_t request_head;
+                uint32_t padding_1[15];
+                uint32_t request_tail;
+                uint32_t padding_2[15];
+                uint32_t response_head;
+                uint32_t padding_3[15];
+                uint32_t response_tail;
+                uint32_t padding_4[15];
+                uint32_t server_sleep;
+                uint32_t padding_5[15];
+                uint32_t client_wait_flag;
+                uint32_t padding_6[15];
+        };
+
+        static bool is_power_of_2(uint32_t size)
+        {
+                return (size >= 1024) && (size <= 64 * 1024 * 1024) && ((size & (size - 1)) == 0);
+        }
+
+        bool map(size_t size)
+        {
+                void *p = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, file_descriptor_, 0);
+                if (p == MAP_FAILED)
+                {
+                        return false;
+                }
+                header_ = static_cast<Header*>(p);
+                request_ = static_cast<char*>(p) + sizeof(Header);
+                map_size_ = size;
+                return true;
+        }
+
+        void unmap()
+        {
+                if (header_)
+                {
+                        munmap(header_, map_size_);
+                        header_ = 0;
+                        request_ = 0;
+                        response_ = 0;
+                        map_size_ = 0;
+                }
+        }
+
+        bool is_response() const
+        {
+                return __atomic_load_n(&header_->response_tail, __ATOMIC_ACQUIRE) != response_position_;
+        }
+
+        static void copy_to_ring(char *ring, uint32_t ring_size, uint32_t position, const void *data, uint32_t data_size)
+        {
+                const uint32_t offset = position & (ring_size - 1);
+                const uint32_t size = (data_size < ring_size - offset) ? data_size : ring_size - offset;
+                memcpy(ring + offset, data, size);
+                memcpy(ring, static_cast<const char*>(data) + size, data_size - size);
+        }
+
+        static void copy_from_ring(const char *ring, uint32_t ring_size, uint32_t position, void *data, uint32_t data_size)
+        {
+                const uint32_t offset = position & (ring_size - 1);
+                const uint32_t size = (data_size < ring_size - offset) ? data_size : ring_size - offset;
+                memcpy(data, ring + offset, size);
+                memcpy(static_cast<char*>(data) + size, ring, data_size - size);
+        }
+
+        static int pop(const char *ring, uint32_t ring_size, uint32_t &position, uint32_t tail, uint32_t *head, char *buffer, int buffer_size)
+        {
+                const uint32_t used = tail - position;
+                if (used == 0)
+                {
+                        return POP_EMPTY;
+                }
+                uint32_t size;
+                if ((used > ring_size) || (used < FRAME_HEADER_SIZE))
+                {
+                        return POP_BROKEN;
+                }
+                copy_from_ring(ring, ring_size, position, &size, FRAME_HEADER_SIZE);
+                if ((size > used - FRAME_HEADER_SIZE) || (size > 0x7fffffff))
+                {
+                        return POP_BROKEN;
+                }
+                copy_from_ring(ring, ring_size, position + FRAME_HEADER_SIZE, buffer, (size < static_cast<uint32_t>(buffer_size)) ? size : static_cast<uint32_t>(buffer_size));
+                position += FRAME_HEADER_SIZE + size;
+                __atomic_store_n(head, position, __ATOMIC_RELEASE);
+                return static_cast<int>(size);
+        }
+
+        Header *header_;
+        char *request_;
+        char *response_;
+        size_t map_size_;
+        uint32_t request_size_;
+        uint32_t response_size_;
+// ʬ񤭹¦ΰ֤ǤФǤ request_head  response_tail 饤ȤǤ request_tail  response_head Ǥ
+        uint32_t request_position_;
+        uint32_t response_position_;
+// beginResponse() ƬǤ
+        uint32_t response_frame_;
+        int file_descriptor_;
+};
+
+/// SkkSharedRing ׵륯饤ȤǤ
+/**
+ * connect() ǥФ AF_UNIX ΥåȤ³ "R" ꡢ
+ * ä󥰤 request() ޤ׵ȱϥåȤΤ
+ * Ʊǡ "1" ׵ˤ "1" ޤ "4" ǻϤޤ֤ޤ
+ *
+ * 1 ĤΥ饤Ȥ 1 ĤΥåɤΤ߻Ȥޤ
+ */
+class SkkSharedRingClient
+{
+        SkkSharedRingClient(SkkSharedRingClient &source);
+        SkkSharedRingClient& operator=(SkkSharedRingClient &source);
+
+public:
+        enum
+        {
+// waitResponse() ̲˱Ĵ٤Ǥ CPU  1 ĤʤĴ٤ޤ
+                WAIT_SPIN = 4096,
+// waitResponse() ̲ (ߥ) Ǥ᤮뤿Ӥ˥ФȤ³Τޤ
+                WAIT_TIMEOUT = 1000
+        };
+
+        virtual ~SkkSharedRingClient()
+        {
+                disconnect();
+        }
+
+        SkkSharedRingClient() :
+                ring_(),
+                spin_(SkkSharedRing::isSpinAvailable() ? WAIT_SPIN : 0),
+                file_descriptor_(-1)
+        {
+        }
+
+/// path ΥåȤԤäƤ륵Ф󥰤ޤ
+        bool connect(const char *path)
+        {
+                struct sockaddr_un socket_connect;
+                memset(&socket_connect, 0, sizeof(socket_connect));
+                socket_connect.sun_family = AF_UNIX;
+                if ((file_descriptor_ != -1) || (strlen(path) >= sizeof(socket_connect.sun_path)))
+                {
+                        return false;
+                }
+                strcpy(socket_connect.sun_path, path);
+                file_descriptor_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+                if (file_descriptor_ == -1)
+                {
+                        return false;
+                }
+                const char command = 'R';
+                char reply = 0;
+                int ring_file_descriptor = -1;
+                if ((::connect(file_descriptor_, reinterpret_cast<struct sockaddr*>(&socket_connect), sizeof(socket_connect)) == -1) ||
+                    (send(file_descriptor_, &command, 1, MSG_NOSIGNAL) != 1) ||
+                    ((ring_file_descriptor = SkkSharedRing::receiveFileDescriptor(file_descriptor_, reply)) == -1))
+                {
+                        disconnect();
+                        return false;
+                }
+                if ((reply != command) || !ring_.attach(ring_file_descriptor))
+                {
+                        close(ring_file_descriptor);
+                        disconnect();
+                        return false;
+                }
+                return true;
+        }
+
+        void disconnect()
+        {
+                ring_.finalize();
+                if (file_descriptor_ != -1)
+                {
+                        close(file_descriptor_);
+                        file_descriptor_ = -1;
+                }
+        }
+
+/// data ׵ꡢ reply  reply_size ХȤޤɤ߹ߤޤ
+/**
+ * ͤϱΥǡ reply_size 礭ޤǤ
+ * ߹ߤޤ󡣼Ԥ -1 ֤ʹߤ connect() ľɬ
+ * פޤ
+ */
+        int request(const void *data, int data_size, char *reply, int reply_size)
+        {
+                if ((file_descriptor_ == -1) ||
+                    !ring_.pushRequest(data, data_size) ||
+                    !wake_server(SkkSharedRing::SERVER_SLEEP_REQUEST))
+                {
+                        return -1;
+                }
+                for (;;)
+                {
+                        const int result = ring_.popResponse(reply, reply_size);
+                        if (result >= 0)
+                        {
+// Υ󥰤ΤԤäƤ륵Ф򵯤ޤ
+                                return wake_server(SkkSharedRing::SERVER_SLEEP_RESPONSE) ? result : -1;
+                        }
+                        if ((result == SkkSharedRing::POP_BROKEN) ||
+                            (!ring_.waitResponse(spin_, WAIT_TIMEOUT) && !is_connected()))
+                        {
+                                return -1;
+                        }
+                }
+        }
+
+private:
+/// sleep Ԥä̲äƤ륵Ф򥽥åȤؤ 1 ХȤǵޤ
+        bool wake_server(SkkSharedRing::ServerSleep sleep)
+        {
+                const char doorbell = 'R';
+                return !ring_.isServerSleeping(sleep) || (send(file_descriptor_, &doorbell, 1, MSG_NOSIGNAL) == 1);
+        }
+
+/// ФȤ³ڤƤʤп֤ޤФϥ󥰤Ϥ˥åȤؽ񤭹ߤޤ
+        bool is_connected() const
+        {
+                char tmp;
+                const ssize_t result = recv(file_descriptor_, &tmp, 1, MSG_PEEK | MSG_DONTWAIT);
+                return (result == 1) || ((result == -1) && ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR)));
+        }
+
+        SkkSharedRing ring_;
+        int spin_;
+        int file_descriptor_;
+};
+}
+
+#endif  // YASKKSERV_CONFIG_HAVE_SHARED_RING
+
+#endif  // SKK_SHARED_RING_HPP
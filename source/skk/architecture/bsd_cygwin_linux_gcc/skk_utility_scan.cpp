@@ -0,0 +1,293 @@
+/*
+  Copyright (C) 2005-2021 Tadashi Watanabe <twacc2020@gmail.com>
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "skk_utility_scan.hpp"
+
+namespace YaSkkServ
+{
+namespace SkkUtility
+{
+namespace
+{
+int find_character_scalar(const char *p, int index, int size, char c)
+{
+        for (; index < size; ++index)
+        {
+                if (*(p + index) == c)
+                {
+                        return index;
+                }
+        }
+        return -1;
+}
+
+int find_character_reverse_scalar(const char *p, int minimum, int index, char c)
+{
+        for (; index >= minimum; --index)
+        {
+                if (*(p + index) == c)
+                {
+                        return index;
+                }
+        }
+        return -1;
+}
+
+const char *find_character_unbounded_scalar(const char *p, char c)
+{
+        while (*p != c)
+        {
+                ++p;
+        }
+        return p;
+}
+
+const char *find_slash_or_terminator_scalar(const char *p)
+{
+        for (;;)
+        {
+                char c = *p;
+                if ((c == '/') || (c == '\n') || (c == '\0'))
+                {
+                        return p;
+                }
+                ++p;
+        }
+}
+
+#ifdef YASKKSERV_CONFIG_HAVE_SIMD_X86
+
+//
+// SSE2 
+//
+// ϰϤηޤäƤϥ饤󤵤Ƥʤɤ 16 ХȤ
+// ӤĤϥǤǽޤϰϤηޤäƤʤ 16 
+// ȶ˥饤󤷤ɤȤޤ饤󤵤줿ɤϥڡ
+// ۤʤᡢüɤǤեȤޤ
+//
+__attribute__((target("sse2"))) int find_character_sse2(const char *p, int index, int size, char c)
+{
+        const __m128i pattern = _mm_set1_epi8(c);
+        for (; index + 16 <= size; index += 16)
+        {
+                __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + index));
+                int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(data, pattern));
+                if (mask)
+                {
+                        return index + __builtin_ctz(static_cast<unsigned int>(mask));
+                }
+        }
+        return find_character_scalar(p, index, size, c);
+}
+
+__attribute__((target("sse2"))) int find_character_reverse_sse2(const char *p, int minimum, int index, char c)
+{
+        const __m128i pattern = _mm_set1_epi8(c);
+        for (; index - 15 >= minimum; index -= 16)
+        {
+                __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + index - 15));
+                int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(data, pattern));
+                if (mask)
+                {
+                        return index - 15 + 31 - __builtin_clz(static_cast<unsigned int>(mask));
+                }
+        }
+        return find_character_reverse_scalar(p, minimum, index, c);
+}
+
+__attribute__((target("sse2"))) const char *find_character_unbounded_sse2(const char *p, char c)
+{
+        const __m128i pattern = _mm_set1_epi8(c);
+        const unsigned int offset = static_cast<unsigned int>(reinterpret_cast<size_t>(p) & 15);
+        const char *aligned = p - offset;
+        unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128(reinterpret_cast<const __m128i*>(aligned)), pattern))) >> offset;
+        if (mask)
+        {
+                return p + __builtin_ctz(mask);
+        }
+        for (;;)
+        {
+                aligned += 16;
+                mask = static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128(reinterpret_cast<const __m128i*>(aligned)), pattern)));
+                if (mask)
+                {
+                        return aligned + __builtin_ctz(mask);
+                }
+        }
+}
+
+__attribute__((target("sse2"))) inline unsigned int get_slash_or_terminator_mask_sse2(const char *aligned)
+{
+        __m128i data = _mm_load_si128(reinterpret_cast<const __m128i*>(aligned));
+        __m128i result = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(data, _mm_set1_epi8('/')),
+                                                   _mm_cmpeq_epi8(data, _mm_set1_epi8('\n'))),
+                                      _mm_cmpeq_epi8(data, _mm_setzero_si128()));
+        return static_cast<unsigned int>(_mm_movemask_epi8(result));
+}
+
+__attribute__((target("sse2"))) const char *find_slash_or_terminator_sse2(const char *p)
+{
+        const unsigned int offset = static_cast<unsigned int>(reinterpret_cast<size_t>(p) & 15);
+        const char *aligned = p - offset;
+        unsigned int mask = get_slash_or_terminator_mask_sse2(aligned) >> offset;
+        if (mask)
+        {
+                return p + __builtin_ctz(mask);
+        }
+        for (;;)
+        {
+                aligned += 16;
+                mask = get_slash_or_terminator_mask_sse2(aligned);
+                if (mask)
+                {
+                        return aligned + __builtin_ctz(mask);
+                }
+        }
+}
+
+//
+// AVX2 
+//
+// SSE2 ǤƱͤ 32 ХȤĽޤ 32 ХȤʤ
+// Ĥ SSE2 Ǥǽޤ
+//
+__attribute__((target("avx2"))) int find_character_avx2(const char *p, int index, int size, char c)
+{
+        const __m256i pattern = _mm256_set1_epi8(c);
+        for (; index + 32 <= size; index += 32)
+        {
+                __m256i data = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + index));
+                unsigned int mask = static_cast<unsigned int>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(data, pattern)));
+                if (mask)
+                {
+                        return index + __builtin_ctz(mask);
+                }
+        }
+        return find_character_sse2(p, index, size, c);
+}
+
+__attribute__((target("avx2"))) int find_character_reverse_avx2(const char *p, int minimum, int index, char c)
+{
+        const __m256i pattern = _mm256_set1_epi8(c);
+        for (; index - 31 >= minimum; index -= 32)
+        {
+                __m256i data = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + index - 31));
+                unsigned int mask = static_cast<unsigned int>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(data, pattern)));
+                if (mask)
+                {
+                        return index - 31 + 31 - __builtin_clz(mask);
+                }
+        }
+        return find_character_reverse_sse2(p, minimum, index, c);
+}
+
+__attribute__((target("avx2"))) const char *find_character_unbounded_avx2(const char *p, char c)
+{
+        const __m256i pattern = _mm256_set1_epi8(c);
+        const unsigned int offset = static_cast<unsigned int>(reinterpret_cast<size_t>(p) & 31);
+        const char *aligned = p - offset;
+        unsigned int mask = static_cast<unsigned int>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_load_si256(reinterpret_cast<const __m256i*>(aligned)), pattern))) >> offset;
+        if (mask)
+        {
+                return p + __builtin_ctz(mask);
+        }
+        for (;;)
+        {
+                aligned += 32;
+                mask = static_cast<unsigned int>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_load_si256(reinterpret_cast<const __m256i*>(aligned)), pattern)));
+                if (mask)
+                {
+                        return aligned + __builtin_ctz(mask);
+                }
+        }
+}
+
+__attribute__((target("avx2"))) inline unsigned int get_slash_or_terminator_mask_avx2(const char *aligned)
+{
+        __m256i data = _mm256_load_si256(reinterpret_cast<const __m256i*>(aligned));
+        __m256i result = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(data, _mm256_set1_epi8('/')),
+                                                         _mm256_cmpeq_epi8(data, _mm256_set1_epi8('\n'))),
+                                         _mm256_cmpeq_epi8(data, _mm256_setzero_si256()));
+        return static_cast<unsigned int>(_mm256_movemask_epi8(result));
+}
+
+__attribute__((target("avx2"))) const char *find_slash_or_terminator_avx2(const char *p)
+{
+        const unsigned int offset = static_cast<unsigned int>(reinterpret_cast<size_t>(p) & 31);
+        const char *aligned = p - offset;
+        unsigned int mask = get_slash_or_terminator_mask_avx2(aligned) >> offset;
+        if (mask)
+        {
+                return p + __builtin_ctz(mask);
+        }
+        for (;;)
+        {
+                aligned += 32;
+                mask = get_slash_or_terminator_mask_avx2(aligned);
+                if (mask)
+                {
+                        return aligned + __builtin_ctz(mask);
+                }
+        }
+}
+
+#endif  // YASKKSERV_CONFIG_HAVE_SIMD_X86
+}
+
+ScanFunctionTable scan_function_table =
+{
+        find_character_scalar,
+        find_character_reverse_scalar,
+        find_character_unbounded_scalar,
+        find_slash_or_terminator_scalar,
+        "scalar",
+};
+
+void initializeScan()
+{
+#ifdef YASKKSERV_CONFIG_HAVE_SIMD_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+        {
+                ScanFunctionTable avx2 =
+                {
+                        find_character_avx2,
+                        find_character_reverse_avx2,
+                        find_character_unbounded_avx2,
+                        find_slash_or_terminator_avx2,
+                        "avx2",
+                };
+                scan_function_table = avx2;
+        }
+        else if (__builtin_cpu_supports("sse2"))
+        {
+                ScanFunctionTable sse2 =
+                {
+                        find_character_sse2,
+                        find_character_reverse_sse2,
+                        find_character_unbounded_sse2,
+                        find_slash_or_terminator_sse2,
+                        "sse2",
+                };
+                scan_function_table = sse2;
+        }
+#endif  // YASKKSERV_CONFIG_HAVE_SIMD_X86
+        DEBUG_PRINTF("scan=%s\n", scan_function_table.name);
+}
+}
+}
@@ -0,0 +1,106 @@
+/*
+  Copyright (C) 2005-2021 Tadashi Watanabe <twacc2020@gmail.com>
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#ifndef SKK_UTILITY_SCAN_HPP
+#define SKK_UTILITY_SCAN_HPP
+
+#include "skk_gcc.hpp"
+
+namespace YaSkkServ
+{
+namespace SkkUtility
+{
+/// ʸؿΥơ֥Ǥ
+/**
+ * initializeScan() ƤӽФ CPU ˱ AVX2, SSE2 ޤϥ
+ * Ǥδؿ򤵤ޤ initializeScan() ƤӽФϥǤ
+ * ޤ
+ *
+ * YASKKSERV_CONFIG_HAVE_SIMD_X86 ƤʤϾ˥
+ * Ȥޤ
+ */
+struct ScanFunctionTable
+{
+        int (*find_character)(const char *p, int index, int size, char c);
+        int (*find_character_reverse)(const char *p, int minimum, int index, char c);
+        const char *(*find_character_unbounded)(const char *p, char c);
+        const char *(*find_slash_or_terminator)(const char *p);
+        const char *name;
+};
+
+extern ScanFunctionTable scan_function_table;
+
+/// ʸؿ򤷤ޤץ೫ϻ 1 ٤ƤӽФޤ
+void initializeScan();
+
+/// 򤵤Ƥʸؿ̾ ("avx2", "sse2" ޤ "scalar") ֤ޤ
+inline const char *getScanName()
+{
+        return scan_function_table.name;
+}
+
+/// (p + index)  (p + size - 1) ϰϤǺǽ˸դäʸ c Υǥå֤ޤդʤ -1 ֤ޤ
+inline int findCharacter(const char *p, int index, int size, char c)
+{
+        return scan_function_table.find_character(p, index, size, c);
+}
+
+/// (p + index)  (p + minimum) ϰϤǽ˸դäʸ c Υǥå֤ޤդʤ -1 ֤ޤ
+inline int findCharacterReverse(const char *p, int minimum, int index, char c)
+{
+        return scan_function_table.find_character_reverse(p, minimum, index, c);
+}
+
+/// p ǽ˸դäʸ c ؤΥݥ󥿤֤ޤ
+/**
+ * \attention
+ * ʸ c ɬ¸ߤɬפޤ SIMD Ǥϥ饤󤵤줿֥
+ * ñ̤ɤिᡢڡۤʤϰϤ p ɤळȤ
+ * ޤ
+ */
+inline const char *findCharacterUnbounded(const char *p, char c)
+{
+        return scan_function_table.find_character_unbounded(p, c);
+}
+
+/// p ǽ˸դä '/', '\\n' ޤ '\\0' ؤΥݥ󥿤֤ޤ
+/**
+ * \attention
+ * findCharacterUnbounded() Ʊ͡ p ɤळȤޤ
+ */
+inline const char *findSlashOrTerminator(const char *p)
+{
+        return scan_function_table.find_slash_or_terminator(p);
+}
+
+/// p  8 ХȤ򥢥饤Ȥ˴طʤɤ߹ߤޤ
+inline uint64_t loadWord(const void *p)
+{
+        uint64_t result;
+        memcpy(&result, p, sizeof(result));
+        return result;
+}
+
+/// word  0 ΥХȤޤޤƤ 0 ʳ֤ޤ
+inline uint64_t hasZeroByte(uint64_t word)
+{
+        return (word - 0x0101010101010101ULL) & ~word & 0x8080808080808080ULL;
+}
+}
+}
+
+#endif  // SKK_UTILITY_SCAN_HPP
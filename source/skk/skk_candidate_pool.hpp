@@ -0,0 +1,544 @@
+/*
+  Copyright (C) 2005-2021 Tadashi Watanabe <twacc2020@gmail.com>
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#ifndef SKK_CANDIDATE_POOL_H
+#define SKK_CANDIDATE_POOL_H
+
+#include "skk_architecture.hpp"
+
+namespace YaSkkServ
+{
+/// Ѵʸפ candidate ͭʸסǤ
+/**
+ * Ѵʸ /candidate0/candidate1/  "candidate0/" 
+ * "candidate1/" ʬ֤ candidate  1 ٤ʸ
+ * ˳Ǽޤȥ candidate λȤƬ '/'
+ * ³ƻȤμʸϢ뤹ȸΡѴʸפ
+ *  '/' ǽʤѴʸפƬ '/' ʹߤ 1 Ĥ
+ * candidate Ȥޤ
+ *
+ * ʸΰ candidate ֹϽи¿˿ꡢȤ 7 ӥ
+ * ȤĲ̤¤٤Ĺ (Ǿ̥ӥåȤ³򼨤) ǳǼޤ
+ * 褯Ȥ candidate λȤ 1 ޤ 2 ХȤˤʤޤ 1 
+ * ʤ褦 candidate ϻȤľܳǼޤ
+ */
+class SkkCandidatePool
+{
+        SkkCandidatePool(SkkCandidatePool &source);
+        SkkCandidatePool& operator=(SkkCandidatePool &source);
+
+public:
+        virtual ~SkkCandidatePool()
+        {
+                delete[] string_;
+                delete[] candidate_offset_;
+                delete[] frequency_;
+                delete[] hash_table_;
+                delete[] candidate_;
+                delete[] entry_candidate_;
+                delete[] reference_;
+                delete[] entry_reference_;
+        }
+
+        SkkCandidatePool() :
+                string_(0),
+                candidate_offset_(0),
+                frequency_(0),
+                hash_table_(0),
+                candidate_(0),
+                entry_candidate_(0),
+                reference_(0),
+                entry_reference_(0),
+                string_size_(0),
+                string_capacity_(0),
+                candidate_length_(0),
+                candidate_capacity_(0),
+                hash_table_length_(0),
+                candidate_reference_length_(0),
+                candidate_reference_capacity_(0),
+                entry_length_(0),
+                entry_capacity_(0),
+                reference_size_(0),
+                henkanmojiretsu_size_maximum_(0)
+        {
+        }
+
+/// Ѵʸ henkanmojiretsu 򼡤ΥȥȤɲäޤ henkanmojiretsu  '/' ǻϤޤʤе֤ޤ
+/**
+ * size ϲԤޤޤʤѴʸפΥХȥǤ build() 
+ * ˤ٤ƤΥȥɲäɬפޤ
+ */
+        bool add(const char *henkanmojiretsu, int size)
+        {
+                DEBUG_ASSERT_POINTER(henkanmojiretsu);
+                if ((size <= 0) || (*henkanmojiretsu != '/'))
+                {
+                        return false;
+                }
+                if (entry_length_ + 2 > entry_capacity_)
+                {
+                        entry_candidate_ = resize(entry_candidate_, entry_length_, entry_capacity_ * 2 + 1024);
+                        entry_capacity_ = entry_capacity_ * 2 + 1024;
+                }
+                *(entry_candidate_ + entry_length_) = candidate_reference_length_;
+                if (*(henkanmojiretsu + size - 1) == '/')
+                {
+                        int start = 1;
+                        for (int i = 1; i != size; ++i)
+                        {
+                                if (*(henkanmojiretsu + i) == '/')
+                                {
+                                        add_candidate(henkanmojiretsu + start, i + 1 - start);
+                                        start = i + 1;
+                                }
+                        }
+                }
+                else
+                {
+                        add_candidate(henkanmojiretsu + 1, size - 1);
+                }
+                ++entry_length_;
+                *(entry_candidate_ + entry_length_) = candidate_reference_length_;
+                if (henkanmojiretsu_size_maximum_ < size)
+                {
+                        henkanmojiretsu_size_maximum_ = size;
+                }
+                return true;
+        }
+
+/// ɲäȥ꤫ʸΰȻȤޤ
+        void build()
+        {
+// ʸΰ֤Ⱦʤ candidate ӡиιֹ߽
+// 򿶤ޤ
+                int *order = new int[candidate_length_];
+                int length = 0;
+                for (int i = 0; i != candidate_length_; ++i)
+                {
+                        if (is_pooled(i))
+                        {
+                                *(order + length++) = i;
+                        }
+                }
+                int h;
+                for (h = 1; h < length / 9; h = h * 3 + 1)
+                {
+                }
+                for (; h > 0; h /= 3)
+                {
+                        for (int i = h; i < length; ++i)
+                        {
+                                int j = i;
+                                while ((j >= h) && compare_frequency(*(order + j - h), *(order + j)))
+                                {
+                                        int tmp = *(order + j);
+                                        *(order + j) = *(order + j - h);
+                                        *(order + j - h) = tmp;
+                                        j -= h;
+                                }
+                        }
+                }
+                int *rank = new int[candidate_length_];
+                for (int i = 0; i != candidate_length_; ++i)
+                {
+                        *(rank + i) = -1;
+                }
+                for (int i = 0; i != length; ++i)
+                {
+                        *(rank + *(order + i)) = i;
+                }
+
+                const int varint_size_maximum = 5;
+                int reference_capacity = 1;
+                for (int n = 0; n != candidate_reference_length_; ++n)
+                {
+                        int id = *(candidate_ + n);
+                        reference_capacity += varint_size_maximum + *(candidate_offset_ + id + 1) - *(candidate_offset_ + id);
+                }
+                delete[] reference_;
+                reference_ = new unsigned char[reference_capacity];
+                delete[] entry_reference_;
+                entry_reference_ = new int32_t[entry_length_ + 1];
+                reference_size_ = 0;
+                for (int i = 0; i != entry_length_; ++i)
+                {
+                        *(entry_reference_ + i) = reference_size_;
+                        for (int n = *(entry_candidate_ + i); n != *(entry_candidate_ + i + 1); ++n)
+                        {
+                                int id = *(candidate_ + n);
+                                if (*(rank + id) >= 0)
+                                {
+                                        append_varint(static_cast<unsigned int>(*(rank + id)) << 1);
+                                }
+                                else
+                                {
+//  '/' ľܳǼޤ
+                                        const int slash_size = 1;
+                                        int start = *(candidate_offset_ + id);
+                                        int size = *(candidate_offset_ + id + 1) - start - slash_size;
+                                        append_varint((static_cast<unsigned int>(size) << 1) | 1);
+                                        for (int c = 0; c != size; ++c)
+                                        {
+                                                *(reference_ + reference_size_++) = static_cast<unsigned char>(*(string_ + start + c));
+                                        }
+                                }
+                        }
+                }
+                *(entry_reference_ + entry_length_) = reference_size_;
+
+                int string_size = 0;
+                for (int i = 0; i != length; ++i)
+                {
+                        int id = *(order + i);
+                        string_size += *(candidate_offset_ + id + 1) - *(candidate_offset_ + id);
+                }
+                char *string = new char[string_size + 1];
+                int32_t *candidate_offset = new int32_t[length + 1];
+                int offset = 0;
+                for (int i = 0; i != length; ++i)
+                {
+                        int id = *(order + i);
+                        *(candidate_offset + i) = offset;
+                        for (int n = *(candidate_offset_ + id); n != *(candidate_offset_ + id + 1); ++n)
+                        {
+                                *(string + offset++) = *(string_ + n);
+                        }
+                }
+                *(candidate_offset + length) = offset;
+                delete[] string_;
+                delete[] candidate_offset_;
+                string_ = string;
+                string_size_ = string_size;
+                candidate_offset_ = candidate_offset;
+                candidate_length_ = length;
+
+                delete[] rank;
+                delete[] order;
+        }
+
+        const char *getString() const
+        {
+                return string_;
+        }
+
+        int getStringSize() const
+        {
+                return string_size_;
+        }
+
+/// candidate ʸΰΥեåȤ֤ޤ candidate i  getCandidateOffset()[i]  getCandidateOffset()[i + 1] ޤǤǤ
+        const int32_t *getCandidateOffset() const
+        {
+                return candidate_offset_;
+        }
+
+        int getCandidateLength() const
+        {
+                return candidate_length_;
+        }
+
+        const unsigned char *getReference() const
+        {
+                return reference_;
+        }
+
+        int getReferenceSize() const
+        {
+                return reference_size_;
+        }
+
+/// ȥλȤΥեåȤ֤ޤȥ i λȤ getEntryReference()[i]  getEntryReference()[i + 1] ޤǤǤ
+        const int32_t *getEntryReference() const
+        {
+                return entry_reference_;
+        }
+
+        int getEntryLength() const
+        {
+                return entry_length_;
+        }
+
+/// ǤĹѴʸפΥХȥ֤ޤ
+        int getHenkanmojiretsuSizeMaximum() const
+        {
+                return henkanmojiretsu_size_maximum_;
+        }
+
+/// reference  begin  end ޤǤλȤѴʸפ destination ΥХȥ֤ޤǤʤ -1 ֤ޤ
+/**
+ * ȤϲĹͤǡǲ̥ӥåȤ 0 ʤлĤΥӥåȤʸ
+ *  candidate ֹ桢 1 ʤлĤΥӥåȤΥХȿ³
+ * candidate ľܼ '/' 䤤ޤ
+ */
+        static int decode(const char *string,
+                          const int32_t *candidate_offset,
+                          int candidate_length,
+                          const unsigned char *reference,
+                          int begin,
+                          int end,
+                          char *destination,
+                          int destination_size)
+        {
+                DEBUG_ASSERT_POINTER(string);
+                DEBUG_ASSERT_POINTER(candidate_offset);
+                DEBUG_ASSERT_POINTER(reference);
+                DEBUG_ASSERT_POINTER(destination);
+                if (destination_size < 1)
+                {
+                        return -1;
+                }
+                *destination = '/';
+                int size = 1;
+                int i = begin;
+                while (i < end)
+                {
+                        unsigned int value = 0;
+                        int shift = 0;
+                        for (;;)
+                        {
+                                if ((i >= end) || (shift > 28))
+                                {
+                                        return -1;
+                                }
+                                unsigned int c = *(reference + i++);
+                                value |= (c & 0x7f) << shift;
+                                if ((c & 0x80) == 0)
+                                {
+                                        break;
+                                }
+                                shift += 7;
+                        }
+                        const char *p;
+                        int candidate_size;
+                        int slash_size;
+                        if (value & 1)
+                        {
+                                candidate_size = static_cast<int>(value >> 1);
+                                if (candidate_size > end - i)
+                                {
+                                        return -1;
+                                }
+                                p = reinterpret_cast<const char*>(reference + i);
+                                i += candidate_size;
+                                slash_size = 1;
+                        }
+                        else
+                        {
+                                value >>= 1;
+                                if (value >= static_cast<unsigned int>(candidate_length))
+                                {
+                                        return -1;
+                                }
+                                p = string + *(candidate_offset + value);
+                                candidate_size = *(candidate_offset + value + 1) - *(candidate_offset + value);
+                                slash_size = 0;
+                        }
+                        if (candidate_size + slash_size > destination_size - size)
+                        {
+                                return -1;
+                        }
+                        for (int n = 0; n != candidate_size; ++n)
+                        {
+                                *(destination + size + n) = *(p + n);
+                        }
+                        size += candidate_size;
+                        if (slash_size)
+                        {
+                                *(destination + size++) = '/';
+                        }
+                }
+                return size;
+        }
+
+private:
+        static uint32_t get_hash(const char *p, int size)
+        {
+                uint32_t result = 2166136261U;
+                for (int i = 0; i != size; ++i)
+                {
+                        result = (result ^ static_cast<uint32_t>(*(reinterpret_cast<const unsigned char*>(p) + i))) * 16777619U;
+                }
+                return result;
+        }
+
+        template<class T> static T *resize(T *p, int size, int capacity)
+        {
+                T *tmp = new T[capacity];
+                for (int i = 0; i != size; ++i)
+                {
+                        *(tmp + i) = *(p + i);
+                }
+                delete[] p;
+                return tmp;
+        }
+
+/// candidate id ʸΰ֤ʤп֤ޤ
+/**
+ * ľܳǼ 1 󤢤 candidate ΥХȥ١ʸΰ
+ * ֤ 1 󤢤 2 Х٤λȤ˲äʸȥեåȤ
+ * 1 ɬפˤʤޤ '/' ǽʤ candidate ɬʸΰ
+ * ֤ޤ
+ */
+        bool is_pooled(int id) const
+        {
+                const int reference_size = 2;
+                int start = *(candidate_offset_ + id);
+                int size = *(candidate_offset_ + id + 1) - start;
+                int frequency = *(frequency_ + id);
+                if (*(string_ + start + size - 1) != '/')
+                {
+                        return true;
+                }
+                return frequency * size > frequency * reference_size + size + static_cast<int>(sizeof(int32_t));
+        }
+
+        void append_varint(unsigned int value)
+        {
+                while (value >= 0x80)
+                {
+                        *(reference_ + reference_size_++) = static_cast<unsigned char>((value & 0x7f) | 0x80);
+                        value >>= 7;
+                }
+                *(reference_ + reference_size_++) = static_cast<unsigned char>(value);
+        }
+
+/// candidate a  candidate b ¤֤٤ʤп֤ޤ
+        bool compare_frequency(int a, int b) const
+        {
+                if (*(frequency_ + a) != *(frequency_ + b))
+                {
+                        return *(frequency_ + a) < *(frequency_ + b);
+                }
+                return a > b;
+        }
+
+        bool is_equal(int id, const char *p, int size) const
+        {
+                int start = *(candidate_offset_ + id);
+                if (*(candidate_offset_ + id + 1) - start != size)
+                {
+                        return false;
+                }
+                for (int i = 0; i != size; ++i)
+                {
+                        if (*(string_ + start + i) != *(p + i))
+                        {
+                                return false;
+                        }
+                }
+                return true;
+        }
+
+        void rehash(int hash_table_length)
+        {
+                delete[] hash_table_;
+                hash_table_ = new int[hash_table_length];
+                hash_table_length_ = hash_table_length;
+                for (int i = 0; i != hash_table_length; ++i)
+                {
+                        *(hash_table_ + i) = -1;
+                }
+                for (int id = 0; id != candidate_length_; ++id)
+                {
+                        int start = *(candidate_offset_ + id);
+                        uint32_t index = get_hash(string_ + start, *(candidate_offset_ + id + 1) - start) & static_cast<uint32_t>(hash_table_length - 1);
+                        while (*(hash_table_ + index) != -1)
+                        {
+                                index = (index + 1) & static_cast<uint32_t>(hash_table_length - 1);
+                        }
+                        *(hash_table_ + index) = id;
+                }
+        }
+
+/// size ХȤ candidate p ϿߤΥȥλȤ˲äޤ
+        void add_candidate(const char *p, int size)
+        {
+                if (candidate_length_ * 2 >= hash_table_length_)
+                {
+                        rehash((hash_table_length_ == 0) ? 1024 : hash_table_length_ * 2);
+                }
+                uint32_t index = get_hash(p, size) & static_cast<uint32_t>(hash_table_length_ - 1);
+                int id;
+                for (;;)
+                {
+                        id = *(hash_table_ + index);
+                        if ((id == -1) || is_equal(id, p, size))
+                        {
+                                break;
+                        }
+                        index = (index + 1) & static_cast<uint32_t>(hash_table_length_ - 1);
+                }
+                if (id == -1)
+                {
+                        if (candidate_length_ + 2 > candidate_capacity_)
+                        {
+                                int capacity = candidate_capacity_ * 2 + 1024;
+                                candidate_offset_ = resize(candidate_offset_, candidate_length_, capacity);
+                                frequency_ = resize(frequency_, candidate_length_, capacity);
+                                candidate_capacity_ = capacity;
+                        }
+                        if (string_size_ + size > string_capacity_)
+                        {
+                                int capacity = (string_size_ + size) * 2 + 4096;
+                                string_ = resize(string_, string_size_, capacity);
+                                string_capacity_ = capacity;
+                        }
+                        for (int i = 0; i != size; ++i)
+                        {
+                                *(string_ + string_size_ + i) = *(p + i);
+                        }
+                        id = candidate_length_;
+                        *(candidate_offset_ + id) = string_size_;
+                        *(frequency_ + id) = 0;
+                        string_size_ += size;
+                        ++candidate_length_;
+                        *(candidate_offset_ + candidate_length_) = string_size_;
+                        *(hash_table_ + index) = id;
+                }
+                ++*(frequency_ + id);
+                if (candidate_reference_length_ + 1 > candidate_reference_capacity_)
+                {
+                        int capacity = candidate_reference_capacity_ * 2 + 4096;
+                        candidate_ = resize(candidate_, candidate_reference_length_, capacity);
+                        candidate_reference_capacity_ = capacity;
+                }
+                *(candidate_ + candidate_reference_length_++) = id;
+        }
+
+        char *string_;
+        int32_t *candidate_offset_;
+        int *frequency_;
+        int *hash_table_;
+        int *candidate_;
+        int *entry_candidate_;
+        unsigned char *reference_;
+        int32_t *entry_reference_;
+        int string_size_;
+        int string_capacity_;
+        int candidate_length_;
+        int candidate_capacity_;
+        int hash_table_length_;
+        int candidate_reference_length_;
+        int candidate_reference_capacity_;
+        int entry_length_;
+        int entry_capacity_;
+        int reference_size_;
+        int henkanmojiretsu_size_maximum_;
+};
+}
+
+#endif  // SKK_CANDIDATE_POOL_H
@@ -22,359 +22,162 @@
 
 namespace YaSkkServ
 {
-/// yaskkserv Ѽ񥯥饹Ǥ
+/// Υǥåȥǡĥ饹Ǥ
 /**
+ * Ͻ񤭴ʤǥåɤ߹ȥեǥ
+ * ץõξ֤ϻޤ SkkDictionary ȥ
+ * ȤǶͭǸ SkkDictionary ĤȤ˲ޤե
+ *  pread() Ǥɤޤʤᡢ᡼ͭ SkkDictionary 
+ * ̤ΥåɤõǤޤ
  *
+ * \attention
+ * main_loop_send_found() ϱ쥳ɤǤϤʤȥ饤 SKK 񤽤
+ * ΤΡѴʸפľ򥤥᡼ǰŪ˽񤭴ޤ
+ * 褦ʼΥ᡼ʣΥåɤǶͭϡѴʸ
+ * 񤭴ƤϤʤޤ
  */
-class SkkDictionary
+class SkkDictionaryImage
 {
-        SkkDictionary(SkkDictionary &source);
-        SkkDictionary& operator=(SkkDictionary &source);
+        friend class SkkDictionary;
+
+        SkkDictionaryImage(SkkDictionaryImage &source);
+        SkkDictionaryImage& operator=(SkkDictionaryImage &source);
 
 public:
-        virtual ~SkkDictionary()
+        virtual ~SkkDictionaryImage()
         {
-                close();
+                if (file_descriptor_ >= 0)
+                {
+                        ::close(file_descriptor_);
+                }
+                delete[] index_;
+                delete[] extension_;
+                delete[] trie_buffer_;
+                delete[] raw_buffer_;
+                delete[] raw_index_;
         }
 
-        SkkDictionary() :
+        SkkDictionaryImage() :
                 mtime_(),
-// ʲΥФ close() ǤɬפʤȤդɬפǤ
-                read_buffer_(0),
                 index_(0),
+                extension_(0),
+                key_prefix_(0),
+                key_offset_(0),
+                dispatch_row_index_(0),
+                dispatch_row_(0),
+                special_array_(0),
+                bloom_filter_(0),
+                perfect_hash_pilot_(0),
+                perfect_hash_table_(0),
+                sub_block_index_(0),
+                sub_block_(0),
+                sub_block_string_(0),
+                trie_buffer_(0),
+                trie_entry_(0),
+                trie_base_(0),
+                trie_check_(0),
+                candidate_string_(0),
+                candidate_offset_(0),
+                candidate_entry_reference_(0),
+                candidate_reference_(0),
+                raw_buffer_(0),
+                raw_index_(0),
                 fixed_array_(0),
                 block_(0),
                 block_short_(0),
                 string_(0),
-                midasi_(0),
-                henkanmojiretsu_(0),
                 file_descriptor_(-1),
-                before_read_offset_(-1),
                 index_size_(0),
                 normal_block_length_(0),
                 special_block_length_(0),
+                special_array_length_(0),
+                bloom_filter_bit_length_(0),
+                bloom_filter_hash_length_(0),
+                perfect_hash_bucket_length_(0),
+                perfect_hash_table_length_(0),
+                sub_block_string_size_(0),
+                trie_buffer_size_(0),
+                trie_entry_length_(0),
+                trie_node_length_(0),
+                candidate_length_(0),
+                candidate_buffer_size_(0),
+                raw_buffer_size_(0),
+                raw_index_length_(0),
                 normal_string_size_(0),
                 special_entry_offset_(0),
-                midasi_size_(0),
-                henkanmojiretsu_size_(0),
                 block_size_(0),
-                last_read_offset_start_(0),
-                last_read_index_(0),
-                last_start_block_(0),
-                last_block_length_(0),
-                last_block_index_(0),
-                last_search_result_(false)
+                reply_record_size_(0),
+                reference_count_(1)
         {
         }
 
-        bool open(const char *filename)
+private:
+/// Ȥ 1 䤷ޤ
+        void acquire()
         {
-                return open_system_call(filename);
+                __atomic_add_fetch(&reference_count_, 1, __ATOMIC_RELAXED);
         }
 
-        bool close()
+/// Ȥ 1 ĸ餷ޤǸλȤʤп֤ƤӽФ¦ delete ɬפޤ
+        bool release()
         {
-                return close_system_call();
+                return __atomic_sub_fetch(&reference_count_, 1, __ATOMIC_ACQ_REL) == 0;
         }
 
-/// п֤ޤ񤬹Ƥ update_flag ˿֤ޤ˼Ԥ update_flag ˿ޤ
+/// block ܤΥ֥å (ǡ data_size) ɤ٤֥֥åϰϤ slice_offset  slice_size ֤ޤ
 /**
- * åץǡȥåˤϡ
- *
- * ּե˼¹Ԥ줿þ
- *
- * Ȥ礭꤬뤳ȤդɬפǤ
+ * line_index  0 ʾʤХ֥åΤΰ֤ޤॵ֥֥å
+ * encoded_midasi  0 ʤƬΥ֥֥å򡢤ʳ
+ * encoded_midasi ʲθФǻϤޤǸΥ֥֥åӤޤ
+ * ֥å˥֥֥åʤХ֥åΤ֤ޤ
  */
-        bool isUpdateDictionary(bool &update_flag, const char *filename)
-        {
-                bool result;
-                struct stat stat_work;
-                if (stat(filename, &stat_work) == -1)
-                {
-                        result = false;
-                }
-                else
-                {
-                        result = true;
-                        if (mtime_ != stat_work.st_mtime)
-                        {
-                                mtime_ = stat_work.st_mtime;
-                                update_flag = true;
-                        }
-                        else
-                        {
-                                update_flag = false;
-                        }
-                }
-                return result;
-        }
-
-/// midasi ǻꤷȥõޤդп֤ޤ
-        bool search(const char *midasi)
-        {
-                last_search_result_ = search_system_call<false>(midasi);
-                return last_search_result_;
-        }
-
-/// midasi ǻꤷʸ 1 ʸܤбǽΥȥõޤդп֤ޤ
-        bool searchForFirstCharacter(const char *midasi)
-        {
-                last_search_result_ = search_system_call<true>(midasi);
-                return last_search_result_;
-        }
-
-/// Υȥõޤդп֤ޤ
-        bool searchNextEntry()
-        {
-                last_search_result_ = search_next_entry_system_call();
-                return last_search_result_;
-        }
-
-///  search() ޤ searchNextEntry() Ƥ뤫ɤ֤ޤƤп֤ޤ
-        bool isSuccess() const
-        {
-                return last_search_result_;
-        }
-
-/// search() ޤ searchNextEntry() ǺǸȯָФפΥ֤ޤ˲ʸϴޤߤޤ
-        int getMidasiSize() const
-        {
-                return midasi_size_;
-        }
-
-/// search() ޤ searchNextEntry() ǺǸȯָФפΥݥ󥿤֤ޤ
-        const char *getMidasiPointer() const
-        {
-                return midasi_;
-        }
-
-/// search() ޤ searchNextEntry() ǺǸȯѴʸפΥ֤ޤ˲ʸϴޤߤޤ
-        int getHenkanmojiretsuSize() const
-        {
-                return henkanmojiretsu_size_;
-        }
-
-/// search() ޤ searchNextEntry() ǺǸȯѴʸפΥݥ󥿤֤ޤ
-        const char *getHenkanmojiretsuPointer() const
+        void get_sub_block_range(int block, int data_size, const char *encoded_midasi, int encoded_midasi_size, int line_index, int &slice_offset, int &slice_size) const
         {
-                return henkanmojiretsu_;
-        }
-
-private:
-        template<bool is_first> bool search_system_call(const char *midasi)
-        {
-                DEBUG_ASSERT_POINTER(midasi);
-                const int margin = 8;
-                char encoded_midasi[SkkUtility::ENCODED_MIDASI_BUFFER_SIZE];
-                int encoded_size = SkkUtility::encodeHiragana(midasi, encoded_midasi, sizeof(encoded_midasi) - margin);
-                if (encoded_size == 0)
-                {
-                        encoded_midasi[0] = '\1';
-                        int i;
-                        for (i = 0; sizeof(encoded_midasi) - margin; ++i)
-                        {
-                                if ((*(midasi + i) == ' ') || (*(midasi + i) == '\0'))
-                                {
-                                        goto FOUND_TERMINATOR;
-                                }
-                                encoded_midasi[i + 1] = *(midasi + i);
-                        }
-
-                        return false;
-
-                FOUND_TERMINATOR:
-                        encoded_midasi[i + 1] = '\0';
-                }
-                else
-                {
-                        encoded_midasi[encoded_size] = '\0';
-                }
-
-                int fixed_array_index = SkkUtility::getFixedArrayIndex(encoded_midasi);
-                DEBUG_ASSERT_RANGE(fixed_array_index, -1, 0xff);
-                int start_block;
-                int block_length;
-                int read_offset_start;
-                const char *string;
-                if (fixed_array_index == -1)
-                {
-// special
-                        start_block = normal_block_length_;
-                        block_length = special_block_length_;
-                        read_offset_start = special_entry_offset_;
-                        string = string_ + normal_string_size_;
-                }
-                else
+                const int start = *(sub_block_index_ + block);
+                const int end = *(sub_block_index_ + block + 1);
+                if (start == end)
                 {
-// normal
-                        start_block = (fixed_array_ + fixed_array_index)->start_block;
-                        block_length = (fixed_array_ + fixed_array_index)->block_length;
-                        read_offset_start = 0;
-                        string = string_ + (fixed_array_ + fixed_array_index)->string_data_offset;
+                        slice_offset = 0;
+                        slice_size = data_size;
+                        return;
                 }
-
-                for (int i = 0; i != block_length; ++i)
+                int low = start + 1;
+                int high = end;
+                if ((line_index >= 0) || encoded_midasi)
                 {
-                        int cmp = SkkUtility::compareMidasi(string, 0, 510, encoded_midasi);
-                        if (cmp >= 0)
+                        while (low < high)
                         {
-                                int read_size;
-                                int read_offset;
-                                if (block_)
-                                {
-                                        read_size = (block_ + start_block + i)->getDataSize();
-                                        read_offset = read_offset_start + (block_ + start_block + i)->getOffset();
-                                }
-                                else
-                                {
-                                        read_size = (block_short_ + start_block + i)->getDataSize();
-                                        read_offset = (start_block + i) * block_size_;
-                                }
-
-                                if (before_read_offset_ == read_offset)
+                                int middle = (low + high) / 2;
+                                int tmp;
+                                if (line_index >= 0)
                                 {
-// cached
+                                        tmp = ((sub_block_ + middle)->offset <= line_index) ? -1 : 1;
                                 }
                                 else
                                 {
-                                        if (lseek(file_descriptor_, read_offset, SEEK_SET) == -1)
-                                        {
-                                                DEBUG_PRINTF("#### FAILED lseek() ERROR!!\n");
-                                                return false;
-                                        }
-                                        int read_result = static_cast<int>(read(file_descriptor_, read_buffer_, static_cast<size_t>(read_size)));
-                                        if (read_result != read_size)
-                                        {
-                                                DEBUG_PRINTF("#### FAILED read() ERROR!!  read_size = %d  read_result = %d\n",
-                                                             read_size,
-                                                             read_result);
-                                                return false;
-                                        }
-                                        before_read_offset_ = read_offset;
-                                        last_read_index_ = 0;
+                                        tmp = SkkUtility::compareMidasi(sub_block_string_,
+                                                                        (sub_block_ + middle)->key_offset,
+                                                                        sub_block_string_size_,
+                                                                        encoded_midasi,
+                                                                        encoded_midasi_size);
                                 }
-
-                                if (is_first)
+                                if (tmp <= 0)
                                 {
-                                        int index = 0;
-                                        midasi_ = read_buffer_ + index;
-                                        midasi_size_ = SkkUtility::getMidasiSize(read_buffer_, index, read_size);
-                                        henkanmojiretsu_ = SkkUtility::getHenkanmojiretsuPointer(read_buffer_, index, read_size);
-                                        henkanmojiretsu_size_ = SkkUtility::getHenkanmojiretsuSize(read_buffer_, index, read_size);
-                                        last_read_offset_start_ = read_offset_start;
-                                        last_read_index_ = index;
-                                        last_start_block_ = start_block;
-                                        last_block_length_ = block_length;
-                                        last_block_index_ = i;
-                                        return true;
+                                        low = middle + 1;
                                 }
                                 else
                                 {
-                                        int index;
-                                        if (SkkUtility::searchBinary(read_buffer_, read_size, encoded_midasi, index))
-                                        {
-                                                DEBUG_ASSERT(index >= 0);
-                                                midasi_ = read_buffer_ + index;
-                                                midasi_size_ = SkkUtility::getMidasiSize(read_buffer_, index, read_size);
-                                                henkanmojiretsu_ = SkkUtility::getHenkanmojiretsuPointer(read_buffer_, index, read_size);
-                                                henkanmojiretsu_size_ = SkkUtility::getHenkanmojiretsuSize(read_buffer_, index, read_size);
-                                                last_read_offset_start_ = read_offset_start;
-                                                last_read_index_ = index;
-                                                last_start_block_ = start_block;
-                                                last_block_length_ = block_length;
-                                                last_block_index_ = i;
-                                                return true;
-                                        }
-
-                                        if (SkkUtility::searchLinear(read_buffer_, read_size, encoded_midasi, index))
-                                        {
-                                                DEBUG_ASSERT(index >= 0);
-                                                midasi_ = read_buffer_ + index;
-                                                midasi_size_ = SkkUtility::getMidasiSize(read_buffer_, index, read_size);
-                                                henkanmojiretsu_ = SkkUtility::getHenkanmojiretsuPointer(read_buffer_, index, read_size);
-                                                henkanmojiretsu_size_ = SkkUtility::getHenkanmojiretsuSize(read_buffer_, index, read_size);
-                                                last_read_offset_start_ = read_offset_start;
-                                                last_read_index_ = index;
-                                                last_start_block_ = start_block;
-                                                last_block_length_ = block_length;
-                                                last_block_index_ = i;
-                                                return true;
-                                        }
-
-                                        return false;
+                                        high = middle;
                                 }
                         }
-                        string = skip_space(string);
-                }
-                return false;
-        }
-
-        bool search_next_entry_system_call()
-        {
-                if ((!last_search_result_) || (last_block_index_ >= last_block_length_))
-                {
-                        return false;
-                }
-
-                int read_size;
-                int read_offset;
-                if (block_)
-                {
-                        read_size = (block_ + last_start_block_ + last_block_index_)->getDataSize();
-                        read_offset = last_read_offset_start_ + (block_ + last_start_block_ + last_block_index_)->getOffset();
-                }
-                else
-                {
-                        read_size = (block_short_ + last_start_block_ + last_block_index_)->getDataSize();
-                        read_offset = (last_start_block_ + last_block_index_) * block_size_;
-                }
-
-                last_read_index_ = SkkUtility::getNextLineIndex(read_buffer_, last_read_index_, read_size);
-                if (last_read_index_ < 0)
-                {
-                        ++last_block_index_;
-                        if (last_block_index_ >= last_block_length_)
-                        {
-                                return false;
-                        }
-
-                        if (block_)
-                        {
-                                read_size = (block_ + last_start_block_ + last_block_index_)->getDataSize();
-                                read_offset = last_read_offset_start_ + (block_ + last_start_block_ + last_block_index_)->getOffset();
-                        }
-                        else
-                        {
-                                read_size = (block_short_ + last_start_block_ + last_block_index_)->getDataSize();
-                                read_offset = (last_start_block_ + last_block_index_) * block_size_;
-                        }
-
-                        if (lseek(file_descriptor_, read_offset, SEEK_SET) == -1)
-                        {
-                                DEBUG_PRINTF("#### FAILED lseek() ERROR!!\n");
-
-                                return false;
-                        }
-                        int read_result = static_cast<int>(read(file_descriptor_, read_buffer_, static_cast<size_t>(read_size)));
-                        if (read_result != read_size)
-                        {
-                                DEBUG_PRINTF("#### FAILED read() ERROR!!  read_size = %d  read_result = %d\n",
-                                             read_size,
-                                             read_result);
-                                return false;
-                        }
-                        before_read_offset_ = read_offset;
-                        last_read_index_ = 0;
                 }
-
-                midasi_ = read_buffer_ + last_read_index_;
-                midasi_size_ = SkkUtility::getMidasiSize(read_buffer_, last_read_index_, read_size);
-                henkanmojiretsu_ = SkkUtility::getHenkanmojiretsuPointer(read_buffer_, last_read_index_, read_size);
-                henkanmojiretsu_size_ = SkkUtility::getHenkanmojiretsuSize(read_buffer_, last_read_index_, read_size);
-                return true;
+// low ϾʤǽΥ֥֥åʤΤǡ 1 ɤߤޤ
+                slice_offset = (sub_block_ + low - 1)->offset;
+                slice_size = ((low < end) ? (sub_block_ + low)->offset : data_size) - slice_offset;
         }
 
-        bool open_system_call(const char *filename)
+/// filename 򳫤ޤԤϵ֤ޤ
+        bool open(const char *filename)
         {
                 bool result;
                 file_descriptor_ = ::open(filename, O_RDONLY);
@@ -395,32 +198,37 @@ private:
                                 result = true;
                                 mtime_ = stat.st_mtime;
                         }
+                        bool information_flag = false;
                         {
                                 off_t lseek_offset = sizeof(information);
-                                if (result && (lseek(file_descriptor_, -lseek_offset, SEEK_END) == -1))
+                                if (result &&
+                                    (stat.st_size >= lseek_offset) &&
+                                    (lseek(file_descriptor_, -lseek_offset, SEEK_END) != -1) &&
+                                    (read(file_descriptor_, &information, sizeof(information)) == static_cast<ssize_t>(sizeof(information))) &&
+                                    information.isValidIdentifier())
                                 {
-                                        result = false;
+                                        information_flag = true;
                                 }
-                                else
+                        }
+
+                        if (result && information_flag)
+                        {
+                                if (information.get(SkkJisyo::Information::ID_BIT_FLAG) & SkkJisyo::Information::BIT_FLAG_REPLY_RECORD)
                                 {
-                                        result = true;
+                                        reply_record_size_ = 1;
                                 }
                         }
 
-                        if (result && (read(file_descriptor_, &information, sizeof(information)) == -1))
+                        if (result && !information_flag)
                         {
-                                result = false;
+// Information ʤե SKK 񤽤ΤΤȤƳޤ
+                                result = open_raw(stat.st_size);
                         }
-
-                        if (result)
+                        else if (result && (information.get(SkkJisyo::Information::ID_TRIE_DATA_SIZE) > 0))
                         {
-                                if (information.get(SkkJisyo::Information::ID_IDENTIFIER) != SkkJisyo::IDENTIFIER)
-                                {
-                                        result = false;
-                                }
+                                result = open_trie(information);
                         }
-
-                        if (result)
+                        else if (result)
                         {
                                 const int size_limit_minimum = 1 * 1024;
                                 const int size_limit_maximum = 256 * 1024;
@@ -464,9 +272,6 @@ private:
                                                 }
                                                 else
                                                 {
-                                                        const int margin = 32;
-                                                        read_buffer_ = new char[block_size_ + margin];
-
                                                         normal_block_length_ = index_data_header.get(SkkJisyo::IndexDataHeader::ID_NORMAL_BLOCK_LENGTH);
                                                         special_block_length_ = index_data_header.get(SkkJisyo::IndexDataHeader::ID_SPECIAL_BLOCK_LENGTH);
                                                         normal_string_size_ = index_data_header.get(SkkJisyo::IndexDataHeader::ID_NORMAL_STRING_SIZE);
@@ -493,86 +298,1676 @@ private:
                                         }
                                 }
                         }
+
+                        if (result &&
+                            information_flag &&
+                            (information.get(SkkJisyo::Information::ID_VERSION) >= SkkJisyo::Information::VERSION_EXTENSION_DATA) &&
+                            (information.get(SkkJisyo::Information::ID_EXTENSION_DATA_OFFSET) > 0))
+                        {
+                                result = read_extension_data(information);
+                        }
                 }
                 return result;
         }
 
-        bool close_system_call()
+/// SKK 񤽤Τ (filesize Х) ɤ߹ߡƬեåȤ򸫽Фν¤٤ǥåޤԤϵ֤ޤ
+/**
+ * main_loop_send_found() ϸդäȥΥХåե񤭴Ʋ
+ * ԤޤǤ send() 뤿ᡢ mmap زԤäɤ߹ߤ
+ * ȹԡԤȥڡޤޤʤԤ̵뤷ޤ
+ *
+ * SKK ꤢꥨȥϵս¤ӡĿͼϤ⤽¤Ǥ
+ * ʤᡢ٤ƤιԤХȽ¤ؤޤԿ¿¤
+ * ʣΥåɤʬôޤ
+ */
+        bool open_raw(off_t filesize)
         {
-                delete[] read_buffer_;
-
-                if (file_descriptor_ >= 0)
+                const int size_limit_maximum = 1024 * 1024 * 1024;
+                if ((filesize <= 0) || (filesize >= size_limit_maximum))
                 {
-                        ::close(file_descriptor_);
+                        return false;
                 }
+                const int size = static_cast<int>(filesize);
+                if (lseek(file_descriptor_, 0, SEEK_SET) == -1)
+                {
+                        return false;
+                }
+                const int cr_size = 1;
+                raw_buffer_ = new char[size + cr_size];
+                if (read(file_descriptor_, raw_buffer_, static_cast<size_t>(size)) != size)
+                {
+                        return false;
+                }
+                if (*raw_buffer_ != ';')
+                {
+// Ƭ ';' Ǥʤ SKK ǤϤʤΤȤޤ
+                        return false;
+                }
+                *(raw_buffer_ + size) = '\n';
+                raw_buffer_size_ = size + cr_size;
 
-                delete[] index_;
-
-                read_buffer_ = 0;
-                index_ = 0;
-                fixed_array_ = 0;
-                block_ = 0;
-                block_short_ = 0;
-                string_ = 0;
-                midasi_ = 0;
-                henkanmojiretsu_ = 0;
-                file_descriptor_ = -1;
+                int length = 0;
+                for (int index = 0; index >= 0; index = SkkUtility::getNextLineIndex(raw_buffer_, index, raw_buffer_size_))
+                {
+                        if (is_raw_entry(raw_buffer_, index))
+                        {
+                                ++length;
+                        }
+                }
+// Ŀͼ϶ΤȤ⤢Τǡȥ꤬ 1 ĤʤƤⳫޤ
+                int32_t *raw_index = new int32_t[length];
+                raw_index_ = raw_index;
+                raw_index_length_ = length;
+                int i = 0;
+                for (int index = 0; index >= 0; index = SkkUtility::getNextLineIndex(raw_buffer_, index, raw_buffer_size_))
+                {
+                        if (is_raw_entry(raw_buffer_, index))
+                        {
+                                *(raw_index + i) = index;
+                                ++i;
+                        }
+                }
+                if (length > 1)
+                {
+                        int32_t *work = new int32_t[length];
+                        sort_raw_index(raw_buffer_, raw_buffer_size_, raw_index, work, length);
+                        delete[] work;
+                }
+                return true;
+        }
+
+/// buffer  index ϤޤԤȥʤп֤ޤ
+        static bool is_raw_entry(const char *buffer, int index)
+        {
+                const char c = *(buffer + index);
+                if ((c == ';') || (c == ' ') || (c == '\n') || (c == '\r') || (c == '\1'))
+                {
+                        return false;
+                }
+                int i;
+                for (i = index; (*(buffer + i) != ' ') && (*(buffer + i) != '\n'); ++i)
+                {
+                }
+// Ф '\1' ֤ raw_midasi_ ʣ̤ǤĹ˸¤ޤ
+                const int margin = 8;
+                return (*(buffer + i) == ' ') && (i - index < SkkUtility::ENCODED_MIDASI_BUFFER_SIZE - margin);
+        }
+
+        enum
+        {
+                RAW_SORT_THREAD_LENGTH_MAXIMUM = 8
+        };
+
+/// Ƭեå index  begin  end (end ϴޤޤʤ) ¤ؤ뤫 middle 򶭤¤ 2 ĤϰϤʻ礷ޤ
+        struct RawSortArgument
+        {
+                const char *buffer;
+                int size;
+                int32_t *index;
+                int32_t *work;
+                int begin;
+                int middle;
+                int end;
+        };
+
+/// index  length ĤιƬեåȤ򸫽ФΥХȽ¤ؤޤ work  length ĤκΰǤ
+/**
+ * ϰϤ򥹥åɤοʬƤ줾¤ؤ٤礦ϰϤʻ礹
+ * 뤳Ȥ򷫤֤ޤʻϰʤΤǡƱФιԤϥե
+ * ν¤Ӥޤ
+ */
+        static void sort_raw_index(const char *buffer, int size, int32_t *index, int32_t *work, int length)
+        {
+                RawSortArgument argument[RAW_SORT_THREAD_LENGTH_MAXIMUM];
+                int boundary[RAW_SORT_THREAD_LENGTH_MAXIMUM + 1];
+                const int thread_length = get_raw_sort_thread_length(length);
+                for (int i = 0; i <= thread_length; ++i)
+                {
+                        boundary[i] = static_cast<int>(static_cast<int64_t>(length) * i / thread_length);
+                }
+                for (int i = 0; i != thread_length; ++i)
+                {
+                        RawSortArgument tmp = { buffer, size, index, work, boundary[i], -1, boundary[i + 1], };
+                        argument[i] = tmp;
+                }
+                run_raw_sort_thread(argument, thread_length);
+                for (int width = 1; width < thread_length; width *= 2)
+                {
+                        int argument_length = 0;
+                        for (int i = 0; i + width < thread_length; i += width * 2)
+                        {
+                                const int end = (i + width * 2 < thread_length) ? i + width * 2 : thread_length;
+                                RawSortArgument tmp = { buffer, size, index, work, boundary[i], boundary[i + width], boundary[end], };
+                                argument[argument_length] = tmp;
+                                ++argument_length;
+                        }
+                        run_raw_sort_thread(argument, argument_length);
+                }
+        }
+
+/// ¤ؤ˻Ȥåɤο֤ޤ
+        static int get_raw_sort_thread_length(int length)
+        {
+#ifdef YASKKSERV_CONFIG_HAVE_PTHREAD
+                const int parallel_length_minimum = 32 * 1024;
+                if (length < parallel_length_minimum)
+                {
+                        return 1;
+                }
+                long processor = sysconf(_SC_NPROCESSORS_ONLN);
+                if (processor < 1)
+                {
+                        return 1;
+                }
+                if (processor > RAW_SORT_THREAD_LENGTH_MAXIMUM)
+                {
+                        return RAW_SORT_THREAD_LENGTH_MAXIMUM;
+                }
+                return static_cast<int>(processor);
+#else  // YASKKSERV_CONFIG_HAVE_PTHREAD
+                (void)length;
+                return 1;
+#endif  // YASKKSERV_CONFIG_HAVE_PTHREAD
+        }
+
+/// argument  length Ĥν򤽤줾쥹åɤǼ¹Ԥ٤ƤνλԤޤåɤʤиƤӽФǼ¹Ԥޤ
+        static void run_raw_sort_thread(RawSortArgument *argument, int length)
+        {
+#ifdef YASKKSERV_CONFIG_HAVE_PTHREAD
+                pthread_t thread[RAW_SORT_THREAD_LENGTH_MAXIMUM];
+                bool create_flag[RAW_SORT_THREAD_LENGTH_MAXIMUM];
+                for (int i = 1; i < length; ++i)
+                {
+                        create_flag[i] = (pthread_create(&thread[i], 0, raw_sort_thread, argument + i) == 0);
+                }
+                if (length > 0)
+                {
+                        raw_sort_thread(argument);
+                }
+                for (int i = 1; i < length; ++i)
+                {
+                        if (create_flag[i])
+                        {
+                                pthread_join(thread[i], 0);
+                        }
+                        else
+                        {
+                                raw_sort_thread(argument + i);
+                        }
+                }
+#else  // YASKKSERV_CONFIG_HAVE_PTHREAD
+                for (int i = 0; i < length; ++i)
+                {
+                        raw_sort_thread(argument + i);
+                }
+#endif  // YASKKSERV_CONFIG_HAVE_PTHREAD
+        }
+
+        static void *raw_sort_thread(void *p)
+        {
+                RawSortArgument *argument = static_cast<RawSortArgument*>(p);
+                if (argument->middle < 0)
+                {
+                        sort_raw_index_core(argument->buffer, argument->size, argument->index, argument->work, argument->begin, argument->end);
+                }
+                else
+                {
+                        merge_raw_index(argument->buffer, argument->size, argument->index, argument->work, argument->begin, argument->middle, argument->end);
+                }
+                return 0;
+        }
+
+/// index  begin  end (end ϴޤޤʤ) ޡȤ¤ؤޤ
+        static void sort_raw_index_core(const char *buffer, int size, int32_t *index, int32_t *work, int begin, int end)
+        {
+                const int insertion_sort_length = 16;
+                if (end - begin <= insertion_sort_length)
+                {
+                        for (int i = begin + 1; i < end; ++i)
+                        {
+                                int32_t tmp = *(index + i);
+                                int n;
+                                for (n = i; (n > begin) && (SkkUtility::compareMidasi(buffer, *(index + n - 1), size, buffer + tmp, size - tmp) > 0); --n)
+                                {
+                                        *(index + n) = *(index + n - 1);
+                                }
+                                *(index + n) = tmp;
+                        }
+                        return;
+                }
+                int middle = begin + (end - begin) / 2;
+                sort_raw_index_core(buffer, size, index, work, begin, middle);
+                sort_raw_index_core(buffer, size, index, work, middle, end);
+                merge_raw_index(buffer, size, index, work, begin, middle, end);
+        }
+
+/// 줾¤Ǥ index  begin  middle  middle  end ʻ礷ޤ work  begin  middle Ȥޤ
+        static void merge_raw_index(const char *buffer, int size, int32_t *index, int32_t *work, int begin, int middle, int end)
+        {
+                if (SkkUtility::compareMidasi(buffer, *(index + middle - 1), size, buffer + *(index + middle), size - *(index + middle)) <= 0)
+                {
+// ¤Ǥޤ SKK ʤȥϤۤȤɤˤ
+// ޤ
+                        return;
+                }
+                for (int i = begin; i != middle; ++i)
+                {
+                        *(work + i) = *(index + i);
+                }
+                int left = begin;
+                int right = middle;
+                int destination = begin;
+                while ((left < middle) && (right < end))
+                {
+                        if (SkkUtility::compareMidasi(buffer, *(work + left), size, buffer + *(index + right), size - *(index + right)) <= 0)
+                        {
+                                *(index + destination++) = *(work + left++);
+                        }
+                        else
+                        {
+                                *(index + destination++) = *(index + right++);
+                        }
+                }
+                while (left < middle)
+                {
+                        *(index + destination++) = *(work + left++);
+                }
+        }
+
+/// ȥ饤ļɤ߹ߤޤԤϵ֤ޤ
+/**
+ * main_loop_send_found() ϸդäȥΥХåե񤭴뤿
+ * ᡢ mmap ˥ȥ饤ǡޤǤɤ߹ߤޤ
+ */
+        bool open_trie(SkkJisyo::Information &information)
+        {
+                const int size_limit_maximum = 256 * 1024 * 1024;
+                int buffer_size = information.get(SkkJisyo::Information::ID_NORMAL_SIZE) + information.get(SkkJisyo::Information::ID_SPECIAL_SIZE);
+                int trie_data_offset = information.get(SkkJisyo::Information::ID_TRIE_DATA_OFFSET);
+                int trie_data_size = information.get(SkkJisyo::Information::ID_TRIE_DATA_SIZE);
+                if ((buffer_size <= 0) ||
+                    (trie_data_offset < buffer_size) ||
+                    (trie_data_offset & 0x3) ||
+                    (trie_data_size < SkkJisyo::TrieDataHeader::getSize()) ||
+                    (trie_data_size >= size_limit_maximum - trie_data_offset))
+                {
+                        return false;
+                }
+                if (lseek(file_descriptor_, 0, SEEK_SET) == -1)
+                {
+                        return false;
+                }
+                char *p = new char[trie_data_offset + trie_data_size];
+                trie_buffer_ = p;
+                if (read(file_descriptor_, p, static_cast<size_t>(trie_data_offset + trie_data_size)) != trie_data_offset + trie_data_size)
+                {
+                        return false;
+                }
+
+                SkkJisyo::TrieDataHeader trie_data_header;
+                trie_data_header.initialize(p + trie_data_offset);
+                int entry_length = trie_data_header.get(SkkJisyo::TrieDataHeader::ID_ENTRY_LENGTH);
+                int node_length = trie_data_header.get(SkkJisyo::TrieDataHeader::ID_NODE_LENGTH);
+                struct
+                {
+                        SkkJisyo::TrieDataHeader::Id id;
+                        int length;
+                }
+                table[] =
+                {
+                        { SkkJisyo::TrieDataHeader::ID_ENTRY_OFFSET, entry_length, },
+                        { SkkJisyo::TrieDataHeader::ID_BASE_OFFSET, node_length, },
+                        { SkkJisyo::TrieDataHeader::ID_CHECK_OFFSET, node_length, },
+                };
+                const int32_t *array[3];
+                for (int i = 0; i != 3; ++i)
+                {
+                        int offset = trie_data_header.get(table[i].id);
+                        if ((table[i].length <= 0) ||
+                            (offset < SkkJisyo::TrieDataHeader::getSize()) ||
+                            (offset & 0x3) ||
+                            (table[i].length > (trie_data_size - offset) / static_cast<int>(sizeof(int32_t))))
+                        {
+                                return false;
+                        }
+                        array[i] = reinterpret_cast<const int32_t*>(p + trie_data_offset + offset);
+                }
+                for (int i = 0; i != entry_length; ++i)
+                {
+                        if ((*(array[0] + i) < 0) || (*(array[0] + i) >= buffer_size))
+                        {
+                                return false;
+                        }
+                }
+
+                int candidate_pool_offset = trie_data_header.get(SkkJisyo::TrieDataHeader::ID_CANDIDATE_POOL_OFFSET);
+                if ((candidate_pool_offset > 0) &&
+                    !open_candidate_pool(p + trie_data_offset, trie_data_size, candidate_pool_offset, entry_length))
+                {
+                        return false;
+                }
+
+                trie_buffer_size_ = buffer_size;
+                trie_entry_ = array[0];
+                trie_base_ = array[1];
+                trie_check_ = array[2];
+                trie_entry_length_ = entry_length;
+                trie_node_length_ = node_length;
+                return true;
+        }
+
+/// ȥ饤ǡ trie_data θסɤ߹ߤޤԤϵ֤ޤ
+        bool open_candidate_pool(const char *trie_data, int trie_data_size, int candidate_pool_offset, int entry_length)
+        {
+                if ((candidate_pool_offset & 0x3) ||
+                    (candidate_pool_offset > trie_data_size - SkkJisyo::CandidatePoolHeader::getSize()))
+                {
+                        return false;
+                }
+                SkkJisyo::CandidatePoolHeader candidate_pool_header;
+                candidate_pool_header.initialize(trie_data + candidate_pool_offset);
+                int candidate_length = candidate_pool_header.get(SkkJisyo::CandidatePoolHeader::ID_CANDIDATE_LENGTH);
+                int string_size = candidate_pool_header.get(SkkJisyo::CandidatePoolHeader::ID_STRING_SIZE);
+                int reference_size = candidate_pool_header.get(SkkJisyo::CandidatePoolHeader::ID_REFERENCE_SIZE);
+                int henkanmojiretsu_size_maximum = candidate_pool_header.get(SkkJisyo::CandidatePoolHeader::ID_HENKANMOJIRETSU_SIZE_MAXIMUM);
+                int candidate_offset_offset = candidate_pool_header.get(SkkJisyo::CandidatePoolHeader::ID_CANDIDATE_OFFSET_OFFSET);
+                int entry_reference_offset = candidate_pool_header.get(SkkJisyo::CandidatePoolHeader::ID_ENTRY_REFERENCE_OFFSET);
+                int string_offset = candidate_pool_header.get(SkkJisyo::CandidatePoolHeader::ID_STRING_OFFSET);
+                int reference_offset = candidate_pool_header.get(SkkJisyo::CandidatePoolHeader::ID_REFERENCE_OFFSET);
+                const int henkanmojiretsu_size_limit_maximum = 16 * 1024 * 1024;
+                if ((candidate_length < 0) ||
+                    (string_size < 0) ||
+                    (reference_size < 0) ||
+                    (henkanmojiretsu_size_maximum <= 0) ||
+                    (henkanmojiretsu_size_maximum > henkanmojiretsu_size_limit_maximum) ||
+                    (candidate_offset_offset < 0) ||
+                    (candidate_offset_offset & 0x3) ||
+                    (candidate_length >= (trie_data_size - candidate_offset_offset) / static_cast<int>(sizeof(int32_t))) ||
+                    (entry_reference_offset < 0) ||
+                    (entry_reference_offset & 0x3) ||
+                    (entry_length >= (trie_data_size - entry_reference_offset) / static_cast<int>(sizeof(int32_t))) ||
+                    (string_offset < 0) ||
+                    (string_size > trie_data_size - string_offset) ||
+                    (reference_offset < 0) ||
+                    (reference_size > trie_data_size - reference_offset))
+                {
+                        return false;
+                }
+                const int32_t *candidate_offset = reinterpret_cast<const int32_t*>(trie_data + candidate_offset_offset);
+                const int32_t *entry_reference = reinterpret_cast<const int32_t*>(trie_data + entry_reference_offset);
+                if ((*(candidate_offset + 0) != 0) || (*(candidate_offset + candidate_length) > string_size))
+                {
+                        return false;
+                }
+                for (int i = 0; i != candidate_length; ++i)
+                {
+                        if (*(candidate_offset + i) > *(candidate_offset + i + 1))
+                        {
+                                return false;
+                        }
+                }
+                if ((*(entry_reference + 0) != 0) || (*(entry_reference + entry_length) > reference_size))
+                {
+                        return false;
+                }
+                for (int i = 0; i != entry_length; ++i)
+                {
+                        if (*(entry_reference + i) > *(entry_reference + i + 1))
+                        {
+                                return false;
+                        }
+                }
+
+                const int protocol_size = 1;
+                const int cr_size = 1;
+                candidate_buffer_size_ = protocol_size + henkanmojiretsu_size_maximum + cr_size;
+                candidate_string_ = trie_data + string_offset;
+                candidate_offset_ = candidate_offset;
+                candidate_entry_reference_ = entry_reference;
+                candidate_reference_ = reinterpret_cast<const unsigned char*>(trie_data + reference_offset);
+                candidate_length_ = candidate_length;
+                return true;
+        }
+
+/// ĥǡɤ߹ߤޤԤϵ֤ޤ
+        bool read_extension_data(SkkJisyo::Information &information)
+        {
+                const int size_limit_maximum = 64 * 1024 * 1024;
+                int extension_data_offset = information.get(SkkJisyo::Information::ID_EXTENSION_DATA_OFFSET);
+                int extension_data_size = information.get(SkkJisyo::Information::ID_EXTENSION_DATA_SIZE);
+                if ((extension_data_size < SkkJisyo::ExtensionDataHeader::getSize()) ||
+                    (extension_data_size >= size_limit_maximum))
+                {
+                        return false;
+                }
+                if (lseek(file_descriptor_, extension_data_offset, SEEK_SET) == -1)
+                {
+                        return false;
+                }
+                extension_ = new char[extension_data_size];
+                if (read(file_descriptor_, extension_, static_cast<size_t>(extension_data_size)) != extension_data_size)
+                {
+                        return false;
+                }
+
+                SkkJisyo::ExtensionDataHeader extension_data_header;
+                extension_data_header.initialize(extension_);
+
+                int key_prefix_offset = extension_data_header.get(SkkJisyo::ExtensionDataHeader::ID_KEY_PREFIX_OFFSET);
+                int key_prefix_size = extension_data_header.get(SkkJisyo::ExtensionDataHeader::ID_KEY_PREFIX_SIZE);
+                if (key_prefix_offset > 0)
+                {
+                        if ((key_prefix_offset % 8 != 0) ||
+                            (key_prefix_size != static_cast<int>(sizeof(uint64_t)) * (normal_block_length_ + special_block_length_)) ||
+                            (key_prefix_offset + key_prefix_size > extension_data_size))
+                        {
+                                return false;
+                        }
+                        key_prefix_ = reinterpret_cast<const uint64_t*>(extension_ + key_prefix_offset);
+                }
+
+                int key_offset_offset = extension_data_header.get(SkkJisyo::ExtensionDataHeader::ID_KEY_OFFSET_OFFSET);
+                int key_offset_size = extension_data_header.get(SkkJisyo::ExtensionDataHeader::ID_KEY_OFFSET_SIZE);
+                if (key_offset_offset > 0)
+                {
+                        if ((key_offset_offset % 4 != 0) ||
+                            (key_offset_size != static_cast<int>(sizeof(int32_t)) * (normal_block_length_ + special_block_length_)) ||
+                            (key_offset_offset + key_offset_size > extension_data_size))
+                        {
+                                return false;
+                        }
+                        const int32_t *key_offset = reinterpret_cast<const int32_t*>(extension_ + key_offset_offset);
+// ƥ֥åκǸθФʸǼΰ˾¤Ǥɬפ
+// ޤ
+                        const int string_size = static_cast<int>(index_ + index_size_ - string_);
+                        const int block_length = normal_block_length_ + special_block_length_;
+                        for (int i = 0; i != block_length; ++i)
+                        {
+                                if (((i > 0) && (*(key_offset + i - 1) >= *(key_offset + i))) ||
+                                    (*(key_offset + i) < 0) ||
+                                    (*(key_offset + i) >= string_size))
+                                {
+                                        return false;
+                                }
+                        }
+                        key_offset_ = key_offset;
+                }
+
+                int dispatch_offset = extension_data_header.get(SkkJisyo::ExtensionDataHeader::ID_DISPATCH_OFFSET);
+                int dispatch_size = extension_data_header.get(SkkJisyo::ExtensionDataHeader::ID_DISPATCH_SIZE);
+                if ((dispatch_offset > 0) && key_offset_)
+                {
+                        const int row_index_size = static_cast<int>(sizeof(int32_t)) * SkkJisyo::DISPATCH_ROW_INDEX_LENGTH;
+                        const int row_size = static_cast<int>(sizeof(uint16_t)) * SkkJisyo::DISPATCH_ROW_SIZE;
+                        if ((dispatch_offset % 8 != 0) ||
+                            (dispatch_size < row_index_size) ||
+                            ((dispatch_size - row_index_size) % row_size != 0) ||
+                            (dispatch_offset + dispatch_size > extension_data_size))
+                        {
+                                return false;
+                        }
+                        const int32_t *row_index = reinterpret_cast<const int32_t*>(extension_ + dispatch_offset);
+                        const uint16_t *dispatch_row = reinterpret_cast<const uint16_t*>(extension_ + dispatch_offset + row_index_size);
+                        int row_length = (dispatch_size - row_index_size) / row_size;
+                        for (int i = 0; i != SkkJisyo::DISPATCH_ROW_LENGTH; ++i)
+                        {
+                                if ((*(row_index + i) < -1) || (*(row_index + i) >= row_length))
+                                {
+                                        return false;
+                                }
+                                if (*(row_index + i) == -1)
+                                {
+                                        continue;
+                                }
+// ԤͤϹԤĥ֥åϰа֤ǡ¤Ǥ
+// ɬפޤ
+                                int block_length;
+                                if (i == SkkJisyo::DISPATCH_ROW_SPECIAL)
+                                {
+                                        block_length = special_block_length_;
+                                }
+                                else
+                                {
+                                        const int start_block = (fixed_array_ + i)->start_block;
+                                        block_length = (fixed_array_ + i)->block_length;
+                                        if ((start_block < 0) ||
+                                            (block_length < 0) ||
+                                            (start_block + block_length > normal_block_length_))
+                                        {
+                                                return false;
+                                        }
+                                }
+                                const uint16_t *row = dispatch_row + *(row_index + i) * SkkJisyo::DISPATCH_ROW_SIZE;
+                                for (int n = 0; n != SkkJisyo::DISPATCH_ROW_SIZE; ++n)
+                                {
+                                        if ((*(row + n) > block_length) ||
+                                            ((n > 0) && (*(row + n - 1) > *(row + n))))
+                                        {
+                                                return false;
+                                        }
+                                }
+                        }
+                        dispatch_row_index_ = row_index;
+                        dispatch_row_ = dispatch_row;
+                }
+
+                int special_array_offset = extension_data_header.get(SkkJisyo::ExtensionDataHeader::ID_SPECIAL_ARRAY_OFFSET);
+                int special_array_size = extension_data_header.get(SkkJisyo::ExtensionDataHeader::ID_SPECIAL_ARRAY_SIZE);
+                if ((special_array_offset > 0) && key_offset_)
+                {
+                        if ((special_array_offset % 8 != 0) ||
+                            (special_array_size <= 0) ||
+                            (special_array_size % static_cast<int>(sizeof(SkkJisyo::SpecialArray)) != 0) ||
+                            (special_array_offset + special_array_size > extension_data_size))
+                        {
+                                return false;
+                        }
+                        const SkkJisyo::SpecialArray *special_array = reinterpret_cast<const SkkJisyo::SpecialArray*>(extension_ + special_array_offset);
+                        int special_array_length = special_array_size / static_cast<int>(sizeof(SkkJisyo::SpecialArray));
+                        for (int i = 0; i != special_array_length; ++i)
+                        {
+                                if (((i > 0) && ((special_array + i - 1)->character >= (special_array + i)->character)) ||
+                                    ((special_array + i)->start_block < 0) ||
+                                    ((special_array + i)->block_length == 0) ||
+                                    ((special_array + i)->start_block + (special_array + i)->block_length > special_block_length_))
+                                {
+                                        return false;
+                                }
+                        }
+                        special_array_ = special_array;
+                        special_array_length_ = special_array_length;
+                }
+
+                int bloom_filter_offset = extension_data_header.get(SkkJisyo::ExtensionDataHeader::ID_BLOOM_FILTER_OFFSET);
+                int bloom_filter_size = extension_data_header.get(SkkJisyo::ExtensionDataHeader::ID_BLOOM_FILTER_SIZE);
+                int bloom_filter_hash_length = extension_data_header.get(SkkJisyo::ExtensionDataHeader::ID_BLOOM_FILTER_HASH_LENGTH);
+                if (bloom_filter_offset > 0)
+                {
+                        if ((bloom_filter_offset % 8 != 0) ||
+                            (bloom_filter_size <= 0) ||
+                            (bloom_filter_size % 8 != 0) ||
+                            (bloom_filter_size > SkkJisyo::BLOOM_FILTER_BIT_LENGTH_MAXIMUM / 8) ||
+                            (bloom_filter_offset + bloom_filter_size > extension_data_size) ||
+                            (bloom_filter_hash_length <= 0) ||
+                            (bloom_filter_hash_length > SkkJisyo::BLOOM_FILTER_HASH_LENGTH_MAXIMUM))
+                        {
+                                return false;
+                        }
+                        bloom_filter_ = reinterpret_cast<const uint64_t*>(extension_ + bloom_filter_offset);
+                        bloom_filter_bit_length_ = bloom_filter_size * 8;
+                        bloom_filter_hash_length_ = bloom_filter_hash_length;
+                }
+
+                if (information.get(SkkJisyo::Information::ID_VERSION) >= SkkJisyo::Information::VERSION_PERFECT_HASH)
+                {
+                        int pilot_offset = extension_data_header.get(SkkJisyo::ExtensionDataHeader::ID_PERFECT_HASH_PILOT_OFFSET);
+                        int pilot_size = extension_data_header.get(SkkJisyo::ExtensionDataHeader::ID_PERFECT_HASH_PILOT_SIZE);
+                        int table_offset = extension_data_header.get(SkkJisyo::ExtensionDataHeader::ID_PERFECT_HASH_TABLE_OFFSET);
+                        int table_size = extension_data_header.get(SkkJisyo::ExtensionDataHeader::ID_PERFECT_HASH_TABLE_SIZE);
+                        if ((pilot_offset <= 0) ||
+                            (pilot_offset % 8 != 0) ||
+                            (pilot_size <= 0) ||
+                            (pilot_size % static_cast<int>(sizeof(uint32_t)) != 0) ||
+                            (pilot_offset + pilot_size > extension_data_size) ||
+                            (table_offset <= 0) ||
+                            (table_offset % 8 != 0) ||
+                            (table_size <= 0) ||
+                            (table_size % static_cast<int>(sizeof(SkkJisyo::PerfectHashEntry)) != 0) ||
+                            (table_offset + table_size > extension_data_size))
+                        {
+                                return false;
+                        }
+                        const uint32_t *pilot = reinterpret_cast<const uint32_t*>(extension_ + pilot_offset);
+                        int bucket_length = pilot_size / static_cast<int>(sizeof(uint32_t));
+                        int table_length = table_size / static_cast<int>(sizeof(SkkJisyo::PerfectHashEntry));
+                        for (int i = 0; i != bucket_length; ++i)
+                        {
+                                if ((*(pilot + i) & SkkJisyo::PERFECT_HASH_PILOT_DIRECT) &&
+                                    (static_cast<int>(*(pilot + i) & ~static_cast<uint32_t>(SkkJisyo::PERFECT_HASH_PILOT_DIRECT)) >= table_length))
+                                {
+                                        return false;
+                                }
+                        }
+                        perfect_hash_pilot_ = pilot;
+                        perfect_hash_table_ = reinterpret_cast<const SkkJisyo::PerfectHashEntry*>(extension_ + table_offset);
+                        perfect_hash_bucket_length_ = bucket_length;
+                        perfect_hash_table_length_ = table_length;
+                }
+
+                int sub_block_index_offset = extension_data_header.get(SkkJisyo::ExtensionDataHeader::ID_SUB_BLOCK_INDEX_OFFSET);
+                int sub_block_index_size = extension_data_header.get(SkkJisyo::ExtensionDataHeader::ID_SUB_BLOCK_INDEX_SIZE);
+                int sub_block_offset = extension_data_header.get(SkkJisyo::ExtensionDataHeader::ID_SUB_BLOCK_OFFSET);
+                int sub_block_size = extension_data_header.get(SkkJisyo::ExtensionDataHeader::ID_SUB_BLOCK_SIZE);
+                int sub_block_string_offset = extension_data_header.get(SkkJisyo::ExtensionDataHeader::ID_SUB_BLOCK_STRING_OFFSET);
+                int sub_block_string_size = extension_data_header.get(SkkJisyo::ExtensionDataHeader::ID_SUB_BLOCK_STRING_SIZE);
+                if (sub_block_index_offset > 0)
+                {
+                        const int block_length = normal_block_length_ + special_block_length_;
+                        if ((sub_block_index_offset % 8 != 0) ||
+                            (sub_block_index_size != static_cast<int>(sizeof(int32_t)) * (block_length + 1)) ||
+                            (sub_block_index_offset + sub_block_index_size > extension_data_size) ||
+                            (sub_block_offset <= 0) ||
+                            (sub_block_offset % 8 != 0) ||
+                            (sub_block_size % static_cast<int>(sizeof(SkkJisyo::SubBlock)) != 0) ||
+                            (sub_block_offset + sub_block_size > extension_data_size) ||
+                            (sub_block_string_offset <= 0) ||
+                            (sub_block_string_size <= 0) ||
+                            (sub_block_string_offset + sub_block_string_size > extension_data_size) ||
+                            (*(extension_ + sub_block_string_offset + sub_block_string_size - 1) != ' '))
+                        {
+                                return false;
+                        }
+                        const int32_t *sub_block_index = reinterpret_cast<const int32_t*>(extension_ + sub_block_index_offset);
+                        const SkkJisyo::SubBlock *sub_block = reinterpret_cast<const SkkJisyo::SubBlock*>(extension_ + sub_block_offset);
+                        int sub_block_length = sub_block_size / static_cast<int>(sizeof(SkkJisyo::SubBlock));
+                        if ((*sub_block_index != 0) || (*(sub_block_index + block_length) != sub_block_length))
+                        {
+                                return false;
+                        }
+// ƥ֥åΥ֥֥åϥ֥åƬϤޤꡢեåȤξ
+// ¤Ǥɬפޤ
+                        for (int i = 0; i != block_length; ++i)
+                        {
+                                int start = *(sub_block_index + i);
+                                int end = *(sub_block_index + i + 1);
+                                int data_size = block_ ? (block_ + i)->getDataSize() : (block_short_ + i)->getDataSize();
+                                if ((start > end) ||
+                                    ((start < end) && ((sub_block + start)->offset != 0)))
+                                {
+                                        return false;
+                                }
+                                for (int n = start; n != end; ++n)
+                                {
+                                        if (((n > start) && ((sub_block + n - 1)->offset >= (sub_block + n)->offset)) ||
+                                            ((sub_block + n)->offset >= data_size) ||
+                                            ((sub_block + n)->key_offset < 0) ||
+                                            ((sub_block + n)->key_offset >= sub_block_string_size))
+                                        {
+                                                return false;
+                                        }
+                                }
+                        }
+                        sub_block_index_ = sub_block_index;
+                        sub_block_ = sub_block;
+                        sub_block_string_ = extension_ + sub_block_string_offset;
+                        sub_block_string_size_ = sub_block_string_size;
+                }
+                return true;
+        }
+
+/// block ܤΥ֥åκǸΡָФ string  encoded_midasi Ӥޤͤ SkkUtility::compareMidasi() ƱǤ
+/**
+ * ĥǡ˥ץեåСޤӤ
+ * ʸӤޤ string ϥǥåǡؤ
+ * ɬפޤ
+ */
+        int compare_block_midasi(const char *string, int block, const char *encoded_midasi, int encoded_midasi_size, uint64_t midasi_prefix) const
+        {
+                if (key_prefix_)
+                {
+                        uint64_t key_prefix = *(key_prefix_ + block);
+                        if (key_prefix < midasi_prefix)
+                        {
+                                return -1;
+                        }
+                        if (key_prefix > midasi_prefix)
+                        {
+                                return 1;
+                        }
+                }
+                return SkkUtility::compareMidasi(string, 0, static_cast<int>(index_ + index_size_ - string), encoded_midasi, encoded_midasi_size);
+        }
+
+/// start_block  block_length ĤΥ֥å encoded_midasi ޤ֥åõޤդХ֥åΥǥå (0  block_length - 1) 򡢸դʤ -1 ֤ޤ
+/**
+ * string  start_block ܤΥ֥åκǸΡָФפǤ
+ * dispatch_row ϥեåɥ쥤ǥåü쥨ȥʤ
+ * SkkJisyo::DISPATCH_ROW_SPECIAL Ǥ
+ *
+ * ĥǡ˥եåȤХХʥꥵʤʸ
+ * ǼΰƬõޤǥѥåơ֥뤬ХХ
+ * ꥵϰϤ򶹤ޤü쥨ȥ 1 ʸܤȤΥ֥å
+ * ϤХǥѥåơ֥ˤȤޤ
+ *
+ * exact_flag ʤ encoded_midasi Ȱפ븫Фõ
+ * Ȥü쥨ȥ 1 ʸܤ¸ߤʤХ֥åõ -1
+ * ֤ޤ
+ */
+        int find_block(const char *string, int start_block, int block_length, int dispatch_row, const char *encoded_midasi, int encoded_midasi_size, uint64_t midasi_prefix, bool exact_flag) const
+        {
+                if (key_offset_)
+                {
+                        int low = 0;
+                        int high = block_length;
+                        if (special_array_ && (dispatch_row == SkkJisyo::DISPATCH_ROW_SPECIAL))
+                        {
+                                int index = find_special_array(static_cast<uint16_t>(midasi_prefix >> 48));
+                                if ((index < special_array_length_) && ((special_array_ + index)->character == static_cast<uint16_t>(midasi_prefix >> 48)))
+                                {
+// ϰϤμΥ֥åκǸθФϡɬʸǻϤޤɤθФ
+// 礭ʤޤ
+                                        low = (special_array_ + index)->start_block;
+                                        high = low + (special_array_ + index)->block_length + 1;
+                                        if (high > block_length)
+                                        {
+                                                high = block_length;
+                                        }
+                                }
+                                else
+                                {
+                                        if (exact_flag)
+                                        {
+                                                return -1;
+                                        }
+                                        return (index < special_array_length_) ? (special_array_ + index)->start_block : -1;
+                                }
+                        }
+                        else if (dispatch_row_index_ && (*(dispatch_row_index_ + dispatch_row) >= 0))
+                        {
+                                const uint16_t *row = dispatch_row_ + *(dispatch_row_index_ + dispatch_row) * SkkJisyo::DISPATCH_ROW_SIZE;
+                                int column = SkkJisyo::getDispatchIndex(midasi_prefix, dispatch_row == SkkJisyo::DISPATCH_ROW_SPECIAL);
+                                low = *(row + column);
+                                if ((column + 1 < SkkJisyo::DISPATCH_ROW_SIZE) && (*(row + column + 1) < block_length))
+                                {
+// κǽΥ֥åޤǤõϰϤǤ
+                                        high = *(row + column + 1) + 1;
+                                }
+                        }
+                        while (low < high)
+                        {
+                                int middle = (low + high) / 2;
+                                if (compare_block_midasi(string_ + *(key_offset_ + start_block + middle),
+                                                         start_block + middle,
+                                                         encoded_midasi,
+                                                         encoded_midasi_size,
+                                                         midasi_prefix) < 0)
+                                {
+                                        low = middle + 1;
+                                }
+                                else
+                                {
+                                        high = middle;
+                                }
+                        }
+                        return (low < block_length) ? low : -1;
+                }
+                for (int i = 0; i != block_length; ++i)
+                {
+                        if (compare_block_midasi(string, start_block + i, encoded_midasi, encoded_midasi_size, midasi_prefix) >= 0)
+                        {
+                                return i;
+                        }
+                        string = skip_space(string);
+                }
+                return -1;
+        }
+
+/// character ʾȤʤǽ special_array_ Υǥå֤ޤʤ special_array_length_ ֤ޤ
+        int find_special_array(uint16_t character) const
+        {
+                int low = 0;
+                int high = special_array_length_;
+                while (low < high)
+                {
+                        int middle = (low + high) / 2;
+                        if ((special_array_ + middle)->character < character)
+                        {
+                                low = middle + 1;
+                        }
+                        else
+                        {
+                                high = middle;
+                        }
+                }
+                return low;
+        }
+
+/// raw_index_ ΤФ key ʾȤʤǽΰ֤֤ޤ
+        int get_raw_lower_bound(const char *key) const
+        {
+                const int key_size = SkkUtility::getTerminatedMidasiSize(key);
+                int low = 0;
+                int high = raw_index_length_;
+                while (low < high)
+                {
+                        int middle = (low + high) / 2;
+                        if (SkkUtility::compareMidasi(raw_buffer_, *(raw_index_ + middle), raw_buffer_size_, key, key_size) < 0)
+                        {
+                                low = middle + 1;
+                        }
+                        else
+                        {
+                                high = middle;
+                        }
+                }
+                return low;
+        }
+
+/// 1 ԸιƬؤΥݥ󥿤֤ޤ
+        static const char *get_next_line(const char *p)
+        {
+                return SkkUtility::getNextPointer<'\n'>(p);
+        }
+
+        static const char *skip_space(const char *p)
+        {
+                return SkkUtility::getNextPointer<' '>(p);
+        }
+
+private:
+        time_t mtime_;
+        char *index_;
+        char *extension_;
+        const uint64_t *key_prefix_;
+        const int32_t *key_offset_;
+        const int32_t *dispatch_row_index_;
+        const uint16_t *dispatch_row_;
+        const SkkJisyo::SpecialArray *special_array_;
+        const uint64_t *bloom_filter_;
+        const uint32_t *perfect_hash_pilot_;
+        const SkkJisyo::PerfectHashEntry *perfect_hash_table_;
+        const int32_t *sub_block_index_;
+        const SkkJisyo::SubBlock *sub_block_;
+        const char *sub_block_string_;
+        char *trie_buffer_;
+        const int32_t *trie_entry_;
+        const int32_t *trie_base_;
+        const int32_t *trie_check_;
+        const char *candidate_string_;
+        const int32_t *candidate_offset_;
+        const int32_t *candidate_entry_reference_;
+        const unsigned char *candidate_reference_;
+        char *raw_buffer_;
+        const int32_t *raw_index_;
+        SkkJisyo::FixedArray *fixed_array_;
+        SkkJisyo::Block *block_;
+        SkkJisyo::BlockShort *block_short_;
+        char *string_;
+        int file_descriptor_;
+        int index_size_;
+        int normal_block_length_;
+        int special_block_length_;
+        int special_array_length_;
+        int bloom_filter_bit_length_;
+        int bloom_filter_hash_length_;
+        int perfect_hash_bucket_length_;
+        int perfect_hash_table_length_;
+        int sub_block_string_size_;
+        int trie_buffer_size_;
+        int trie_entry_length_;
+        int trie_node_length_;
+        int candidate_length_;
+        int candidate_buffer_size_;
+        int raw_buffer_size_;
+        int raw_index_length_;
+        int normal_string_size_;
+        int special_entry_offset_;
+        int block_size_;
+        int reply_record_size_;
+        int reference_count_;
+};
+
+/// yaskkserv Ѽ񥯥饹Ǥ
+/**
+ * Υǥåȥǡ SkkDictionaryImage ֤Υ饹
+ * õξ (ߤΥȥꡢ֥åɤ߹ߥХåեȰ) 
+ * ޤ share() Ʊ᡼ͭ륪֥ȤС
+ * ǥåʣ˥åɤȤõ˻Ȥޤ 1 ĤΥ֥
+ * ȤʣΥåɤƱ˻ȤäƤϤʤޤ
+ */
+class SkkDictionary
+{
+        SkkDictionary(SkkDictionary &source);
+        SkkDictionary& operator=(SkkDictionary &source);
+
+public:
+        virtual ~SkkDictionary()
+        {
+                close();
+        }
+
+        SkkDictionary() :
+                mtime_(),
+                image_(0),
+                read_buffer_(0),
+                candidate_buffer_(0),
+                midasi_(0),
+                henkanmojiretsu_(0),
+                before_read_offset_(-1),
+                before_read_size_(0),
+                trie_entry_index_(0),
+                raw_entry_index_(0),
+                raw_group_end_(0),
+                midasi_size_(0),
+                henkanmojiretsu_size_(0),
+                last_read_offset_start_(0),
+                last_read_index_(0),
+                last_start_block_(0),
+                last_block_length_(0),
+                last_block_index_(0),
+                last_search_result_(false),
+                read_count_(0),
+                read_byte_size_(0),
+                raw_midasi_()
+        {
+        }
+
+        bool open(const char *filename)
+        {
+                close();
+                SkkDictionaryImage *image = new SkkDictionaryImage();
+                if (!image->open(filename))
+                {
+                        delete image;
+                        return false;
+                }
+                attach(image);
+                return true;
+        }
+
+/// source Ƥ뼭Υ᡼ͭƳޤ source Ƥʤе֤ޤ
+/**
+ * ե򳫤ľǥåʣޤ󡣤Υ֥
+ *  source ΩõǤ source ĤƤ⤫ޤޤ
+ */
+        bool share(const SkkDictionary &source)
+        {
+                if (&source == this)
+                {
+                        return image_ != 0;
+                }
+                close();
+                if (source.image_ == 0)
+                {
+                        return false;
+                }
+                source.image_->acquire();
+                attach(source.image_);
+                return true;
+        }
+
+        bool close()
+        {
+                if (image_ && image_->release())
+                {
+                        delete image_;
+                }
+                delete[] read_buffer_;
+                delete[] candidate_buffer_;
+
+                mtime_ = 0;
+                image_ = 0;
+                read_buffer_ = 0;
+                candidate_buffer_ = 0;
                 before_read_offset_ = -1;
-                index_size_ = 0;
-                normal_block_length_ = 0;
-                special_block_length_ = 0;
-                normal_string_size_ = 0;
-                special_entry_offset_ = 0;
-                midasi_size_ = 0;
-                henkanmojiretsu_size_ = 0;
-                block_size_ = 0;
+                before_read_size_ = 0;
+                trie_entry_index_ = 0;
+                raw_entry_index_ = 0;
+                raw_group_end_ = 0;
                 last_read_offset_start_ = 0;
                 last_read_index_ = 0;
                 last_start_block_ = 0;
                 last_block_length_ = 0;
                 last_block_index_ = 0;
+                read_count_ = 0;
+                read_byte_size_ = 0;
+                reset_entry();
+
+                return true;
+        }
+
+/// source ȳƤ뼭ؤޤ
+/**
+ * 򳫤ľȤ̤Υ֥Ȥǳ򤳤Υ֥
+ * ؤ뤿˻Ȥޤ᡼ؤλȤȥХåեνͭ
+ * ؤΤǡؤ source  close() ޤ˴и
+ * ǤޤŤ᡼ share() ǶͭƤ¾Υ
+ * ȤС᡼Ϥ餬ĤޤǻĤޤ
+ *
+ * õξ֤ϰѤξȤõ˼Ԥ֤ˤʤޤ
+ * ɤ߹ߤפؤޤ
+ */
+        void swap(SkkDictionary &source)
+        {
+                swap_member(mtime_, source.mtime_);
+                swap_member(image_, source.image_);
+                swap_member(read_buffer_, source.read_buffer_);
+                swap_member(candidate_buffer_, source.candidate_buffer_);
+                swap_member(before_read_offset_, source.before_read_offset_);
+                swap_member(before_read_size_, source.before_read_size_);
+                reset_entry();
+                source.reset_entry();
+        }
+
+/// п֤ޤ񤬹Ƥ update_flag ˿֤ޤ˼Ԥ update_flag ˿ޤ
+/**
+ * åץǡȥåˤϡ
+ *
+ * ּե˼¹Ԥ줿þ
+ *
+ * Ȥ礭꤬뤳ȤդɬפǤ
+ */
+        bool isUpdateDictionary(bool &update_flag, const char *filename)
+        {
+                bool result;
+                struct stat stat_work;
+                if (stat(filename, &stat_work) == -1)
+                {
+                        result = false;
+                }
+                else
+                {
+                        result = true;
+                        if (mtime_ != stat_work.st_mtime)
+                        {
+                                mtime_ = stat_work.st_mtime;
+                                update_flag = true;
+                        }
+                        else
+                        {
+                                update_flag = false;
+                        }
+                }
+                return result;
+        }
+
+/// midasi ǻꤷȥõޤդп֤ޤ
+        bool search(const char *midasi)
+        {
+                last_search_result_ = search_system_call<false>(midasi);
+                return last_search_result_;
+        }
+
+/// midasi ǻꤷʸ 1 ʸܤбǽΥȥõޤդп֤ޤ
+        bool searchForFirstCharacter(const char *midasi)
+        {
+                last_search_result_ = search_system_call<true>(midasi);
+                return last_search_result_;
+        }
+
+/// Υȥõޤդп֤ޤ
+        bool searchNextEntry()
+        {
+                last_search_result_ = search_next_entry_system_call();
+                return last_search_result_;
+        }
+
+///  search() ޤ searchNextEntry() Ƥ뤫ɤ֤ޤƤп֤ޤ
+        bool isSuccess() const
+        {
+                return last_search_result_;
+        }
+
+/// search() ޤ searchNextEntry() ǺǸȯָФפΥ֤ޤ˲ʸϴޤߤޤ
+        int getMidasiSize() const
+        {
+                return midasi_size_;
+        }
+
+/// search() ޤ searchNextEntry() ǺǸȯָФפΥݥ󥿤֤ޤ
+        const char *getMidasiPointer() const
+        {
+                return midasi_;
+        }
+
+/// search() ޤ searchNextEntry() ǺǸȯѴʸפΥ֤ޤ˲ʸϴޤߤޤ
+        int getHenkanmojiretsuSize() const
+        {
+                return henkanmojiretsu_size_;
+        }
+
+/// search() ޤ searchNextEntry() ǺǸȯѴʸפΥݥ󥿤֤ޤ
+        const char *getHenkanmojiretsuPointer() const
+        {
+                return henkanmojiretsu_;
+        }
+
+/// õΤ˥֥å read() ȹפΥХȿ֤ޤ
+        void getReadStatistics(int64_t &count, int64_t &byte_size) const
+        {
+                count = read_count_;
+                byte_size = read_byte_size_;
+        }
+
+/// getHenkanmojiretsuPointer() - 1  '1' ꡢ getHenkanmojiretsuSize() + 2 ХȤ򤽤ΤޤޱȤ뼭ʤп֤ޤ
+        bool isReplyRecord() const
+        {
+                return (image_ && (image_->reply_record_size_ > 0)) || (candidate_buffer_ != 0);
+        }
+
+private:
+        template<typename T> static void swap_member(T &a, T &b)
+        {
+                T tmp = a;
+                a = b;
+                b = tmp;
+        }
+
+/// ߤΥȥʤ֤ˤޤ
+        void reset_entry()
+        {
+                midasi_ = 0;
+                henkanmojiretsu_ = 0;
+                midasi_size_ = 0;
+                henkanmojiretsu_size_ = 0;
                 last_search_result_ = false;
+        }
+
+/// image 򻲾ȤõɬפʥХåեݤޤ image λȤϸƤӽФ¦ 1 䤷Ƥɬפޤ
+        void attach(SkkDictionaryImage *image)
+        {
+                image_ = image;
+                mtime_ = image->mtime_;
+                if (image->block_size_ > 0)
+                {
+                        const int margin = 32;
+                        read_buffer_ = new char[image->block_size_ + margin];
+                }
+                if (image->candidate_buffer_size_ > 0)
+                {
+// Ƭ 1 ХȤϱ '1' ǡѴʸפϤθ
+// 
+                        candidate_buffer_ = new char[image->candidate_buffer_size_];
+                        *candidate_buffer_ = '1';
+                }
+        }
+
+        template<bool is_first> bool search_system_call(const char *midasi)
+        {
+                DEBUG_ASSERT_POINTER(midasi);
+                if (image_ == 0)
+                {
+                        return false;
+                }
+                if (image_->trie_base_)
+                {
+                        return search_trie(midasi, is_first);
+                }
+                if (image_->raw_index_)
+                {
+                        return search_raw(midasi, is_first);
+                }
+
+                const int margin = 8;
+                char encoded_midasi[SkkUtility::ENCODED_MIDASI_BUFFER_SIZE];
+                int encoded_size = SkkUtility::encodeHiragana(midasi, encoded_midasi, sizeof(encoded_midasi) - margin);
+                if (encoded_size == 0)
+                {
+                        encoded_midasi[0] = '\1';
+                        int i;
+                        for (i = 0; i < static_cast<int>(sizeof(encoded_midasi)) - margin; ++i)
+                        {
+                                if ((*(midasi + i) == ' ') || (*(midasi + i) == '\0'))
+                                {
+                                        goto FOUND_TERMINATOR;
+                                }
+                                encoded_midasi[i + 1] = *(midasi + i);
+                        }
+
+                        return false;
+
+                FOUND_TERMINATOR:
+                        encoded_midasi[i + 1] = '\0';
+                }
+                else
+                {
+                        encoded_midasi[encoded_size] = '\0';
+                }
+
+                const int encoded_midasi_size = SkkUtility::getTerminatedMidasiSize(encoded_midasi);
+                const uint64_t midasi_hash = SkkUtility::getMidasiHash(encoded_midasi);
+                if ((!is_first) &&
+                    image_->bloom_filter_ &&
+                    (!SkkJisyo::testBloomFilter(image_->bloom_filter_, image_->bloom_filter_bit_length_, image_->bloom_filter_hash_length_, midasi_hash)))
+                {
+// ¸ߤʤФʤΤǥ֥åɤޤ˽ޤ
+                        return false;
+                }
+
+                const uint64_t midasi_prefix = SkkUtility::getMidasiPrefix(encoded_midasi);
+                int fixed_array_index = SkkUtility::getFixedArrayIndex(encoded_midasi);
+                DEBUG_ASSERT_RANGE(fixed_array_index, -1, 0xff);
+                int start_block;
+                int block_length;
+                int read_offset_start;
+                const char *string;
+                if (fixed_array_index == -1)
+                {
+// special
+                        start_block = image_->normal_block_length_;
+                        block_length = image_->special_block_length_;
+                        read_offset_start = image_->special_entry_offset_;
+                        string = image_->string_ + image_->normal_string_size_;
+                }
+                else
+                {
+// normal
+                        start_block = (image_->fixed_array_ + fixed_array_index)->start_block;
+                        block_length = (image_->fixed_array_ + fixed_array_index)->block_length;
+                        read_offset_start = 0;
+                        string = image_->string_ + (image_->fixed_array_ + fixed_array_index)->string_data_offset;
+                }
+
+                int i;
+                int line_index = -1;
+                if ((!is_first) && image_->perfect_hash_table_)
+                {
+// ϥåǸФΰ֤ޤФ¸ߤǽ
+// Ϥΰ֤Ǥ
+                        const SkkJisyo::PerfectHashEntry *entry = image_->perfect_hash_table_ + SkkJisyo::getPerfectHashSlot(midasi_hash,
+                                                                                                                     *(image_->perfect_hash_pilot_ + SkkJisyo::getPerfectHashBucket(midasi_hash, image_->perfect_hash_bucket_length_)),
+                                                                                                                     image_->perfect_hash_table_length_);
+                        i = entry->block - start_block;
+                        if ((i < 0) || (i >= block_length))
+                        {
+                                return false;
+                        }
+                        line_index = entry->offset;
+                }
+                else
+                {
+                        i = image_->find_block(string,
+                                       start_block,
+                                       block_length,
+                                       (fixed_array_index == -1) ? SkkJisyo::DISPATCH_ROW_SPECIAL : fixed_array_index,
+                                       encoded_midasi,
+                                       encoded_midasi_size,
+                                       midasi_prefix,
+                                       !is_first);
+                        if (i < 0)
+                        {
+                                return false;
+                        }
+                }
+
+                int read_size;
+                int read_offset;
+                if (image_->block_)
+                {
+                        read_size = (image_->block_ + start_block + i)->getDataSize();
+                        read_offset = read_offset_start + (image_->block_ + start_block + i)->getOffset();
+                }
+                else
+                {
+                        read_size = (image_->block_short_ + start_block + i)->getDataSize();
+                        read_offset = (start_block + i) * image_->block_size_;
+                }
+
+                int slice_offset = 0;
+                int slice_size = read_size;
+                if (image_->sub_block_)
+                {
+// ֥֥åС֥åΤФޤॵ֥֥å
+// ɤߤޤ
+                        image_->get_sub_block_range(start_block + i,
+                                            read_size,
+                                            is_first ? 0 : encoded_midasi,
+                                            encoded_midasi_size,
+                                            line_index,
+                                            slice_offset,
+                                            slice_size);
+                }
+
+                if ((before_read_offset_ >= 0) &&
+                    (before_read_offset_ <= read_offset + slice_offset) &&
+                    (read_offset + slice_offset + slice_size <= before_read_offset_ + before_read_size_))
+                {
+// cached
+                }
+                else
+                {
+                        if (!read_block(read_offset + slice_offset, slice_size))
+                        {
+                                return false;
+                        }
+                }
+// read_buffer_ Ƭϥ֥åƬ buffer_offset ХȤΰ֤
+// ޤ
+                const int buffer_offset = before_read_offset_ - read_offset;
+                read_size = before_read_size_;
+
+                if (is_first)
+                {
+                        DEBUG_ASSERT(buffer_offset == 0);
+                        int index = 0;
+                        set_entry(read_buffer_, index, read_size);
+                        last_read_offset_start_ = read_offset_start;
+                        last_read_index_ = index;
+                        last_start_block_ = start_block;
+                        last_block_length_ = block_length;
+                        last_block_index_ = i;
+                        return true;
+                }
+                else
+                {
+                        int index;
+                        if (line_index >= 0)
+                        {
+// ϥåǵ᤿֤ȹ礷ޤ
+                                line_index -= buffer_offset;
+                                if ((line_index >= 0) &&
+                                    (line_index < read_size) &&
+                                    (SkkUtility::compareMidasi(read_buffer_, line_index, read_size, encoded_midasi, encoded_midasi_size) == 0))
+                                {
+                                        index = line_index;
+                                        set_entry(read_buffer_, index, read_size);
+                                        last_read_offset_start_ = read_offset_start;
+                                        last_read_index_ = index;
+                                        last_start_block_ = start_block;
+                                        last_block_length_ = block_length;
+                                        last_block_index_ = i;
+                                        return true;
+                                }
+                                return false;
+                        }
+
+                        if (SkkUtility::searchBinary(read_buffer_, read_size, encoded_midasi, index))
+                        {
+                                DEBUG_ASSERT(index >= 0);
+                                set_entry(read_buffer_, index, read_size);
+                                last_read_offset_start_ = read_offset_start;
+                                last_read_index_ = index;
+                                last_start_block_ = start_block;
+                                last_block_length_ = block_length;
+                                last_block_index_ = i;
+                                return true;
+                        }
+
+                        if (SkkUtility::searchLinear(read_buffer_, read_size, encoded_midasi, index))
+                        {
+                                DEBUG_ASSERT(index >= 0);
+                                set_entry(read_buffer_, index, read_size);
+                                last_read_offset_start_ = read_offset_start;
+                                last_read_index_ = index;
+                                last_start_block_ = start_block;
+                                last_block_length_ = block_length;
+                                last_block_index_ = i;
+                                return true;
+                        }
+
+                        return false;
+                }
+        }
+
+/// ȥ饤 midasi õޤ is_first ʤ midasi ǻϤޤǽΥȥõޤդп֤ޤ
+/**
+ * ȥ饤ΥϥǥɤФʤΤǡ midasi 򥨥󥳡ɤ
+ * Τޤܤޤʬڤ˴ޤޤ븫Ф midasi ǻϤ
+ * 븫ФΤ٤Ƥǡȥ饤ͤϢ³ޤ
+ */
+        bool search_trie(const char *midasi, bool is_first)
+        {
+                int size;
+                for (size = 0; (*(midasi + size) != ' ') && (*(midasi + size) != '\0'); ++size)
+                {
+                }
+                int node = SkkDoubleArray::traverse(image_->trie_base_, image_->trie_check_, image_->trie_node_length_, 0, midasi, size);
+                if (node < 0)
+                {
+                        return false;
+                }
+                int entry;
+                if (is_first)
+                {
+                        entry = SkkDoubleArray::getFirstValue(image_->trie_base_, image_->trie_check_, image_->trie_node_length_, node);
+                }
+                else
+                {
+                        entry = SkkDoubleArray::getValue(image_->trie_base_, image_->trie_check_, image_->trie_node_length_, node);
+                }
+                return set_trie_entry(entry);
+        }
+
+/// SKK 񤽤ΤΤ򳫤 midasi õޤ is_first ʤ midasi  1 ʸܤǻϤޤǽΥȥõޤդп֤ޤ
+/**
+ * õ searchNextEntry() ϡ֥åñ̤ΥǥåƱͤ
+ * midasi  1 ʸܤǻϤޤ륨ȥϰϤǼΥȥ֤ޤ
+ */
+        bool search_raw(const char *midasi, bool is_first)
+        {
+                const int c = *midasi & 0xff;
+                if ((c == ' ') || (c == '\0'))
+                {
+                        return false;
+                }
+                int prefix_size = (c == 0x8f) ? 3 : ((c & 0x80) ? 2 : 1);
+// 1 ʸ ( 3 Х) ȽüɤʬǤ
+                char prefix[4];
+                for (int i = 0; i != prefix_size; ++i)
+                {
+                        if ((*(midasi + i) == ' ') || (*(midasi + i) == '\0'))
+                        {
+                                prefix_size = i;
+                                break;
+                        }
+                        prefix[i] = *(midasi + i);
+                }
+                prefix[prefix_size] = ' ';
 
+                int entry = image_->get_raw_lower_bound(is_first ? prefix : midasi);
+                if (entry >= image_->raw_index_length_)
+                {
+                        return false;
+                }
+                if ((!is_first) && (SkkUtility::compareMidasi(image_->raw_buffer_, *(image_->raw_index_ + entry), image_->raw_buffer_size_, midasi, SkkUtility::getTerminatedMidasiSize(midasi)) != 0))
+                {
+                        return false;
+                }
+// compareMidasi() Ϻǽ˰ۤʤ + 1 ֤Τǡ prefix_size 
+// ǰۤʤ (ޤ) Ф prefix ǻϤޤޤ
+                int low = entry;
+                int high = image_->raw_index_length_;
+                while (low < high)
+                {
+                        int middle = (low + high) / 2;
+                        int tmp = SkkUtility::compareMidasi(image_->raw_buffer_, *(image_->raw_index_ + middle), image_->raw_buffer_size_, prefix, prefix_size + 1);
+                        if ((tmp == 0) || (tmp > prefix_size))
+                        {
+                                low = middle + 1;
+                        }
+                        else
+                        {
+                                high = middle;
+                        }
+                }
+                raw_group_end_ = low;
+                return set_raw_entry(entry);
+        }
+
+/// raw_index_  entry ܤΥȥ򸽺ߤΥȥˤޤõϰϤγʤе֤ޤ
+/**
+ * ָФפϥ󥳡ɤʤФƱ '\\1' ֤֤ᡢ
+ * getMidasiPointer()  SkkUtility::decodeHiragana() ϤϤ
+ * ޤưޤ
+ */
+        bool set_raw_entry(int entry)
+        {
+                if ((entry < 0) || (entry >= raw_group_end_))
+                {
+                        return false;
+                }
+                set_entry(image_->raw_buffer_, *(image_->raw_index_ + entry), image_->raw_buffer_size_);
+                const int raw_code = 1; // \1 ʬ
+                raw_midasi_[0] = '\1';
+                for (int i = 0; i != midasi_size_; ++i)
+                {
+                        raw_midasi_[raw_code + i] = *(midasi_ + i);
+                }
+                raw_midasi_[raw_code + midasi_size_] = ' ';
+                midasi_ = raw_midasi_;
+                midasi_size_ += raw_code;
+                raw_entry_index_ = entry;
                 return true;
         }
 
-/// 1 ԸιƬؤΥݥ󥿤֤ޤ
-        static const char *get_next_line(const char *p)
+/// buffer  index ϤޤԤ򸽺ߤΥȥˤޤ쥳ɤμǤϡѴʸפ '1' Фޤ
+        void set_entry(const char *buffer, int index, int size)
         {
-                return SkkUtility::getNextPointer<'\n'>(p);
+                midasi_ = buffer + index;
+                midasi_size_ = SkkUtility::getMidasiSize(buffer, index, size);
+                henkanmojiretsu_ = SkkUtility::getHenkanmojiretsuPointer(buffer, index, size) + image_->reply_record_size_;
+                henkanmojiretsu_size_ = SkkUtility::getHenkanmojiretsuSize(buffer, index, size) - image_->reply_record_size_;
         }
 
-        static const char *skip_space(const char *p)
+/// ȥ饤 entry ܤΥȥ򸽺ߤΥȥˤޤϰϳʤе֤ޤ
+        bool set_trie_entry(int entry)
         {
-                return SkkUtility::getNextPointer<' '>(p);
+                if ((entry < 0) || (entry >= image_->trie_entry_length_))
+                {
+                        return false;
+                }
+                int index = *(image_->trie_entry_ + entry);
+                if (candidate_buffer_)
+                {
+// ס뤫ѴʸפޤƬ 1 ХȤ open 
+// ˽񤤤 '1' ǡԤޤǤ򤽤ΤޤޱȤ send() Ǥޤ
+                        const int protocol_size = 1;
+                        const int cr_size = 1;
+                        int size = SkkCandidatePool::decode(image_->candidate_string_,
+                                                            image_->candidate_offset_,
+                                                            image_->candidate_length_,
+                                                            image_->candidate_reference_,
+                                                            *(image_->candidate_entry_reference_ + entry),
+                                                            *(image_->candidate_entry_reference_ + entry + 1),
+                                                            candidate_buffer_ + protocol_size,
+                                                            image_->candidate_buffer_size_ - protocol_size - cr_size);
+                        if (size < 0)
+                        {
+                                return false;
+                        }
+                        *(candidate_buffer_ + protocol_size + size) = '\n';
+                        midasi_ = image_->trie_buffer_ + index;
+                        midasi_size_ = SkkUtility::getMidasiSize(image_->trie_buffer_, index, image_->trie_buffer_size_);
+                        henkanmojiretsu_ = candidate_buffer_ + protocol_size;
+                        henkanmojiretsu_size_ = size;
+                }
+                else
+                {
+                        set_entry(image_->trie_buffer_, index, image_->trie_buffer_size_);
+                }
+                trie_entry_index_ = entry;
+                return true;
+        }
+
+        bool search_next_entry_system_call()
+        {
+                if (image_ == 0)
+                {
+                        return false;
+                }
+                if (image_->trie_base_)
+                {
+                        return last_search_result_ && set_trie_entry(trie_entry_index_ + 1);
+                }
+                if (image_->raw_index_)
+                {
+                        return last_search_result_ && set_raw_entry(raw_entry_index_ + 1);
+                }
+
+                if ((!last_search_result_) || (last_block_index_ >= last_block_length_))
+                {
+                        return false;
+                }
+
+                int read_size;
+                int read_offset;
+                if (image_->block_)
+                {
+                        read_size = (image_->block_ + last_start_block_ + last_block_index_)->getDataSize();
+                        read_offset = last_read_offset_start_ + (image_->block_ + last_start_block_ + last_block_index_)->getOffset();
+                }
+                else
+                {
+                        read_size = (image_->block_short_ + last_start_block_ + last_block_index_)->getDataSize();
+                        read_offset = (last_start_block_ + last_block_index_) * image_->block_size_;
+                }
+
+                last_read_index_ = SkkUtility::getNextLineIndex(read_buffer_, last_read_index_, before_read_size_);
+                if ((last_read_index_ < 0) && (before_read_offset_ + before_read_size_ < read_offset + read_size))
+                {
+// ֥֥åɤǤϡ֥åλĤɤߤޤ
+                        int read_end = before_read_offset_ + before_read_size_;
+                        if (!read_block(read_end, read_offset + read_size - read_end))
+                        {
+                                return false;
+                        }
+                }
+                else if (last_read_index_ < 0)
+                {
+                        ++last_block_index_;
+                        if (last_block_index_ >= last_block_length_)
+                        {
+                                return false;
+                        }
+
+                        if (image_->block_)
+                        {
+                                read_size = (image_->block_ + last_start_block_ + last_block_index_)->getDataSize();
+                                read_offset = last_read_offset_start_ + (image_->block_ + last_start_block_ + last_block_index_)->getOffset();
+                        }
+                        else
+                        {
+                                read_size = (image_->block_short_ + last_start_block_ + last_block_index_)->getDataSize();
+                                read_offset = (last_start_block_ + last_block_index_) * image_->block_size_;
+                        }
+
+                        if (!read_block(read_offset, read_size))
+                        {
+                                return false;
+                        }
+                }
+
+                set_entry(read_buffer_, last_read_index_, before_read_size_);
+                return true;
+        }
+
+/// ե read_offset  read_size ХȤ read_buffer_ ɤ߹ߤޤԤϵ֤ޤ
+/**
+ * եǥץƱ᡼ͭ뤹٤ƤΥ֥
+ * ǶѤ뤿ᡢե륪եåȤưʤ pread() ɤߤޤ
+ */
+        bool read_block(int read_offset, int read_size)
+        {
+                before_read_offset_ = -1;
+                int read_result = static_cast<int>(pread(image_->file_descriptor_, read_buffer_, static_cast<size_t>(read_size), read_offset));
+                if (read_result != read_size)
+                {
+                        DEBUG_PRINTF("#### FAILED pread() ERROR!!  read_size = %d  read_result = %d\n",
+                                     read_size,
+                                     read_result);
+                        return false;
+                }
+                before_read_offset_ = read_offset;
+                before_read_size_ = read_size;
+                last_read_index_ = 0;
+                ++read_count_;
+                read_byte_size_ += read_size;
+                return true;
         }
 
 private:
         time_t mtime_;
+        SkkDictionaryImage *image_;
         char *read_buffer_;
-        char *index_;
-        SkkJisyo::FixedArray *fixed_array_;
-        SkkJisyo::Block *block_;
-        SkkJisyo::BlockShort *block_short_;
-        char *string_;
+        char *candidate_buffer_;
         const char *midasi_;
         const char *henkanmojiretsu_;
-        int file_descriptor_;
         int before_read_offset_;
-        int index_size_;
-        int normal_block_length_;
-        int special_block_length_;
-        int normal_string_size_;
-        int special_entry_offset_;
+        int before_read_size_;
+        int trie_entry_index_;
+        int raw_entry_index_;
+        int raw_group_end_;
         int midasi_size_;
         int henkanmojiretsu_size_;
-        int block_size_;
         int last_read_offset_start_;
         int last_read_index_;
         int last_start_block_;
         int last_block_length_;
         int last_block_index_;
         bool last_search_result_;
+        int64_t read_count_;
+        int64_t read_byte_size_;
+        char raw_midasi_[SkkUtility::ENCODED_MIDASI_BUFFER_SIZE];
 };
 }
 
@@ -0,0 +1,295 @@
+/*
+  Copyright (C) 2005-2021 Tadashi Watanabe <twacc2020@gmail.com>
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#ifndef SKK_DICTIONARY_RELOADER_H
+#define SKK_DICTIONARY_RELOADER_H
+
+#include "skk_architecture.hpp"
+#include "skk_dictionary.hpp"
+
+namespace YaSkkServ
+{
+/// 줿Хå饦ɤΥåɤǳľƤӽФ¦ΥåɤǺؤ륯饹Ǥ
+/**
+ * request() ǻꤷ start() ǥåɤο SkkDictionary ˳
+ * ǥեιȥѤäƤʤȤΤޤ
+ * ȥѥפ 1 ХȽ񤭹Τǡ getFileDescriptor() 
+ * select() ˲äƤиƤӽФ¦Ԥ˺Ѥߤޤ
+ *
+ * isFinished() ˤʤä finish() ǡľȻ
+ *  SkkDictionary::swap() ؤŤޤ
+ * ؤϥݥ󥿤θ򴹤ʤΤǡõι֤Ǥõߤ᤺˼
+ * 򺹤ؤޤľ˼ԤϺؤޤ
+ *
+ * YASKKSERV_CONFIG_HAVE_PTHREAD Ƥʤ start() 
+ * ľޤ
+ */
+class SkkDictionaryReloader
+{
+        SkkDictionaryReloader(SkkDictionaryReloader &source);
+        SkkDictionaryReloader& operator=(SkkDictionaryReloader &source);
+
+public:
+        enum Result
+        {
+                RESULT_NONE,
+                RESULT_SWAPPED,
+                RESULT_FAILED
+        };
+
+        virtual ~SkkDictionaryReloader()
+        {
+                if (running_flag_)
+                {
+                        join();
+                }
+                for (int i = 0; i != length_; ++i)
+                {
+                        delete *(fresh_ + i);
+                }
+                delete[] fresh_;
+                delete[] result_;
+                delete[] request_;
+                if (pipe_[0] != -1)
+                {
+                        close(pipe_[0]);
+                        close(pipe_[1]);
+                }
+        }
+
+        SkkDictionaryReloader() :
+                fresh_(0),
+                filename_table_(0),
+                result_(0),
+                request_(0),
+#ifdef YASKKSERV_CONFIG_HAVE_PTHREAD
+                thread_(),
+#endif  // YASKKSERV_CONFIG_HAVE_PTHREAD
+                length_(0),
+                running_flag_(false),
+                finished_flag_(false)
+        {
+                pipe_[0] = -1;
+                pipe_[1] = -1;
+        }
+
+/// length Ĥμ򰷤褦ˤޤԤϵ֤ޤ
+        bool initialize(int length)
+        {
+                if ((length_ != 0) || (length <= 0) || (pipe(pipe_) == -1))
+                {
+                        return false;
+                }
+                fcntl(pipe_[0], F_SETFL, O_NONBLOCK);
+                fresh_ = new SkkDictionary*[length];
+                result_ = new Result[length];
+                request_ = new bool[length];
+                for (int i = 0; i != length; ++i)
+                {
+                        *(fresh_ + i) = 0;
+                        *(result_ + i) = RESULT_NONE;
+                        *(request_ + i) = false;
+                }
+                length_ = length;
+                return true;
+        }
+
+        bool isInitialized() const
+        {
+                return length_ > 0;
+        }
+
+/// ľνλΤѥפɤ߽Ф¦֤ޤ initialize()  -1 ֤ޤ
+        int getFileDescriptor() const
+        {
+                return pipe_[0];
+        }
+
+/// ľ (finish() ) ʤп֤ޤ
+        bool isRunning() const
+        {
+                return running_flag_;
+        }
+
+/// index ܤμ򼡤 start() ǳľ褦ˤޤ
+        void request(int index)
+        {
+                DEBUG_ASSERT(index >= 0);
+                DEBUG_ASSERT(index < length_);
+                *(request_ + index) = true;
+        }
+
+/// request()  filename_table Υե뤫鳫ľϤޤľ椫 request() 񤬤ʤе֤ޤ
+/**
+ * filename_table  finish() ޤǻȤΤǡޤͭǤɬ
+ * ޤ
+ */
+        bool start(const char * const *filename_table)
+        {
+                if (running_flag_ || (length_ == 0))
+                {
+                        return false;
+                }
+                bool request_flag = false;
+                for (int i = 0; i != length_; ++i)
+                {
+// ľޤǤ RESULT_FAILED ȤƤޤ
+                        *(result_ + i) = (*(request_ + i) && *(filename_table + i)) ? RESULT_FAILED : RESULT_NONE;
+                        if (*(result_ + i) == RESULT_FAILED)
+                        {
+                                request_flag = true;
+                        }
+                        *(request_ + i) = false;
+                }
+                if (!request_flag)
+                {
+                        return false;
+                }
+                filename_table_ = filename_table;
+                running_flag_ = true;
+                finished_flag_ = false;
+#ifdef YASKKSERV_CONFIG_HAVE_PTHREAD
+                if (pthread_create(&thread_, 0, reload_thread, this) == 0)
+                {
+                        return true;
+                }
+#endif  // YASKKSERV_CONFIG_HAVE_PTHREAD
+// åɤȤʤФξǳľޤ
+                reload();
+                finished_flag_ = true;
+                return true;
+        }
+
+/// ľ򽪤Ƥп֤ޤ֥åޤ
+        bool isFinished()
+        {
+                if (running_flag_ && !finished_flag_)
+                {
+                        char tmp;
+                        if (read(pipe_[0], &tmp, 1) == 1)
+                        {
+                                finished_flag_ = true;
+                        }
+                }
+                return running_flag_ && finished_flag_;
+        }
+
+/// ľ skk_dictionary μؤŤޤ isFinished() ˤʤ˸ƤϳľνλԤޤ
+        template<typename T> void finish(T *skk_dictionary)
+        {
+                if (!running_flag_)
+                {
+                        return;
+                }
+                join();
+                for (int i = 0; i != length_; ++i)
+                {
+                        if (*(fresh_ + i))
+                        {
+                                (skk_dictionary + i)->swap(**(fresh_ + i));
+                                delete *(fresh_ + i);
+                                *(fresh_ + i) = 0;
+                        }
+                }
+        }
+
+/// Ǹ finish() Ǥ index ܤμη̤֤ޤ
+        Result getResult(int index) const
+        {
+                return *(result_ + index);
+        }
+
+private:
+        void join()
+        {
+#ifdef YASKKSERV_CONFIG_HAVE_PTHREAD
+                if (!finished_flag_)
+                {
+                        char tmp;
+                        while (read(pipe_[0], &tmp, 1) != 1)
+                        {
+                                fd_set fd_set_read;
+                                FD_ZERO(&fd_set_read);
+                                FD_SET(pipe_[0], &fd_set_read);
+                                select(pipe_[0] + 1, &fd_set_read, 0, 0, 0);
+                        }
+                }
+                pthread_join(thread_, 0);
+#endif  // YASKKSERV_CONFIG_HAVE_PTHREAD
+                running_flag_ = false;
+                finished_flag_ = false;
+        }
+
+#ifdef YASKKSERV_CONFIG_HAVE_PTHREAD
+        static void *reload_thread(void *p)
+        {
+                SkkDictionaryReloader *object = static_cast<SkkDictionaryReloader*>(p);
+                object->reload();
+                const char tmp = 1;
+                while ((write(object->pipe_[1], &tmp, 1) == -1) && (errno == EINTR))
+                {
+                }
+                return 0;
+        }
+#endif  // YASKKSERV_CONFIG_HAVE_PTHREAD
+
+/// result_  RESULT_FAILED μ򳫤ľ RESULT_SWAPPED ˤޤ
+        void reload()
+        {
+                for (int i = 0; i != length_; ++i)
+                {
+                        if (*(result_ + i) != RESULT_FAILED)
+                        {
+                                continue;
+                        }
+                        const char *filename = *(filename_table_ + i);
+                        struct stat stat_before;
+                        if (stat(filename, &stat_before) == -1)
+                        {
+                                continue;
+                        }
+                        SkkDictionary *fresh = new SkkDictionary();
+                        struct stat stat_after;
+                        if ((!fresh->open(filename)) ||
+                            (stat(filename, &stat_after) == -1) ||
+                            (stat_before.st_mtime != stat_after.st_mtime) ||
+                            (stat_before.st_size != stat_after.st_size))
+                        {
+// ʤƤ֤˽񤭴줿ϻȤޤ
+                                delete fresh;
+                                continue;
+                        }
+                        *(fresh_ + i) = fresh;
+                        *(result_ + i) = RESULT_SWAPPED;
+                }
+        }
+
+        SkkDictionary **fresh_;
+        const char * const *filename_table_;
+        Result *result_;
+        bool *request_;
+#ifdef YASKKSERV_CONFIG_HAVE_PTHREAD
+        pthread_t thread_;
+#endif  // YASKKSERV_CONFIG_HAVE_PTHREAD
+        int pipe_[2];
+        int length_;
+        bool running_flag_;
+        bool finished_flag_;
+};
+}
+
+#endif  // SKK_DICTIONARY_RELOADER_H
@@ -0,0 +1,283 @@
+/*
+  Copyright (C) 2005-2021 Tadashi Watanabe <twacc2020@gmail.com>
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#ifndef SKK_DICTIONARY_WATCHER_H
+#define SKK_DICTIONARY_WATCHER_H
+
+#include "skk_architecture.hpp"
+#include "skk_utility.hpp"
+
+namespace YaSkkServ
+{
+/// inotify Ǽեιƻ뤹륯饹Ǥ
+/**
+ * ե뤽ΤΤǤϤʤΤǥ쥯ȥƻ뤷
+ * Ʊ̾Υե IN_CLOSE_WRITE (񤭹ߤ򽪤Ĥ) 
+ * IN_MOVED_TO (rename() ֤줿) 򹹿Ȥߤʤޤ񤭹
+ * ߤǤϹȤߤʤ֤Ƥƻ뤬ޤ
+ * ܥå󥯤μ realpath() ǲ褷ƻ뤷
+ * 
+ *
+ * ̾ΥեǤʤ (¸ߤʤե yaskkserv_hairy 
+ * лʤ) ϴƻ뤷ޤ̾ΥեǤƻϤ
+ * ä isStatRequired() ˤʤΤǡƤӽФ¦
+ * isUpdateDictionary() ˤǧ³ɬפޤ
+ *
+ * getFileDescriptor()  select() ˲äƤɤ߹߲ǽˤʤä
+ * Ȥ readEvent() Сõ뤿Ӥ stat() ɬפ
+ * ޤ
+ *
+ * YASKKSERV_CONFIG_HAVE_INOTIFY Ƥʤ initialize() 
+ * ˼ԤΤǡƤӽФ¦ isUpdateDictionary() ˤǧڤ
+ * ؤɬפޤ
+ */
+class SkkDictionaryWatcher
+{
+        SkkDictionaryWatcher(SkkDictionaryWatcher &source);
+        SkkDictionaryWatcher& operator=(SkkDictionaryWatcher &source);
+
+public:
+        virtual ~SkkDictionaryWatcher()
+        {
+                finalize();
+        }
+
+        SkkDictionaryWatcher() :
+                real_filename_table_(0),
+                watch_descriptor_(0),
+                update_(0),
+                length_(0),
+                file_descriptor_(-1)
+        {
+        }
+
+/// filename_table  length ĤμδƻϤޤ inotify Ȥʤϵ֤ޤ
+/**
+ * 0 Υե̾ϴƻ뤷ޤ󡣰μ񤬴ƻǤʤƤ⡢Ĥ
+ * δƻ³ޤ
+ */
+        bool initialize(const char * const *filename_table, int length)
+        {
+#ifdef YASKKSERV_CONFIG_HAVE_INOTIFY
+                if ((file_descriptor_ != -1) || (length <= 0))
+                {
+                        return false;
+                }
+                file_descriptor_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+                if (file_descriptor_ == -1)
+                {
+                        return false;
+                }
+                real_filename_table_ = new char*[length];
+                watch_descriptor_ = new int[length];
+                update_ = new bool[length];
+                length_ = length;
+                for (int i = 0; i != length; ++i)
+                {
+                        *(real_filename_table_ + i) = 0;
+                        *(watch_descriptor_ + i) = WATCH_DESCRIPTOR_NONE;
+                        *(update_ + i) = false;
+                }
+                for (int i = 0; i != length; ++i)
+                {
+                        if (*(filename_table + i) == 0)
+                        {
+                                continue;
+                        }
+// ¸ߤʤޤ̾ΥեǤʤϴƻ뤷ޤ
+                        char *filename = realpath(*(filename_table + i), 0);
+                        struct stat stat_work;
+                        if ((filename == 0) ||
+                            (stat(filename, &stat_work) == -1) ||
+                            !S_ISREG(stat_work.st_mode))
+                        {
+                                free(filename);
+                                continue;
+                        }
+                        *(real_filename_table_ + i) = filename;
+                        const char *basename = get_basename(filename);
+                        int directory_size = static_cast<int>(basename - filename);
+// "/SKK-JISYO"  "/" ʳ '/' ޤ
+                        if (directory_size > 1)
+                        {
+                                --directory_size;
+                        }
+                        char *directory = new char[directory_size + 2];
+                        if (directory_size == 0)
+                        {
+                                *(directory + 0) = '.';
+                                *(directory + 1) = '\0';
+                        }
+                        else
+                        {
+                                SkkUtility::copyMemory(filename, directory, directory_size);
+                                *(directory + directory_size) = '\0';
+                        }
+                        int watch_descriptor = inotify_add_watch(file_descriptor_, directory, IN_CLOSE_WRITE | IN_MOVED_TO);
+                        delete[] directory;
+                        *(watch_descriptor_ + i) = (watch_descriptor == -1) ? WATCH_DESCRIPTOR_FAILED : watch_descriptor;
+                }
+                return true;
+#else  // YASKKSERV_CONFIG_HAVE_INOTIFY
+                (void)filename_table;
+                (void)length;
+                return false;
+#endif  // YASKKSERV_CONFIG_HAVE_INOTIFY
+        }
+
+/// ƻ뤷Ƥп֤ޤ
+        bool isInitialized() const
+        {
+                return file_descriptor_ != -1;
+        }
+
+/// index ܤμ̾ΥեʤΤ˴ƻǤƤʤп֤ޤ
+        bool isStatRequired(int index) const
+        {
+                DEBUG_ASSERT(index >= 0);
+                DEBUG_ASSERT(index < length_);
+                return *(watch_descriptor_ + index) == WATCH_DESCRIPTOR_FAILED;
+        }
+
+/// select() ˲äեǥץ֤ޤƻ뤷Ƥʤ -1 ֤ޤ
+        int getFileDescriptor() const
+        {
+                return file_descriptor_;
+        }
+
+/// ίޤäƤ륤٥Ȥ򤹤٤ɤߡ줿˰դޤդ񤬤п֤ޤ֥åޤ
+        bool readEvent()
+        {
+                bool result = false;
+#ifdef YASKKSERV_CONFIG_HAVE_INOTIFY
+                if (file_descriptor_ == -1)
+                {
+                        return result;
+                }
+// struct inotify_event Υ饤Ȥ int64_t ǳݤޤ
+                int64_t buffer[EVENT_BUFFER_SIZE / sizeof(int64_t)];
+                for (;;)
+                {
+                        ssize_t size = read(file_descriptor_, buffer, sizeof(buffer));
+                        if (size <= 0)
+                        {
+                                break;
+                        }
+                        const char *p = reinterpret_cast<const char*>(buffer);
+                        const char *end = p + size;
+                        while (p < end)
+                        {
+                                const struct inotify_event *event = reinterpret_cast<const struct inotify_event*>(p);
+                                if (event->mask & IN_Q_OVERFLOW)
+                                {
+// ٥ȤꤳܤΤǡ٤Ƥμ򹹿줿Ȥߤʤޤ
+                                        for (int i = 0; i != length_; ++i)
+                                        {
+                                                if (*(watch_descriptor_ + i) >= 0)
+                                                {
+                                                        *(update_ + i) = true;
+                                                        result = true;
+                                                }
+                                        }
+                                }
+                                else if (event->len > 0)
+                                {
+                                        for (int i = 0; i != length_; ++i)
+                                        {
+                                                if ((*(watch_descriptor_ + i) == event->wd) &&
+                                                    (strcmp(get_basename(*(real_filename_table_ + i)), event->name) == 0))
+                                                {
+                                                        *(update_ + i) = true;
+                                                        result = true;
+                                                }
+                                        }
+                                }
+                                p += sizeof(struct inotify_event) + event->len;
+                        }
+                }
+#endif  // YASKKSERV_CONFIG_HAVE_INOTIFY
+                return result;
+        }
+
+/// index ܤμ񤬹Ƥп֤äޤ
+        bool getAndClearUpdate(int index)
+        {
+                DEBUG_ASSERT(index >= 0);
+                DEBUG_ASSERT(index < length_);
+                const bool result = *(update_ + index);
+                *(update_ + index) = false;
+                return result;
+        }
+
+private:
+        enum
+        {
+                EVENT_BUFFER_SIZE = 4096
+        };
+        enum
+        {
+                WATCH_DESCRIPTOR_NONE = -1,
+                WATCH_DESCRIPTOR_FAILED = -2
+        };
+
+        static const char *get_basename(const char *filename)
+        {
+                const char *result = filename;
+                for (const char *p = filename; *p; ++p)
+                {
+                        if (*p == '/')
+                        {
+                                result = p + 1;
+                        }
+                }
+                return result;
+        }
+
+        void finalize()
+        {
+                if (file_descriptor_ != -1)
+                {
+// inotify ΥեǥץĤȴƻ⤹٤Ƴޤ
+                        close(file_descriptor_);
+                        file_descriptor_ = -1;
+                }
+                if (real_filename_table_)
+                {
+                        for (int i = 0; i != length_; ++i)
+                        {
+// realpath()  malloc() ǳݤΰǤ
+                                free(*(real_filename_table_ + i));
+                        }
+                }
+                delete[] real_filename_table_;
+                delete[] update_;
+                delete[] watch_descriptor_;
+                real_filename_table_ = 0;
+                update_ = 0;
+                watch_descriptor_ = 0;
+                length_ = 0;
+        }
+
+        char **real_filename_table_;
+        int *watch_descriptor_;
+        bool *update_;
+        int length_;
+        int file_descriptor_;
+};
+}
+
+#endif  // SKK_DICTIONARY_WATCHER_H
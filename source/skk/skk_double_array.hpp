@@ -0,0 +1,316 @@
+/*
+  Copyright (C) 2005-2021 Tadashi Watanabe <twacc2020@gmail.com>
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#ifndef SKK_DOUBLE_ARRAY_H
+#define SKK_DOUBLE_ARRAY_H
+
+#include "skk_architecture.hpp"
+
+namespace YaSkkServ
+{
+/// ֥ˤȥ饤Ǥ
+/**
+ * Ρ s ʸ c ܤ t = base[s] + code(c) ǡ
+ * check[t] == s ʤܤǤޤ code(c) ϥХ + 1 ǡ 0 
+ * νü򼨤ޤüܤΥΡɤ base ˤϥ
+ *  -1 - value ȤƳǼޤ롼ȤϥΡ 0 Ǥ
+ *
+ * Ͼ˥ȤƤɬפꡢΡɤλҤʸξ
+ * ֤ᡢͤ򥽡ȽΥǥåȤȡΡɰʲ
+ * ͤϢ³ޤ
+ */
+class SkkDoubleArray
+{
+        SkkDoubleArray(SkkDoubleArray &source);
+        SkkDoubleArray& operator=(SkkDoubleArray &source);
+
+public:
+        enum
+        {
+                CODE_TERMINATOR = 0,
+                CODE_LENGTH = 256 + 1
+        };
+
+        virtual ~SkkDoubleArray()
+        {
+                delete[] base_;
+                delete[] check_;
+        }
+
+        SkkDoubleArray() :
+                base_(0),
+                check_(0),
+                key_(0),
+                key_offset_(0),
+                key_size_(0),
+                capacity_(0),
+                length_(0),
+                next_check_position_(0)
+        {
+        }
+
+/// key_length ĤΥ֥ޤǤʤϵ֤ޤ
+/**
+ * i ܤΥ (key + *(key_offset + i))  *(key_size + i) Х
+ * Ȥǡͤ i ˤʤޤϾ˥Ȥ졢ʣƤʤɬ
+ * ޤ
+ */
+        bool build(const char *key, const int *key_offset, const int *key_size, int key_length)
+        {
+                DEBUG_ASSERT_POINTER(key);
+                DEBUG_ASSERT_POINTER(key_offset);
+                DEBUG_ASSERT_POINTER(key_size);
+                key_ = key;
+                key_offset_ = key_offset;
+                key_size_ = key_size;
+                length_ = 1;
+                next_check_position_ = 1;
+                resize(key_length * 2 + CODE_LENGTH);
+                *(check_ + 0) = 0;
+                bool result = true;
+                if (key_length > 0)
+                {
+                        result = insert(0, 0, key_length, 0);
+                }
+                key_ = 0;
+                key_offset_ = 0;
+                key_size_ = 0;
+                return result;
+        }
+
+        const int32_t *getBase() const
+        {
+                return base_;
+        }
+
+        const int32_t *getCheck() const
+        {
+                return check_;
+        }
+
+/// Ρɿ֤ޤ
+        int getLength() const
+        {
+                return length_;
+        }
+
+/// node  key  size ХȤܤΡɤ֤ޤܤǤʤ -1 ֤ޤ
+        static int traverse(const int32_t *base, const int32_t *check, int length, int node, const char *key, int size)
+        {
+                DEBUG_ASSERT_POINTER(base);
+                DEBUG_ASSERT_POINTER(check);
+                DEBUG_ASSERT_POINTER(key);
+                for (int i = 0; i != size; ++i)
+                {
+                        int next = *(base + node) + (*(reinterpret_cast<const unsigned char*>(key) + i)) + 1;
+                        if ((*(base + node) < 0) || (next < 0) || (next >= length) || (*(check + next) != node))
+                        {
+                                return -1;
+                        }
+                        node = next;
+                }
+                return node;
+        }
+
+/// node ǽ륭֤ͤޤ¸ߤʤ -1 ֤ޤ
+        static int getValue(const int32_t *base, const int32_t *check, int length, int node)
+        {
+                DEBUG_ASSERT_POINTER(base);
+                DEBUG_ASSERT_POINTER(check);
+                int next = *(base + node) + CODE_TERMINATOR;
+                if ((*(base + node) < 0) || (next < 0) || (next >= length) || (*(check + next) != node))
+                {
+                        return -1;
+                }
+                return -1 - *(base + next);
+        }
+
+/// node ʲǺǤ⾮֤ͤޤ¸ߤʤ -1 ֤ޤ
+        static int getFirstValue(const int32_t *base, const int32_t *check, int length, int node)
+        {
+                DEBUG_ASSERT_POINTER(base);
+                DEBUG_ASSERT_POINTER(check);
+                for (;;)
+                {
+                        if (*(base + node) < 0)
+                        {
+                                return -1 - *(base + node);
+                        }
+                        int code;
+                        for (code = 0; code != CODE_LENGTH; ++code)
+                        {
+                                int next = *(base + node) + code;
+                                if ((next >= 0) && (next < length) && (*(check + next) == node))
+                                {
+                                        node = next;
+                                        break;
+                                }
+                        }
+                        if (code == CODE_LENGTH)
+                        {
+                                return -1;
+                        }
+                }
+        }
+
+private:
+        int get_code(int index, int depth) const
+        {
+                if (depth >= *(key_size_ + index))
+                {
+                        return CODE_TERMINATOR;
+                }
+                return (*(reinterpret_cast<const unsigned char*>(key_) + *(key_offset_ + index) + depth)) + 1;
+        }
+
+        void resize(int capacity)
+        {
+                if (capacity <= capacity_)
+                {
+                        return;
+                }
+                if (capacity < capacity_ * 2)
+                {
+                        capacity = capacity_ * 2;
+                }
+                int32_t *base = new int32_t[capacity];
+                int32_t *check = new int32_t[capacity];
+                for (int i = 0; i != capacity_; ++i)
+                {
+                        *(base + i) = *(base_ + i);
+                        *(check + i) = *(check_ + i);
+                }
+                for (int i = capacity_; i != capacity; ++i)
+                {
+                        *(base + i) = 0;
+                        *(check + i) = -1;
+                }
+                delete[] base_;
+                delete[] check_;
+                base_ = base;
+                check_ = check;
+                capacity_ = capacity;
+        }
+
+/// begin  end - 1 ܤΥ depth Хܤ node λҤȤ֤ޤ
+        bool insert(int node, int begin, int end, int depth)
+        {
+                int16_t code_table[CODE_LENGTH];
+                int begin_table[CODE_LENGTH + 1];
+                int length = 0;
+                for (int i = begin; i != end; ++i)
+                {
+                        int code = get_code(i, depth);
+                        if ((length == 0) || (code_table[length - 1] != code))
+                        {
+                                if ((length > 0) && (code_table[length - 1] > code))
+                                {
+// ȤƤޤ
+                                        return false;
+                                }
+                                code_table[length] = static_cast<int16_t>(code);
+                                begin_table[length] = i;
+                                ++length;
+                        }
+                        else if (code == CODE_TERMINATOR)
+                        {
+// Ʊ¸ߤޤ
+                                return false;
+                        }
+                }
+                begin_table[length] = end;
+
+// ٤ƤλҤ֤˼ޤ base õޤ
+                int position = next_check_position_;
+                if (position <= code_table[0])
+                {
+                        position = code_table[0] + 1;
+                }
+                int used = 0;
+                bool first = true;
+                int base;
+                for (;; ++position)
+                {
+                        resize(position + CODE_LENGTH);
+                        if (*(check_ + position) != -1)
+                        {
+                                ++used;
+                                continue;
+                        }
+                        if (first)
+                        {
+                                next_check_position_ = position;
+                                first = false;
+                        }
+                        base = position - code_table[0];
+                        int i;
+                        for (i = 1; i != length; ++i)
+                        {
+                                if (*(check_ + base + code_table[i]) != -1)
+                                {
+                                        break;
+                                }
+                        }
+                        if (i == length)
+                        {
+                                break;
+                        }
+                }
+// õϰϤۤޤäƤСϤ褫õޤ
+                if (used * 20 >= (position - next_check_position_ + 1) * 19)
+                {
+                        next_check_position_ = position;
+                }
+
+                *(base_ + node) = base;
+                for (int i = 0; i != length; ++i)
+                {
+                        *(check_ + base + code_table[i]) = node;
+                        if (length_ <= base + code_table[i])
+                        {
+                                length_ = base + code_table[i] + 1;
+                        }
+                }
+                for (int i = 0; i != length; ++i)
+                {
+                        if (code_table[i] == CODE_TERMINATOR)
+                        {
+                                *(base_ + base) = -1 - begin_table[i];
+                        }
+                        else
+                        {
+                                if (!insert(base + code_table[i], begin_table[i], begin_table[i + 1], depth + 1))
+                                {
+                                        return false;
+                                }
+                        }
+                }
+                return true;
+        }
+
+        int32_t *base_;
+        int32_t *check_;
+        const char *key_;
+        const int *key_offset_;
+        const int *key_size_;
+        int capacity_;
+        int length_;
+        int next_check_position_;
+};
+}
+
+#endif  // SKK_DOUBLE_ARRAY_H
@@ -21,6 +21,8 @@
 #include "skk_architecture.hpp"
 #include "skk_utility.hpp"
 #include "skk_mmap.hpp"
+#include "skk_double_array.hpp"
+#include "skk_candidate_pool.hpp"
 
 namespace YaSkkServ
 {
@@ -54,6 +56,12 @@ namespace YaSkkServ
  *
  * \li createDictionaryForClassSkkDictionary() Ѥ
  *
+ * 2 ʳܤ˥ȥ饤ղä뤳ȤǤޤ
+ *
+ * \li class SkkDictionary  (ȥ饤)
+ *
+ * \li createDictionaryForClassSkkTrie() Ѥ
+ *
  *
  * ѴƤϰʲ̤Ǥ
  *
@@ -68,6 +76,21 @@ namespace YaSkkServ
  * \li 2 ʳܤǤϥǥåǡղä
  *
  * \li ˼󤬥Хʥղä
+ *
+ * \subsection replyrecord 쥳
+ *
+ * Υӥåȥե饰 BIT_FLAG_REPLY_RECORD ΩäƤ뼭Ǥϡ
+ * ƹԤΡָФפȥڡθ˥ץȥ "1" ֤ޤ
+ * "1" ԤޤǤΤޤޱˤʤ뤿ᡢդäȥХ
+ * ե񤭴 1  send() ֤ȤǤޤ
+ *
+ * Ԥΰ̣Ѥ뤿ᡢ쥳ɤμ ID_IDENTIFIER 
+ * IDENTIFIER_REPLY_RECORD ˤʤޤ쥳ɤΤʤŤ
+ * yaskkserv ϤμΤʤȤƳޤ
+ *
+ * \verbatim
+ߤ 1/Ѵʸ0/Ѵʸ1/\n
+\endverbatim
  *
  * \subsection special ü쥨ȥ
  * 
@@ -95,6 +118,13 @@ namespace YaSkkServ
  |               | index data  ǥåǡ     |
  +---------------+------------------------------------+
  |               | terminator and alignment           |
+ | extension     | 1 - 4 ХȤ 0 ߥ͡ΰ  |
+ | data          +------------------------------------+ <-- ĥǡեå
+ | (1 ʳܤǤ | struct ExtensionDataHeader         |
+ |  ¸ߤʤ)  |              +                     |
+ |               | extension data  ĥǡ         |
+ +---------------+------------------------------------+
+ |               | terminator and alignment           |
  |               | 1 - 4 ХȤ 0 ߥ͡ΰ  |
  | information   +------------------------------------+ <--- ե륵 - sizeof(Information)
  |               |                                    |
@@ -110,10 +140,10 @@ namespace YaSkkServ
 struct Information
 
  object[0]  : ӥåȥե饰
- object[1]  : ꥶ
- object[2]  : ꥶ
- object[3]  : ꥶ
- object[4]  : ꥶ
+ object[1]  : ĥǡؤΥեå
+ object[2]  : ĥǡ
+ object[3]  : ȥ饤ǡؤΥեå
+ object[4]  : ȥ饤ǡ
  object[5]  : ꥶ
  object[6]  : ǥåǡؤΥեå
  object[7]  : ǥåǡ
@@ -189,6 +219,199 @@ struct Information
  |     ¸ߤ뤫ɤĴ٤ޤ                   |
  |                                                    |
  +----------------------------------------------------+
+\endverbatim
+ *
+ * \section aboutextensiondata ĥǡˤĤ
+ *
+ * ĥǡϥС 2 ɲä줿õ®뤿
+ * ǡǤǥåǡθ֤졢 Information γĥǡ
+ * ؤΥեåȤȥǼޤ餬 0 μ(С
+ * 1 μ)䡢ĥǡΤʤŤǤñ̵뤵ޤ
+ *
+ * ĥǡγƥǡ ExtensionDataHeader ˳ĥǡƬ
+ * եåȤȥǼ졢 8 ХȤǥ饤Ȥޤ
+ * եåȤ 0 Υǡ¸ߤޤ
+ *
+ * \verbatim
+ +----------------------------------------------------+
+ |                                                    |
+ |  struct ExtensionDataHeader                        |
+ |                                                    |
+ +----------------------------------------------------+
+ |                                                    |
+ |  uint64_t key_prefix[block_length]                 |
+ |                                                    |
+ |     ƥ֥åκǸθФƬ 8 ХȤ      |
+ |     SkkUtility::getMidasiPrefix() ˤ     |
+ |     ΤǤʸǼΰθФӤ     |
+ |     Ӥޤ                         |
+ |                                                    |
+ +----------------------------------------------------+
+ |                                                    |
+ |  int32_t key_offset[block_length]                  |
+ |                                                    |
+ |     ƥ֥åκǸθФʸǼΰƬ   |
+ |     ΥեåȤǤ֥åХʥꥵ   |
+ |     õ˻Ѥޤ                     |
+ |                                                    |
+ +----------------------------------------------------+
+ |                                                    |
+ |  int32_t row_index[DISPATCH_ROW_INDEX_LENGTH]      |
+ |  uint16_t row[row_length][DISPATCH_ROW_SIZE]       |
+ |                                                    |
+ |     ǥѥåơ֥ǤάǽǤ       |
+ |     row_index ϥեåɥ쥤 (256 )      |
+ |     ü쥨ȥ (DISPATCH_ROW_SPECIAL) Ȥ     |
+ |     ֹǡԤʤ -1 ǤԤ           |
+ |     getDispatchIndex() 󤴤Ȥˡõ      |
+ |     Ϥ֥åݻޤ                   |
+ |                                                    |
+ +----------------------------------------------------+
+ |                                                    |
+ |  struct SpecialArray special_array[length]         |
+ |                                                    |
+ |     ü쥨ȥ 1 ʸ (2 Х) Ȥ      |
+ |     ֥åϰϤǤ 1 ʸܤξ¤      |
+ |     ޤü쥨ȥõǤϡޤ     |
+ |     1 ʸܤХʥꥵõ֥å     |
+ |     õϰϤޤ 1 ʸܤ¸ߤʤ  |
+ |     ֥åɤޤõ򽪤ޤ         |
+ |                                                    |
+ +----------------------------------------------------+
+ |                                                    |
+ |  uint64_t bloom_filter[size / 8]                   |
+ |                                                    |
+ |     ٤ƤθФ SkkUtility::getMidasiHash()   |
+ |     ˤ֥롼ե륿Ǥϥåؿ     |
+ |      ID_BLOOM_FILTER_HASH_LENGTH Ǥ        |
+ |     Ф¸ߤʤȤʬС֥å     |
+ |     ɤޤõ򽪤ޤ                 |
+ |                                                    |
+ +----------------------------------------------------+
+ |                                                    |
+ |  uint32_t perfect_hash_pilot[bucket_length]        |
+ |  struct PerfectHashEntry perfect_hash_table[lines] |
+ |                                                    |
+ |     ٤ƤθФκǾϥåؿȡФ |
+ |     ޤ֥åȥ֥åΰ֤Ǥάǽ |
+ |     ǡ¸ߤ뼭 ID_VERSION                |
+ |     VERSION_PERFECT_HASH ʾˤʤޤ          |
+ |     getPerfectHashSlot() ǸФΰ֤ޤꡢ  |
+ |     Υ֥åɤ 1 ٤ȹ礷ޤ      |
+ |                                                    |
+ +----------------------------------------------------+
+ |                                                    |
+ |  int32_t sub_block_index[block_length + 1]         |
+ |  struct SubBlock sub_block[sub_block_length]       |
+ |  char sub_block_string[size]                       |
+ |                                                    |
+ |     ֥å¤ʥǥåǤάǽ     |
+ |     Ǥ֥åԤζܤ N ХȤĤ    |
+ |     ֥֥åʬ sub_block_index ϥ֥  |
+ |     ȤκǽΥ֥֥åֹǤƥ   |
+ |     ֥åϥ֥åƬԤΥեåȤȡ   |
+ |     ιԤθФ sub_block_string Υե |
+ |     ȤޤФϥڡǽüޤ   |
+ |     ֥åΤǤϤʤФޤॵ֥֥å   |
+ |     ɤкѤߤޤ                         |
+ |                                                    |
+ +----------------------------------------------------+
+\endverbatim
+ *
+ * \section abouttriedata ȥ饤ǡˤĤ
+ *
+ * createDictionaryForClassSkkTrie() Ǻϥǥåǡ
+ * ȳĥǡˤ٤ƤθФΥ֥ˤ
+ * 饤 (SkkDoubleArray) ޤȥ饤ǡ Information Υȥ
+ * ǡؤΥեåȤȥǼ졢 ID_VERSION  VERSION_TRIE
+ * ʾˤʤޤƥեåȤϥȥ饤ǡƬΤΤǤ
+ *
+ * \verbatim
+ +----------------------------------------------------+
+ |                                                    |
+ |  struct TrieDataHeader                             |
+ |                                                    |
+ |          header[0]  : ӥåȥե饰                 |
+ |          header[1]  : header                 |
+ |          header[2]  : entry_length                 |
+ |          header[3]  : node_length                  |
+ |          header[4]  : entry ؤΥեå         |
+ |          header[5]  : base ؤΥեå          |
+ |          header[6]  : check ؤΥեå         |
+ |          header[7]  : סؤΥեå     |
+ |                                                    |
+ +----------------------------------------------------+
+ |                                                    |
+ |  int32_t entry[entry_length]                       |
+ |                                                    |
+ |     ФιƬΥեƬΥեå     |
+ |     Ǥξ¤ӡȥ饤ͤϤ   |
+ |     ΥǥåǤ                           |
+ |                                                    |
+ +----------------------------------------------------+
+ |                                                    |
+ |  int32_t base[node_length]                         |
+ |  int32_t check[node_length]                        |
+ |                                                    |
+ |     ֥Ǥϡ֤Ҥ餬ʥ󥳡ɡ   |
+ |     ǥɤФǤ                     |
+ |                                                    |
+ +----------------------------------------------------+
+\endverbatim
+ *
+ * ס (SkkCandidatePool) ļǤϡ̾泌ȥפȡ
+ * 쥨ȥפγƹԤָФפȥڡˤʤꡢѴʸ
+ * ϸס뤫ޤס TrieDataHeader θס
+ * ؤΥեåȤ 0 Ǥʤ¸ߤƥեåȤϥȥ饤ǡ
+ * ƬΤΤǤ
+ *
+ * \verbatim
+ +----------------------------------------------------+
+ |                                                    |
+ |  struct CandidatePoolHeader                        |
+ |                                                    |
+ |          header[0]  : ӥåȥե饰                 |
+ |          header[1]  : header                 |
+ |          header[2]  : candidate_length             |
+ |          header[3]  : candidate_offset եå  |
+ |          header[4]  : entry_reference եå   |
+ |          header[5]  : string ؤΥեå        |
+ |          header[6]  : string_size                  |
+ |          header[7]  : reference ؤΥեå     |
+ |          header[8]  : reference_size               |
+ |          header[9]  : ΡѴʸץ   |
+ |          header[10] : ꥶ                     |
+ |             :                                      |
+ |          header[15] : ꥶ                     |
+ |                                                    |
+ +----------------------------------------------------+
+ |                                                    |
+ |  int32_t candidate_offset[candidate_length + 1]    |
+ |                                                    |
+ |     candidate  string ΥեåȤǤ       |
+ |                                                    |
+ +----------------------------------------------------+
+ |                                                    |
+ |  int32_t entry_reference[entry_length + 1]         |
+ |                                                    |
+ |     entry Ʊ¤֡ƥȥ reference   |
+ |     ΥեåȤǤ                           |
+ |                                                    |
+ +----------------------------------------------------+
+ |                                                    |
+ |  char string[string_size]                          |
+ |                                                    |
+ |     ֤ "candidate/" ʣʤϢ     |
+ |     ΤǤ                                 |
+ |                                                    |
+ +----------------------------------------------------+
+ |                                                    |
+ |  unsigned char reference[reference_size]           |
+ |                                                    |
+ |     ƥȥ candidate λȤβĹ    |
+ |                                                |
+ |                                                    |
+ +----------------------------------------------------+
 \endverbatim
  *
  */
@@ -210,7 +433,8 @@ public:
                 JISYO_TYPE_UNKNOWN,
                 JISYO_TYPE_SKK_RAW,
                 JISYO_TYPE_CLASS_SKK_JISYO,
-                JISYO_TYPE_CLASS_SKK_DICTIONARY
+                JISYO_TYPE_CLASS_SKK_DICTIONARY,
+                JISYO_TYPE_CLASS_SKK_TRIE
         };
         enum SeekPosition
         {
@@ -222,7 +446,37 @@ public:
         };
         enum
         {
-                IDENTIFIER = 0x7fedc000
+                IDENTIFIER = 0x7fedc000,
+                IDENTIFIER_REPLY_RECORD = 0x7fedc001
+        };
+        enum
+        {
+                DISPATCH_ROW_SIZE = 256,
+                DISPATCH_ROW_SPECIAL = 256,
+                DISPATCH_ROW_LENGTH = 256 + 1,
+// ԥǥå 8 Хȥ饤ȤΤĤˤƤޤ
+                DISPATCH_ROW_INDEX_LENGTH = 256 + 2
+        };
+        enum
+        {
+// Ф 1 Ĥ 10 ӥåȡϥåؿ 7 ĤǵΨ 1% Ǥ
+                BLOOM_FILTER_BITS_PER_KEY = 10,
+                BLOOM_FILTER_HASH_LENGTH = 7,
+                BLOOM_FILTER_HASH_LENGTH_MAXIMUM = 16,
+// ӥåȿХȿ 8 ܤ int ˼ޤ 64 ܿǤ
+                BLOOM_FILTER_BIT_LENGTH_MAXIMUM = 0x7fffffc0
+        };
+        enum
+        {
+// ϥåΥХåȤʿѸФǤ
+                PERFECT_HASH_BUCKET_SIZE = 4,
+                PERFECT_HASH_PILOT_DIRECT = 0x80000000,
+                PERFECT_HASH_PILOT_MAXIMUM = 16 * 1024 * 1024
+        };
+        enum
+        {
+// ֥֥å礭β¤Ǥ¤ϥ֥åǤ
+                SUB_BLOCK_SIZE_MINIMUM = 64
         };
 
 /// array[0] Ͼ˥ӥåȥե饰򼨤ȤդɬפǤ
@@ -326,10 +580,10 @@ public:
                 {
                         ID_BIT_FLAG,
 
-                        ID_RESERVE_1,
-                        ID_RESERVE_2,
-                        ID_RESERVE_3,
-                        ID_RESERVE_4,
+                        ID_EXTENSION_DATA_OFFSET,
+                        ID_EXTENSION_DATA_SIZE,
+                        ID_TRIE_DATA_OFFSET,
+                        ID_TRIE_DATA_SIZE,
                         ID_RESERVE_5,
 
                         ID_INDEX_DATA_OFFSET,
@@ -351,6 +605,17 @@ public:
                         return sizeof(int32_t) * ID_LENGTH;
                 }
 
+                enum
+                {
+                        BIT_FLAG_REPLY_RECORD = 0x1 << 1
+                };
+                enum
+                {
+                        VERSION_EXTENSION_DATA = 2,
+                        VERSION_PERFECT_HASH = 3,
+                        VERSION_TRIE = 4
+                };
+
                 Information(int bit_flag = ArrayInt32<ID_LENGTH>::BIT_FLAG_BYTE_ORDER_VAX) :
                         object(bit_flag)
                 {
@@ -362,7 +627,7 @@ public:
                             (0 * 1000) +
                             (0 * 100) +
                             (0 * 10) +
-                            (1 * 1));
+                            (2 * 1));
                 }
 
                 bool initialize(const void *p)
@@ -380,6 +645,28 @@ public:
                         return object.set(id, scalar);
                 }
 
+                /// ID_BIT_FLAG  BIT_FLAG_REPLY_RECORD  ID_IDENTIFIER ·ꤷޤ
+                void setReplyRecord(bool flag)
+                {
+                        if (flag)
+                        {
+                                set(ID_BIT_FLAG, get(ID_BIT_FLAG) | BIT_FLAG_REPLY_RECORD);
+                                set(ID_IDENTIFIER, SkkJisyo::IDENTIFIER_REPLY_RECORD);
+                        }
+                        else
+                        {
+                                set(ID_BIT_FLAG, get(ID_BIT_FLAG) & ~BIT_FLAG_REPLY_RECORD);
+                                set(ID_IDENTIFIER, SkkJisyo::IDENTIFIER);
+                        }
+                }
+
+                /// ID_IDENTIFIER  BIT_FLAG_REPLY_RECORD бΤΤΤʤп֤ޤ
+                bool isValidIdentifier()
+                {
+                        int32_t identifier = ((get(ID_BIT_FLAG) & BIT_FLAG_REPLY_RECORD) != 0) ? SkkJisyo::IDENTIFIER_REPLY_RECORD : SkkJisyo::IDENTIFIER;
+                        return get(ID_IDENTIFIER) == identifier;
+                }
+
                 ArrayInt32<ID_LENGTH> object;
         };
 
@@ -433,90 +720,316 @@ public:
                 ArrayInt32<ID_LENGTH> object;
         };
 
-        struct FixedArray
+        struct ExtensionDataHeader
         {
-                FixedArray () :
-                        start_block(0),
-                        block_length(0),
-                        string_data_offset(0)
+                enum Id
+                {
+                        ID_BIT_FLAG,
+
+                        ID_SIZE,
+                        ID_KEY_PREFIX_OFFSET,
+                        ID_KEY_PREFIX_SIZE,
+                        ID_KEY_OFFSET_OFFSET,
+                        ID_KEY_OFFSET_SIZE,
+                        ID_DISPATCH_OFFSET,
+                        ID_DISPATCH_SIZE,
+                        ID_SPECIAL_ARRAY_OFFSET,
+                        ID_SPECIAL_ARRAY_SIZE,
+                        ID_BLOOM_FILTER_OFFSET,
+                        ID_BLOOM_FILTER_SIZE,
+                        ID_BLOOM_FILTER_HASH_LENGTH,
+                        ID_PERFECT_HASH_PILOT_OFFSET,
+                        ID_PERFECT_HASH_PILOT_SIZE,
+                        ID_PERFECT_HASH_TABLE_OFFSET,
+                        ID_PERFECT_HASH_TABLE_SIZE,
+                        ID_SUB_BLOCK_INDEX_OFFSET,
+                        ID_SUB_BLOCK_INDEX_SIZE,
+                        ID_SUB_BLOCK_OFFSET,
+                        ID_SUB_BLOCK_SIZE,
+                        ID_SUB_BLOCK_STRING_OFFSET,
+                        ID_SUB_BLOCK_STRING_SIZE,
+                        ID_RESERVE_20,
+                        ID_RESERVE_21,
+                        ID_RESERVE_22,
+                        ID_RESERVE_23,
+                        ID_RESERVE_24,
+                        ID_RESERVE_25,
+                        ID_RESERVE_26,
+                        ID_RESERVE_27,
+                        ID_RESERVE_28,
+
+                        ID_LENGTH
+                };
+
+                static int getSize()
                 {
+                        return sizeof(int32_t) * ID_LENGTH;
                 }
 
-                int16_t start_block;
-                int16_t block_length;
-                int32_t string_data_offset;
+                ExtensionDataHeader(int bit_flag = ArrayInt32<ID_LENGTH>::BIT_FLAG_BYTE_ORDER_VAX) :
+                        object(bit_flag)
+                {
+                        set(ID_SIZE, getSize());
+                }
+
+                bool initialize(const void *p)
+                {
+                        return object.initialize(p);
+                }
+
+                int32_t get(Id id)
+                {
+                        return object.get(id);
+                }
+
+                void set(Id id, int32_t scalar)
+                {
+                        return object.set(id, scalar);
+                }
+
+                ArrayInt32<ID_LENGTH> object;
         };
 
-        struct Block
+        struct TrieDataHeader
         {
-                Block () :
-                        offset(0),
-                        line_length_and_data_size(0)
+                enum Id
+                {
+                        ID_BIT_FLAG,
+
+                        ID_SIZE,
+                        ID_ENTRY_LENGTH,
+                        ID_NODE_LENGTH,
+                        ID_ENTRY_OFFSET,
+                        ID_BASE_OFFSET,
+                        ID_CHECK_OFFSET,
+                        ID_CANDIDATE_POOL_OFFSET,
+
+                        ID_LENGTH
+                };
+
+                static int getSize()
                 {
+                        return sizeof(int32_t) * ID_LENGTH;
                 }
 
-                int getOffset()
+                TrieDataHeader(int bit_flag = ArrayInt32<ID_LENGTH>::BIT_FLAG_BYTE_ORDER_VAX) :
+                        object(bit_flag)
                 {
-                        return offset;
+                        set(ID_SIZE, getSize());
                 }
 
-                void setOffset(int scalar)
+                bool initialize(const void *p)
                 {
-                        offset = scalar;
+                        return object.initialize(p);
                 }
 
-                int getDataSize()
+                int32_t get(Id id)
                 {
-                        return line_length_and_data_size & 0xfffff;
+                        return object.get(id);
                 }
 
-                void setLineLengthAndDataSize(int line_length, int data_size)
+                void set(Id id, int32_t scalar)
                 {
-                        line_length_and_data_size = (line_length << 20) | data_size;
+                        return object.set(id, scalar);
                 }
 
-                int32_t offset;
-                int32_t line_length_and_data_size;
+                ArrayInt32<ID_LENGTH> object;
         };
 
-        struct BlockShort
+        struct CandidatePoolHeader
         {
-                BlockShort () :
-                        data_size(0)
+                enum Id
+                {
+                        ID_BIT_FLAG,
+
+                        ID_SIZE,
+                        ID_CANDIDATE_LENGTH,
+                        ID_CANDIDATE_OFFSET_OFFSET,
+                        ID_ENTRY_REFERENCE_OFFSET,
+                        ID_STRING_OFFSET,
+                        ID_STRING_SIZE,
+                        ID_REFERENCE_OFFSET,
+                        ID_REFERENCE_SIZE,
+                        ID_HENKANMOJIRETSU_SIZE_MAXIMUM,
+                        ID_RESERVE_10,
+                        ID_RESERVE_11,
+                        ID_RESERVE_12,
+                        ID_RESERVE_13,
+                        ID_RESERVE_14,
+                        ID_RESERVE_15,
+
+                        ID_LENGTH
+                };
+
+                static int getSize()
                 {
+                        return sizeof(int32_t) * ID_LENGTH;
                 }
 
-                int getDataSize()
+                CandidatePoolHeader(int bit_flag = ArrayInt32<ID_LENGTH>::BIT_FLAG_BYTE_ORDER_VAX) :
+                        object(bit_flag)
                 {
-                        return data_size;
+                        set(ID_SIZE, getSize());
                 }
 
-                void setDataSize(int size)
+                bool initialize(const void *p)
                 {
-                        data_size = static_cast<int16_t>(size);
+                        return object.initialize(p);
                 }
 
-                int16_t data_size;
+                int32_t get(Id id)
+                {
+                        return object.get(id);
+                }
+
+                void set(Id id, int32_t scalar)
+                {
+                        return object.set(id, scalar);
+                }
+
+                ArrayInt32<ID_LENGTH> object;
         };
 
-private:
-/// okuri_ari_index  okuri_nasi_index ޤԤϵ֤ޤ
-        static bool get_index(const char *buffer, int filesize, int &okuri_ari_index, int &okuri_nasi_index)
+        struct FixedArray
         {
-                DEBUG_ASSERT_POINTER(buffer);
-                for (;;)
+                FixedArray () :
+                        start_block(0),
+                        block_length(0),
+                        string_data_offset(0)
                 {
-//
-// okuri_ari_index  okuri_nasi_index ʲΤ褦ήǵޤ
-//
-// ================ SKK ι¤ȥǥå ==================
-// ;; okuri-ari entries.
-// u /.../
-// i /.../
-// a /.../  ιƬ okuri_ari_index
-// ;; okuri-nasi entries.
-//  /.../  ιƬ okuri_nasi_index
-//  /.../
+                }
+
+                int16_t start_block;
+                int16_t block_length;
+                int32_t string_data_offset;
+        };
+
+/// ü쥨ȥ 1 ʸܤȤΥ֥åϰϤǤ
+/**
+ * character  1 ʸܤ 2 ХȤǡ SkkUtility::getMidasiPrefix()
+ * ξ 16 ӥåȤƱͤǤ start_block ü쥨ȥƬ֥
+ * а֤ǡ block_length ĤΥ֥åˤʸǻϤޤ븫
+ * Ф٤ƴޤޤޤ
+ */
+        struct SpecialArray
+        {
+                SpecialArray () :
+                        character(0),
+                        block_length(0),
+                        start_block(0)
+                {
+                }
+
+                uint16_t character;
+                uint16_t block_length;
+                int32_t start_block;
+        };
+
+/// ϥåǵ᤿Фΰ֤Ǥ
+/**
+ * block ϥ֥åΥǥå (ü쥨ȥֹ̤) offset 
+ * ֥åǤιƬΥեåȤǤ
+ */
+        struct PerfectHashEntry
+        {
+                PerfectHashEntry () :
+                        block(0),
+                        offset(0)
+                {
+                }
+
+                int32_t block;
+                int32_t offset;
+        };
+
+/// ֥åΥ֥֥åǤ
+/**
+ * offset ϥ֥åǤΥ֥֥åƬԤΥեåȡ
+ * key_offset ϤιԤθФΥ֥֥åʸǼΰΥե
+ * ȤǤ
+ */
+        struct SubBlock
+        {
+                SubBlock () :
+                        offset(0),
+                        key_offset(0)
+                {
+                }
+
+                int32_t offset;
+                int32_t key_offset;
+        };
+
+        struct Block
+        {
+                Block () :
+                        offset(0),
+                        line_length_and_data_size(0)
+                {
+                }
+
+                int getOffset()
+                {
+                        return offset;
+                }
+
+                void setOffset(int scalar)
+                {
+                        offset = scalar;
+                }
+
+                int getDataSize()
+                {
+                        return line_length_and_data_size & 0xfffff;
+                }
+
+                void setLineLengthAndDataSize(int line_length, int data_size)
+                {
+                        line_length_and_data_size = (line_length << 20) | data_size;
+                }
+
+                int32_t offset;
+                int32_t line_length_and_data_size;
+        };
+
+        struct BlockShort
+        {
+                BlockShort () :
+                        data_size(0)
+                {
+                }
+
+                int getDataSize()
+                {
+                        return data_size;
+                }
+
+                void setDataSize(int size)
+                {
+                        data_size = static_cast<int16_t>(size);
+                }
+
+                int16_t data_size;
+        };
+
+private:
+/// okuri_ari_index  okuri_nasi_index ޤԤϵ֤ޤ
+        static bool get_index(const char *buffer, int filesize, int &okuri_ari_index, int &okuri_nasi_index)
+        {
+                DEBUG_ASSERT_POINTER(buffer);
+                for (;;)
+                {
+//
+// okuri_ari_index  okuri_nasi_index ʲΤ褦ήǵޤ
+//
+// ================ SKK ι¤ȥǥå ==================
+// ;; okuri-ari entries.
+// u /.../
+// i /.../
+// a /.../  ιƬ okuri_ari_index
+// ;; okuri-nasi entries.
+//  /.../  ιƬ okuri_nasi_index
+//  /.../
 //  /.../
 // ================================================================
 //
@@ -568,72 +1081,1202 @@ private:
                                         }
                                         else
                                         {
-                                                break;
+                                                break;
+                                        }
+                                }
+                                break;
+                        }
+                        okuri_nasi_index = SkkUtility::getNextLineIndex(buffer, okuri_nasi_index, filesize);
+                        if (okuri_nasi_index < 0)
+                        {
+                                return false;
+                        }
+                }
+                return true;
+        }
+
+        static bool append_terminator(FILE *file)
+        {
+                DEBUG_ASSERT_POINTER(file);
+// ߥ͡󥢥饤ΰ(4 bytes·)
+                char tmp[4];
+                for (int i = 0; i != 4; ++i)
+                {
+                        tmp[i] = 0;
+                }
+
+// 1 or 2 or 3 or 4 ХȤ 0 (Ǥ 4 Хȥ饤ʤ 4 Х)
+                long current = ftell(file);
+                if (fwrite(tmp, 4 - (current % 4), 1, file) < 1)
+                {
+                        return false;
+                }
+                return true;
+        }
+
+        static bool append_information(FILE *file,
+                                       int block_alignment_size,
+                                       int normal_size,
+                                       int normal_lines,
+                                       int special_size,
+                                       int special_lines,
+                                       int index_data_size,
+                                       int index_data_offset,
+                                       bool reply_record_flag)
+        {
+                DEBUG_ASSERT_POINTER(file);
+                Information information;
+                information.setReplyRecord(reply_record_flag);
+                information.set(Information::ID_BLOCK_ALIGNMENT_SIZE,
+                                block_alignment_size);
+                information.set(Information::ID_NORMAL_SIZE,
+                                normal_size);
+                information.set(Information::ID_NORMAL_LINES,
+                                normal_lines);
+                information.set(Information::ID_SPECIAL_SIZE,
+                                special_size);
+                information.set(Information::ID_SPECIAL_LINES,
+                                special_lines);
+                information.set(Information::ID_INDEX_DATA_SIZE,
+                                index_data_size);
+                information.set(Information::ID_INDEX_DATA_OFFSET,
+                                index_data_offset);
+
+                append_terminator(file);
+
+                if (fwrite(&information, sizeof(information), 1, file) < 1)
+                {
+                        return false;
+                }
+                return true;
+        }
+
+/// ĥǡΥǡ 8 ХȤǥ饤Ȥƽ񤭽Ф header ˥եåȤȥꤷޤԤϵ֤ޤ
+        static bool append_extension_section(FILE *file,
+                                             int extension_data_offset,
+                                             const void *p,
+                                             int size,
+                                             ExtensionDataHeader &header,
+                                             ExtensionDataHeader::Id id_offset,
+                                             ExtensionDataHeader::Id id_size)
+        {
+                DEBUG_ASSERT_POINTER(file);
+                char tmp[8];
+                for (int i = 0; i != 8; ++i)
+                {
+                        tmp[i] = 0;
+                }
+                int offset = static_cast<int>(ftell(file)) - extension_data_offset;
+                int padding = (8 - (offset % 8)) % 8;
+                if ((padding > 0) && (fwrite(tmp, static_cast<size_t>(padding), 1, file) < 1))
+                {
+                        return false;
+                }
+                header.set(id_offset, offset + padding);
+                header.set(id_size, size);
+                if ((size > 0) && (fwrite(p, static_cast<size_t>(size), 1, file) < 1))
+                {
+                        return false;
+                }
+                return true;
+        }
+
+/// start_block  block_length ĤΥ֥åˤĤƥǥѥåơ֥ 1 ԤޤǤʤϵ֤ޤ
+/**
+ * row[s] ˤϡ֥åκǸθФΥǥѥåǥå s
+ * ʾȤʤǽΥ֥å (start_block а) Ǽޤ
+ * ֥åʤ block_length Ǽޤ
+ *
+ * ϰ fixed_array_index ʳθФǽ֥å䡢
+ * ǥѥåǥå¤ФʤϺǤޤ
+ */
+        static bool create_dispatch_row(const uint64_t *key_prefix,
+                                        const int32_t *key_offset,
+                                        const char *string,
+                                        int start_block,
+                                        int block_length,
+                                        int fixed_array_index,
+                                        uint16_t *row)
+        {
+                if ((block_length <= 1) || (block_length > 0xffff))
+                {
+                        return false;
+                }
+                int before_index = 0;
+                for (int i = 0; i != block_length; ++i)
+                {
+                        if (SkkUtility::getFixedArrayIndex(string + *(key_offset + start_block + i)) != fixed_array_index)
+                        {
+                                return false;
+                        }
+                        int index = getDispatchIndex(*(key_prefix + start_block + i), fixed_array_index == -1);
+                        if (index < before_index)
+                        {
+                                return false;
+                        }
+                        before_index = index;
+                }
+                int block = 0;
+                for (int i = 0; i != DISPATCH_ROW_SIZE; ++i)
+                {
+                        while ((block < block_length) &&
+                               (getDispatchIndex(*(key_prefix + start_block + block), fixed_array_index == -1) < i))
+                        {
+                                ++block;
+                        }
+                        *(row + i) = static_cast<uint16_t>(block);
+                }
+                return true;
+        }
+
+/// start_block  block_length ĤΥ֥å鸫Ф midasi ޤ֥å (start_block а) ֤ޤ
+        static int get_block_for_midasi(const uint64_t *key_prefix,
+                                        const int32_t *key_offset,
+                                        const char *string,
+                                        int start_block,
+                                        int block_length,
+                                        const char *midasi)
+        {
+                const uint64_t midasi_prefix = SkkUtility::getMidasiPrefix(midasi);
+                const int midasi_size = SkkUtility::getTerminatedMidasiSize(midasi);
+                int low = 0;
+                int high = block_length;
+                while (low < high)
+                {
+                        int middle = (low + high) / 2;
+                        uint64_t prefix = *(key_prefix + start_block + middle);
+                        int tmp;
+                        if (prefix < midasi_prefix)
+                        {
+                                tmp = -1;
+                        }
+                        else if (prefix > midasi_prefix)
+                        {
+                                tmp = 1;
+                        }
+                        else
+                        {
+                                const char *key = string + *(key_offset + start_block + middle);
+                                tmp = SkkUtility::compareMidasi(key, 0, SkkUtility::getTerminatedMidasiSize(key), midasi, midasi_size);
+                        }
+                        if (tmp < 0)
+                        {
+                                low = middle + 1;
+                        }
+                        else
+                        {
+                                high = middle;
+                        }
+                }
+                return low;
+        }
+
+/// ü쥨ȥ 1 ʸܤȤΥ֥åϰϤޤǤʤϵ֤ޤ
+/**
+ * object ü쥨ȥ򤹤٤ޤ special_array 
+ * special_lines İʾǤɬפꡢ special_array_length 
+ * ǿ֤ޤ
+ */
+        static bool create_special_array(SkkJisyo &object,
+                                         const uint64_t *key_prefix,
+                                         const int32_t *key_offset,
+                                         const char *string,
+                                         int normal_block_length,
+                                         int special_block_length,
+                                         int special_lines,
+                                         SpecialArray *special_array,
+                                         int &special_array_length)
+        {
+                special_array_length = 0;
+                if ((special_block_length <= 0) || (special_lines <= 0))
+                {
+                        return false;
+                }
+                object.setState(STATE_SPECIAL);
+                if (!object.seek(SEEK_POSITION_TOP))
+                {
+                        return false;
+                }
+                const char *last_midasi = 0;
+                for (;;)
+                {
+                        const char *midasi = object.getMidasiPointer();
+                        uint16_t character = static_cast<uint16_t>(SkkUtility::getMidasiPrefix(midasi) >> 48);
+                        if ((special_array_length == 0) || ((special_array + special_array_length - 1)->character != character))
+                        {
+                                if (special_array_length > 0)
+                                {
+                                        if ((special_array + special_array_length - 1)->character > character)
+                                        {
+                                                return false;
+                                        }
+                                        (special_array + special_array_length - 1)->block_length = static_cast<uint16_t>(get_block_for_midasi(key_prefix,
+                                                                                                                                               key_offset,
+                                                                                                                                               string,
+                                                                                                                                               normal_block_length,
+                                                                                                                                               special_block_length,
+                                                                                                                                               last_midasi) - (special_array + special_array_length - 1)->start_block + 1);
+                                }
+                                if (special_array_length >= special_lines)
+                                {
+                                        return false;
+                                }
+                                (special_array + special_array_length)->character = character;
+                                (special_array + special_array_length)->start_block = get_block_for_midasi(key_prefix,
+                                                                                                           key_offset,
+                                                                                                           string,
+                                                                                                           normal_block_length,
+                                                                                                           special_block_length,
+                                                                                                           midasi);
+                                ++special_array_length;
+                        }
+                        last_midasi = midasi;
+                        if (!object.seek(SEEK_POSITION_NEXT))
+                        {
+                                break;
+                        }
+                }
+                (special_array + special_array_length - 1)->block_length = static_cast<uint16_t>(get_block_for_midasi(key_prefix,
+                                                                                                                       key_offset,
+                                                                                                                       string,
+                                                                                                                       normal_block_length,
+                                                                                                                       special_block_length,
+                                                                                                                       last_midasi) - (special_array + special_array_length - 1)->start_block + 1);
+                for (int i = 0; i != special_array_length; ++i)
+                {
+                        int start_block = (special_array + i)->start_block;
+                        if ((start_block >= special_block_length) ||
+                            ((special_array + i)->block_length == 0) ||
+                            (start_block + (special_array + i)->block_length > special_block_length))
+                        {
+                                return false;
+                        }
+                }
+                return true;
+        }
+
+/// object Τ٤ƤθФ֥롼ե륿 bloom_filter (bit_length ӥå) Ͽޤ
+        static void create_bloom_filter(SkkJisyo &object, uint64_t *bloom_filter, int bit_length)
+        {
+                for (int i = 0; i != bit_length / 64; ++i)
+                {
+                        *(bloom_filter + i) = 0;
+                }
+                const State state_table[] =
+                {
+                        STATE_NORMAL,
+                        STATE_SPECIAL,
+                };
+                for (int i = 0; i != static_cast<int>(sizeof(state_table) / sizeof(state_table[0])); ++i)
+                {
+                        object.setState(state_table[i]);
+                        if (object.size_table_[state_table[i]] <= 0)
+                        {
+                                continue;
+                        }
+                        object.seek(SEEK_POSITION_TOP);
+                        do
+                        {
+                                setBloomFilter(bloom_filter,
+                                               bit_length,
+                                               BLOOM_FILTER_HASH_LENGTH,
+                                               SkkUtility::getMidasiHash(object.getMidasiPointer()));
+                        }
+                        while (object.seek(SEEK_POSITION_NEXT));
+                }
+        }
+
+/// object Τ٤ƤθФˤĤƺǾϥåޤǤʤϵ֤ޤ
+/**
+ * block ޤ block_short ΥǡƸФޤ֥å
+ * ֥åΰ֤ޤ pilot  bucket_length ġ table 
+ * lines ĤǤɬפޤ
+ *
+ * ХåȤ礭¤١ХåΤ٤ƤθФ֤
+ * ޤѥåȤõޤФ 1 ĤΥХåȤ϶֤
+ * PERFECT_HASH_PILOT_DIRECT դľܳǼޤ
+ */
+        static bool create_perfect_hash(SkkJisyo &object,
+                                        Block *block,
+                                        BlockShort *block_short,
+                                        int normal_block_length,
+                                        int special_block_length,
+                                        int lines,
+                                        uint32_t *pilot,
+                                        int bucket_length,
+                                        PerfectHashEntry *table)
+        {
+                uint64_t *hash = new uint64_t[lines];
+                PerfectHashEntry *entry = new PerfectHashEntry[lines];
+                int *bucket_start = new int[bucket_length + 1];
+                int *bucket_key = new int[lines];
+                int *bucket_order = new int[bucket_length];
+                char *used = new char[lines];
+                bool result = true;
+
+// ƸФΥϥåͤȰ֤ޤ
+                int length = 0;
+                {
+                        const State state_table[] =
+                        {
+                                STATE_NORMAL,
+                                STATE_SPECIAL,
+                        };
+                        for (int i = 0; result && (i != static_cast<int>(sizeof(state_table) / sizeof(state_table[0]))); ++i)
+                        {
+                                int block_index = (state_table[i] == STATE_NORMAL) ? 0 : normal_block_length;
+                                const int block_index_end = (state_table[i] == STATE_NORMAL) ? normal_block_length : normal_block_length + special_block_length;
+                                int offset = 0;
+                                object.setState(state_table[i]);
+                                if (object.size_table_[state_table[i]] <= 0)
+                                {
+                                        continue;
+                                }
+                                object.seek(SEEK_POSITION_TOP);
+                                do
+                                {
+                                        for (;;)
+                                        {
+                                                if (block_index >= block_index_end)
+                                                {
+                                                        result = false;
+                                                        break;
+                                                }
+                                                int data_size = block ? (block + block_index)->getDataSize() : (block_short + block_index)->getDataSize();
+                                                if (offset < data_size)
+                                                {
+                                                        break;
+                                                }
+                                                ++block_index;
+                                                offset = 0;
+                                        }
+                                        if ((!result) || (length >= lines))
+                                        {
+                                                result = false;
+                                                break;
+                                        }
+                                        *(hash + length) = SkkUtility::getMidasiHash(object.getMidasiPointer());
+                                        (entry + length)->block = block_index;
+                                        (entry + length)->offset = offset;
+                                        ++length;
+                                        offset += object.getLineSize() + 1;
+                                }
+                                while (object.seek(SEEK_POSITION_NEXT));
+                        }
+                        if (length != lines)
+                        {
+                                result = false;
+                        }
+                }
+
+// ХåȤȤ˸ФʬФ¿ХåȤ¤٤ޤ
+                if (result)
+                {
+                        for (int i = 0; i != bucket_length + 1; ++i)
+                        {
+                                *(bucket_start + i) = 0;
+                        }
+                        for (int i = 0; i != lines; ++i)
+                        {
+                                ++*(bucket_start + getPerfectHashBucket(*(hash + i), bucket_length) + 1);
+                        }
+                        int size_maximum = 0;
+                        for (int i = 0; i != bucket_length; ++i)
+                        {
+                                if (size_maximum < *(bucket_start + i + 1))
+                                {
+                                        size_maximum = *(bucket_start + i + 1);
+                                }
+                                *(bucket_start + i + 1) += *(bucket_start + i);
+                        }
+                        for (int i = 0; i != lines; ++i)
+                        {
+                                *(used + i) = 0;
+                        }
+                        {
+                                int *position = new int[bucket_length];
+                                for (int i = 0; i != bucket_length; ++i)
+                                {
+                                        *(position + i) = *(bucket_start + i);
+                                }
+                                for (int i = 0; i != lines; ++i)
+                                {
+                                        int bucket = getPerfectHashBucket(*(hash + i), bucket_length);
+                                        *(bucket_key + *(position + bucket)) = i;
+                                        ++*(position + bucket);
+                                }
+                                delete[] position;
+                        }
+                        int order_length = 0;
+                        for (int size = size_maximum; size >= 0; --size)
+                        {
+                                for (int i = 0; i != bucket_length; ++i)
+                                {
+                                        if (*(bucket_start + i + 1) - *(bucket_start + i) == size)
+                                        {
+                                                *(bucket_order + order_length) = i;
+                                                ++order_length;
+                                        }
+                                }
+                        }
+                }
+
+// ѥåȤõޤ
+                if (result)
+                {
+                        int free_slot = 0;
+                        int slot_table[64];
+                        for (int i = 0; result && (i != bucket_length); ++i)
+                        {
+                                int bucket = *(bucket_order + i);
+                                int start = *(bucket_start + bucket);
+                                int size = *(bucket_start + bucket + 1) - start;
+                                if (size == 0)
+                                {
+                                        *(pilot + bucket) = 0;
+                                }
+                                else if (size == 1)
+                                {
+                                        while (*(used + free_slot))
+                                        {
+                                                ++free_slot;
+                                        }
+                                        *(pilot + bucket) = PERFECT_HASH_PILOT_DIRECT | static_cast<uint32_t>(free_slot);
+                                        *(used + free_slot) = 1;
+                                        *(table + free_slot) = *(entry + *(bucket_key + start));
+                                }
+                                else if (size > static_cast<int>(sizeof(slot_table) / sizeof(slot_table[0])))
+                                {
+                                        result = false;
+                                }
+                                else
+                                {
+                                        uint32_t p;
+                                        for (p = 0; p != PERFECT_HASH_PILOT_MAXIMUM; ++p)
+                                        {
+                                                int j;
+                                                for (j = 0; j != size; ++j)
+                                                {
+                                                        int slot = getPerfectHashSlot(*(hash + *(bucket_key + start + j)), p, lines);
+                                                        if (*(used + slot))
+                                                        {
+                                                                break;
+                                                        }
+                                                        int k;
+                                                        for (k = 0; k != j; ++k)
+                                                        {
+                                                                if (slot_table[k] == slot)
+                                                                {
+                                                                        break;
+                                                                }
+                                                        }
+                                                        if (k != j)
+                                                        {
+                                                                break;
+                                                        }
+                                                        slot_table[j] = slot;
+                                                }
+                                                if (j == size)
+                                                {
+                                                        break;
+                                                }
+                                        }
+                                        if (p == PERFECT_HASH_PILOT_MAXIMUM)
+                                        {
+// ƱϥåͤθФʤɡѥåȤդޤ
+                                                result = false;
+                                        }
+                                        else
+                                        {
+                                                *(pilot + bucket) = p;
+                                                for (int j = 0; j != size; ++j)
+                                                {
+                                                        *(used + slot_table[j]) = 1;
+                                                        *(table + slot_table[j]) = *(entry + *(bucket_key + start + j));
+                                                }
+                                        }
+                                }
+                        }
+                }
+
+                delete[] used;
+                delete[] bucket_order;
+                delete[] bucket_key;
+                delete[] bucket_start;
+                delete[] entry;
+                delete[] hash;
+
+                return result;
+        }
+
+/// object Τ٤ƤιԤ֥åȤˤ褽 sub_block_size ХȤΥ֥֥åʬޤǤʤϵ֤ޤ
+/**
+ * ֥åƬԤϤޤꡢƬԤ sub_block_size ХȰʾΥ
+ * 줿ǽιԤǼΥ֥֥åϤޤ sub_block_index 
+ * block_length + 1 ġ sub_block  lines ġ sub_block_string 
+ * string_size_maximum ХȤǤɬפޤ
+ *
+ * sub_block_length  sub_block_string_size ˺֥֥å
+ * ʸǼΰΥ֤ޤ
+ */
+        static bool create_sub_block(SkkJisyo &object,
+                                     Block *block,
+                                     BlockShort *block_short,
+                                     int normal_block_length,
+                                     int special_block_length,
+                                     int lines,
+                                     int sub_block_size,
+                                     int32_t *sub_block_index,
+                                     SubBlock *sub_block,
+                                     char *sub_block_string,
+                                     int string_size_maximum,
+                                     int &sub_block_length,
+                                     int &sub_block_string_size)
+        {
+                const int block_length = normal_block_length + special_block_length;
+                for (int i = 0; i != block_length + 1; ++i)
+                {
+                        *(sub_block_index + i) = -1;
+                }
+                bool result = true;
+                sub_block_length = 0;
+                sub_block_string_size = 0;
+                const State state_table[] =
+                {
+                        STATE_NORMAL,
+                        STATE_SPECIAL,
+                };
+                for (int i = 0; result && (i != static_cast<int>(sizeof(state_table) / sizeof(state_table[0]))); ++i)
+                {
+                        int block_index = (state_table[i] == STATE_NORMAL) ? 0 : normal_block_length;
+                        const int block_index_end = (state_table[i] == STATE_NORMAL) ? normal_block_length : block_length;
+                        int offset = 0;
+                        int sub_block_offset = 0;
+                        object.setState(state_table[i]);
+                        if (object.size_table_[state_table[i]] <= 0)
+                        {
+                                continue;
+                        }
+                        object.seek(SEEK_POSITION_TOP);
+                        do
+                        {
+                                for (;;)
+                                {
+                                        if (block_index >= block_index_end)
+                                        {
+                                                result = false;
+                                                break;
+                                        }
+                                        int data_size = block ? (block + block_index)->getDataSize() : (block_short + block_index)->getDataSize();
+                                        if (offset < data_size)
+                                        {
+                                                break;
+                                        }
+                                        ++block_index;
+                                        offset = 0;
+                                }
+                                if (!result)
+                                {
+                                        break;
+                                }
+                                if ((*(sub_block_index + block_index) < 0) ||
+                                    (offset - sub_block_offset >= sub_block_size))
+                                {
+                                        const int terminator_size = 1;
+                                        int midasi_size = object.getMidasiSize();
+                                        if ((sub_block_length >= lines) ||
+                                            (sub_block_string_size + midasi_size + terminator_size > string_size_maximum))
+                                        {
+                                                result = false;
+                                                break;
+                                        }
+                                        if (*(sub_block_index + block_index) < 0)
+                                        {
+                                                *(sub_block_index + block_index) = sub_block_length;
+                                        }
+                                        (sub_block + sub_block_length)->offset = offset;
+                                        (sub_block + sub_block_length)->key_offset = sub_block_string_size;
+                                        const char *midasi = object.getMidasiPointer();
+                                        for (int n = 0; n != midasi_size; ++n)
+                                        {
+                                                *(sub_block_string + sub_block_string_size + n) = *(midasi + n);
+                                        }
+                                        *(sub_block_string + sub_block_string_size + midasi_size) = ' ';
+                                        sub_block_string_size += midasi_size + terminator_size;
+                                        ++sub_block_length;
+                                        sub_block_offset = offset;
+                                }
+                                offset += object.getLineSize() + 1;
+                        }
+                        while (object.seek(SEEK_POSITION_NEXT));
+                }
+// Ԥʤ֥åϼΥ֥åƱֹˤ֥֥å
+// Ϥˤޤ
+                *(sub_block_index + block_length) = sub_block_length;
+                for (int i = block_length - 1; i >= 0; --i)
+                {
+                        if (*(sub_block_index + i) < 0)
+                        {
+                                *(sub_block_index + i) = *(sub_block_index + i + 1);
+                        }
+                }
+                return result;
+        }
+
+/// ĥǡ񤭽ФޤԤϵ֤ޤ
+/**
+ * string  normal_block_length + special_block_length ĤθФ
+ * ʸǼΰǤ dispatch_flag ʤХǥѥåơ֥
+ * 񤭽Фޤü쥨ȥ 1 ʸܤȤΥ֥åϰϤȥ֥롼
+ * ե륿 object θФޤ perfect_hash_flag 
+ * ʤкǾϥå񤭽Ф perfect_hash_result ˽񤭽Ф
+ * ɤ֤ޤ sub_block_size  0 ǤʤХ֥֥å
+ * Фޤ
+ *
+ * extension_data_offset  extension_data_size ˽񤭽Фĥǡ
+ * ΥեåȤȥ֤ޤ
+ */
+        static bool append_extension_data(FILE *file,
+                                          SkkJisyo &object,
+                                          const FixedArray *fixed_array,
+                                          const char *string,
+                                          int normal_block_length,
+                                          Block *block,
+                                          BlockShort *block_short,
+                                          int special_block_length,
+                                          bool dispatch_flag,
+                                          bool perfect_hash_flag,
+                                          bool &perfect_hash_result,
+                                          int sub_block_size,
+                                          int &extension_data_offset,
+                                          int &extension_data_size)
+        {
+                DEBUG_ASSERT_POINTER(file);
+                DEBUG_ASSERT_POINTER(fixed_array);
+                DEBUG_ASSERT_POINTER(string);
+                extension_data_offset = static_cast<int>(ftell(file));
+
+                ExtensionDataHeader extension_data_header;
+                if (fwrite(&extension_data_header, sizeof(extension_data_header), 1, file) < 1)
+                {
+                        return false;
+                }
+
+                const int block_length = normal_block_length + special_block_length;
+                uint64_t *key_prefix = new uint64_t[block_length];
+                int32_t *key_offset = new int32_t[block_length];
+                {
+                        const char *p = string;
+                        for (int i = 0; i != block_length; ++i)
+                        {
+                                *(key_prefix + i) = SkkUtility::getMidasiPrefix(p);
+                                *(key_offset + i) = static_cast<int32_t>(p - string);
+                                p = SkkUtility::getNextPointer<' '>(p);
+                        }
+                }
+
+                bool result = append_extension_section(file,
+                                                       extension_data_offset,
+                                                       key_prefix,
+                                                       static_cast<int>(sizeof(uint64_t)) * block_length,
+                                                       extension_data_header,
+                                                       ExtensionDataHeader::ID_KEY_PREFIX_OFFSET,
+                                                       ExtensionDataHeader::ID_KEY_PREFIX_SIZE);
+                if (result)
+                {
+                        result = append_extension_section(file,
+                                                          extension_data_offset,
+                                                          key_offset,
+                                                          static_cast<int>(sizeof(int32_t)) * block_length,
+                                                          extension_data_header,
+                                                          ExtensionDataHeader::ID_KEY_OFFSET_OFFSET,
+                                                          ExtensionDataHeader::ID_KEY_OFFSET_SIZE);
+                }
+
+                if (result && dispatch_flag)
+                {
+// ǥѥåơ֥Ϲԥǥå int32_t[DISPATCH_ROW_INDEX_LENGTH]
+// ȡ³ uint16_t[DISPATCH_ROW_SIZE] ιԤʤޤ
+                        const int row_index_size = static_cast<int>(sizeof(int32_t)) * DISPATCH_ROW_INDEX_LENGTH;
+                        const int row_size = static_cast<int>(sizeof(uint16_t)) * DISPATCH_ROW_SIZE;
+                        char *dispatch = new char[row_index_size + row_size * DISPATCH_ROW_LENGTH];
+                        int32_t *row_index = reinterpret_cast<int32_t*>(dispatch);
+                        int row_length = 0;
+                        for (int i = 0; i != DISPATCH_ROW_INDEX_LENGTH; ++i)
+                        {
+                                *(row_index + i) = -1;
+                        }
+                        for (int i = 0; i != DISPATCH_ROW_LENGTH; ++i)
+                        {
+                                int start_block;
+                                int length;
+                                int fixed_array_index;
+                                if (i == DISPATCH_ROW_SPECIAL)
+                                {
+                                        start_block = normal_block_length;
+                                        length = special_block_length;
+                                        fixed_array_index = -1;
+                                }
+                                else
+                                {
+                                        start_block = (fixed_array + i)->start_block;
+                                        length = (fixed_array + i)->block_length;
+                                        fixed_array_index = i;
+                                }
+                                uint16_t *row = reinterpret_cast<uint16_t*>(dispatch + row_index_size + row_size * row_length);
+                                if (create_dispatch_row(key_prefix, key_offset, string, start_block, length, fixed_array_index, row))
+                                {
+                                        *(row_index + i) = row_length;
+                                        ++row_length;
+                                }
+                        }
+                        result = append_extension_section(file,
+                                                          extension_data_offset,
+                                                          dispatch,
+                                                          row_index_size + row_size * row_length,
+                                                          extension_data_header,
+                                                          ExtensionDataHeader::ID_DISPATCH_OFFSET,
+                                                          ExtensionDataHeader::ID_DISPATCH_SIZE);
+                        delete[] dispatch;
+                }
+
+                if (result)
+                {
+                        Information information;
+                        object.getInformation(information);
+                        int special_lines = information.get(Information::ID_SPECIAL_LINES);
+                        if (special_lines > 0)
+                        {
+                                SpecialArray *special_array = new SpecialArray[special_lines];
+                                int special_array_length;
+// Ǥʤü쥨ȥΤõʤΤǡĥǡ
+// ޤ᤺³ޤ
+                                if (create_special_array(object,
+                                                         key_prefix,
+                                                         key_offset,
+                                                         string,
+                                                         normal_block_length,
+                                                         special_block_length,
+                                                         special_lines,
+                                                         special_array,
+                                                         special_array_length))
+                                {
+                                        result = append_extension_section(file,
+                                                                          extension_data_offset,
+                                                                          special_array,
+                                                                          static_cast<int>(sizeof(SpecialArray)) * special_array_length,
+                                                                          extension_data_header,
+                                                                          ExtensionDataHeader::ID_SPECIAL_ARRAY_OFFSET,
+                                                                          ExtensionDataHeader::ID_SPECIAL_ARRAY_SIZE);
+                                }
+                                delete[] special_array;
+                        }
+                }
+
+                if (result)
+                {
+                        Information information;
+                        object.getInformation(information);
+                        int lines = information.get(Information::ID_NORMAL_LINES) + information.get(Information::ID_SPECIAL_LINES);
+                        const int64_t bit_length_64 = (static_cast<int64_t>(lines) * BLOOM_FILTER_BITS_PER_KEY + 63) / 64 * 64;
+// ֥롼ե륿ϾάǤΤǡӥåȿ礭᤮кޤ
+                        if ((lines > 0) && (bit_length_64 <= BLOOM_FILTER_BIT_LENGTH_MAXIMUM))
+                        {
+                                int bit_length = static_cast<int>(bit_length_64);
+                                uint64_t *bloom_filter = new uint64_t[bit_length / 64];
+                                create_bloom_filter(object, bloom_filter, bit_length);
+                                result = append_extension_section(file,
+                                                                  extension_data_offset,
+                                                                  bloom_filter,
+                                                                  bit_length / 8,
+                                                                  extension_data_header,
+                                                                  ExtensionDataHeader::ID_BLOOM_FILTER_OFFSET,
+                                                                  ExtensionDataHeader::ID_BLOOM_FILTER_SIZE);
+                                extension_data_header.set(ExtensionDataHeader::ID_BLOOM_FILTER_HASH_LENGTH, BLOOM_FILTER_HASH_LENGTH);
+                                delete[] bloom_filter;
+                        }
+                }
+
+                perfect_hash_result = false;
+                if (result && perfect_hash_flag)
+                {
+                        Information information;
+                        object.getInformation(information);
+                        int lines = information.get(Information::ID_NORMAL_LINES) + information.get(Information::ID_SPECIAL_LINES);
+                        if (lines > 0)
+                        {
+                                int bucket_length = (lines + PERFECT_HASH_BUCKET_SIZE - 1) / PERFECT_HASH_BUCKET_SIZE;
+                                uint32_t *pilot = new uint32_t[bucket_length];
+                                PerfectHashEntry *table = new PerfectHashEntry[lines];
+                                if (create_perfect_hash(object,
+                                                        block,
+                                                        block_short,
+                                                        normal_block_length,
+                                                        special_block_length,
+                                                        lines,
+                                                        pilot,
+                                                        bucket_length,
+                                                        table))
+                                {
+                                        result = append_extension_section(file,
+                                                                          extension_data_offset,
+                                                                          pilot,
+                                                                          static_cast<int>(sizeof(uint32_t)) * bucket_length,
+                                                                          extension_data_header,
+                                                                          ExtensionDataHeader::ID_PERFECT_HASH_PILOT_OFFSET,
+                                                                          ExtensionDataHeader::ID_PERFECT_HASH_PILOT_SIZE);
+                                        if (result)
+                                        {
+                                                result = append_extension_section(file,
+                                                                                  extension_data_offset,
+                                                                                  table,
+                                                                                  static_cast<int>(sizeof(PerfectHashEntry)) * lines,
+                                                                                  extension_data_header,
+                                                                                  ExtensionDataHeader::ID_PERFECT_HASH_TABLE_OFFSET,
+                                                                                  ExtensionDataHeader::ID_PERFECT_HASH_TABLE_SIZE);
+                                        }
+                                        perfect_hash_result = result;
+                                }
+                                else
+                                {
+                                        SkkUtility::printf("perfect hash creation failed (ignored)\n");
+                                }
+                                delete[] table;
+                                delete[] pilot;
+                        }
+                }
+
+                if (result && (sub_block_size > 0))
+                {
+                        Information information;
+                        object.getInformation(information);
+                        int lines = information.get(Information::ID_NORMAL_LINES) + information.get(Information::ID_SPECIAL_LINES);
+                        int string_size_maximum = information.get(Information::ID_NORMAL_SIZE) + information.get(Information::ID_SPECIAL_SIZE);
+                        if (lines > 0)
+                        {
+                                int32_t *sub_block_index = new int32_t[block_length + 1];
+                                SubBlock *sub_block = new SubBlock[lines];
+                                char *sub_block_string = new char[string_size_maximum];
+                                int sub_block_length;
+                                int sub_block_string_size;
+                                result = create_sub_block(object,
+                                                          block,
+                                                          block_short,
+                                                          normal_block_length,
+                                                          special_block_length,
+                                                          lines,
+                                                          sub_block_size,
+                                                          sub_block_index,
+                                                          sub_block,
+                                                          sub_block_string,
+                                                          string_size_maximum,
+                                                          sub_block_length,
+                                                          sub_block_string_size);
+                                if (result)
+                                {
+                                        result = append_extension_section(file,
+                                                                          extension_data_offset,
+                                                                          sub_block_index,
+                                                                          static_cast<int>(sizeof(int32_t)) * (block_length + 1),
+                                                                          extension_data_header,
+                                                                          ExtensionDataHeader::ID_SUB_BLOCK_INDEX_OFFSET,
+                                                                          ExtensionDataHeader::ID_SUB_BLOCK_INDEX_SIZE);
+                                }
+                                if (result)
+                                {
+                                        result = append_extension_section(file,
+                                                                          extension_data_offset,
+                                                                          sub_block,
+                                                                          static_cast<int>(sizeof(SubBlock)) * sub_block_length,
+                                                                          extension_data_header,
+                                                                          ExtensionDataHeader::ID_SUB_BLOCK_OFFSET,
+                                                                          ExtensionDataHeader::ID_SUB_BLOCK_SIZE);
+                                }
+                                if (result)
+                                {
+                                        result = append_extension_section(file,
+                                                                          extension_data_offset,
+                                                                          sub_block_string,
+                                                                          sub_block_string_size,
+                                                                          extension_data_header,
+                                                                          ExtensionDataHeader::ID_SUB_BLOCK_STRING_OFFSET,
+                                                                          ExtensionDataHeader::ID_SUB_BLOCK_STRING_SIZE);
+                                }
+                                delete[] sub_block_string;
+                                delete[] sub_block;
+                                delete[] sub_block_index;
+                        }
+                }
+
+                delete[] key_offset;
+                delete[] key_prefix;
+
+                if (result)
+                {
+                        extension_data_size = static_cast<int>(ftell(file)) - extension_data_offset;
+                        if ((fseek(file, extension_data_offset, SEEK_SET) == -1) ||
+                            (fwrite(&extension_data_header, sizeof(extension_data_header), 1, file) < 1) ||
+                            (fseek(file, 0, SEEK_END) == -1))
+                        {
+                                result = false;
+                        }
+                }
+                return result;
+        }
+
+/// ƹԤ쥳ɤʤСѴʸפ "1" Υ򡢤Ǥʤ 0 ֤ޤ
+        int get_reply_record_size()
+        {
+                return (information_.get(Information::ID_BIT_FLAG) & Information::BIT_FLAG_REPLY_RECORD) ? 1 : 0;
+        }
+
+/// ȥ饤Υ i ȥ j Ӥޤͤ strcmp(3) ƱͤǤ
+        static int compare_trie_key(const char *key, const int *key_offset, const int *key_size, int i, int j)
+        {
+                const unsigned char *p_1 = reinterpret_cast<const unsigned char*>(key + *(key_offset + i));
+                const unsigned char *p_2 = reinterpret_cast<const unsigned char*>(key + *(key_offset + j));
+                int size_1 = *(key_size + i);
+                int size_2 = *(key_size + j);
+                for (int k = 0; (k != size_1) && (k != size_2); ++k)
+                {
+                        if (*(p_1 + k) != *(p_2 + k))
+                        {
+                                return *(p_1 + k) - *(p_2 + k);
+                        }
+                }
+                return size_1 - size_2;
+        }
+
+/// object Τ٤ƤθФȥ饤ޤ entry ˤϸФιƬΥեƬΥեåȤȥ饤ͤν֤ޤǤʤϵ֤ޤ
+/**
+ * ϡ֤Ҥ餬ʥ󥳡ɡפǥɤФĤޤ SKK 
+ * θФΤΤǤξ¤٤뤿ᡢ륭ǻϤޤ븫
+ * ϥȥ饤ͤϢ³ޤƱФʣ¸ߤϺǽΤ
+ * ΤȤޤ
+ */
+        static bool create_trie(SkkJisyo &object,
+                                Information &information,
+                                SkkDoubleArray &double_array,
+                                int32_t *&entry,
+                                int &entry_length)
+        {
+// ̾泌ȥü쥨ȥϢ³ƤΤǡޤȤ 1 ĤΥХ
+// եȤưޤ
+                object.setState(STATE_NORMAL);
+                const char *buffer = object.getBuffer();
+                int size = information.get(Information::ID_NORMAL_SIZE) + information.get(Information::ID_SPECIAL_SIZE);
+                if ((buffer == 0) || (size <= 0))
+                {
+                        return false;
+                }
+                int lines = 0;
+                for (int index = 0; index >= 0; index = SkkUtility::getNextLineIndex(buffer, index, size))
+                {
+                        ++lines;
+                }
+
+                const int key_buffer_size = size * 2;
+                char *key = new char[key_buffer_size];
+                int *key_offset = new int[lines];
+                int *key_size = new int[lines];
+                int *line_index = new int[lines];
+                bool result = true;
+                {
+                        int index = 0;
+                        int key_index = 0;
+                        for (int i = 0; i != lines; ++i)
+                        {
+                                int tmp = SkkUtility::decodeHiragana(buffer + index, key + key_index, key_buffer_size - key_index);
+                                if (tmp == 0)
+                                {
+                                        if (*(buffer + index) != '\1')
+                                        {
+                                                result = false;
+                                                break;
+                                        }
+                                        for (tmp = 0; *(buffer + index + 1 + tmp) != ' '; ++tmp)
+                                        {
+                                                if ((index + 1 + tmp >= size) || (key_index + tmp >= key_buffer_size))
+                                                {
+                                                        result = false;
+                                                        break;
+                                                }
+                                                *(key + key_index + tmp) = *(buffer + index + 1 + tmp);
+                                        }
+                                        if (!result)
+                                        {
+                                                break;
+                                        }
+                                }
+                                *(key_offset + i) = key_index;
+                                *(key_size + i) = tmp;
+                                *(line_index + i) = index;
+                                key_index += tmp;
+                                index = SkkUtility::getNextLineIndex(buffer, index, size);
+                        }
+                }
+
+// ۤܥȺѤߤʤΤ sortMidasi() Ʊͤ˥륽ȤȤޤ
+                int *order = new int[lines];
+                for (int i = 0; i != lines; ++i)
+                {
+                        *(order + i) = i;
+                }
+                if (result)
+                {
+                        int h;
+                        for (h = 1; h < lines / 9; h = h * 3 + 1)
+                        {
+                        }
+                        for (; h > 0; h /= 3)
+                        {
+                                for (int i = h; i < lines; ++i)
+                                {
+                                        int j = i;
+                                        while ((j >= h) &&
+                                               (compare_trie_key(key, key_offset, key_size, *(order + j - h), *(order + j)) > 0))
+                                        {
+                                                int tmp = *(order + j);
+                                                *(order + j) = *(order + j - h);
+                                                *(order + j - h) = tmp;
+                                                j -= h;
                                         }
                                 }
-                                break;
-                        }
-                        okuri_nasi_index = SkkUtility::getNextLineIndex(buffer, okuri_nasi_index, filesize);
-                        if (okuri_nasi_index < 0)
-                        {
-                                return false;
                         }
                 }
-                return true;
-        }
 
-        static bool append_terminator(FILE *file)
-        {
-                DEBUG_ASSERT_POINTER(file);
-// ߥ͡󥢥饤ΰ(4 bytes·)
-                char tmp[4];
-                for (int i = 0; i != 4; ++i)
+                int *sorted_key_offset = new int[lines];
+                int *sorted_key_size = new int[lines];
+                entry = new int32_t[lines];
+                entry_length = 0;
+                for (int i = 0; result && (i != lines); ++i)
                 {
-                        tmp[i] = 0;
+                        if ((i > 0) && (compare_trie_key(key, key_offset, key_size, *(order + i - 1), *(order + i)) == 0))
+                        {
+                                continue;
+                        }
+                        *(sorted_key_offset + entry_length) = *(key_offset + *(order + i));
+                        *(sorted_key_size + entry_length) = *(key_size + *(order + i));
+                        *(entry + entry_length) = *(line_index + *(order + i));
+                        ++entry_length;
                 }
 
-// 1 or 2 or 3 or 4 ХȤ 0 (Ǥ 4 Хȥ饤ʤ 4 Х)
-                long current = ftell(file);
-                if (fwrite(tmp, 4 - (current % 4), 1, file) < 1)
+                if (result)
                 {
-                        return false;
+                        result = double_array.build(key, sorted_key_offset, sorted_key_size, entry_length);
                 }
-                return true;
+
+                delete[] sorted_key_size;
+                delete[] sorted_key_offset;
+                delete[] order;
+                delete[] line_index;
+                delete[] key_size;
+                delete[] key_offset;
+                delete[] key;
+
+                return result;
         }
 
-        static bool append_information(FILE *file,
-                                       int block_alignment_size,
-                                       int normal_size,
-                                       int normal_lines,
-                                       int special_size,
-                                       int special_lines,
-                                       int index_data_size,
-                                       int index_data_offset)
+/// entry ν object ΡѴʸפסƹԤָФפȥڡˤ text ֤ޤǤʤϵ֤ޤ
+/**
+ * text  delete[] ɬפޤ entry  text Υեå
+ * ˡ information  normal  special Υ text ΤΤ˽
+ * ޤ
+ */
+        static bool create_candidate_pool(SkkJisyo &object,
+                                          Information &information,
+                                          int32_t *entry,
+                                          int entry_length,
+                                          SkkCandidatePool &candidate_pool,
+                                          char *&text,
+                                          int &text_size)
         {
-                DEBUG_ASSERT_POINTER(file);
-                Information information;
-                information.set(Information::ID_BLOCK_ALIGNMENT_SIZE,
-                                block_alignment_size);
-                information.set(Information::ID_NORMAL_SIZE,
-                                normal_size);
-                information.set(Information::ID_NORMAL_LINES,
-                                normal_lines);
-                information.set(Information::ID_SPECIAL_SIZE,
-                                special_size);
-                information.set(Information::ID_SPECIAL_LINES,
-                                special_lines);
-                information.set(Information::ID_INDEX_DATA_SIZE,
-                                index_data_size);
-                information.set(Information::ID_INDEX_DATA_OFFSET,
-                                index_data_offset);
+                object.setState(STATE_NORMAL);
+                const char *buffer = object.getBuffer();
+                int normal_size = information.get(Information::ID_NORMAL_SIZE);
+                int size = normal_size + information.get(Information::ID_SPECIAL_SIZE);
+                if ((buffer == 0) || (size <= 0))
+                {
+                        return false;
+                }
+                const int reply_record_size = object.get_reply_record_size();
+                for (int i = 0; i != entry_length; ++i)
+                {
+                        int index = *(entry + i);
+                        if (!candidate_pool.add(SkkUtility::getHenkanmojiretsuPointer(buffer, index, size) + reply_record_size,
+                                                SkkUtility::getHenkanmojiretsuSize(buffer, index, size) - reply_record_size))
+                        {
+                                return false;
+                        }
+                }
+                candidate_pool.build();
 
-                append_terminator(file);
+                int lines = 0;
+                for (int index = 0; index >= 0; index = SkkUtility::getNextLineIndex(buffer, index, size))
+                {
+                        ++lines;
+                }
+                int *line_index = new int[lines];
+                int *text_index = new int[lines];
+                text = new char[size];
+                text_size = 0;
+                int text_normal_size = 0;
+                {
+                        int i = 0;
+                        for (int index = 0; index >= 0; index = SkkUtility::getNextLineIndex(buffer, index, size))
+                        {
+                                if (index == normal_size)
+                                {
+                                        text_normal_size = text_size;
+                                }
+                                *(line_index + i) = index;
+                                *(text_index + i) = text_size;
+                                const int space_size = 1;
+                                int midasi_size = SkkUtility::getMidasiSize(buffer, index, size) + space_size;
+                                for (int n = 0; n != midasi_size; ++n)
+                                {
+                                        *(text + text_size++) = *(buffer + index + n);
+                                }
+                                *(text + text_size++) = '\n';
+                                ++i;
+                        }
+                }
+                if (normal_size == size)
+                {
+                        text_normal_size = text_size;
+                }
 
-                if (fwrite(&information, sizeof(information), 1, file) < 1)
+                bool result = true;
+                for (int i = 0; i != entry_length; ++i)
                 {
-                        return false;
+                        int low = 0;
+                        int high = lines;
+                        while (low < high)
+                        {
+                                int middle = low + (high - low) / 2;
+                                if (*(line_index + middle) < *(entry + i))
+                                {
+                                        low = middle + 1;
+                                }
+                                else
+                                {
+                                        high = middle;
+                                }
+                        }
+                        if ((low == lines) || (*(line_index + low) != *(entry + i)))
+                        {
+                                result = false;
+                                break;
+                        }
+                        *(entry + i) = *(text_index + low);
                 }
-                return true;
+                information.set(Information::ID_NORMAL_SIZE, text_normal_size);
+                information.set(Information::ID_SPECIAL_SIZE, text_size - text_normal_size);
+
+                delete[] text_index;
+                delete[] line_index;
+
+                return result;
         }
 
         static bool create_dictionary_for_class_skk_jisyo_write_temporary_raw(FILE *file, const char *buffer, int index, int line_size)
@@ -732,7 +2375,7 @@ private:
                                 bool copy_okuri_nasi = false;
                                 if ((okuri_ari_index > 0) && (okuri_nasi_index >= 0))
                                 {
-                                        int tmp = SkkUtility::compareMidasi(buffer, okuri_ari_index, filesize, buffer + okuri_nasi_index);
+                                        int tmp = SkkUtility::compareMidasi(buffer, okuri_ari_index, filesize, buffer + okuri_nasi_index, filesize - okuri_nasi_index);
                                         if (tmp == 0)
                                         {
 // ʤ ari/nasi ƱФ (ä餪)
@@ -900,7 +2543,7 @@ private:
                 return result;
         }
 
-        static bool create_dictionary_for_class_skk_jisyo_sort_core(FILE *file, char *buffer, int filesize, int lines)
+        static bool create_dictionary_for_class_skk_jisyo_sort_core(FILE *file, char *buffer, int filesize, int lines, bool reply_record_flag)
         {
                 DEBUG_ASSERT_POINTER(file);
                 DEBUG_ASSERT_POINTER(buffer);
@@ -920,8 +2563,22 @@ private:
 
                 for (int i = 0; i != lines; ++i)
                 {
-                        int line_size = SkkUtility::getLineSize(buffer, (sort_key + i)->index, filesize);
-                        if (fwrite(buffer + (sort_key + i)->index, static_cast<size_t>(line_size + cr_size), 1, file) < 1)
+                        int line_index = (sort_key + i)->index;
+                        int line_size = SkkUtility::getLineSize(buffer, line_index, filesize);
+                        if (reply_record_flag)
+                        {
+// ָФפȥڡθ˥ץȥ "1" 򶴤ߤޤ
+                                const int space_size = 1;
+                                int midasi_size = SkkUtility::getMidasiSize(buffer, line_index, filesize) + space_size;
+                                if ((fwrite(buffer + line_index, static_cast<size_t>(midasi_size), 1, file) < 1) ||
+                                    (fwrite("1", 1, 1, file) < 1) ||
+                                    (fwrite(buffer + line_index + midasi_size, static_cast<size_t>(line_size + cr_size - midasi_size), 1, file) < 1))
+                                {
+                                        result = false;
+                                        break;
+                                }
+                        }
+                        else if (fwrite(buffer + line_index, static_cast<size_t>(line_size + cr_size), 1, file) < 1)
                         {
                                 result = false;
                                 break;
@@ -936,7 +2593,8 @@ private:
                                                                          const char *filename_special,
                                                                          int okuri_ari_lines,
                                                                          int okuri_nasi_lines,
-                                                                         int special_okuri_nasi_lines)
+                                                                         int special_okuri_nasi_lines,
+                                                                         bool reply_record_flag)
         {
                 DEBUG_ASSERT_POINTER(filename_destination);
                 DEBUG_ASSERT_POINTER(filename_normal);
@@ -965,11 +2623,12 @@ private:
                                 }
                                 else
                                 {
-                                        normal_size = mmap.getFilesize();
                                         result = create_dictionary_for_class_skk_jisyo_sort_core(file,
                                                                                                  buffer,
-                                                                                                 normal_size,
-                                                                                                 okuri_ari_lines + okuri_nasi_lines);
+                                                                                                 mmap.getFilesize(),
+                                                                                                 okuri_ari_lines + okuri_nasi_lines,
+                                                                                                 reply_record_flag);
+                                        normal_size = static_cast<int>(ftell(file));
                                 }
                         }
 
@@ -983,11 +2642,12 @@ private:
                                 }
                                 else
                                 {
-                                        special_size = mmap.getFilesize();
                                         result = create_dictionary_for_class_skk_jisyo_sort_core(file,
                                                                                                  buffer,
-                                                                                                 special_size,
-                                                                                                 special_okuri_nasi_lines);
+                                                                                                 mmap.getFilesize(),
+                                                                                                 special_okuri_nasi_lines,
+                                                                                                 reply_record_flag);
+                                        special_size = static_cast<int>(ftell(file)) - normal_size;
                                 }
                         }
 
@@ -1000,7 +2660,8 @@ private:
                                                             special_size,
                                                             special_okuri_nasi_lines,
                                                             0,
-                                                            0);
+                                                            0,
+                                                            reply_record_flag);
                                 if (!result)
                                 {
                                         DEBUG_PRINTF("append_information() failed.\n");
@@ -1032,7 +2693,8 @@ private:
                                                           const char *buffer,
                                                           int filesize,
                                                           int okuri_ari_index,
-                                                          int okuri_nasi_index)
+                                                          int okuri_nasi_index,
+                                                          bool reply_record_flag)
         {
                 DEBUG_ASSERT_POINTER(filename_destination);
                 DEBUG_ASSERT_POINTER(buffer);
@@ -1071,7 +2733,8 @@ private:
                                                                                       tmp_filename_special,
                                                                                       okuri_ari_lines,
                                                                                       okuri_nasi_lines,
-                                                                                      special_okuri_nasi_lines);
+                                                                                      special_okuri_nasi_lines,
+                                                                                      reply_record_flag);
                 }
                 if (unlink(tmp_filename_normal) == -1)
                 {
@@ -1675,6 +3338,83 @@ private:
         }
 
 public:
+/// SkkUtility::getMidasiPrefix() ץեå顢ǥѥåơ֥ (0  DISPATCH_ROW_SIZE - 1) ֤ޤ
+/**
+ * ̾泌ȥǤ 2 ʸܡü쥨ȥǤ 1 ʸܤ 1 Х
+ * ֤ޤƱեåɥ쥤ǥåĸФδ֤Ǥϡ
+ * Фνݤޤ
+ *
+ * 1 ʸܤҤ餬ʤǤʤ̾泌ȥȡ 2 ʸܤ 0xa4 꾮
+ * Ф 0 礭Ф 255 Ȥޤ
+ */
+        static int getDispatchIndex(uint64_t midasi_prefix, bool special_flag)
+        {
+                int c_0 = static_cast<int>((midasi_prefix >> 56) & 0xff);
+                int c_2 = static_cast<int>((midasi_prefix >> 40) & 0xff);
+                int c_3 = static_cast<int>((midasi_prefix >> 32) & 0xff);
+                if (special_flag)
+                {
+                        return c_0;
+                }
+                if (c_0 != 0xa4)
+                {
+                        return 0;
+                }
+                if (c_2 == 0xa4)
+                {
+                        return c_3;
+                }
+                return (c_2 < 0xa4) ? 0 : 0xff;
+        }
+
+/// ֥롼ե륿 bloom_filter (bit_length ӥå)  hash Ͽޤ
+        static void setBloomFilter(uint64_t *bloom_filter, int bit_length, int hash_length, uint64_t hash)
+        {
+                uint32_t hash_0 = static_cast<uint32_t>(hash);
+                uint32_t hash_1 = static_cast<uint32_t>(hash >> 32) | 1;
+                for (int i = 0; i != hash_length; ++i)
+                {
+                        uint32_t bit = (hash_0 + static_cast<uint32_t>(i) * hash_1) % static_cast<uint32_t>(bit_length);
+                        *(bloom_filter + bit / 64) |= 1ULL << (bit % 64);
+                }
+        }
+
+/// ֥롼ե륿 bloom_filter (bit_length ӥå)  hash ϿƤǽп֤ޤʤ hash ϿƤޤ
+        static bool testBloomFilter(const uint64_t *bloom_filter, int bit_length, int hash_length, uint64_t hash)
+        {
+                uint32_t hash_0 = static_cast<uint32_t>(hash);
+                uint32_t hash_1 = static_cast<uint32_t>(hash >> 32) | 1;
+                for (int i = 0; i != hash_length; ++i)
+                {
+                        uint32_t bit = (hash_0 + static_cast<uint32_t>(i) * hash_1) % static_cast<uint32_t>(bit_length);
+                        if ((*(bloom_filter + bit / 64) & (1ULL << (bit % 64))) == 0)
+                        {
+                                return false;
+                        }
+                }
+                return true;
+        }
+
+/// getMidasiHash() Υϥå hash °봰ϥåΥХåȤ֤ޤ
+        static int getPerfectHashBucket(uint64_t hash, int bucket_length)
+        {
+                return static_cast<int>(((hash >> 32) * static_cast<uint64_t>(bucket_length)) >> 32);
+        }
+
+/// getMidasiHash() Υϥå hash ȥѥå pilot 顢ϥåΰ (0  table_length - 1) ֤ޤ
+        static int getPerfectHashSlot(uint64_t hash, uint32_t pilot, int table_length)
+        {
+                if (pilot & PERFECT_HASH_PILOT_DIRECT)
+                {
+                        return static_cast<int>(pilot & ~static_cast<uint32_t>(PERFECT_HASH_PILOT_DIRECT));
+                }
+                uint64_t tmp = hash ^ (static_cast<uint64_t>(pilot) * 0x9e3779b97f4a7c15ULL);
+                tmp ^= tmp >> 33;
+                tmp *= 0xc4ceb9fe1a85ec53ULL;
+                tmp ^= tmp >> 33;
+                return static_cast<int>(((tmp & 0xffffffff) * static_cast<uint64_t>(table_length)) >> 32);
+        }
+
         static bool getJisyoType(const char *filename, JisyoType &type)
         {
                 DEBUG_ASSERT_POINTER(filename);
@@ -1727,14 +3467,18 @@ public:
                                                         }
                                                         else
                                                         {
-                                                                if (tmp_information.get(Information::ID_IDENTIFIER) != IDENTIFIER)
+                                                                if (!tmp_information.isValidIdentifier())
                                                                 {
 // IDENTIFIER פʤΤΤʤǤ
                                                                         type = JISYO_TYPE_UNKNOWN;
                                                                 }
                                                                 else
                                                                 {
-                                                                        if (tmp_information.get(Information::ID_INDEX_DATA_SIZE) == 0)
+                                                                        if (tmp_information.get(Information::ID_TRIE_DATA_SIZE) > 0)
+                                                                        {
+                                                                                type = JISYO_TYPE_CLASS_SKK_TRIE;
+                                                                        }
+                                                                        else if (tmp_information.get(Information::ID_INDEX_DATA_SIZE) == 0)
                                                                         {
 // ǥåǡ¸ߤʤΤ class SkkJisyo ѤǤ
                                                                                 type = JISYO_TYPE_CLASS_SKK_JISYO;
@@ -1757,8 +3501,12 @@ public:
 /// SKK  class SkkJisyo μѴޤѴ˼Ԥϵ֤ޤ
 /**
  * class SkkJisyo ǰμˤϥǥåǡ¸ߤޤ
+ *
+ * reply_record_flag ʤгƹԤ쥳ɤˤޤ
  */
-        static bool createDictionaryForClassSkkJisyo(const char *filename_source, const char *filename_destination)
+        static bool createDictionaryForClassSkkJisyo(const char *filename_source,
+                                                     const char *filename_destination,
+                                                     bool reply_record_flag = false)
         {
                 DEBUG_ASSERT_POINTER(filename_source);
                 DEBUG_ASSERT_POINTER(filename_destination);
@@ -1787,7 +3535,12 @@ public:
                                 }
                                 else
                                 {
-                                        result = create_dictionary_for_class_skk_jisyo(filename_destination, buffer, filesize, okuri_ari_index, okuri_nasi_index);
+                                        result = create_dictionary_for_class_skk_jisyo(filename_destination,
+                                                                                       buffer,
+                                                                                       filesize,
+                                                                                       okuri_ari_index,
+                                                                                       okuri_nasi_index,
+                                                                                       reply_record_flag);
                                 }
                         }
                 }
@@ -1795,11 +3548,19 @@ public:
         }
 
 /// SKK  block_size  class SkkDictionary μѴޤѴ˼Ԥϵ֤ޤ
+/**
+ * sub_block_size  0 ǤʤС֥å򤪤褽 sub_block_size 
+ * ȤĤʬ֥֥åĥǡ˲äޤ
+ */
         static bool createDictionaryForClassSkkDictionary(const char *filename_source,
                                                           const char *filename_destination,
                                                           int block_size,
                                                           bool alignment_flag = false,
-                                                          bool block_short_flag = false)
+                                                          bool block_short_flag = false,
+                                                          bool dispatch_flag = false,
+                                                          bool perfect_hash_flag = false,
+                                                          bool reply_record_flag = false,
+                                                          int sub_block_size = 0)
         {
                 DEBUG_ASSERT_POINTER(filename_source);
                 DEBUG_ASSERT_POINTER(filename_destination);
@@ -1827,7 +3588,7 @@ public:
                         else
                         {
                                 ::close(tmp_fd);
-                                result = createDictionaryForClassSkkJisyo(filename_source, tmp_filename);
+                                result = createDictionaryForClassSkkJisyo(filename_source, tmp_filename, reply_record_flag);
                                 if (result)
                                 {
                                         result = object.open(tmp_filename);
@@ -1865,7 +3626,7 @@ public:
                 }
                 else
                 {
-                        result = createDictionaryForClassSkkJisyo(filename_source, filename_destination);
+                        result = createDictionaryForClassSkkJisyo(filename_source, filename_destination, reply_record_flag);
                         if (result)
                         {
                                 result = object.open(filename_destination);
@@ -1976,6 +3737,32 @@ public:
                                                                 result = append_terminator(file);
                                                         }
 
+                                                        int extension_data_offset = 0;
+                                                        int extension_data_size = 0;
+                                                        bool perfect_hash_result = false;
+                                                        if (result)
+                                                        {
+                                                                result = append_extension_data(file,
+                                                                                               object,
+                                                                                               fixed_array,
+                                                                                               string,
+                                                                                               normal_block_length,
+                                                                                               block,
+                                                                                               block_short,
+                                                                                               special_block_length,
+                                                                                               dispatch_flag,
+                                                                                               perfect_hash_flag,
+                                                                                               perfect_hash_result,
+                                                                                               sub_block_size,
+                                                                                               extension_data_offset,
+                                                                                               extension_data_size);
+                                                        }
+
+                                                        if (result)
+                                                        {
+                                                                result = append_terminator(file);
+                                                        }
+
                                                         if (result)
                                                         {
                                                                 int index_data_size = static_cast<int>(sizeof(index_data_header) +
@@ -1986,6 +3773,15 @@ public:
                                                                                     index_data_size);
                                                                 tmp_information.set(Information::ID_INDEX_DATA_OFFSET,
                                                                                     index_data_offset);
+                                                                tmp_information.set(Information::ID_EXTENSION_DATA_SIZE,
+                                                                                    extension_data_size);
+                                                                tmp_information.set(Information::ID_EXTENSION_DATA_OFFSET,
+                                                                                    extension_data_offset);
+                                                                if (perfect_hash_result)
+                                                                {
+                                                                        tmp_information.set(Information::ID_VERSION,
+                                                                                            Information::VERSION_PERFECT_HASH);
+                                                                }
                                                                 if (fwrite(&tmp_information, sizeof(tmp_information), 1, file) < 1)
                                                                 {
                                                                         result = false;
@@ -2003,13 +3799,188 @@ public:
                 return result;
         }
 
+/// SKK ȥ饤 class SkkDictionary μѴޤѴ˼Ԥϵ֤ޤ
+/**
+ * class SkkJisyo μθ˥ȥ饤ǡղäޤǥ
+ * ǡϻʤᡢȥ饤ΤʤǤϥץ˼Ԥ
+ * ޤ
+ *
+ * candidate_pool_flag ʤСѴʸפסذܤ
+ * ԤָФפˤޤ
+ */
+        static bool createDictionaryForClassSkkTrie(const char *filename_source,
+                                                    const char *filename_destination,
+                                                    bool candidate_pool_flag,
+                                                    bool reply_record_flag = false)
+        {
+                DEBUG_ASSERT_POINTER(filename_source);
+                DEBUG_ASSERT_POINTER(filename_destination);
+                SkkDoubleArray double_array;
+                SkkCandidatePool candidate_pool;
+                int32_t *entry = 0;
+                int entry_length = 0;
+                char *text = 0;
+                int text_size = 0;
+                Information tmp_information;
+                bool result = createDictionaryForClassSkkJisyo(filename_source, filename_destination, reply_record_flag);
+                if (result)
+                {
+                        SkkJisyo object;
+                        result = object.open(filename_destination);
+                        if (result)
+                        {
+                                object.getInformation(tmp_information);
+                                result = create_trie(object, tmp_information, double_array, entry, entry_length);
+                        }
+                        if (result && candidate_pool_flag)
+                        {
+                                result = create_candidate_pool(object, tmp_information, entry, entry_length, candidate_pool, text, text_size);
+                        }
+                }
+
+                if (result)
+                {
+// סľϹԤ񤭴 text ľʤ
+//  Information ΰ֤ȥ饤ǡ񤭡 Information 
+// ľޤ
+                        FILE *file = fopen(filename_destination, text ? "wb" : "r+b");
+                        if (file == 0)
+                        {
+                                result = false;
+                        }
+                        else
+                        {
+                                if (text)
+                                {
+                                        if ((fwrite(text, static_cast<size_t>(text_size), 1, file) < 1) ||
+                                            !append_terminator(file))
+                                        {
+                                                result = false;
+                                        }
+                                }
+                                else if (fseek(file, -static_cast<long>(sizeof(Information)), SEEK_END) == -1)
+                                {
+                                        result = false;
+                                }
+                                int trie_data_offset = static_cast<int>(ftell(file));
+                                int node_length = double_array.getLength();
+                                int candidate_pool_offset = TrieDataHeader::getSize() + static_cast<int>(sizeof(int32_t)) * (entry_length + node_length * 2);
+                                TrieDataHeader trie_data_header;
+                                trie_data_header.set(TrieDataHeader::ID_ENTRY_LENGTH, entry_length);
+                                trie_data_header.set(TrieDataHeader::ID_NODE_LENGTH, node_length);
+                                trie_data_header.set(TrieDataHeader::ID_ENTRY_OFFSET,
+                                                     TrieDataHeader::getSize());
+                                trie_data_header.set(TrieDataHeader::ID_BASE_OFFSET,
+                                                     TrieDataHeader::getSize() + static_cast<int>(sizeof(int32_t)) * entry_length);
+                                trie_data_header.set(TrieDataHeader::ID_CHECK_OFFSET,
+                                                     TrieDataHeader::getSize() + static_cast<int>(sizeof(int32_t)) * (entry_length + node_length));
+                                CandidatePoolHeader candidate_pool_header;
+                                int candidate_pool_size = 0;
+                                if (text)
+                                {
+                                        int candidate_length = candidate_pool.getCandidateLength();
+                                        int offset = candidate_pool_offset + CandidatePoolHeader::getSize();
+                                        candidate_pool_header.set(CandidatePoolHeader::ID_CANDIDATE_LENGTH, candidate_length);
+                                        candidate_pool_header.set(CandidatePoolHeader::ID_CANDIDATE_OFFSET_OFFSET, offset);
+                                        offset += static_cast<int>(sizeof(int32_t)) * (candidate_length + 1);
+                                        candidate_pool_header.set(CandidatePoolHeader::ID_ENTRY_REFERENCE_OFFSET, offset);
+                                        offset += static_cast<int>(sizeof(int32_t)) * (entry_length + 1);
+                                        candidate_pool_header.set(CandidatePoolHeader::ID_STRING_OFFSET, offset);
+                                        candidate_pool_header.set(CandidatePoolHeader::ID_STRING_SIZE, candidate_pool.getStringSize());
+                                        offset += candidate_pool.getStringSize();
+                                        candidate_pool_header.set(CandidatePoolHeader::ID_REFERENCE_OFFSET, offset);
+                                        candidate_pool_header.set(CandidatePoolHeader::ID_REFERENCE_SIZE, candidate_pool.getReferenceSize());
+                                        candidate_pool_header.set(CandidatePoolHeader::ID_HENKANMOJIRETSU_SIZE_MAXIMUM,
+                                                                  candidate_pool.getHenkanmojiretsuSizeMaximum());
+                                        trie_data_header.set(TrieDataHeader::ID_CANDIDATE_POOL_OFFSET, candidate_pool_offset);
+                                        candidate_pool_size = static_cast<int>(sizeof(candidate_pool_header));
+                                }
+                                struct
+                                {
+                                        const void *p;
+                                        size_t size;
+                                }
+                                table[] =
+                                {
+                                        { &trie_data_header,
+                                          sizeof(trie_data_header), },
+                                        { entry,
+                                          sizeof(int32_t) * static_cast<size_t>(entry_length), },
+                                        { double_array.getBase(),
+                                          sizeof(int32_t) * static_cast<size_t>(node_length), },
+                                        { double_array.getCheck(),
+                                          sizeof(int32_t) * static_cast<size_t>(node_length), },
+                                        { &candidate_pool_header,
+                                          static_cast<size_t>(candidate_pool_size), },
+                                        { candidate_pool.getCandidateOffset(),
+                                          text ? sizeof(int32_t) * static_cast<size_t>(candidate_pool.getCandidateLength() + 1) : 0, },
+                                        { candidate_pool.getEntryReference(),
+                                          text ? sizeof(int32_t) * static_cast<size_t>(entry_length + 1) : 0, },
+                                        { candidate_pool.getString(),
+                                          text ? static_cast<size_t>(candidate_pool.getStringSize()) : 0, },
+                                        { candidate_pool.getReference(),
+                                          text ? static_cast<size_t>(candidate_pool.getReferenceSize()) : 0, },
+                                };
+                                int trie_data_size = 0;
+                                for (int i = 0; result && (i != static_cast<int>(sizeof(table) / sizeof(table[0]))); ++i)
+                                {
+                                        if ((table[i].size > 0) && (fwrite(table[i].p, table[i].size, 1, file) < 1))
+                                        {
+                                                result = false;
+                                        }
+                                        trie_data_size += static_cast<int>(table[i].size);
+                                }
+
+                                if (result)
+                                {
+                                        result = append_terminator(file);
+                                }
+
+                                if (result)
+                                {
+                                        tmp_information.set(Information::ID_TRIE_DATA_OFFSET,
+                                                            trie_data_offset);
+                                        tmp_information.set(Information::ID_TRIE_DATA_SIZE,
+                                                            trie_data_size);
+                                        tmp_information.set(Information::ID_VERSION,
+                                                            Information::VERSION_TRIE);
+// סιԤϡָФפʤΤǱ쥳ɤΥե饰Ȥޤ
+//  SkkDictionary  '1' ޤ
+                                        if (text)
+                                        {
+                                                tmp_information.setReplyRecord(false);
+                                        }
+                                        if (fwrite(&tmp_information, sizeof(tmp_information), 1, file) < 1)
+                                        {
+                                                result = false;
+                                        }
+                                }
+
+                                fclose(file);
+                                SkkUtility::chmod(filename_destination, 0644);
+                        }
+                }
+
+                if (!result)
+                {
+                        unlink(filename_destination);
+                }
+
+                delete[] text;
+                delete[] entry;
+
+                return result;
+        }
+
 /// ꤷե뤫 Information ޤ˼Ԥϵ֤ޤ
         static bool getInformation(const char *filename, Information &information)
         {
                 DEBUG_ASSERT_POINTER(filename);
                 JisyoType type;
                 bool result = getJisyoType(filename, type);
-                if ((type == JISYO_TYPE_CLASS_SKK_JISYO) || (type == JISYO_TYPE_CLASS_SKK_DICTIONARY))
+                if ((type == JISYO_TYPE_CLASS_SKK_JISYO) ||
+                    (type == JISYO_TYPE_CLASS_SKK_DICTIONARY) ||
+                    (type == JISYO_TYPE_CLASS_SKK_TRIE))
                 {
                         FILE *file = fopen(filename, "rb");
                         if (file == 0)
@@ -2081,6 +4052,42 @@ public:
                 return result;
         }
 
+/// ꤷե뤫 ExtensionDataHeader ޤĥǡ¸ߤʤ˼Ԥϵ֤ޤ
+        static bool getExtensionDataHeader(const char *filename, ExtensionDataHeader &extension_data_header)
+        {
+                DEBUG_ASSERT_POINTER(filename);
+                Information tmp_information;
+                bool result = getInformation(filename, tmp_information);
+                int extension_data_offset = tmp_information.get(Information::ID_EXTENSION_DATA_OFFSET);
+                if (result &&
+                    ((tmp_information.get(Information::ID_VERSION) < Information::VERSION_EXTENSION_DATA) ||
+                     (extension_data_offset <= 0)))
+                {
+                        result = false;
+                }
+                if (result)
+                {
+                        FILE *file = fopen(filename, "rb");
+                        if (file == 0)
+                        {
+                                result = false;
+                        }
+                        else
+                        {
+                                if (fseek(file, extension_data_offset, SEEK_SET) == -1)
+                                {
+                                        result = false;
+                                }
+                                if (result && (fread(&extension_data_header, sizeof(extension_data_header), 1, file) < 1))
+                                {
+                                        result = false;
+                                }
+                                fclose(file);
+                        }
+                }
+                return result;
+        }
+
         virtual ~SkkJisyo()
         {
                 close();
@@ -2283,7 +4290,8 @@ public:
                                                            special_size,
                                                            information_.get(Information::ID_SPECIAL_LINES),
                                                            0,
-                                                           0);
+                                                           0,
+                                                           (information_.get(Information::ID_BIT_FLAG) & Information::BIT_FLAG_REPLY_RECORD) != 0);
                                 }
                         }
                 }
@@ -2431,7 +4439,7 @@ public:
 
                         information_.initialize(buffer_table_[STATE_NORMAL] + mmap_->getFilesize() - Information::getSize());
 
-                        if ((information_.get(Information::ID_IDENTIFIER) != IDENTIFIER) ||
+                        if (!information_.isValidIdentifier() ||
                             (information_.get(Information::ID_BLOCK_ALIGNMENT_SIZE) != 0))
                         {
 // IDENTIFIER ޤϥ饤Ȥ줿ʤмԤޤ
@@ -2559,7 +4567,7 @@ public:
                 {
                         encoded_midasi[0] = '\1';
                         int i;
-                        for (i = 0; sizeof(encoded_midasi) - margin; ++i)
+                        for (i = 0; i < static_cast<int>(sizeof(encoded_midasi)) - margin; ++i)
                         {
                                 if ((*(midasi + i) == ' ') || (*(midasi + i) == '\0'))
                                 {
@@ -2578,25 +4586,19 @@ public:
                         encoded_midasi[encoded_size] = '\0';
                 }
 
-// ޤХʥꥵõդʤϥХʥꥵνϤ
+// ü쥨ȥϹñ̤ΥХʥꥵõޤ̾泌ȥϤ
+// ХʥꥵõդʤϥХʥꥵνϤ
 // Ѥõޤ
                 if (SkkUtility::getFixedArrayIndex(encoded_midasi) == -1)
                 {
                         state_ = STATE_SPECIAL;
                         int index;
-                        if (SkkUtility::searchBinary(buffer_table_[state_], size_table_[state_], encoded_midasi, index))
+                        if ((size_table_[state_] > 0) &&
+                            SkkUtility::searchLowerBound(buffer_table_[state_], size_table_[state_], encoded_midasi, index))
                         {
                                 setIndex(index);
                                 return true;
                         }
-                        else
-                        {
-                                if (SkkUtility::searchLinear(buffer_table_[state_], size_table_[state_], encoded_midasi, index))
-                                {
-                                        setIndex(index);
-                                        return true;
-                                }
-                        }
                 }
                 else
                 {
@@ -2632,13 +4634,13 @@ public:
 /// index Ƭ֤ˤȤơѴʸפΥ֤ޤ˲ʸϴޤߤޤ
         int getHenkanmojiretsuSize()
         {
-                return SkkUtility::getHenkanmojiretsuSize(buffer_table_[state_], getIndex(), size_table_[state_]);
+                return SkkUtility::getHenkanmojiretsuSize(buffer_table_[state_], getIndex(), size_table_[state_]) - get_reply_record_size();
         }
 
 /// index Ƭ֤ˤȤơѴʸפΥݥ󥿤֤ޤ
         const char *getHenkanmojiretsuPointer()
         {
-                return SkkUtility::getHenkanmojiretsuPointer(buffer_table_[state_], getIndex(), size_table_[state_]);
+                return SkkUtility::getHenkanmojiretsuPointer(buffer_table_[state_], getIndex(), size_table_[state_]) + get_reply_record_size();
         }
 
 /// index Ƭ֤ˤȤơ 1 ԤΥ֤ޤ˲ʸϴޤߤޤ
@@ -0,0 +1,313 @@
+/*
+  Copyright (C) 2005-2021 Tadashi Watanabe <twacc2020@gmail.com>
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#ifndef SKK_LOOKUP_H
+#define SKK_LOOKUP_H
+
+#include "skk_architecture.hpp"
+#include "skk_dictionary.hpp"
+#include "skk_simple_string.hpp"
+#include "skk_utility.hpp"
+
+namespace YaSkkServ
+{
+/// ʣμޤȤõ륯饹Ǥ
+/**
+ * Фȥ饤֥ǶѤޤϻȤǡĤ
+ * ƤӽФ¦ʤޤ SkkDictionary 䡢
+ * μõϡؤΥݥ󥿤Ϥޤ
+ *
+ * search() ƤμǡָФפõդäο֤
+ * ޤ 1 ĤμǤդʤ getFoundDictionary() Ρ
+ * ʸפ򤽤Τޤ޻ȤޤʣμǸդä
+ * appendMergedHenkanmojiretsu()  candidate νʣϢ뤷ޤ
+ *
+ * \attention
+ * õξ֤ϼ񥪥֥ȤĤᡢƱʣΥ
+ * åɤƱõƤϤʤޤ󡣥åɤȤ
+ * SkkDictionary::share() ǺäȤޤ
+ */
+class SkkLookup
+{
+        SkkLookup(SkkLookup &source);
+        SkkLookup& operator=(SkkLookup &source);
+
+public:
+        virtual ~SkkLookup()
+        {
+        }
+
+        SkkLookup(SkkDictionary *skk_dictionary, int skk_dictionary_length) :
+                skk_dictionary_(skk_dictionary),
+                skk_dictionary_table_(0),
+                skk_dictionary_length_(skk_dictionary_length),
+                found_times_(0),
+                candidate_length_(0),
+                total_henkanmojiretsu_size_(0)
+        {
+        }
+
+        SkkLookup(SkkDictionary * const *skk_dictionary_table, int skk_dictionary_length) :
+                skk_dictionary_(0),
+                skk_dictionary_table_(skk_dictionary_table),
+                skk_dictionary_length_(skk_dictionary_length),
+                found_times_(0),
+                candidate_length_(0),
+                total_henkanmojiretsu_size_(0)
+        {
+        }
+
+/// ڡǽü줿 midasi Ƥμõޤդäο֤ޤ
+        int search(const char *midasi)
+        {
+                found_times_ = 0;
+                candidate_length_ = 0;
+                total_henkanmojiretsu_size_ = 0;
+                for (int h = 0; h != skk_dictionary_length_; ++h)
+                {
+                        if (get_dictionary(h)->search(midasi))
+                        {
+                                const int cr_size = 1;
+                                total_henkanmojiretsu_size_ += get_dictionary(h)->getHenkanmojiretsuSize() + cr_size;
+                                candidate_length_ += SkkUtility::getCandidateLength(get_dictionary(h)->getHenkanmojiretsuPointer());
+                                ++found_times_;
+                        }
+                }
+                return found_times_;
+        }
+
+/// search() Ǹդä candidate οιפ֤ޤʣϽޤ
+        int getCandidateLength() const
+        {
+                return candidate_length_;
+        }
+
+/// search() ǸդäѴʸפΥ˲ʸʬäΤιפ֤ޤ
+        int getTotalHenkanmojiretsuSize() const
+        {
+                return total_henkanmojiretsu_size_;
+        }
+
+/// search() ǥȥ꤬դäǽμ֤ޤդäƤʤ 0 ֤ޤ
+        SkkDictionary *getFoundDictionary() const
+        {
+                for (int h = 0; h != skk_dictionary_length_; ++h)
+                {
+                        if (get_dictionary(h)->isSuccess())
+                        {
+                                return get_dictionary(h);
+                        }
+                }
+                return 0;
+        }
+
+/// search() ǸդäѴʸפ candidate νʣϢ뤷 /candidate0/candidate1/ η string ɲäޤԤϵ֤ޤ
+/**
+ * string ˤϾʤȤ getTotalHenkanmojiretsuSize() ХȤζɬ
+ * פǤ
+ */
+        bool appendMergedHenkanmojiretsu(SkkSimpleString &string) const
+        {
+// candidate_length Ŭ hash_table_length Ѵޤ
+                int hash_table_length = SkkUtility::Hash<SkkUtility::HASH_TYPE_CANDIDATE>::getPrimeHashTableLength(candidate_length_);
+                if (hash_table_length == 0)
+                {
+                        return false;
+                }
+                SkkUtility::Hash<SkkUtility::HASH_TYPE_CANDIDATE> hash(hash_table_length);
+
+// first slash
+                if (!string.append('/'))
+                {
+                        return false;
+                }
+                for (int h = 0; h != skk_dictionary_length_; ++h)
+                {
+                        if (get_dictionary(h)->isSuccess())
+                        {
+                                const char *p = get_dictionary(h)->getHenkanmojiretsuPointer();
+                                int length = SkkUtility::getCandidateLength(p);
+                                for (int g = 0; g != length; ++g)
+                                {
+                                        const char *start;
+                                        int size;
+                                        if (SkkUtility::getCandidateInformation(p, g, start, size))
+                                        {
+                                                if (!hash.contain(start, size))
+                                                {
+                                                        hash.add(start, size);
+                                                        const int tail_slash_size = 1;
+                                                        if (!string.append(start, size + tail_slash_size))
+                                                        {
+                                                                return false;
+                                                        }
+                                                }
+                                        }
+                                        else
+                                        {
+                                                return false;
+                                        }
+                                }
+                        }
+                }
+                return true;
+        }
+
+/// midasi_size ХȤ midasi ǻϤޤʤפΡָФפ midasi_length ġ separator Ƕڤä string ɲäޤɲä length ֤ޤԤϵ֤ޤ
+/**
+ * midasi ϥڡǽüƤɬפޤָФפ
+ * separator ǻϤޤ separator ǽɲäޤ midasi 
+ * ꤢפʤвɲä length  0 ֤ޤ
+ * ignore_slash_flag ʤ '/' ޤָФפɲäޤ
+ *
+ * ָФפդФΥȥ꤫顢դʤФΥ
+ * ꤬ޤޤǤ֥åƬ searchNextEntry() éޤ
+ * ʣΤʣμǸդäǤ
+ */
+        bool appendCompletion(const char *midasi, int midasi_size, int midasi_length, char separator, SkkSimpleString &string, int &length, bool ignore_slash_flag = false)
+        {
+                length = 0;
+                if (SkkUtility::isOkuriAri(midasi, midasi_size))
+                {
+                        return true;
+                }
+                found_times_ = 0;
+                for (int h = 0; h != skk_dictionary_length_; ++h)
+                {
+                        if (get_dictionary(h)->search(midasi) ||
+                            get_dictionary(h)->searchForFirstCharacter(midasi))
+                        {
+                                ++found_times_;
+                        }
+                }
+                if (found_times_ == 0)
+                {
+                        return true;
+                }
+
+                SkkUtility::Hash<SkkUtility::HASH_TYPE_CANDIDATE> *hash = 0;
+                if (found_times_ > 1)
+                {
+                        int prime_length = SkkUtility::Hash<SkkUtility::HASH_TYPE_CANDIDATE>::getPrimeHashTableLength(midasi_length);
+                        if (prime_length == 0)
+                        {
+                                return false;
+                        }
+                        hash = new SkkUtility::Hash<SkkUtility::HASH_TYPE_CANDIDATE>(prime_length);
+                }
+                bool result = append_completion_core(midasi, midasi_size, midasi_length, separator, ignore_slash_flag, hash, string, length);
+                delete hash;
+                return result;
+        }
+
+private:
+        SkkDictionary *get_dictionary(int index) const
+        {
+                return skk_dictionary_table_ ? *(skk_dictionary_table_ + index) : skk_dictionary_ + index;
+        }
+
+        bool append_completion_core(const char *midasi,
+                                    int midasi_size,
+                                    int midasi_length,
+                                    char separator,
+                                    bool ignore_slash_flag,
+                                    SkkUtility::Hash<SkkUtility::HASH_TYPE_CANDIDATE> *hash,
+                                    SkkSimpleString &string,
+                                    int &length)
+        {
+// ָФפϡ֤Ҥ餬ʥ󥳡ɡפƤ뤳ȤդɬפǤ
+                char decode_buffer[SkkUtility::MIDASI_DECODE_HIRAGANA_BUFFER_SIZE];
+                if (!string.append(separator))
+                {
+                        return false;
+                }
+                for (int h = 0; h != skk_dictionary_length_; ++h)
+                {
+                        if (!get_dictionary(h)->isSuccess())
+                        {
+                                continue;
+                        }
+                        bool found_flag = false;
+                        do
+                        {
+                                const char *p = get_dictionary(h)->getMidasiPointer();
+// decodeHiragana() ϥߥ͡¸ߤʤȤդɬפǤ
+// size ⥿ߥ͡ޤޤʤǤ
+                                int size = SkkUtility::decodeHiragana(p, decode_buffer, sizeof(decode_buffer));
+                                if (size == 0)
+                                {
+                                        const int raw_code = 1; // \1 ʬ
+                                        p += raw_code;
+                                        size = get_dictionary(h)->getMidasiSize() - raw_code;
+                                }
+                                else
+                                {
+                                        p = decode_buffer;
+                                }
+
+                                if (!SkkSimpleString::startWith(p, midasi, size, midasi_size))
+                                {
+                                        if (found_flag)
+                                        {
+                                                break;
+                                        }
+                                        continue;
+                                }
+                                found_flag = true;
+
+                                if (SkkUtility::isOkuriNasiOrAbbrev(p, size) &&
+                                    !(ignore_slash_flag && SkkSimpleString::search(p, '/', size)) &&
+                                    ((hash == 0) || !hash->contain(p, size)))
+                                {
+                                        const int separator_size = 1;
+                                        if (!string.isAppendSize(size + separator_size))
+                                        {
+                                                return false;
+                                        }
+// hash  string ɲäʸ򻲾Ȥ뤿ᡢ decode_buffer Ǥ
+// ʤ string ¦Ͽޤ
+                                        const char *current = string.getCurrentBuffer();
+                                        string.append(p, size);
+                                        string.appendFast(separator); // + separator_size
+                                        if (hash)
+                                        {
+                                                if (!hash->add(current, size))
+                                                {
+                                                        return false;
+                                                }
+                                        }
+                                        if (++length >= midasi_length)
+                                        {
+                                                return true;
+                                        }
+                                }
+                        }
+                        while (get_dictionary(h)->searchNextEntry());
+                }
+                return true;
+        }
+
+        SkkDictionary *skk_dictionary_;
+        SkkDictionary * const *skk_dictionary_table_;
+        int skk_dictionary_length_;
+        int found_times_;
+        int candidate_length_;
+        int total_henkanmojiretsu_size_;
+};
+}
+
+#endif  // SKK_LOOKUP_H
@@ -24,9 +24,14 @@
 
 #include "skk_architecture.hpp"
 #include "skk_socket.hpp"
+#include "skk_io_uring.hpp"
+#include "skk_shared_ring.hpp"
 #include "skk_utility.hpp"
 #include "skk_dictionary.hpp"
+#include "skk_dictionary_reloader.hpp"
+#include "skk_dictionary_watcher.hpp"
 #include "skk_syslog.hpp"
+#include "skk_timer_wheel.hpp"
 
 namespace YaSkkServ
 {
@@ -97,26 +102,65 @@ class SkkServer
 public:
         virtual ~SkkServer()
         {
-                for (int i = 0; i != max_connection_; ++i)
+                for (int i = 0; i != work_length_; ++i)
                 {
 #ifdef SKK_MEMORY_DEBUG
                         delete[] ((work_ + i)->read_buffer - SKK_MEMORY_DEBUG_MARGIN_SIZE);
 #else  // SKK_MEMORY_DEBUG
                         delete[] (work_ + i)->read_buffer;
 #endif  // SKK_MEMORY_DEBUG
+                        delete[] (work_ + i)->output_buffer;
+#ifdef YASKKSERV_CONFIG_HAVE_SHARED_RING
+                        delete (work_ + i)->shared_ring;
+#endif  // YASKKSERV_CONFIG_HAVE_SHARED_RING
                 }
                 delete[] work_;
+                delete[] work_free_;
+#ifdef YASKKSERV_CONFIG_HAVE_IO_URING
+                delete[] io_uring_work_;
+                delete io_uring_;
+#endif  // YASKKSERV_CONFIG_HAVE_IO_URING
                 syslog_.printf(1, SkkSyslog::LEVEL_INFO, "terminated");
         }
 
         SkkServer(const char *identifier, int port, int log_level, const char *address) :
                 syslog_(identifier, log_level),
+                reloader_(),
+                watcher_(),
                 work_(0),
+                work_free_(0),
+                work_length_(0),
+                work_free_length_(0),
+                send_work_index_(0),
+                idle_timer_wheel_(),
+                idle_time_(0),
+                idle_timeout_(0),
+                idle_reap_count_(0),
+                statistics_buffer_(),
+                statistics_(&statistics_buffer_),
+#ifdef YASKKSERV_CONFIG_HAVE_SHARED_RING
+                shared_ring_spin_flag_(false),
+                shared_ring_spin_available_flag_(SkkSharedRing::isSpinAvailable()),
+#endif  // YASKKSERV_CONFIG_HAVE_SHARED_RING
+#ifdef YASKKSERV_CONFIG_HAVE_IO_URING
+                io_uring_(0),
+                io_uring_work_(0),
+                io_uring_poll_(),
+                io_uring_poll_length_(0),
+                io_uring_accept_flag_(false),
+                io_uring_unix_accept_flag_(false),
+                io_uring_accept_stop_flag_(false),
+#endif  // YASKKSERV_CONFIG_HAVE_IO_URING
+                worker_flag_(false),
                 port_(port),
                 address_(address),
                 max_connection_(0),
                 listen_queue_(0),
-                file_descriptor_(0)
+                file_descriptor_(-1),
+                unix_socket_path_(0),
+                unix_socket_mode_(0600),
+                unix_file_descriptor_(-1),
+                unix_socket_unlink_flag_(false)
         {
         }
 
@@ -128,9 +172,81 @@ public:
         virtual bool mainLoop() = 0;
 
 protected:
-/// send() п֤ޤ֤ Work::closeAndReset() ٤Ǥ
+/// դ³Ƚ׵οǤ
+        struct Statistics
+        {
+                int64_t connection;
+                int64_t request;
+                int64_t found;
+                int64_t idle_timeout;
+        };
+
+/// send() п֤ޤ֤ main_loop_close() ٤Ǥ
+/**
+ * Work ΥåȤϥΥ֥å󥰤Ǥʤäǡ
+ * Work  output_buffer ίᡢ main_loop_select() ǽ񤭹߲ǽˤʤ
+ * Ƥ³ޤΥǡĤäƤ֤Ͽǡ
+ * ίΤǡνѤޤί᤿ǡ
+ * OUTPUT_BUFFER_LIMIT_SIZE ۤۤɼ٤饤ȤФƤ
+ * ֤ޤ
+ *
+ * io_uring Ȥ send()  output_buffer ίǤί
+ * ϼ io_uring_enter() ǤޤȤޤ
+ *
+ * SkkSharedRing Ȥ Work ؤ send() ϱΥ󥰤ؽ񤭹ߤޤ
+ */
         bool send(int file_descriptor, const void *data, int data_size)
         {
+                const int work_index = main_loop_get_work_index(file_descriptor);
+                if (work_index != -1)
+                {
+                        Work *work = work_ + work_index;
+#ifdef YASKKSERV_CONFIG_HAVE_SHARED_RING
+                        if (work->shared_ring)
+                        {
+                                if (!work->shared_ring->appendResponse(data, data_size))
+                                {
+                                        syslog_.printf(1,
+                                                       SkkSyslog::LEVEL_WARNING,
+                                                       "shared ring overflow (%s)",
+                                                       main_loop_get_peer_name(work_index));
+                                        return false;
+                                }
+                                return true;
+                        }
+#endif  // YASKKSERV_CONFIG_HAVE_SHARED_RING
+                        int send_size = 0;
+                        if (!main_loop_is_io_uring())
+                        {
+                                while ((work->output_size == 0) && (send_size < data_size))
+                                {
+                                        int send_result = SkkSocket::send(file_descriptor,
+                                                                          static_cast<const char*>(data) + send_size,
+                                                                          data_size - send_size);
+                                        if (send_result == -1)
+                                        {
+                                                if ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR))
+                                                {
+                                                        return false;
+                                                }
+                                                break;
+                                        }
+                                        send_size += send_result;
+                                }
+                        }
+                        if (send_size < data_size)
+                        {
+                                if (!work->append(static_cast<const char*>(data) + send_size, data_size - send_size))
+                                {
+                                        syslog_.printf(1,
+                                                       SkkSyslog::LEVEL_WARNING,
+                                                       "output buffer overflow (%s)",
+                                                       main_loop_get_peer_name(work_index));
+                                        return false;
+                                }
+                        }
+                        return true;
+                }
                 bool result = false;
                 int send_size = 0;
                 for (;;)
@@ -153,34 +269,313 @@ protected:
                 return result;
         }
 
+/// idle_timeout äΤʤä³Ĥ褦ˤޤ 0 ʤĤޤ main_loop_initialize() ˸Ƥɬפޤ
+        void main_loop_set_idle_timeout(int idle_timeout)
+        {
+                idle_timeout_ = idle_timeout;
+        }
+
+/// ̵̿Ĥ³ο֤ޤ
+        int main_loop_get_idle_reap_count() const
+        {
+                return idle_reap_count_;
+        }
+
+/// ³Ƥ Work ο֤ޤ
+        int main_loop_get_connection_count() const
+        {
+                int result = 0;
+                for (int i = 0; i != work_length_; ++i)
+                {
+                        if ((work_ + i)->flag)
+                        {
+                                ++result;
+                        }
+                }
+                return result;
+        }
+
+/// פ counter  1 äޤ
+/**
+ * main_loop_prefork() λҥץǤϿƥץ̤Υץ
+ * िᡢȥߥå˲äޤ񤭹ΤϤΥץǤ
+ */
+        static void main_loop_add_statistics(int64_t &counter)
+        {
+                __atomic_add_fetch(&counter, 1, __ATOMIC_RELAXED);
+        }
+
+/// ָФפõ׵ 1 ĽȤפ˲äޤ found_flag ϸդäɤǤ
+        void main_loop_count_request(bool found_flag)
+        {
+                main_loop_add_statistics(statistics_->request);
+                if (found_flag)
+                {
+                        main_loop_add_statistics(statistics_->found);
+                }
+        }
+
+/// worker_length Ĥλҥץ fork() ƥץϻҥץƻ뤷ޤԤϵ֤ޤ
+/**
+ * main_loop_initialize()  listen åȤȳ򤽤Τޤ
+ * ҥץذѤΤǡǥåȼΥڡ copy-on-write
+ * ǶͭޤƻҥץƱåȤ accept() 줾
+ * select() (ޤ io_uring) Υ롼פǱޤ
+ *
+ * ҥץǤ parent_flag ˵֤ľΤǡƤӽФ¦
+ * Τޤ mainLoop() Υ롼פؿʤߤޤio_uring ȼ򳫤ľ
+ * åɤϻҥץȤˡ롼פѰդɬפޤ
+ *
+ * ƥץ SIGTERM  SIGINT ޤޤ󡣽λҥ
+ * Ϻľư 1 ð˽λ 1 ԤäƤ
+ * ľޤ SIGHUP Ƥλҥץפιפ
+ * syslog ˽Ϥޤפ϶֤ͭΤǡλҥץ
+ * ʬפ˻Ĥޤ SIGTERM  SIGINT Ȼҥץ
+ * SIGTERM ꡢƽλƤ parent_flag ˿֤ޤ
+ * ƤӽФ¦ main_loop_finalize() Ƥ齪λޤ
+ */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wold-style-cast"
+        bool main_loop_prefork(int worker_length, bool &parent_flag)
+        {
+                parent_flag = true;
+                const size_t size = sizeof(Statistics) * static_cast<size_t>(worker_length + 1);
+                void *p = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANON, -1, 0);
+                if (p == MAP_FAILED)
+                {
+                        syslog_.printf(1, SkkSyslog::LEVEL_WARNING, "worker statistics mmap() failed");
+                        return false;
+                }
+// ǸǤϽλҥץפιפǤ
+                Statistics *worker_statistics = static_cast<Statistics*>(p);
+                Statistics *exited_statistics = worker_statistics + worker_length;
+
+                sigset_t sigset;
+                sigset_t old_sigset;
+                sigemptyset(&sigset);
+                sigaddset(&sigset, SIGCHLD);
+                sigaddset(&sigset, SIGHUP);
+                sigaddset(&sigset, SIGINT);
+                sigaddset(&sigset, SIGTERM);
+                sigprocmask(SIG_BLOCK, &sigset, &old_sigset);
+// SIGCHLD δư̵ʤΤǡ sigwait() ǳμ¤˼褦
+// ˲⤷ʤϥɥꤷޤ
+                struct sigaction action;
+                struct sigaction old_action;
+                SkkUtility::clearMemory(&action, sizeof(action));
+                action.sa_handler = main_loop_prefork_handler;
+                sigemptyset(&action.sa_mask);
+                sigaction(SIGCHLD, &action, &old_action);
+
+                pid_t *pid = new pid_t[worker_length];
+                time_t *start_time = new time_t[worker_length];
+                for (int i = 0; i != worker_length; ++i)
+                {
+                        *(pid + i) = -1;
+                        *(start_time + i) = 0;
+                }
+                int restart_count = 0;
+                bool result = true;
+                bool terminate_flag = false;
+                for (;;)
+                {
+                        int alive_length = 0;
+                        for (int i = 0; i != worker_length; ++i)
+                        {
+                                if ((*(pid + i) == -1) && !terminate_flag)
+                                {
+                                        const pid_t child = fork();
+                                        if (child == 0)
+                                        {
+                                                sigaction(SIGCHLD, &old_action, 0);
+                                                sigprocmask(SIG_SETMASK, &old_sigset, 0);
+                                                statistics_ = worker_statistics + i;
+                                                worker_flag_ = true;
+// åȤϿƥץäޤ
+                                                unix_socket_unlink_flag_ = false;
+                                                delete[] start_time;
+                                                delete[] pid;
+                                                parent_flag = false;
+                                                return true;
+                                        }
+                                        if (child == -1)
+                                        {
+                                                syslog_.printf(1, SkkSyslog::LEVEL_WARNING, "worker %d fork() failed", i);
+                                        }
+                                        else
+                                        {
+                                                syslog_.printf(2, SkkSyslog::LEVEL_INFO, "worker %d started (pid=%d)", i, static_cast<int>(child));
+                                                *(pid + i) = child;
+                                                *(start_time + i) = main_loop_get_time();
+                                        }
+                                }
+                                if (*(pid + i) != -1)
+                                {
+                                        ++alive_length;
+                                }
+                        }
+                        if (alive_length == 0)
+                        {
+                                result = terminate_flag;
+                                break;
+                        }
+
+                        int signal_number;
+                        if (sigwait(&sigset, &signal_number) != 0)
+                        {
+                                continue;
+                        }
+                        switch (signal_number)
+                        {
+                        default:
+                                break;
+                        case SIGCHLD:
+                                {
+                                        bool throttle_flag = false;
+                                        int status;
+                                        pid_t child;
+                                        while ((child = waitpid(-1, &status, WNOHANG)) > 0)
+                                        {
+                                                for (int i = 0; i != worker_length; ++i)
+                                                {
+                                                        if (*(pid + i) == child)
+                                                        {
+                                                                main_loop_prefork_exit_worker(i, child, status, worker_statistics + i, exited_statistics, terminate_flag);
+                                                                if (main_loop_get_time() - *(start_time + i) < 1)
+                                                                {
+                                                                        throttle_flag = true;
+                                                                }
+                                                                *(pid + i) = -1;
+                                                                if (!terminate_flag)
+                                                                {
+                                                                        ++restart_count;
+                                                                }
+                                                                break;
+                                                        }
+                                                }
+                                        }
+                                        if (throttle_flag && !terminate_flag)
+                                        {
+                                                SkkUtility::sleep(1);
+                                        }
+                                }
+                                break;
+                        case SIGHUP:
+                                main_loop_prefork_print_statistics(worker_statistics, worker_length, alive_length, restart_count);
+                                break;
+                        case SIGINT: // FALLTHROUGH
+                        case SIGTERM:
+                                if (!terminate_flag)
+                                {
+                                        terminate_flag = true;
+                                        for (int i = 0; i != worker_length; ++i)
+                                        {
+                                                if (*(pid + i) != -1)
+                                                {
+                                                        kill(*(pid + i), SIGTERM);
+                                                }
+                                        }
+                                }
+                                break;
+                        }
+                }
+                main_loop_prefork_print_statistics(worker_statistics, worker_length, 0, restart_count);
+
+                delete[] start_time;
+                delete[] pid;
+                munmap(p, size);
+                sigaction(SIGCHLD, &old_action, 0);
+                sigprocmask(SIG_SETMASK, &old_sigset, 0);
+                return result;
+        }
+#pragma GCC diagnostic pop
+
+        static void main_loop_prefork_handler(int signum)
+        {
+                (void)signum;
+        }
+
+/// λ index ܤλҥץ statistics  exited_statistics ˲ä 0 ˤޤ
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wold-style-cast"
+        void main_loop_prefork_exit_worker(int index, pid_t child, int status, Statistics *statistics, Statistics *exited_statistics, bool terminate_flag)
+        {
+                exited_statistics->connection += __atomic_load_n(&statistics->connection, __ATOMIC_RELAXED);
+                exited_statistics->request += __atomic_load_n(&statistics->request, __ATOMIC_RELAXED);
+                exited_statistics->found += __atomic_load_n(&statistics->found, __ATOMIC_RELAXED);
+                exited_statistics->idle_timeout += __atomic_load_n(&statistics->idle_timeout, __ATOMIC_RELAXED);
+                SkkUtility::clearMemory(statistics, sizeof(Statistics));
+                if (terminate_flag)
+                {
+                        syslog_.printf(2, SkkSyslog::LEVEL_INFO, "worker %d terminated (pid=%d)", index, static_cast<int>(child));
+                }
+                else if (WIFSIGNALED(status))
+                {
+                        syslog_.printf(1, SkkSyslog::LEVEL_WARNING, "worker %d (pid=%d) killed by signal %d (restart)", index, static_cast<int>(child), WTERMSIG(status));
+                }
+                else
+                {
+                        syslog_.printf(1, SkkSyslog::LEVEL_WARNING, "worker %d (pid=%d) exited with status %d (restart)", index, static_cast<int>(child), WEXITSTATUS(status));
+                }
+        }
+#pragma GCC diagnostic pop
+
+/// worker_length ĤλҥץȽλҥץפιפ syslog ˽Ϥޤ
+        void main_loop_prefork_print_statistics(const Statistics *worker_statistics, int worker_length, int alive_length, int restart_count)
+        {
+                Statistics total;
+                SkkUtility::clearMemory(&total, sizeof(total));
+// ǸǤϽλҥץʬǤ
+                for (int i = 0; i != worker_length + 1; ++i)
+                {
+                        total.connection += __atomic_load_n(&(worker_statistics + i)->connection, __ATOMIC_RELAXED);
+                        total.request += __atomic_load_n(&(worker_statistics + i)->request, __ATOMIC_RELAXED);
+                        total.found += __atomic_load_n(&(worker_statistics + i)->found, __ATOMIC_RELAXED);
+                        total.idle_timeout += __atomic_load_n(&(worker_statistics + i)->idle_timeout, __ATOMIC_RELAXED);
+                }
+                syslog_.printf(1,
+                               SkkSyslog::LEVEL_INFO,
+                               "worker status    worker : %d/%d    restart : %d    connection : %lld    request : %lld    found : %lld    idle timeout : %lld",
+                               alive_length,
+                               worker_length,
+                               restart_count,
+                               static_cast<long long>(total.connection),
+                               static_cast<long long>(total.request),
+                               static_cast<long long>(total.found),
+                               static_cast<long long>(total.idle_timeout));
+        }
+
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wold-style-cast"
 /// MainLoop() Υ˥饤Ǥ
+/**
+ * max_connection Ʊ³Ǥξ¤Ǥ Work 
+ * WORK_INITIAL_LENGTH ĤѰդ­ʤʤä
+ * main_loop_allocate_work()  max_connection ޤܡ䤷ޤ
+ */
         bool main_loop_initialize(int max_connection, int listen_queue)
         {
                 max_connection_ = max_connection;
                 listen_queue_ = listen_queue;
-// delete[] ϥǥȥ饯ǡ
-                work_ = new Work[max_connection_];
-
-                for (int i = 0; i != max_connection_; ++i)
-                {
-#ifdef SKK_MEMORY_DEBUG
-                        (work_ + i)->read_buffer = new char[SKK_MEMORY_DEBUG_MARGIN_SIZE + READ_BUFFER_SIZE + SKK_MEMORY_DEBUG_MARGIN_SIZE];
-                        (work_ + i)->read_buffer += SKK_MEMORY_DEBUG_MARGIN_SIZE;
-                        skk_memory_debug_set_((work_ + i)->read_buffer - SKK_MEMORY_DEBUG_MARGIN_SIZE);
-                        skk_memory_debug_set_((work_ + i)->read_buffer - SKK_MEMORY_DEBUG_MARGIN_SIZE + SKK_MEMORY_DEBUG_MARGIN_SIZE + READ_BUFFER_SIZE);
-#else  // SKK_MEMORY_DEBUG
-                        (work_ + i)->read_buffer = new char[READ_BUFFER_SIZE];
-#endif  // SKK_MEMORY_DEBUG
-                        *((work_ + i)->read_buffer + 0) = '\0';
-                }
+                idle_time_ = main_loop_get_time();
+                idle_timer_wheel_.initialize(idle_time_);
+                main_loop_grow_work((max_connection_ < WORK_INITIAL_LENGTH) ? max_connection_ : WORK_INITIAL_LENGTH);
 
 #ifdef YASKKSERV_CONFIG_HAVE_SYSTEMD
                 int number_of_fds = sd_listen_fds(1);
-                if (number_of_fds == 1) {
-                        file_descriptor_ = SD_LISTEN_FDS_START;
-                        syslog_.printf(1, SkkSyslog::LEVEL_INFO, "Use fd=%d from systemd socket activation", file_descriptor_);
+                if (number_of_fds >= 1) {
+// AF_UNIX ΥåȤ unix_file_descriptor_ ǡʳ file_descriptor_ Ԥޤ
+                        file_descriptor_ = -1;
+                        for (int i = 0; i != number_of_fds; ++i) {
+                                const int fd = SD_LISTEN_FDS_START + i;
+                                fcntl(fd, F_SETFL, O_NONBLOCK);
+                                if (sd_is_socket_unix(fd, SOCK_STREAM, 1, 0, 0) > 0) {
+                                        unix_file_descriptor_ = fd;
+                                } else {
+                                        file_descriptor_ = fd;
+                                }
+                                syslog_.printf(1, SkkSyslog::LEVEL_INFO, "Use fd=%d from systemd socket activation", fd);
+                        }
                         return true;
                 }
 #endif
@@ -220,10 +615,103 @@ protected:
                         close(file_descriptor_);
                         return false;
                 }
+                return main_loop_initialize_unix_socket();
+        }
+
+/// socket_connect ΥåȤ³Ǥʤп֤ޤ
+        static bool main_loop_is_unused_unix_socket(const struct sockaddr_un &socket_connect)
+        {
+                int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+                if (fd == -1)
+                {
+                        return false;
+                }
+                const bool result = (connect(fd, reinterpret_cast<const struct sockaddr*>(&socket_connect), sizeof(socket_connect)) == -1) && (errno == ECONNREFUSED);
+                close(fd);
+                return result;
+        }
+
+/// main_loop_set_unix_socket() ǻꤷѥ AF_UNIX ΥåȤä listen ޤ
+/**
+ * ѥΥåȤĤäƤơ³ǤʤоäƤľ
+ * ޤѥ˥åȰʳΥե뤬оä˼Ԥޤ
+ * åȤ main_loop_finalize() Ǿäޤ
+ *
+ * bind() δ֤ umask ǥѡߥå mode ˤΤǡåȤ
+ * ä mode ʳθ¤Ǥ³Ǥޤ
+ */
+        bool main_loop_initialize_unix_socket()
+        {
+                if (unix_socket_path_ == 0)
+                {
+                        return true;
+                }
+                struct sockaddr_un socket_connect;
+                SkkUtility::clearMemory(&socket_connect, sizeof(socket_connect));
+                socket_connect.sun_family = AF_UNIX;
+                if ((*unix_socket_path_ != '/') || (strlen(unix_socket_path_) >= sizeof(socket_connect.sun_path)))
+                {
+                        SkkUtility::printf("invalid unix socket path \"%s\"\n", unix_socket_path_);
+                        return false;
+                }
+                strcpy(socket_connect.sun_path, unix_socket_path_);
+                unix_file_descriptor_ = socket(AF_UNIX, SOCK_STREAM, 0);
+                if (unix_file_descriptor_ == -1)
+                {
+                        return false;
+                }
+                fcntl(unix_file_descriptor_, F_SETFL, O_NONBLOCK);
+                fcntl(unix_file_descriptor_, F_SETFD, FD_CLOEXEC);
+                const mode_t backup_umask = umask(static_cast<mode_t>(~unix_socket_mode_ & 0777));
+                int retry = 3;
+                while (bind(unix_file_descriptor_, reinterpret_cast<struct sockaddr*>(&socket_connect), sizeof(socket_connect)) == -1)
+                {
+                        struct stat stat_buffer;
+                        if ((errno != EADDRINUSE) ||
+                            (--retry <= 0) ||
+                            ((lstat(unix_socket_path_, &stat_buffer) == 0) && !S_ISSOCK(stat_buffer.st_mode)))
+                        {
+                                umask(backup_umask);
+                                close(unix_file_descriptor_);
+                                unix_file_descriptor_ = -1;
+                                SkkUtility::printf("unix socket bind failed \"%s\"\n", unix_socket_path_);
+                                return false;
+                        }
+                        if (main_loop_is_unused_unix_socket(socket_connect))
+                        {
+                                unlink(unix_socket_path_);
+                        }
+                        else
+                        {
+                                SkkUtility::sleep(1);
+                        }
+                }
+                umask(backup_umask);
+                unix_socket_unlink_flag_ = true;
+                if (listen(unix_file_descriptor_, listen_queue_) == -1)
+                {
+// äåȥե unix_socket_unlink_flag_  main_loop_finalize() äޤ
+                        close(unix_file_descriptor_);
+                        unix_file_descriptor_ = -1;
+                        SkkUtility::printf("unix socket listen failed \"%s\"\n", unix_socket_path_);
+                        return false;
+                }
                 return true;
         }
 #pragma GCC diagnostic pop
 
+/// main_loop_initialize()  TCP ˲ä path  AF_UNIX ΥåȤꡢѡߥå mode ˤޤ path  0 ʤкޤ
+/**
+ * path Хѥǻꤹɬפޤ systemd  socket
+ * activation  AF_UNIX ΥåȤä path Ȥޤ
+ * 
+ */
+        void main_loop_set_unix_socket(const char *path, int mode)
+        {
+                unix_socket_path_ = path;
+                unix_socket_mode_ = mode;
+        }
+
 /// ָФפõΤȤ "1" ղäߤΥХåեΡѴʸפ send() ޤ
         void main_loop_send_found(int work_index, SkkDictionary *skk_dictionary)
         {
@@ -243,15 +731,26 @@ protected:
 //        ^
 //        |
 //        p == getHenkanmojiretsuPointer()
+//
+// 쥳ɤμǤ p - 1 ˴ '1' 뤿ᡢ񤭴ˤ
+// ޤ send() ޤ
 //
                 char *p = const_cast<char*>(skk_dictionary->getHenkanmojiretsuPointer());
                 const int protocol_size = 1;
                 const int cr_size = 1;
+                if (skk_dictionary->isReplyRecord())
+                {
+                        if (!send((work_ + work_index)->file_descriptor, p - 1, protocol_size + skk_dictionary->getHenkanmojiretsuSize() + cr_size))
+                        {
+                                main_loop_close(work_index);
+                        }
+                        return;
+                }
                 char backup = *(p - 1);
                 *(p - 1) = '1';
                 if (!send((work_ + work_index)->file_descriptor, p - 1, protocol_size + skk_dictionary->getHenkanmojiretsuSize() + cr_size))
                 {
-                        (work_ + work_index)->closeAndReset();
+                        main_loop_close(work_index);
                 }
                 *(p - 1) = backup;
         }
@@ -284,25 +783,78 @@ protected:
                 *((work_ + work_index)->read_buffer) = '4';
                 if (!send((work_ + work_index)->file_descriptor, (work_ + work_index)->read_buffer, send_size))
                 {
-                        (work_ + work_index)->closeAndReset();
+                        main_loop_close(work_index);
                 }
                 *((work_ + work_index)->read_buffer) = backup;
                 *((work_ + work_index)->read_buffer + recv_result) = backup_2;
         }
 
 /// mainLoop()  select() ޤ
+        int main_loop_select(fd_set &fd_set_read)
+        {
+                return main_loop_select(fd_set_read, 0, 0, 0);
+        }
+
+/// mainLoop()  file_descriptor_table  length ĤΥեǥץä select() ޤ timeout  0 Ǥʤ timeout ǥॢȤޤ
+/**
+ * file_descriptor_table  -1 ̵뤷ޤ
+ */
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wold-style-cast"
-        int main_loop_select(fd_set &fd_set_read)
+        int main_loop_select(fd_set &fd_set_read, const int *file_descriptor_table, int length, struct timeval *timeout)
         {
-                int file_descriptor_maximum = file_descriptor_;
+                int file_descriptor_maximum = (file_descriptor_ > unix_file_descriptor_) ? file_descriptor_ : unix_file_descriptor_;
+                fd_set fd_set_write;
+                bool write_flag = false;
                 FD_ZERO(&fd_set_read);
-                FD_SET(file_descriptor_, &fd_set_read);
-                for (int i = 0; i != max_connection_; ++i)
+                FD_ZERO(&fd_set_write);
+                const bool accept_flag = main_loop_is_accept();
+                if ((file_descriptor_ != -1) && accept_flag)
+                {
+                        FD_SET(file_descriptor_, &fd_set_read);
+                }
+                if ((unix_file_descriptor_ != -1) && accept_flag)
+                {
+                        FD_SET(unix_file_descriptor_, &fd_set_read);
+                }
+                for (int i = 0; i != length; ++i)
+                {
+                        if (*(file_descriptor_table + i) != -1)
+                        {
+                                FD_SET(*(file_descriptor_table + i), &fd_set_read);
+                                if (*(file_descriptor_table + i) > file_descriptor_maximum)
+                                {
+                                        file_descriptor_maximum = *(file_descriptor_table + i);
+                                }
+                        }
+                }
+// γľ򽪤뤫񤬹줿 select() ޤ
+                if (reloader_.isRunning())
+                {
+                        FD_SET(reloader_.getFileDescriptor(), &fd_set_read);
+                        if (reloader_.getFileDescriptor() > file_descriptor_maximum)
+                        {
+                                file_descriptor_maximum = reloader_.getFileDescriptor();
+                        }
+                }
+                if (watcher_.isInitialized())
+                {
+                        FD_SET(watcher_.getFileDescriptor(), &fd_set_read);
+                        if (watcher_.getFileDescriptor() > file_descriptor_maximum)
+                        {
+                                file_descriptor_maximum = watcher_.getFileDescriptor();
+                        }
+                }
+                for (int i = 0; i != work_length_; ++i)
                 {
                         if ((work_ + i)->flag)
                         {
                                 FD_SET((work_ + i)->file_descriptor, &fd_set_read);
+                                if ((work_ + i)->output_size > 0)
+                                {
+                                        FD_SET((work_ + i)->file_descriptor, &fd_set_write);
+                                        write_flag = true;
+                                }
                                 if ((work_ + i)->file_descriptor > file_descriptor_maximum)
                                 {
                                         file_descriptor_maximum = (work_ + i)->file_descriptor;
@@ -313,152 +865,734 @@ protected:
                         skk_memory_debug_check_((work_ + i)->read_buffer - SKK_MEMORY_DEBUG_MARGIN_SIZE + SKK_MEMORY_DEBUG_MARGIN_SIZE + READ_BUFFER_SIZE);
 #endif  // SKK_MEMORY_DEBUG
                 }
-                int n = select(file_descriptor_maximum + 1, &fd_set_read, 0, 0, 0);
+                struct timeval idle_timeout;
+                struct timeval *wait_timeout = main_loop_get_idle_timeout(timeout, idle_timeout);
+                if (main_loop_prepare_shared_ring_sleep())
+                {
+                        idle_timeout.tv_sec = 0;
+                        idle_timeout.tv_usec = 0;
+                        wait_timeout = &idle_timeout;
+                }
+                int n = select(file_descriptor_maximum + 1, &fd_set_read, write_flag ? &fd_set_write : 0, 0, wait_timeout);
                 if ((n == -1) && (errno == EINTR))
                 {
                         syslog_.printf(1, SkkSyslog::LEVEL_INFO, "caught signal");
                 }
+                idle_time_ = main_loop_get_time();
+                main_loop_process_shared_ring();
+                main_loop_reap(fd_set_read, n > 0);
+                if ((n > 0) && write_flag)
+                {
+                        for (int i = 0; i != work_length_; ++i)
+                        {
+                                if ((work_ + i)->flag && FD_ISSET((work_ + i)->file_descriptor, &fd_set_write) && !main_loop_flush(i))
+                                {
+// Ĥ Work ƤӽФ¦ recv() ʤ褦ˤޤ
+                                        FD_CLR((work_ + i)->file_descriptor, &fd_set_read);
+                                        main_loop_close(i);
+                                }
+                        }
+                }
                 return n;
         }
+#pragma GCC diagnostic pop
 
-        int main_loop_select_polling(fd_set &fd_set_read)
+/// output_buffer ί᤿ǡǤ send() ޤ˼Ԥϵ֤ޤ
+        bool main_loop_flush(int work_index)
         {
-                int file_descriptor_maximum = file_descriptor_;
-                FD_ZERO(&fd_set_read);
-                FD_SET(file_descriptor_, &fd_set_read);
-                for (int i = 0; i != max_connection_; ++i)
+                Work *work = work_ + work_index;
+                while (work->output_index < work->output_size)
                 {
-                        if ((work_ + i)->flag)
+                        int send_result = SkkSocket::send(work->file_descriptor,
+                                                          work->output_buffer + work->output_index,
+                                                          work->output_size - work->output_index);
+                        if (send_result == -1)
                         {
-                                FD_SET((work_ + i)->file_descriptor, &fd_set_read);
-                                if ((work_ + i)->file_descriptor > file_descriptor_maximum)
-                                {
-                                        file_descriptor_maximum = (work_ + i)->file_descriptor;
-                                }
+                                return (errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR);
+                        }
+                        work->output_index += send_result;
+                }
+                work->resetOutput();
+                return true;
+        }
+
+/// file_descriptor ³Ƥ Work Υǥå֤ޤդʤ -1 ֤ޤ
+/**
+ * ̾ľ˼ Work ؤ send() ʤΤǡ send_work_index_ 
+ * Ĵ٤ޤ
+ */
+        int main_loop_get_work_index(int file_descriptor)
+        {
+                if ((work_ + send_work_index_)->flag && ((work_ + send_work_index_)->file_descriptor == file_descriptor))
+                {
+                        return send_work_index_;
+                }
+                for (int i = 0; i != work_length_; ++i)
+                {
+                        if ((work_ + i)->flag && ((work_ + i)->file_descriptor == file_descriptor))
+                        {
+                                return i;
+                        }
+                }
+                return -1;
+        }
+
+/// Work  length Ĥ䤷ޤ
+/**
+ * 䤷 Work  read_buffer ݤƶ Work ΥꥹȤ˲äޤ
+ * ¸ Work ϥХåեȿذܤΤǡ Work Υݥ󥿤
+ * main_loop_allocate_work() θƤӽФޤǻäƤϤޤ
+ */
+        void main_loop_grow_work(int length)
+        {
+                DEBUG_ASSERT(length > work_length_);
+// delete[] ϥǥȥ饯ǡ
+                Work *work = new Work[length];
+                int *work_free = new int[length];
+                for (int i = 0; i != work_length_; ++i)
+                {
+                        (work + i)->move(work_ + i);
+                }
+                for (int i = 0; i != work_free_length_; ++i)
+                {
+                        *(work_free + i) = *(work_free_ + i);
+                }
+#ifdef YASKKSERV_CONFIG_HAVE_IO_URING
+                if (io_uring_work_)
+                {
+                        IoUringWork *io_uring_work = new IoUringWork[length];
+                        for (int i = 0; i != work_length_; ++i)
+                        {
+                                (io_uring_work + i)->move(io_uring_work_ + i);
                         }
+                        delete[] io_uring_work_;
+                        io_uring_work_ = io_uring_work;
+                }
+#endif  // YASKKSERV_CONFIG_HAVE_IO_URING
+                delete[] work_;
+                delete[] work_free_;
+                work_ = work;
+                work_free_ = work_free;
+                if (idle_timeout_ > 0)
+                {
+                        idle_timer_wheel_.resize(length);
+                }
+// ǥåȤ褦ˡսѤߤޤ
+                for (int i = length - 1; i >= work_length_; --i)
+                {
 #ifdef SKK_MEMORY_DEBUG
-                        skk_memory_debug_check_((work_ + i)->read_buffer - SKK_MEMORY_DEBUG_MARGIN_SIZE);
-                        skk_memory_debug_check_((work_ + i)->read_buffer - SKK_MEMORY_DEBUG_MARGIN_SIZE + SKK_MEMORY_DEBUG_MARGIN_SIZE + READ_BUFFER_SIZE);
+                        (work_ + i)->read_buffer = new char[SKK_MEMORY_DEBUG_MARGIN_SIZE + READ_BUFFER_SIZE + SKK_MEMORY_DEBUG_MARGIN_SIZE];
+                        (work_ + i)->read_buffer += SKK_MEMORY_DEBUG_MARGIN_SIZE;
+                        skk_memory_debug_set_((work_ + i)->read_buffer - SKK_MEMORY_DEBUG_MARGIN_SIZE);
+                        skk_memory_debug_set_((work_ + i)->read_buffer - SKK_MEMORY_DEBUG_MARGIN_SIZE + SKK_MEMORY_DEBUG_MARGIN_SIZE + READ_BUFFER_SIZE);
+#else  // SKK_MEMORY_DEBUG
+                        (work_ + i)->read_buffer = new char[READ_BUFFER_SIZE];
 #endif  // SKK_MEMORY_DEBUG
+                        *((work_ + i)->read_buffer + 0) = '\0';
+                        *(work_free_ + work_free_length_) = i;
+                        ++work_free_length_;
                 }
-                struct timeval timeout;
-                timeout.tv_sec = 3;
-                timeout.tv_usec = 0;
-                int n = select(file_descriptor_maximum + 1, &fd_set_read, 0, 0, &timeout);
-                if ((n == -1) && (errno == EINTR))
+                work_length_ = length;
+        }
+
+/// listen Ƥ륽åȤ³ԤĤ٤ʤп֤ޤ
+/**
+ * main_loop_prefork() λҥץƱåȤ accept() Τǡ
+ * Work ƻδ֤ϥåȤԤ³¾λҥץǤ
+ * ޤ
+ */
+        bool main_loop_is_accept() const
+        {
+                return !worker_flag_ || (work_free_length_ != 0) || (work_length_ < max_connection_);
+        }
+
+/// Ƥ Work Υǥå֤ޤ max_connection_ Ĥ٤ƻʤ -1 ֤ޤ
+        int main_loop_allocate_work()
+        {
+                if (work_free_length_ == 0)
                 {
-                        syslog_.printf(1, SkkSyslog::LEVEL_INFO, "caught signal");
+                        if (work_length_ >= max_connection_)
+                        {
+                                return -1;
+                        }
+                        main_loop_grow_work((work_length_ * 2 < max_connection_) ? work_length_ * 2 : max_connection_);
                 }
-                return n;
+                --work_free_length_;
+                return *(work_free_ + work_free_length_);
+        }
+
+/// Work Ĥƶ Work ΥꥹȤᤷޤ send() ˼Ԥ Work ʤɤϤδؿĤ٤Ǥ
+/**
+ * io_uring  Work ϡ send δλԤäƤꥹȤᤷ
+ * 
+ */
+        void main_loop_close(int work_index)
+        {
+                if (!(work_ + work_index)->flag)
+                {
+                        return;
+                }
+                (work_ + work_index)->closeAndReset();
+                if (idle_timeout_ > 0)
+                {
+                        idle_timer_wheel_.remove(work_index);
+                }
+#ifdef YASKKSERV_CONFIG_HAVE_IO_URING
+                if (io_uring_work_ && (io_uring_work_ + work_index)->send_flag)
+                {
+                        return;
+                }
+#endif  // YASKKSERV_CONFIG_HAVE_IO_URING
+                main_loop_release_work(work_index);
+        }
+
+/// ȤäƤʤ Work  Work ΥꥹȤᤷޤ
+        void main_loop_release_work(int work_index)
+        {
+                DEBUG_ASSERT(work_free_length_ < work_length_);
+                *(work_free_ + work_free_length_) = work_index;
+                ++work_free_length_;
+        }
+
+/// accept  Work ̵̿³Ĥ륿ޡ˲äޤ
+        void main_loop_start_idle_timer(int work_index)
+        {
+                (work_ + work_index)->activity_time = idle_time_;
+                if (idle_timeout_ > 0)
+                {
+                        idle_timer_wheel_.add(work_index, idle_time_ + idle_timeout_);
+                }
+        }
+
+/// timeout ȼ main_loop_reap() ٤ᤤ֤ޤɤ̵ 0 ֤ޤ
+/**
+ * ͤ buffer ؤ礬Τǡ buffer  select() ʤɤ
+ * ޤݻɬפޤ
+ */
+        struct timeval *main_loop_get_idle_timeout(struct timeval *timeout, struct timeval &buffer) const
+        {
+                const int second = idle_timer_wheel_.getTimeout(idle_time_);
+                if ((second == -1) || (timeout && (timeout->tv_sec < second)))
+                {
+                        return timeout;
+                }
+                buffer.tv_sec = second;
+                buffer.tv_usec = 0;
+                return &buffer;
+        }
+
+/// idle_timeout_ äΤƤʤ Work ĤޤĤ Work  fd_set_read ޤ
+/**
+ * ΤӤˤ activity_time 񤭴ǡޡľ
+ * ޤ󡣴¤褿 Work θ˼ƤС
+ * activity_time δ¤ľޤ
+ *
+ * readable_flag ʤС fd_set_read ɤ߹߲ǽ Work ϼ
+ * äȤߤʤޤ select() θ塢 recv() ˸Ƥ֤Τǡ
+ * ¤礦ɤϤ׵ΤƤ˺Ѥߤޤ io_uring Ǥϼ
+ * ƤƤ֤ΤǵϤޤ
+ */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wold-style-cast"
+        void main_loop_reap(fd_set &fd_set_read, bool readable_flag)
+        {
+                if (idle_timeout_ <= 0)
+                {
+                        return;
+                }
+// ƤӽФ¦ select() ʤɤ errno Ĵ٤Τǡʤ褦ˤޤ
+                const int backup_errno = errno;
+                int i;
+                while ((i = idle_timer_wheel_.pop(idle_time_)) != -1)
+                {
+                        Work *work = work_ + i;
+                        DEBUG_ASSERT(work->flag);
+                        if (readable_flag && FD_ISSET(work->file_descriptor, &fd_set_read))
+                        {
+                                work->activity_time = idle_time_;
+                        }
+                        if (work->activity_time + idle_timeout_ > idle_time_)
+                        {
+                                idle_timer_wheel_.add(i, work->activity_time + idle_timeout_);
+                                continue;
+                        }
+                        syslog_.printf(2,
+                                       SkkSyslog::LEVEL_INFO,
+                                       "idle timeout %s",
+                                       main_loop_get_peer_name(i));
+                        if (main_loop_is_io_uring())
+                        {
+                                main_loop_cancel_receive(i);
+                        }
+                        else
+                        {
+                                FD_CLR(work->file_descriptor, &fd_set_read);
+                        }
+                        main_loop_close(i);
+                        ++idle_reap_count_;
+                        main_loop_add_statistics(statistics_->idle_timeout);
+                }
+                errno = backup_errno;
         }
 #pragma GCC diagnostic pop
 
-/// mainLoop() Ǽιå򤷤ޤ
-        int main_loop_check_reload_dictionary(SkkDictionary *skk_dictionary,
-                                              int skk_dictionary_length,
-                                              const char * const *dictionary_filename_table,
-                                              bool dictionary_check_update_flag)
+/// io_uring ǼδλԤĤ Work  multishot recv äޤ
+/**
+ * äޤǤϥͥ뤬åȤ򻲾ȤƤΤǡ close() Ƥ
+ * Ǥޤ
+ */
+        void main_loop_cancel_receive(int work_index)
+        {
+#ifdef YASKKSERV_CONFIG_HAVE_IO_URING
+                if (io_uring_)
+                {
+                        io_uring_->prepareCancel(io_uring_user_data(IO_URING_TYPE_RECEIVE, (io_uring_work_ + work_index)->generation, work_index),
+                                                 io_uring_user_data(IO_URING_TYPE_CANCEL, 0, 0));
+                }
+#else  // YASKKSERV_CONFIG_HAVE_IO_URING
+                (void)work_index;
+#endif  // YASKKSERV_CONFIG_HAVE_IO_URING
+        }
+
+/// ˽Ϥ³֤ޤ
+        const char *main_loop_get_peer_name(int work_index) const
+        {
+                if ((work_ + work_index)->socket.sin_family == AF_UNIX)
+                {
+                        return "unix socket";
+                }
+                return inet_ntoa((work_ + work_index)->socket.sin_addr);
+        }
+
+/// ä֤ޤפ碌Ƥޤ
+        static time_t main_loop_get_time()
+        {
+                struct timespec ts;
+                clock_gettime(CLOCK_MONOTONIC, &ts);
+                return ts.tv_sec;
+        }
+
+/// main_loop_get_time() Ʊפλʥä֤ޤ
+        static int64_t main_loop_get_time_nanosecond()
+        {
+                struct timespec ts;
+                clock_gettime(CLOCK_MONOTONIC, &ts);
+                return static_cast<int64_t>(ts.tv_sec) * 1000 * 1000 * 1000 + static_cast<int64_t>(ts.tv_nsec);
+        }
+
+/// mainLoop() Ǽ׵ޤ
+/**
+ * read_buffer  read_process_index  recv_result ХȤ˼
+ * ǡޤ main_loop_io_uring() ȤФϡ select() 
+ * recv() Ʊ򤳤δؿǼɬפޤ
+ */
+        virtual void main_loop_process(int work_index, int recv_result)
+        {
+                (void)recv_result;
+                (work_ + work_index)->reset();
+        }
+
+/// mainLoop()  io_uring Ȥ򤷤ޤ io_uring Ȥʤе֤ main_loop_select() Ȥ٤Ǥ
+/**
+ * multishot recv Ȥ뤫ɤϡºݤ socketpair() ǼƳ
+ * ޤ multishot recv Ȥ륫ͥǤ multishot accept 
+ * ޤ
+ */
+        bool main_loop_initialize_io_uring()
+        {
+#ifdef YASKKSERV_CONFIG_HAVE_IO_URING
+                io_uring_ = new SkkIoUring;
+                if (io_uring_->initialize(IO_URING_ENTRIES) &&
+                    io_uring_->initializeBuffer(IO_URING_BUFFER_GROUP,
+                                                IO_URING_BUFFER_COUNT,
+                                                MIDASI_SIZE + MIDASI_TERMINATOR_SIZE,
+                                                io_uring_user_data(IO_URING_TYPE_BUFFER, 0, 0)) &&
+                    io_uring_test_multishot_receive())
+                {
+                        io_uring_work_ = new IoUringWork[work_length_];
+                        if (file_descriptor_ != -1)
+                        {
+                                io_uring_prepare_accept(file_descriptor_);
+                        }
+                        if (unix_file_descriptor_ != -1)
+                        {
+                                io_uring_prepare_accept(unix_file_descriptor_);
+                        }
+                        syslog_.printf(1, SkkSyslog::LEVEL_INFO, "io_uring enabled");
+                        return true;
+                }
+                delete io_uring_;
+                io_uring_ = 0;
+#endif  // YASKKSERV_CONFIG_HAVE_IO_URING
+                return false;
+        }
+
+/// main_loop_initialize_io_uring() Ƥп֤ޤ
+        bool main_loop_is_io_uring() const
+        {
+#ifdef YASKKSERV_CONFIG_HAVE_IO_URING
+                return io_uring_ != 0;
+#else  // YASKKSERV_CONFIG_HAVE_IO_URING
+                return false;
+#endif  // YASKKSERV_CONFIG_HAVE_IO_URING
+        }
+
+/// mainLoop()  main_loop_select()  io_uring Ԥޤ
+/**
+ * accept  recv  multishot Ǿ׵ᤷƤǡ
+ * main_loop_process() ǽޤƤӽФ¦ main_loop_accept() 
+ * recv() 򤹤ɬפϤޤ
+ *
+ *  Work ȤХåեίᡢ send δλԤäƤ鼡
+ *  send ׵ᤷޤ 1 Ĥ Work  send Ͼ 1 ĤʤΤǡ
+ * Ѥޤ send ׵ϼθƤӽФǤޤȤϤΤǡ
+ * ׵ȱǤ io_uring_enter()  1 롼פ 1 Ǥ
+ *
+ * file_descriptor_table ȼγľΥեǥץ poll
+ * ơɤ߹߲ǽˤʤäΤ fd_set_read ֤ޤͤϽ
+ * λοǡॢȤʤ 0 Ԥ -1 ֤
+ * 
+ */
+        int main_loop_io_uring(fd_set &fd_set_read, const int *file_descriptor_table, int length, struct timeval *timeout)
         {
+#ifdef YASKKSERV_CONFIG_HAVE_IO_URING
+                FD_ZERO(&fd_set_read);
+                for (int i = 0; i != length; ++i)
+                {
+                        io_uring_prepare_poll(*(file_descriptor_table + i));
+                }
+                if (reloader_.isRunning())
+                {
+                        io_uring_prepare_poll(reloader_.getFileDescriptor());
+                }
+                if (watcher_.isInitialized())
+                {
+                        io_uring_prepare_poll(watcher_.getFileDescriptor());
+                }
+                struct timeval idle_timeout;
+                const struct timeval *wait_timeout = main_loop_get_idle_timeout(timeout, idle_timeout);
+                if (main_loop_prepare_shared_ring_sleep())
+                {
+                        idle_timeout.tv_sec = 0;
+                        idle_timeout.tv_usec = 0;
+                        wait_timeout = &idle_timeout;
+                }
+                struct __kernel_timespec io_uring_timeout;
+                if (wait_timeout)
+                {
+                        io_uring_timeout.tv_sec = wait_timeout->tv_sec;
+                        io_uring_timeout.tv_nsec = wait_timeout->tv_usec * 1000;
+                }
+                if (io_uring_->submitAndWait(1, wait_timeout ? &io_uring_timeout : 0) == -1)
+                {
+// EBUSY  EAGAIN ϴλ塼Ƥ뤫񸻤Ū­ʤ
+// Ǥλ򴢤СϤʤä׵ϼ io_uring_enter() 
+// Ϥޤ
+                        if ((errno != ETIME) && (errno != EBUSY) && (errno != EAGAIN))
+                        {
+                                if (errno == EINTR)
+                                {
+                                        syslog_.printf(1, SkkSyslog::LEVEL_INFO, "caught signal");
+                                }
+                                return -1;
+                        }
+                }
+                idle_time_ = main_loop_get_time();
                 int result = 0;
+                const struct io_uring_cqe *cqe;
+                while ((cqe = io_uring_->peekCompletion()) != 0)
+                {
+                        const uint64_t user_data = cqe->user_data;
+                        const int cqe_result = cqe->res;
+                        const unsigned int cqe_flags = cqe->flags;
+                        io_uring_->advanceCompletion();
+                        const int index = static_cast<int>(user_data & 0xffffffff);
+                        const unsigned int generation = static_cast<unsigned int>(user_data >> 32) & 0xffffff;
+                        switch (static_cast<int>(user_data >> 56))
+                        {
+                        default:
+                                DEBUG_ASSERT(0);
+                                break;
+                        case IO_URING_TYPE_ACCEPT:
+                                ++result;
+                                io_uring_accept(index, cqe_result, cqe_flags);
+                                break;
+                        case IO_URING_TYPE_RECEIVE:
+                                ++result;
+                                io_uring_receive(index, generation, cqe_result, cqe_flags);
+                                break;
+                        case IO_URING_TYPE_SEND:
+                                ++result;
+                                io_uring_send(index, generation, cqe_result);
+                                break;
+                        case IO_URING_TYPE_POLL:
+                                ++result;
+                                io_uring_poll(index, fd_set_read);
+                                break;
+                        case IO_URING_TYPE_BUFFER:
+// Хåե֤ʤäλ֤ޤ
+                                syslog_.printf(1, SkkSyslog::LEVEL_WARNING, "io_uring provide buffer failed (%d)", cqe_result);
+                                break;
+                        case IO_URING_TYPE_CANCEL:
+                        case IO_URING_TYPE_TEST:
+                                break;
+                        }
+                }
+                main_loop_process_shared_ring();
+                main_loop_reap(fd_set_read, false);
+                io_uring_update_accept();
+// ίޤäϼ io_uring_enter() ޤ
+                for (int i = 0; i != work_length_; ++i)
+                {
+                        IoUringWork *p = io_uring_work_ + i;
+                        if ((work_ + i)->flag && !p->send_flag && ((work_ + i)->output_size > 0))
+                        {
+                                p->swap(work_ + i);
+                                io_uring_->prepareSend((work_ + i)->file_descriptor,
+                                                       p->sending_buffer + p->sent_size,
+                                                       p->sending_size - p->sent_size,
+                                                       io_uring_user_data(IO_URING_TYPE_SEND, p->generation, i));
+                        }
+                }
+                return result;
+#else  // YASKKSERV_CONFIG_HAVE_IO_URING
+                return main_loop_select(fd_set_read, file_descriptor_table, length, timeout);
+#endif  // YASKKSERV_CONFIG_HAVE_IO_URING
+        }
+
+/// mainLoop() ˼ιåޤ
+/**
+ * inotify Ȥ SkkDictionaryWatcher Ǽιƻ뤷Ȥ
+ * ʤ main_loop_check_reload_dictionary() ΤӤ
+ * SkkDictionary::isUpdateDictionary() ǳǧޤ
+ */
+        void main_loop_initialize_reload_dictionary(int skk_dictionary_length,
+                                                    const char * const *dictionary_filename_table,
+                                                    bool dictionary_check_update_flag)
+        {
                 if (dictionary_check_update_flag && dictionary_filename_table)
                 {
-                        int total_read_size = 0;
-                        for (int i = 0; i != max_connection_; ++i)
+                        if (!reloader_.initialize(skk_dictionary_length))
                         {
-                                if ((work_ + i)->flag)
+                                syslog_.printf(1,
+                                               SkkSyslog::LEVEL_WARNING,
+                                               "dictionary reloader initialize failed");
+                                return;
+                        }
+                        if (!watcher_.initialize(dictionary_filename_table, skk_dictionary_length))
+                        {
+                                syslog_.printf(1,
+                                               SkkSyslog::LEVEL_INFO,
+                                               "inotify is not available (dictionary update is checked by stat())");
+                        }
+                }
+        }
+
+/// mainLoop() Ǽιå򤷤ޤ
+/**
+ * 줿 SkkDictionaryReloader ǥХå饦ɤΥå
+ * 鳫ľľ򽪤θƤӽФǺؤޤؤ
+ * õι֤˹ԤΤǡ³Υ饤ȤԤ˺Ѥߤޤ
+ * ľ˼ԤϸμȤ³ޤ
+ *
+ * inotify Ǵƻ뤷Ƥϡ fd_set_read ΤäȤ
+ * ٥ȤɤΤǡõȤΥƥॳϤޤ
+ *
+ * ƤӽФ¦ select()  errno Ĵ٤褦ˡ errno Ѥޤ
+ * 
+ *
+ * ͤϺؤοǤ
+ */
+        template<typename T> int main_loop_check_reload_dictionary(T *skk_dictionary,
+                                                                   int skk_dictionary_length,
+                                                                   const char * const *dictionary_filename_table,
+                                                                   const fd_set &fd_set_read)
+        {
+                int result = 0;
+                if (!reloader_.isInitialized())
+                {
+                        return result;
+                }
+                const int backup_errno = errno;
+                if (reloader_.isRunning())
+                {
+                        if (FD_ISSET(reloader_.getFileDescriptor(), &fd_set_read) && reloader_.isFinished())
+                        {
+                                reloader_.finish(skk_dictionary);
+                                for (int i = 0; i != skk_dictionary_length; ++i)
                                 {
-                                        total_read_size += (work_ + i)->read_process_index;
+                                        switch (reloader_.getResult(i))
+                                        {
+                                        default:
+                                                DEBUG_ASSERT(0);
+                                                break;
+                                        case SkkDictionaryReloader::RESULT_NONE:
+                                                break;
+                                        case SkkDictionaryReloader::RESULT_SWAPPED:
+                                                ++result;
+                                                syslog_.printf(1,
+                                                               SkkSyslog::LEVEL_INFO,
+                                                               "dictionary \"%s\" (index = %d) updated",
+                                                               *(dictionary_filename_table + i),
+                                                               i);
+                                                break;
+                                        case SkkDictionaryReloader::RESULT_FAILED:
+                                                syslog_.printf(1,
+                                                               SkkSyslog::LEVEL_WARNING,
+                                                               "dictionary \"%s\" (index = %d) reload failed (previous dictionary is used)",
+                                                               *(dictionary_filename_table + i),
+                                                               i);
+                                                break;
+                                        }
                                 }
                         }
-                        if (total_read_size == 0)
+                }
+                if (watcher_.isInitialized())
+                {
+                        if (FD_ISSET(watcher_.getFileDescriptor(), &fd_set_read) && watcher_.readEvent())
                         {
                                 for (int i = 0; i != skk_dictionary_length; ++i)
                                 {
-                                        if (*(dictionary_filename_table + i))
+                                        if (watcher_.getAndClearUpdate(i))
                                         {
-                                                bool update_flag;
-                                                if ((skk_dictionary + i)->isUpdateDictionary(update_flag, *(dictionary_filename_table + i)))
-                                                {
-                                                        if (update_flag)
-                                                        {
-                                                                ++result;
-                                                                (skk_dictionary + i)->close();
-                                                                (skk_dictionary + i)->open(*(dictionary_filename_table + i));
-                                                                syslog_.printf(1,
-                                                                               SkkSyslog::LEVEL_INFO,
-                                                                               "dictionary \"%s\" (index = %d) updated",
-                                                                               *(dictionary_filename_table + i),
-                                                                               i);
-                                                        }
-                                                }
-                                                else
+                                                reloader_.request(i);
+                                        }
+                                }
+                        }
+                }
+                if (!reloader_.isRunning())
+                {
+                        for (int i = 0; i != skk_dictionary_length; ++i)
+                        {
+// inotify ǴƻǤʤä stat() ǳǧޤ
+                                if (*(dictionary_filename_table + i) &&
+                                    (!watcher_.isInitialized() || watcher_.isStatRequired(i)))
+                                {
+                                        bool update_flag;
+                                        if ((skk_dictionary + i)->isUpdateDictionary(update_flag, *(dictionary_filename_table + i)))
+                                        {
+                                                if (update_flag)
                                                 {
-                                                        syslog_.printf(1,
-                                                                       SkkSyslog::LEVEL_WARNING,
-                                                                       "dictionary \"%s\" (index = %d) check failed",
-                                                                       *(dictionary_filename_table + i),
-                                                                       i);
+                                                        reloader_.request(i);
                                                 }
                                         }
+                                        else
+                                        {
+                                                syslog_.printf(1,
+                                                               SkkSyslog::LEVEL_WARNING,
+                                                               "dictionary \"%s\" (index = %d) check failed",
+                                                               *(dictionary_filename_table + i),
+                                                               i);
+                                        }
                                 }
                         }
                 }
+// ľ˹줿ϡľ򽪤Ƥ鳫ľޤ
+                if (!reloader_.isRunning())
+                {
+                        reloader_.start(dictionary_filename_table);
+                }
+                errno = backup_errno;
                 return result;
         }
 
 /// mainLoop()  accept() ޤ
+/**
+ * listen Ƥ륽åȤϥΥ֥å󥰤ʤΤǡԤäƤ³
+ * ʤޤǼդޤƤ Work ʤмդå
+ * 򤹤Ĥޤ
+ * select() ǰʤ FD_SETSIZE ʾΥեǥץĤ
+ * 
+ */
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wold-style-cast"
         bool main_loop_accept(fd_set &fd_set_read, int select_result)
+        {
+                (void)select_result;
+                if ((file_descriptor_ != -1) && FD_ISSET(file_descriptor_, &fd_set_read) && !main_loop_accept_listen_socket(file_descriptor_))
+                {
+                        return false;
+                }
+                if ((unix_file_descriptor_ != -1) && FD_ISSET(unix_file_descriptor_, &fd_set_read) && !main_loop_accept_listen_socket(unix_file_descriptor_))
+                {
+                        return false;
+                }
+                return true;
+        }
+
+/// listen_file_descriptor ԤäƤ³դޤ
+        bool main_loop_accept_listen_socket(int listen_file_descriptor)
         {
                 socklen_t length = sizeof(struct sockaddr_in);
-                if (FD_ISSET(file_descriptor_, &fd_set_read))
+                int counter = 0;
+                bool full_flag = false;
+                for (;;)
                 {
-                        int counter = 0;
-                        for (int i = 0; i != max_connection_; ++i)
+                        const int i = main_loop_allocate_work();
+                        if (i == -1)
                         {
-                                if ((work_ + i)->flag == false)
-                                {
-                                        int fd = accept(file_descriptor_,
-                                                        reinterpret_cast<struct sockaddr*>(&(work_ + i)->socket),
-                                                        reinterpret_cast<socklen_t*>(&length));
-                                        if (fd == -1)
-                                        {
-//                                         goto ERROR_BREAK;
-//                                         return false;
-                                        }
-                                        else
-                                        {
-                                                syslog_.printf(2,
-                                                               SkkSyslog::LEVEL_INFO,
-                                                               "connected from %s",
-                                                               inet_ntoa((work_ + i)->socket.sin_addr));
-                                                (work_ + i)->flag = true;
-                                                (work_ + i)->file_descriptor = fd;
-                                                ++counter;
-                                                if (counter >= select_result)
-                                                {
-                                                        break;
-                                                }
-                                        }
-                                }
+                                full_flag = true;
+                                break;
                         }
-                        if (counter == 0)
+                        length = sizeof(struct sockaddr_in);
+                        int fd = main_loop_accept_socket(listen_file_descriptor, &(work_ + i)->socket, &length);
+                        if ((fd == -1) || (fd >= FD_SETSIZE))
                         {
-                                struct sockaddr_in dummy_socket;
-                                int dummy_fd = accept(file_descriptor_,
-                                                      reinterpret_cast<struct sockaddr*>(&dummy_socket),
-                                                      reinterpret_cast<socklen_t*>(&length));
-                                if (dummy_fd == -1)
+                                if (fd != -1)
                                 {
-                                        return false;
+                                        syslog_.printf(1, SkkSyslog::LEVEL_WARNING, "too many file descriptors for select()");
+                                        close(fd);
                                 }
-                                close(dummy_fd);
+                                main_loop_release_work(i);
+                                break;
+                        }
+                        syslog_.printf(2,
+                                       SkkSyslog::LEVEL_INFO,
+                                       "connected from %s",
+                                       main_loop_get_peer_name(i));
+                        (work_ + i)->flag = true;
+                        (work_ + i)->file_descriptor = fd;
+                        (work_ + i)->resetOutput();
+                        main_loop_start_idle_timer(i);
+                        main_loop_add_statistics(statistics_->connection);
+                        ++counter;
+                }
+                if (full_flag && (counter == 0))
+                {
+                        struct sockaddr_in dummy_socket;
+                        int dummy_fd = accept(listen_file_descriptor,
+                                              reinterpret_cast<struct sockaddr*>(&dummy_socket),
+                                              reinterpret_cast<socklen_t*>(&length));
+                        if (dummy_fd == -1)
+                        {
+// ¾Υץ˼դʤɤ EAGAIN ˤʤޤ
+                                return (errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == ECONNABORTED) || (errno == EINTR);
                         }
+                        close(dummy_fd);
                 }
                 return true;
         }
 
+/// listen_file_descriptor  accept() ơΥ֥å󥰤 close-on-exec ΥåȤ֤ޤ
+/**
+ * AF_UNIX ΥåȤդ硢 socket ˤ sin_family 
+ * AF_UNIX ޤ
+ */
+        int main_loop_accept_socket(int listen_file_descriptor, struct sockaddr_in *socket, socklen_t *length)
+        {
+#ifdef YASKKSERV_CONFIG_FUNCTION_HAVE_ACCEPT4
+                return accept4(listen_file_descriptor, reinterpret_cast<struct sockaddr*>(socket), length, SOCK_NONBLOCK | SOCK_CLOEXEC);
+#else  // YASKKSERV_CONFIG_FUNCTION_HAVE_ACCEPT4
+                int fd = accept(listen_file_descriptor, reinterpret_cast<struct sockaddr*>(socket), length);
+                if (fd != -1)
+                {
+                        fcntl(fd, F_SETFL, O_NONBLOCK);
+                        fcntl(fd, F_SETFD, FD_CLOEXEC);
+                }
+                return fd;
+#endif  // YASKKSERV_CONFIG_FUNCTION_HAVE_ACCEPT4
+        }
+
 /// MainLoop()  recv() ٤ɤ֤ޤ
         bool main_loop_is_recv(int work_index, fd_set &fd_set_read)
         {
@@ -477,6 +1611,8 @@ protected:
         bool main_loop_recv(int work_index, int &recv_result, bool &error_break_flag)
         {
                 bool result = true;
+                send_work_index_ = work_index;
+                (work_ + work_index)->activity_time = idle_time_;
                 recv_result = SkkSocket::receive((work_ + work_index)->file_descriptor,
                                                  (work_ + work_index)->read_buffer + (work_ + work_index)->read_process_index,
                                                  MIDASI_SIZE + MIDASI_TERMINATOR_SIZE - (work_ + work_index)->read_process_index);
@@ -499,10 +1635,7 @@ protected:
                 }
                 else if (recv_result == 0)
                 {
-                        close((work_ + work_index)->file_descriptor);
-                        (work_ + work_index)->reset();
-                        (work_ + work_index)->file_descriptor = 0;
-                        (work_ + work_index)->flag = false;
+                        main_loop_close(work_index);
                 }
                 else if (recv_result > MIDASI_SIZE + MIDASI_TERMINATOR_SIZE)
                 {
@@ -511,6 +1644,14 @@ protected:
                         DEBUG_ASSERT(0);
                         (work_ + work_index)->reset();
                 }
+#ifdef YASKKSERV_CONFIG_HAVE_SHARED_RING
+                else if ((work_ + work_index)->shared_ring)
+                {
+// SkkSharedRing Ȥ Work ΥåȤˤϥФ򵯤 1 ХȤ
+// ʤΤǼΤƤޤ
+                        (work_ + work_index)->reset();
+                }
+#endif  // YASKKSERV_CONFIG_HAVE_SHARED_RING
                 else
                 {
                         result = false;
@@ -523,9 +1664,7 @@ protected:
 /// mainLoop()  "0" ν򤷤ޤ
         void main_loop_0(int work_index)
         {
-                close((work_ + work_index)->file_descriptor);
-                (work_ + work_index)->file_descriptor = 0;
-                (work_ + work_index)->flag = false;
+                main_loop_close(work_index);
         }
 
 /// mainLoop()  "2" ν򤷤ޤ
@@ -533,7 +1672,7 @@ protected:
         {
                 if (!send((work_ + work_index)->file_descriptor, version_string, version_string_size - 1))
                 {
-                        (work_ + work_index)->closeAndReset();
+                        main_loop_close(work_index);
                 }
         }
 
@@ -543,8 +1682,155 @@ protected:
                 const char hostname[] = "hostname:addr:...: ";
                 if (!send((work_ + work_index)->file_descriptor, hostname, sizeof(hostname) - 1))
                 {
-                        (work_ + work_index)->closeAndReset();
+                        main_loop_close(work_index);
+                }
+        }
+
+/// mainLoop()  "R" ν򤷤ޤ
+/**
+ * AF_UNIX ΥåȤ³饤Ȥ SkkSharedRing ä
+ * ʹߤ׵ϥ󥰤ǼޤåȤϥ饤Ȥ
+ * Ф򵯤˻Ȥޤ󥰤Ȥʤʥޥ
+ * Ȥưޤ
+ */
+        void main_loop_shared_ring(int work_index)
+        {
+#ifdef YASKKSERV_CONFIG_HAVE_SHARED_RING
+                Work *work = work_ + work_index;
+// ƤʤС󥰤ϤȽѤäƤޤޤ
+                bool sending_flag = (work->output_size > 0);
+#ifdef YASKKSERV_CONFIG_HAVE_IO_URING
+                if (io_uring_work_ && (io_uring_work_ + work_index)->send_flag)
+                {
+                        sending_flag = true;
+                }
+#endif  // YASKKSERV_CONFIG_HAVE_IO_URING
+                if ((work->socket.sin_family == AF_UNIX) && (work->shared_ring == 0) && !sending_flag)
+                {
+                        SkkSharedRing *shared_ring = new SkkSharedRing;
+                        if (shared_ring->create(SHARED_RING_REQUEST_SIZE, SHARED_RING_RESPONSE_SIZE) &&
+                            SkkSharedRing::sendFileDescriptor(work->file_descriptor, 'R', shared_ring->getFileDescriptor()))
+                        {
+                                shared_ring->closeFileDescriptor();
+                                work->shared_ring = shared_ring;
+                                syslog_.printf(2, SkkSyslog::LEVEL_INFO, "shared ring enabled");
+                                return;
+                        }
+                        delete shared_ring;
+                }
+#endif  // YASKKSERV_CONFIG_HAVE_SHARED_RING
+                main_loop_illegal_command(work_index);
+        }
+
+/// work_index  SkkSharedRing ȤäƤп֤ޤ
+        bool main_loop_is_shared_ring(int work_index) const
+        {
+#ifdef YASKKSERV_CONFIG_HAVE_SHARED_RING
+                return (work_ + work_index)->shared_ring != 0;
+#else  // YASKKSERV_CONFIG_HAVE_SHARED_RING
+                (void)work_index;
+                return false;
+#endif  // YASKKSERV_CONFIG_HAVE_SHARED_RING
+        }
+
+/// select()  io_uring Ԥˡ SkkSharedRing Ȥ饤Ȥ褦ˤޤԤ˽Ǥ׵᤬п֤ޤ
+/**
+ * ľ˥󥰤׵ƤС̲ SHARED_RING_SPIN_TIME
+ * ʥäޤǼ׵Ԥޤä饤ȤϤ
+ * ׵񤯤Ȥ¿Τǡδ֤ϥ饤ȤåȤǥ
+ * Ф򵯤˺Ѥߤޤ CPU  1 ĤʤԤޤ
+ */
+        bool main_loop_prepare_shared_ring_sleep()
+        {
+                bool result = false;
+#ifdef YASKKSERV_CONFIG_HAVE_SHARED_RING
+                if (shared_ring_spin_flag_)
+                {
+                        shared_ring_spin_flag_ = false;
+                        const int64_t limit = main_loop_get_time_nanosecond() + SHARED_RING_SPIN_TIME;
+                        do
+                        {
+                                for (int i = 0; i != work_length_; ++i)
+                                {
+                                        if ((work_ + i)->flag && (work_ + i)->shared_ring && (work_ + i)->shared_ring->isRequest())
+                                        {
+                                                return true;
+                                        }
+                                }
+                                SkkSharedRing::relax();
+                        }
+                        while (main_loop_get_time_nanosecond() < limit);
+                }
+                for (int i = 0; i != work_length_; ++i)
+                {
+                        if ((work_ + i)->flag && (work_ + i)->shared_ring && (work_ + i)->shared_ring->prepareSleep(SHARED_RING_RESPONSE_RESERVE))
+                        {
+                                result = true;
+                        }
+                }
+#endif  // YASKKSERV_CONFIG_HAVE_SHARED_RING
+                return result;
+        }
+
+/// SkkSharedRing Ǽä׵ main_loop_process() ޤ
+/**
+ * ׵ 1 Ĥ read_buffer ɤ߹ǽδ֤ send() 
+ * Τ 1 ĤαȤƥ󥰤ؽ񤭤ޤΥ󥰤ζ
+ * SHARED_RING_RESPONSE_RESERVE ̤ˤʤä顢饤Ȥɤޤ
+ * Ĥ׵ϼФޤ
+ */
+        void main_loop_process_shared_ring()
+        {
+#ifdef YASKKSERV_CONFIG_HAVE_SHARED_RING
+// ƤӽФ¦ select() ʤɤ errno Ĵ٤Τǡʤ褦ˤޤ
+                const int backup_errno = errno;
+                for (int i = 0; i != work_length_; ++i)
+                {
+                        Work *work = work_ + i;
+                        if (!work->flag || !work->shared_ring)
+                        {
+                                continue;
+                        }
+                        work->shared_ring->wakeServer();
+                        bool response_flag = false;
+                        while (work->shared_ring->getResponseSpace() >= SHARED_RING_RESPONSE_RESERVE)
+                        {
+                                work->reset();
+                                const int size = work->shared_ring->popRequest(work->read_buffer, MIDASI_SIZE + MIDASI_TERMINATOR_SIZE);
+                                if (size == SkkSharedRing::POP_EMPTY)
+                                {
+                                        break;
+                                }
+                                if ((size <= 0) || (size > MIDASI_SIZE + MIDASI_TERMINATOR_SIZE))
+                                {
+                                        syslog_.printf(1,
+                                                       SkkSyslog::LEVEL_WARNING,
+                                                       "illegal shared ring request (%s)",
+                                                       main_loop_get_peer_name(i));
+                                        main_loop_close(i);
+                                        main_loop_cancel_receive(i);
+                                        break;
+                                }
+                                send_work_index_ = i;
+                                work->activity_time = idle_time_;
+                                work->shared_ring->beginResponse();
+                                main_loop_process(i, size);
+                                if (!work->flag)
+                                {
+                                        main_loop_cancel_receive(i);
+                                        break;
+                                }
+                                work->shared_ring->commitResponse();
+                                response_flag = true;
+                        }
+                        if (response_flag && work->flag)
+                        {
+                                work->shared_ring->wakeClient();
+                                shared_ring_spin_flag_ = shared_ring_spin_available_flag_;
+                        }
                 }
+                errno = backup_errno;
+#endif  // YASKKSERV_CONFIG_HAVE_SHARED_RING
         }
 
 /// mainLoop() ʥޥɤν򤷤ޤ
@@ -553,7 +1839,7 @@ protected:
                 const char result[] = "0\n";
                 if (!send((work_ + work_index)->file_descriptor, result, sizeof(result) - 1))
                 {
-                        (work_ + work_index)->closeAndReset();
+                        main_loop_close(work_index);
                 }
         }
 
@@ -651,7 +1937,7 @@ protected:
 /// MainLoop() Υեʥ饤Ǥ
         bool main_loop_finalize()
         {
-                for (int i = 0; i != max_connection_; ++i)
+                for (int i = 0; i != work_length_; ++i)
                 {
                         if ((work_ + i)->flag)
                         {
@@ -660,7 +1946,18 @@ protected:
                                 (work_ + i)->flag = false;
                         }
                 }
-                close(file_descriptor_);
+                if (file_descriptor_ != -1)
+                {
+                        close(file_descriptor_);
+                }
+                if (unix_file_descriptor_ != -1)
+                {
+                        close(unix_file_descriptor_);
+                }
+                if (unix_socket_unlink_flag_)
+                {
+                        unlink(unix_socket_path_);
+                }
                 return true;
         }
 
@@ -676,7 +1973,18 @@ protected:
 // ɬפǤ
                 MIDASI_MARGIN_SIZE = 4,
 // struct Work  read_buffer ΥǤ
-                READ_BUFFER_SIZE = MIDASI_SIZE + MIDASI_TERMINATOR_SIZE + MIDASI_MARGIN_SIZE
+                READ_BUFFER_SIZE = MIDASI_SIZE + MIDASI_TERMINATOR_SIZE + MIDASI_MARGIN_SIZE,
+// struct Work  output_buffer ίΥǤۤ饤ȤǤޤ
+                OUTPUT_BUFFER_LIMIT_SIZE = 256 * 1024,
+// SkkSharedRing ׵ȱΥ󥰤ΥǤ
+                SHARED_RING_REQUEST_SIZE = 64 * 1024,
+                SHARED_RING_RESPONSE_SIZE = 1024 * 1024,
+// Υ󥰤ˤζʤ׵Фޤ
+                SHARED_RING_RESPONSE_RESERVE = OUTPUT_BUFFER_LIMIT_SIZE,
+// ׵塢̲餺˼׵ԤĻ (ʥ) Ǥ
+                SHARED_RING_SPIN_TIME = 50 * 1000,
+// main_loop_initialize() Ѱդ Work οǤ
+                WORK_INITIAL_LENGTH = 8
         };
 
         struct Work
@@ -688,14 +1996,95 @@ protected:
         public:
                 Work() :
                         read_buffer(0),
+                        output_buffer(0),
                         file_descriptor(0),
                         read_process_index(0),
+                        output_index(0),
+                        output_size(0),
+                        output_buffer_size(0),
+                        activity_time(0),
+#ifdef YASKKSERV_CONFIG_HAVE_SHARED_RING
+                        shared_ring(0),
+#endif  // YASKKSERV_CONFIG_HAVE_SHARED_RING
                         socket(),
                         flag(false)
                 {
                         SkkUtility::clearMemory(&socket, sizeof(socket));
                 }
 
+/// Ƥʤ data  output_buffer ίޤί᤿ǡ OUTPUT_BUFFER_LIMIT_SIZE ۤϵ֤ޤ
+                bool append(const void *data, int data_size)
+                {
+                        if (output_size - output_index + data_size > OUTPUT_BUFFER_LIMIT_SIZE)
+                        {
+                                return false;
+                        }
+                        if (output_size + data_size > output_buffer_size)
+                        {
+// ѤߤʬͤƤ­ʤ礭ޤ
+                                int size = output_buffer_size;
+                                if (size < output_size - output_index + data_size)
+                                {
+                                        size = output_buffer_size * 2;
+                                        if (size < output_size - output_index + data_size)
+                                        {
+                                                size = output_size - output_index + data_size;
+                                        }
+                                        if (size < 1024)
+                                        {
+                                                size = 1024;
+                                        }
+                                }
+                                char *p = output_buffer;
+                                if (size != output_buffer_size)
+                                {
+                                        p = new char[size];
+                                }
+                                if (output_size - output_index > 0)
+                                {
+                                        memmove(p, output_buffer + output_index, static_cast<size_t>(output_size - output_index));
+                                }
+                                if (p != output_buffer)
+                                {
+                                        delete[] output_buffer;
+                                        output_buffer = p;
+                                        output_buffer_size = size;
+                                }
+                                output_size -= output_index;
+                                output_index = 0;
+                        }
+                        memcpy(output_buffer + output_size, data, static_cast<size_t>(data_size));
+                        output_size += data_size;
+                        return true;
+                }
+
+                void resetOutput()
+                {
+                        output_index = 0;
+                        output_size = 0;
+                }
+
+/// source ƤХåեȰܤޤ
+                void move(Work *source)
+                {
+                        read_buffer = source->read_buffer;
+                        output_buffer = source->output_buffer;
+                        file_descriptor = source->file_descriptor;
+                        read_process_index = source->read_process_index;
+                        output_index = source->output_index;
+                        output_size = source->output_size;
+                        output_buffer_size = source->output_buffer_size;
+                        activity_time = source->activity_time;
+#ifdef YASKKSERV_CONFIG_HAVE_SHARED_RING
+                        shared_ring = source->shared_ring;
+                        source->shared_ring = 0;
+#endif  // YASKKSERV_CONFIG_HAVE_SHARED_RING
+                        socket = source->socket;
+                        flag = source->flag;
+                        source->read_buffer = 0;
+                        source->output_buffer = 0;
+                }
+
                 void reset()
                 {
                         read_process_index = 0;
@@ -705,25 +2094,452 @@ protected:
                 void closeAndReset()
                 {
                         close(file_descriptor);
+#ifdef YASKKSERV_CONFIG_HAVE_SHARED_RING
+                        delete shared_ring;
+                        shared_ring = 0;
+#endif  // YASKKSERV_CONFIG_HAVE_SHARED_RING
                         reset();
                         file_descriptor = 0;
                         flag = false;
                 }
 
                 char *read_buffer;
+// Ƥʤǡ output_buffer  output_index  output_size ޤǤǤ
+                char *output_buffer;
                 int file_descriptor;
                 int read_process_index;
+                int output_index;
+                int output_size;
+                int output_buffer_size;
+// Ǹ˼Ǥ
+                time_t activity_time;
+#ifdef YASKKSERV_CONFIG_HAVE_SHARED_RING
+// "R" ǥ饤ȤϤ󥰤ǤȤäƤʤ 0 Ǥ
+                SkkSharedRing *shared_ring;
+#endif  // YASKKSERV_CONFIG_HAVE_SHARED_RING
                 struct sockaddr_in socket;
                 bool flag;
         };
 
+#ifdef YASKKSERV_CONFIG_HAVE_IO_URING
+private:
+        enum
+        {
+                IO_URING_ENTRIES = 256,
+// ХåեοǤ­ʤʤä Work  -ENOBUFS  recv ׵ᤷľޤ
+                IO_URING_BUFFER_COUNT = 64,
+                IO_URING_BUFFER_GROUP = 0,
+                IO_URING_POLL_LENGTH = 8
+        };
+
+        enum IoUringType
+        {
+                IO_URING_TYPE_ACCEPT = 1,
+                IO_URING_TYPE_RECEIVE,
+                IO_URING_TYPE_SEND,
+                IO_URING_TYPE_POLL,
+                IO_URING_TYPE_CANCEL,
+                IO_URING_TYPE_BUFFER,
+                IO_URING_TYPE_TEST
+        };
+
+/// io_uring  Work ȤΥХåեǤ
+/**
+ * send()  Work  output_buffer ί᤿
+ * sending_buffer ؤޤ sending_buffer  send δ
+ * λޤǽ񤭴ʤΤǡ Work Ĥ send_flag δ֤
+ *  Work Ѥޤ
+ *
+ * generation  accept 뤿Ӥ䤷Ĥ³ؤδλʬ
+ * 
+ */
+        struct IoUringWork
+        {
+        private:
+                IoUringWork(IoUringWork &source);
+                IoUringWork& operator=(IoUringWork &source);
+
+        public:
+                ~IoUringWork()
+                {
+                        delete[] sending_buffer;
+                }
+
+                IoUringWork() :
+                        sending_buffer(0),
+                        sending_size(0),
+                        sending_buffer_size(0),
+                        sent_size(0),
+                        generation(0),
+                        send_flag(false)
+                {
+                }
+
+/// source ƤХåեȰܤޤ
+                void move(IoUringWork *source)
+                {
+                        sending_buffer = source->sending_buffer;
+                        sending_size = source->sending_size;
+                        sending_buffer_size = source->sending_buffer_size;
+                        sent_size = source->sent_size;
+                        generation = source->generation;
+                        send_flag = source->send_flag;
+                        source->sending_buffer = 0;
+                }
+
+/// work ί᤿ˤޤ
+                void swap(Work *work)
+                {
+                        char *tmp_buffer = sending_buffer;
+                        int tmp_buffer_size = sending_buffer_size;
+                        sending_buffer = work->output_buffer;
+                        sending_buffer_size = work->output_buffer_size;
+                        work->output_buffer = tmp_buffer;
+                        work->output_buffer_size = tmp_buffer_size;
+                        sending_size = work->output_size;
+                        sent_size = work->output_index;
+                        work->resetOutput();
+                        send_flag = true;
+                }
+
+                char *sending_buffer;
+                int sending_size;
+                int sending_buffer_size;
+                int sent_size;
+                unsigned int generation;
+                bool send_flag;
+        };
+
+        static uint64_t io_uring_user_data(int type, unsigned int generation, int index)
+        {
+                return (static_cast<uint64_t>(type) << 56) |
+                        (static_cast<uint64_t>(generation & 0xffffff) << 32) |
+                        static_cast<uint64_t>(static_cast<uint32_t>(index));
+        }
+
+/// multishot recv  socketpair() Ǥп֤ޤ
+        bool io_uring_test_multishot_receive()
+        {
+                int socket_pair[2];
+                if (socketpair(AF_UNIX, SOCK_STREAM, 0, socket_pair) == -1)
+                {
+                        return false;
+                }
+                bool result = false;
+                io_uring_->prepareReceive(socket_pair[0], IO_URING_BUFFER_GROUP, io_uring_user_data(IO_URING_TYPE_TEST, 0, 0));
+                const char tmp = '0';
+                if ((io_uring_->submitAndWait(0) != -1) && (write(socket_pair[1], &tmp, 1) == 1))
+                {
+// ¦Ĥ recv  0 ֤ƽޤ
+                        close(socket_pair[1]);
+                        socket_pair[1] = -1;
+                        bool more_flag = true;
+                        while (more_flag && (io_uring_->submitAndWait(1) != -1))
+                        {
+                                const struct io_uring_cqe *cqe;
+                                while ((cqe = io_uring_->peekCompletion()) != 0)
+                                {
+                                        if ((cqe->res == 1) && (cqe->flags & IORING_CQE_F_MORE))
+                                        {
+                                                result = true;
+                                        }
+                                        if (cqe->flags & IORING_CQE_F_BUFFER)
+                                        {
+                                                io_uring_->provideBuffer(static_cast<unsigned short>(cqe->flags >> IORING_CQE_BUFFER_SHIFT));
+                                        }
+                                        if (!(cqe->flags & IORING_CQE_F_MORE))
+                                        {
+                                                more_flag = false;
+                                        }
+                                        io_uring_->advanceCompletion();
+                                }
+                        }
+                }
+                close(socket_pair[0]);
+                if (socket_pair[1] != -1)
+                {
+                        close(socket_pair[1]);
+                }
+                return result;
+        }
+
+        void io_uring_prepare_poll(int file_descriptor)
+        {
+                if (file_descriptor == -1)
+                {
+                        return;
+                }
+                for (int i = 0; i != io_uring_poll_length_; ++i)
+                {
+                        if (*(io_uring_poll_ + i) == file_descriptor)
+                        {
+                                return;
+                        }
+                }
+                if (io_uring_poll_length_ == IO_URING_POLL_LENGTH)
+                {
+                        DEBUG_ASSERT(0);
+                        return;
+                }
+                *(io_uring_poll_ + io_uring_poll_length_) = file_descriptor;
+                ++io_uring_poll_length_;
+                io_uring_->preparePoll(file_descriptor, io_uring_user_data(IO_URING_TYPE_POLL, 0, file_descriptor));
+        }
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wold-style-cast"
+        void io_uring_poll(int file_descriptor, fd_set &fd_set_read)
+        {
+                for (int i = 0; i != io_uring_poll_length_; ++i)
+                {
+                        if (*(io_uring_poll_ + i) == file_descriptor)
+                        {
+                                --io_uring_poll_length_;
+                                *(io_uring_poll_ + i) = *(io_uring_poll_ + io_uring_poll_length_);
+                                break;
+                        }
+                }
+                FD_SET(file_descriptor, &fd_set_read);
+        }
+#pragma GCC diagnostic pop
+
+/// listen_file_descriptor Ǽդ³ Work ˳Ƥޤ
+        void io_uring_accept(int listen_file_descriptor, int cqe_result, unsigned int cqe_flags)
+        {
+                if (cqe_result >= 0)
+                {
+                        const int i = main_loop_allocate_work();
+                        if (i == -1)
+                        {
+// multishot accept ä˼դ³Ǥ
+                                close(cqe_result);
+                        }
+                        else
+                        {
+                                socklen_t length = sizeof(struct sockaddr_in);
+                                getpeername(cqe_result, reinterpret_cast<struct sockaddr*>(&(work_ + i)->socket), &length);
+                                syslog_.printf(2,
+                                               SkkSyslog::LEVEL_INFO,
+                                               "connected from %s",
+                                               main_loop_get_peer_name(i));
+                                (work_ + i)->flag = true;
+                                (work_ + i)->file_descriptor = cqe_result;
+                                IoUringWork *p = io_uring_work_ + i;
+                                ++p->generation;
+                                (work_ + i)->resetOutput();
+                                main_loop_start_idle_timer(i);
+                                main_loop_add_statistics(statistics_->connection);
+                                io_uring_->prepareReceive(cqe_result, IO_URING_BUFFER_GROUP, io_uring_user_data(IO_URING_TYPE_RECEIVE, p->generation, i));
+                        }
+                }
+                if (!(cqe_flags & IORING_CQE_F_MORE))
+                {
+                        io_uring_get_accept_flag(listen_file_descriptor) = false;
+                        if (!io_uring_accept_stop_flag_)
+                        {
+                                io_uring_prepare_accept(listen_file_descriptor);
+                        }
+                }
+        }
+
+/// listen_file_descriptor  multishot accept ưƤ뤫ɤΥե饰֤ޤ
+        bool &io_uring_get_accept_flag(int listen_file_descriptor)
+        {
+                return (listen_file_descriptor == file_descriptor_) ? io_uring_accept_flag_ : io_uring_unix_accept_flag_;
+        }
+
+/// listen_file_descriptor  multishot accept ޤ
+        void io_uring_prepare_accept(int listen_file_descriptor)
+        {
+                io_uring_get_accept_flag(listen_file_descriptor) = true;
+                io_uring_->prepareAccept(listen_file_descriptor, io_uring_user_data(IO_URING_TYPE_ACCEPT, 0, listen_file_descriptor));
+        }
+
+/// main_loop_is_accept() ˹碌 multishot accept äޤϽľޤ
+/**
+ * ä multishot accept ϺǸδλ io_uring_accept() ߤ
+ * ޤä򽪤˽ľϡδλǽľ
+ * 
+ */
+        void io_uring_update_accept()
+        {
+                const bool stop_flag = !main_loop_is_accept();
+                if (stop_flag == io_uring_accept_stop_flag_)
+                {
+                        return;
+                }
+                io_uring_accept_stop_flag_ = stop_flag;
+                const int listen_file_descriptor_table[] = {file_descriptor_, unix_file_descriptor_};
+                for (int i = 0; i != 2; ++i)
+                {
+                        const int listen_file_descriptor = *(listen_file_descriptor_table + i);
+                        if (listen_file_descriptor == -1)
+                        {
+                                continue;
+                        }
+                        if (stop_flag)
+                        {
+                                if (io_uring_get_accept_flag(listen_file_descriptor))
+                                {
+                                        io_uring_->prepareCancel(io_uring_user_data(IO_URING_TYPE_ACCEPT, 0, listen_file_descriptor),
+                                                                 io_uring_user_data(IO_URING_TYPE_CANCEL, 0, 0));
+                                }
+                        }
+                        else if (!io_uring_get_accept_flag(listen_file_descriptor))
+                        {
+                                io_uring_prepare_accept(listen_file_descriptor);
+                        }
+                }
+        }
+
+///  data  read_buffer 礭 main_loop_process() ޤ
+        void io_uring_process(int work_index, const char *data, int data_size)
+        {
+                send_work_index_ = work_index;
+                (work_ + work_index)->activity_time = idle_time_;
+                int offset = 0;
+// "R" θΤϥФ򵯤 1 ХȤʤΤǽޤ
+                while ((offset < data_size) && (work_ + work_index)->flag && !main_loop_is_shared_ring(work_index))
+                {
+                        int size = MIDASI_SIZE + MIDASI_TERMINATOR_SIZE - (work_ + work_index)->read_process_index;
+                        if (size <= 0)
+                        {
+// ʥꥯȤǤ
+                                (work_ + work_index)->reset();
+                                continue;
+                        }
+                        if (size > data_size - offset)
+                        {
+                                size = data_size - offset;
+                        }
+                        memcpy((work_ + work_index)->read_buffer + (work_ + work_index)->read_process_index, data + offset, static_cast<size_t>(size));
+                        main_loop_process(work_index, size);
+                        offset += size;
+                }
+        }
+
+        void io_uring_receive(int work_index, unsigned int generation, int cqe_result, unsigned int cqe_flags)
+        {
+                IoUringWork *p = io_uring_work_ + work_index;
+                const bool current_flag = (work_ + work_index)->flag && (generation == (p->generation & 0xffffff));
+                if (cqe_flags & IORING_CQE_F_BUFFER)
+                {
+                        const unsigned short buffer_id = static_cast<unsigned short>(cqe_flags >> IORING_CQE_BUFFER_SHIFT);
+                        if (current_flag && (cqe_result > 0))
+                        {
+                                io_uring_process(work_index, io_uring_->getBuffer(buffer_id), cqe_result);
+                        }
+                        io_uring_->provideBuffer(buffer_id);
+                }
+                if (!current_flag)
+                {
+                        return;
+                }
+                if ((cqe_result == 0) || ((cqe_result < 0) && (cqe_result != -ENOBUFS)))
+                {
+// Ǥ줿˼Ԥޤ multishot recv ϴ˽äƤ
+// 
+                        main_loop_close(work_index);
+                }
+                else if (!(work_ + work_index)->flag)
+                {
+// "0" ʤɤĤ Work  multishot recv äޤäޤ
+// ϥͥ뤬åȤ򻲾ȤƤΤǡǤޤ
+                        if (cqe_flags & IORING_CQE_F_MORE)
+                        {
+                                io_uring_->prepareCancel(io_uring_user_data(IO_URING_TYPE_RECEIVE, p->generation, work_index),
+                                                         io_uring_user_data(IO_URING_TYPE_CANCEL, 0, 0));
+                        }
+                }
+                else if (!(cqe_flags & IORING_CQE_F_MORE))
+                {
+                        io_uring_->prepareReceive((work_ + work_index)->file_descriptor,
+                                                  IO_URING_BUFFER_GROUP,
+                                                  io_uring_user_data(IO_URING_TYPE_RECEIVE, p->generation, work_index));
+                }
+        }
+
+        void io_uring_send(int work_index, unsigned int generation, int cqe_result)
+        {
+                IoUringWork *p = io_uring_work_ + work_index;
+                if (!(work_ + work_index)->flag || (generation != (p->generation & 0xffffff)))
+                {
+// Ĥ Work ϡǶ Work ΥꥹȤᤷޤ
+                        p->send_flag = false;
+                        main_loop_release_work(work_index);
+                        return;
+                }
+                if (cqe_result <= 0)
+                {
+                        p->send_flag = false;
+                        main_loop_close(work_index);
+                        io_uring_->prepareCancel(io_uring_user_data(IO_URING_TYPE_RECEIVE, p->generation, work_index),
+                                                 io_uring_user_data(IO_URING_TYPE_CANCEL, 0, 0));
+                        return;
+                }
+                p->sent_size += cqe_result;
+                if (p->sent_size < p->sending_size)
+                {
+                        io_uring_->prepareSend((work_ + work_index)->file_descriptor,
+                                               p->sending_buffer + p->sent_size,
+                                               p->sending_size - p->sent_size,
+                                               io_uring_user_data(IO_URING_TYPE_SEND, p->generation, work_index));
+                }
+                else
+                {
+                        p->send_flag = false;
+                }
+        }
+
+protected:
+#endif  // YASKKSERV_CONFIG_HAVE_IO_URING
+
         SkkSyslog syslog_;
+        SkkDictionaryReloader reloader_;
+        SkkDictionaryWatcher watcher_;
+// work_  work_length_ ĤǡƤ Work Υǥå work_free_  work_free_length_ ѤǤޤ
         Work *work_;
+        int *work_free_;
+        int work_length_;
+        int work_free_length_;
+// ľ˼ Work Ǥ send() Ϥޤ Work Ĵ٤ޤ
+        int send_work_index_;
+// ̵̿³Ĥ뤿 Work Ȥδ¤Ǥ idle_time_ ϥ롼פǺǸĴ٤Ǥ
+        SkkTimerWheel idle_timer_wheel_;
+        time_t idle_time_;
+        int idle_timeout_;
+        int idle_reap_count_;
+// פ statistics_ ˿ޤ main_loop_prefork() λҥץǤ϶ͭؤޤ
+        Statistics statistics_buffer_;
+        Statistics *statistics_;
+#ifdef YASKKSERV_CONFIG_HAVE_SHARED_RING
+// ľΥ롼פ SkkSharedRing ׵ƤпǤ
+        bool shared_ring_spin_flag_;
+        bool shared_ring_spin_available_flag_;
+#endif  // YASKKSERV_CONFIG_HAVE_SHARED_RING
+#ifdef YASKKSERV_CONFIG_HAVE_IO_URING
+        SkkIoUring *io_uring_;
+        IoUringWork *io_uring_work_;
+        int io_uring_poll_[IO_URING_POLL_LENGTH];
+        int io_uring_poll_length_;
+// file_descriptor_  unix_file_descriptor_  multishot accept ưƤпǤ
+        bool io_uring_accept_flag_;
+        bool io_uring_unix_accept_flag_;
+// main_loop_is_accept() ˤʤä multishot accept äƤпǤ
+        bool io_uring_accept_stop_flag_;
+#endif  // YASKKSERV_CONFIG_HAVE_IO_URING
+// main_loop_prefork() λҥץʤпǤ
+        bool worker_flag_;
         int port_;
         const char *address_;
         int max_connection_;
         int listen_queue_;
+// listen Ƥ륽åȤǤȤäƤʤ -1 Ǥ
         int file_descriptor_;
+        const char *unix_socket_path_;
+        int unix_socket_mode_;
+        int unix_file_descriptor_;
+        bool unix_socket_unlink_flag_;
 };
 }
 
@@ -0,0 +1,314 @@
+/*
+  Copyright (C) 2005-2021 Tadashi Watanabe <twacc2020@gmail.com>
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#ifndef SKK_TIMER_WHEEL_H
+#define SKK_TIMER_WHEEL_H
+
+#include "skk_architecture.hpp"
+
+namespace YaSkkServ
+{
+/// 1 ñ̤γإޡۥǤ
+/**
+ * 0  length - 1 ޤǤΥǥå˴ ()  1 ĤĻ
+ * ¤褿ǥå pop() ǼФޤ add()  remove() 
+ * O(1) Ǥ
+ *
+ * ۥ LEVEL ʤǡʤ SLOT_LENGTH ĤΥåȤޤ
+ * 0 ܤΥåȤ 1 á 1 ܤ SLOT_LENGTH á 2 ܤ
+ * SLOT_LENGTH * SLOT_LENGTH äȤǡʤΥåȤϻ郎Υ
+ * åȤäȤ˲ʤľޤ 2 ܤɽʤδ
+ *  2 ܤκǸΥåȤ졢ľȤ˲ƿʬޤ
+ *
+ * åȤϥǥåꥹȤǡ next_  previous_ ˻
+ * ޤ slot_ äƤ륹åȤǡɤˤäƤʤ -1 
+ * 
+ */
+class SkkTimerWheel
+{
+        SkkTimerWheel(SkkTimerWheel &source);
+        SkkTimerWheel& operator=(SkkTimerWheel &source);
+
+public:
+        virtual ~SkkTimerWheel()
+        {
+                delete[] next_;
+                delete[] previous_;
+                delete[] slot_;
+                delete[] expire_;
+        }
+
+        SkkTimerWheel() :
+                next_(0),
+                previous_(0),
+                slot_(0),
+                expire_(0),
+                head_(),
+                current_(0),
+                length_(0),
+                count_(0)
+        {
+                for (int i = 0; i != HEAD_LENGTH; ++i)
+                {
+                        head_[i] = -1;
+                }
+        }
+
+///  now ֤ʤ褦ˤޤ
+        void initialize(time_t now)
+        {
+                current_ = now;
+        }
+
+/// ǥå length ĤޤǻȤ褦ˤޤäƤ륤ǥåϤΤޤޤǤ
+        void resize(int length)
+        {
+                if (length <= length_)
+                {
+                        return;
+                }
+                int *next = new int[length];
+                int *previous = new int[length];
+                int *slot = new int[length];
+                time_t *expire = new time_t[length];
+                for (int i = 0; i != length; ++i)
+                {
+                        if (i < length_)
+                        {
+                                *(next + i) = *(next_ + i);
+                                *(previous + i) = *(previous_ + i);
+                                *(slot + i) = *(slot_ + i);
+                                *(expire + i) = *(expire_ + i);
+                        }
+                        else
+                        {
+                                *(next + i) = -1;
+                                *(previous + i) = -1;
+                                *(slot + i) = -1;
+                                *(expire + i) = 0;
+                        }
+                }
+                delete[] next_;
+                delete[] previous_;
+                delete[] slot_;
+                delete[] expire_;
+                next_ = next;
+                previous_ = previous;
+                slot_ = slot;
+                expire_ = expire;
+                length_ = length;
+        }
+
+/// index δ¤ expire ˤޤäƤľޤ
+        void add(int index, time_t expire)
+        {
+                DEBUG_ASSERT_RANGE(index, 0, length_ - 1);
+                remove(index);
+                *(expire_ + index) = expire;
+                link(index, get_slot(expire));
+                ++count_;
+        }
+
+/// index ޤäƤʤв⤷ޤ
+        void remove(int index)
+        {
+                DEBUG_ASSERT_RANGE(index, 0, length_ - 1);
+                if (*(slot_ + index) == -1)
+                {
+                        return;
+                }
+                unlink(index);
+                --count_;
+        }
+
+///  now ޤǿʤᡢ¤褿ǥå 1 ļ֤ޤʤ -1 ֤ޤ
+        int pop(time_t now)
+        {
+                if (count_ == 0)
+                {
+// ʤľΤʤΤǡΤޤ޿ʤޤ
+                        if (now > current_)
+                        {
+                                current_ = now;
+                        }
+                        return -1;
+                }
+                while ((head_[SLOT_EXPIRED] == -1) && (current_ < now))
+                {
+                        tick();
+                }
+                const int index = head_[SLOT_EXPIRED];
+                if (index != -1)
+                {
+                        unlink(index);
+                        --count_;
+                }
+                return index;
+        }
+
+///  now 鼡 pop() ٤ޤǤÿ֤ޤäƤʤ -1 ֤ޤ
+/**
+ * ʤľλ֤Τǡ¤᤯뤳Ȥ
+ * ޤ SLOT_LENGTH * SLOT_LENGTH äĴ٤ޤ
+ */
+        int getTimeout(time_t now) const
+        {
+                if (count_ == 0)
+                {
+                        return -1;
+                }
+                if (head_[SLOT_EXPIRED] != -1)
+                {
+                        return 0;
+                }
+                time_t next = current_ + SLOT_LENGTH * SLOT_LENGTH;
+                for (int i = 1; i != SLOT_LENGTH; ++i)
+                {
+                        if (head_[(current_ + i) & SLOT_MASK] != -1)
+                        {
+                                next = current_ + i;
+                                break;
+                        }
+                }
+                for (int i = 1; i <= SLOT_LENGTH; ++i)
+                {
+                        const time_t boundary = ((current_ >> SLOT_SHIFT) + i) << SLOT_SHIFT;
+                        if (boundary >= next)
+                        {
+                                break;
+                        }
+                        if ((head_[SLOT_LENGTH + ((boundary >> SLOT_SHIFT) & SLOT_MASK)] != -1) ||
+                            ((((boundary >> SLOT_SHIFT) & SLOT_MASK) == 0) &&
+                             (head_[SLOT_LENGTH * 2 + ((boundary >> (SLOT_SHIFT * 2)) & SLOT_MASK)] != -1)))
+                        {
+                                next = boundary;
+                                break;
+                        }
+                }
+                return (next > now) ? static_cast<int>(next - now) : 0;
+        }
+
+/// äƤ륤ǥåο֤ޤ
+        int getCount() const
+        {
+                return count_;
+        }
+
+private:
+        enum
+        {
+                LEVEL = 3,
+                SLOT_SHIFT = 6,
+                SLOT_LENGTH = 1 << SLOT_SHIFT,
+                SLOT_MASK = SLOT_LENGTH - 1,
+// ¤褿ǥå륹åȤǤ
+                SLOT_EXPIRED = SLOT_LENGTH * LEVEL,
+                HEAD_LENGTH = SLOT_EXPIRED + 1
+        };
+
+        int get_slot(time_t expire) const
+        {
+                const time_t delta = expire - current_;
+                if (delta <= 0)
+                {
+                        return SLOT_EXPIRED;
+                }
+                if (delta < SLOT_LENGTH)
+                {
+                        return static_cast<int>(expire & SLOT_MASK);
+                }
+                if (delta < SLOT_LENGTH * SLOT_LENGTH)
+                {
+                        return SLOT_LENGTH + static_cast<int>((expire >> SLOT_SHIFT) & SLOT_MASK);
+                }
+                if (delta >= SLOT_LENGTH * SLOT_LENGTH * SLOT_LENGTH)
+                {
+                        expire = current_ + SLOT_LENGTH * SLOT_LENGTH * SLOT_LENGTH - 1;
+                }
+                return SLOT_LENGTH * 2 + static_cast<int>((expire >> (SLOT_SHIFT * 2)) & SLOT_MASK);
+        }
+
+        void link(int index, int slot)
+        {
+                *(slot_ + index) = slot;
+                *(previous_ + index) = -1;
+                *(next_ + index) = head_[slot];
+                if (head_[slot] != -1)
+                {
+                        *(previous_ + head_[slot]) = index;
+                }
+                head_[slot] = index;
+        }
+
+        void unlink(int index)
+        {
+                const int slot = *(slot_ + index);
+                if (*(previous_ + index) == -1)
+                {
+                        head_[slot] = *(next_ + index);
+                }
+                else
+                {
+                        *(next_ + *(previous_ + index)) = *(next_ + index);
+                }
+                if (*(next_ + index) != -1)
+                {
+                        *(previous_ + *(next_ + index)) = *(previous_ + index);
+                }
+                *(slot_ + index) = -1;
+        }
+
+/// slot Υǥå򤹤٤ƴ¤ǿʬľޤ
+        void relink(int slot)
+        {
+                int index = head_[slot];
+                head_[slot] = -1;
+                while (index != -1)
+                {
+                        const int next = *(next_ + index);
+                        link(index, get_slot(*(expire_ + index)));
+                        index = next;
+                }
+        }
+
+/// 1 ÿʤޤ
+        void tick()
+        {
+                ++current_;
+                if ((current_ & SLOT_MASK) == 0)
+                {
+                        if (((current_ >> SLOT_SHIFT) & SLOT_MASK) == 0)
+                        {
+                                relink(SLOT_LENGTH * 2 + static_cast<int>((current_ >> (SLOT_SHIFT * 2)) & SLOT_MASK));
+                        }
+                        relink(SLOT_LENGTH + static_cast<int>((current_ >> SLOT_SHIFT) & SLOT_MASK));
+                }
+                relink(static_cast<int>(current_ & SLOT_MASK));
+        }
+
+        int *next_;
+        int *previous_;
+        int *slot_;
+        time_t *expire_;
+        int head_[HEAD_LENGTH];
+        time_t current_;
+        int length_;
+        int count_;
+};
+}
+
+#endif  // SKK_TIMER_WHEEL_H
@@ -20,6 +20,7 @@
 
 #include "skk_architecture.hpp"
 #include "skk_utility_architecture.hpp"
+#include "skk_utility_scan.hpp"
 #include "skk_simple_string.hpp"
 
 namespace YaSkkServ
@@ -211,13 +212,10 @@ inline int getNextLineIndex(const char *p, int index, int size)
 {
         DEBUG_ASSERT_POINTER(p);
         DEBUG_ASSERT(size > 0);
-        while (*(p + index) != '\n')
+        index = findCharacter(p, index, size, '\n');
+        if (index < 0)
         {
-                ++index;
-                if (index >= size)
-                {
-                        return -1;
-                }
+                return -1;
         }
         ++index;
         if (index >= size)
@@ -232,26 +230,20 @@ inline int getPreviousLineIndex(const char *p, int index, int size)
 {
         DEBUG_ASSERT_POINTER(p);
         DEBUG_ASSERT(size > 0);
-        while (*(p + index) != '\n')
+        index = findCharacterReverse(p, 1, index, '\n');
+        if (index < 0)
         {
-                --index;
-                if (index <= 0)
-                {
-                        return 0;
-                }
+                return 0;
         }
         --index;
         if (index <= 0)
         {
                 return 0;
         }
-        while (*(p + index) != '\n')
+        index = findCharacterReverse(p, 1, index, '\n');
+        if (index < 0)
         {
-                --index;
-                if (index <= 0)
-                {
-                        return 0;
-                }
+                return 0;
         }
         ++index;
         if (index >= size)
@@ -274,13 +266,10 @@ inline int getBeginningOfLineIndex(const char *p, int index, int size)
                         return 0;
                 }
         }
-        while (*(p + index) != '\n')
+        index = findCharacterReverse(p, 1, index, '\n');
+        if (index < 0)
         {
-                --index;
-                if (index <= 0)
-                {
-                        return 0;
-                }
+                return 0;
         }
         ++index;
         if (index >= size)
@@ -335,20 +324,13 @@ inline int copyHenkanmojiretsu(const char *p, int index, int size, char *destina
         DEBUG_ASSERT(size > 0);
         DEBUG_ASSERT(destination_size > 0);
         const int margin = 8;
-        for (;;)
+        index = findCharacter(p, index, size, ' ');
+        if (index < 0)
         {
-                if (index >= size)
-                {
-                        DEBUG_ASSERT(0);
-                        return 0;
-                }
-                if (*(p + index) == ' ')
-                {
-                        ++index;
-                        break;
-                }
-                ++index;
+                DEBUG_ASSERT(0);
+                return 0;
         }
+        ++index;
         for (int i = 0; i < destination_size - margin; ++i)
         {
                 if  (index + i >= size)
@@ -370,20 +352,13 @@ inline int copyHenkanmojiretsu(const char *p, int index, int size, char *destina
 /// index Ƭ֤ˤȤơѴʸפΥݥ󥿤֤ޤ
 inline const char *getHenkanmojiretsuPointer(const char *p, int index, int size)
 {
-        for (;;)
+        index = findCharacter(p, index, size, ' ');
+        if (index < 0)
         {
-                if (index >= size)
-                {
-                        DEBUG_ASSERT(0);
-                        return 0;
-                }
-                if (*(p + index) == ' ')
-                {
-                        ++index;
-                        break;
-                }
-                ++index;
+                DEBUG_ASSERT(0);
+                return 0;
         }
+        ++index;
         return p + index;
 }
 
@@ -403,8 +378,8 @@ inline int getCandidateLength(const char *henkanmojiretsu)
 // /entry0/entry1/entry2/
         for (;;)
         {
-                char c = *henkanmojiretsu++;
-                if ((c == '\n') || (c == '\0'))
+                henkanmojiretsu = findSlashOrTerminator(henkanmojiretsu);
+                if (*henkanmojiretsu != '/')
                 {
                         if (entries > 0)
                         {
@@ -412,10 +387,8 @@ inline int getCandidateLength(const char *henkanmojiretsu)
                         }
                         break;
                 }
-                if (c == '/')
-                {
-                        ++entries;
-                }
+                ++entries;
+                ++henkanmojiretsu;
         }
         return entries;
 }
@@ -430,51 +403,52 @@ inline bool getCandidateInformation(const char *henkanmojiretsu, int index, cons
         DEBUG_ASSERT(*(henkanmojiretsu + 0) == '/');
         DEBUG_ASSERT(index >= 0);
         int count = 0;
-        char c;
         for (;;)
         {
-                c = *henkanmojiretsu++;
-                if ((c == '\n') || (c == '\0'))
+                henkanmojiretsu = findSlashOrTerminator(henkanmojiretsu);
+                if (*henkanmojiretsu != '/')
                 {
                         return false;
                 }
-                if (c == '/')
+                ++henkanmojiretsu;
+                if (count == index)
                 {
-                        if (count == index)
+                        if ((*henkanmojiretsu == '\n') || (*henkanmojiretsu == '\0'))
                         {
-                                if ((*henkanmojiretsu == '\n') || (*henkanmojiretsu == '\0'))
-                                {
-                                        DEBUG_ASSERT(0);
-                                        return false;
-                                }
-                                else
-                                {
-                                        const char *tmp = henkanmojiretsu;
-                                        int tmp_size = 0;
-                                        for (;;)
-                                        {
-                                                c = *henkanmojiretsu++;
-                                                if ((c == '\n') || (c == '\0'))
-                                                {
-                                                        DEBUG_ASSERT(0);
-                                                        return false;
-                                                }
-                                                if (c == '/')
-                                                {
-                                                        start = tmp;
-                                                        size = tmp_size;
-                                                        return true;
-                                                }
-                                                ++tmp_size;
-                                        }
-                                }
+                                DEBUG_ASSERT(0);
+                                return false;
+                        }
+                        const char *tmp = henkanmojiretsu;
+                        henkanmojiretsu = findSlashOrTerminator(henkanmojiretsu);
+                        if (*henkanmojiretsu != '/')
+                        {
+                                DEBUG_ASSERT(0);
+                                return false;
                         }
-                        ++count;
+                        start = tmp;
+                        size = static_cast<int>(henkanmojiretsu - tmp);
+                        return true;
                 }
+                ++count;
         }
         return false;           // NOTREACHED
 }
 
+/// ָФʸ p νü (' ' ޤ '\0') ޤǤΥХȥ֤ޤХȥ˽üɤޤߤޤ
+/**
+ * compareMidasi()  compare_size ˻Ȥޤ
+ */
+inline int getTerminatedMidasiSize(const char *p)
+{
+        DEBUG_ASSERT_POINTER(p);
+        int i = 0;
+        while ((*(p + i) != ' ') && (*(p + i) != '\0'))
+        {
+                ++i;
+        }
+        return i + 1;
+}
+
 /// ָФʸ p + index ʸ compare Ӥޤ strncmp(3) Ʊ֤ͤͤޤ
 /**
  * ָФʸ p + index Ȼʸ compare ϡ֤Ҥ餬ʥ󥳡
@@ -482,15 +456,21 @@ inline bool getCandidateInformation(const char *henkanmojiretsu, int index, cons
  *
  * üɤȤ ' ' ޤ '\0' ǧޤ
  *
+ * p  size ХȤޤǡ compare  compare_size ХȤޤɤ
+ * ΤȤޤ 8 Хñ̤ӤϤϰϤ˼ޤԤΤǡ
+ * ϰϤγɤߤޤ compare  compare_size ХȰǽü
+ * Ƥɬפޤ
+ *
  * ͤ strncmp(3) Ʊ͡ʤ p + index  compare ٤ơ
  *  -1 ʲ 0 礭 1 ʾ
  * ֤ޤ
  */
-inline int compareMidasi(const char *p, int index, int size, const char *compare)
+inline int compareMidasi(const char *p, int index, int size, const char *compare, int compare_size)
 {
         DEBUG_ASSERT_POINTER(p);
         DEBUG_ASSERT(size > 0);
         DEBUG_ASSERT_POINTER(compare);
+        DEBUG_ASSERT(compare_size > 0);
         if (index < 0)
         {
                 return -1;
@@ -502,7 +482,21 @@ inline int compareMidasi(const char *p, int index, int size, const char *compare
         if (((*(p + index) != '\1') && (*compare != '\1')) ||
             ((*(p + index) == '\1') && (*compare == '\1')))
         {
-                for (int i = 0; ; ++i)
+// ޤ 8 Хñ̤ӤۤޤϽüɤޤ 8 ХȤ
+// դäȤ 1 Хñ̤Ӥޤ
+                int i = 0;
+                while ((index + i + 8 <= size) && (i + 8 <= compare_size))
+                {
+                        uint64_t word = loadWord(p + index + i);
+                        if ((word != loadWord(compare + i)) ||
+                            hasZeroByte(word) ||
+                            hasZeroByte(word ^ 0x2020202020202020ULL))
+                        {
+                                break;
+                        }
+                        i += 8;
+                }
+                for (; ; ++i)
                 {
                         if ((index + i) >= size)
                         {
@@ -620,6 +614,101 @@ inline int compareMidasi(const char *p, int index, int size, const char *compare
         return -1;      // NOTREACHED
 }
 
+/// ֤Ҥ餬ʥ󥳡ɡפ줿ָФʸ p Ƭ 8 ХȤӥåǥȤ֤ޤ
+/**
+ * compareMidasi() Ʊˤʤ褦 '\\1' ǻϤޤʸ '\\1'
+ * ΡʳʸϳʸȽü 0xa4 
+ * ΤȤưޤ 8 ХȤʤʬ 0 ޤ
+ *
+ * 2 ĤΡָФפͤۤʤС羮 compareMidasi() η
+ * ̤Ȱפޤ compareMidasi() Ӥɬפ
+ * 
+ */
+inline uint64_t getMidasiPrefix(const char *p)
+{
+        DEBUG_ASSERT_POINTER(p);
+        uint64_t result = 0;
+        int length = 0;
+        if (*p == '\1')
+        {
+                ++p;
+                while (length < 8)
+                {
+                        int c = *(reinterpret_cast<const unsigned char*>(p++));
+                        if ((c == ' ') || (c == '\0'))
+                        {
+                                break;
+                        }
+                        result = (result << 8) | static_cast<uint64_t>(c);
+                        ++length;
+                }
+        }
+        else
+        {
+                while (length < 8)
+                {
+                        result = (result << 8) | 0xa4;
+                        ++length;
+                        int c = *(reinterpret_cast<const unsigned char*>(p++));
+                        if ((c == ' ') || (c == '\0') || (length == 8))
+                        {
+                                break;
+                        }
+                        result = (result << 8) | static_cast<uint64_t>(c);
+                        ++length;
+                }
+        }
+        for (; length < 8; ++length)
+        {
+                result <<= 8;
+        }
+        return result;
+}
+
+/// ֤Ҥ餬ʥ󥳡ɡפ줿ָФʸ p  64 ӥåȥϥå֤ͤޤ
+/**
+ * getMidasiPrefix() Ʊͤ '\\1' ǻϤޤʸȡʳʸ
+ *  compareMidasi() Ʊǰᡢ compareMidasi() ָ
+ * ФפƱϥåͤˤʤޤ
+ */
+inline uint64_t getMidasiHash(const char *p)
+{
+        DEBUG_ASSERT_POINTER(p);
+// FNV-1a θ塢̥ӥåȤ򲼰̥ӥåȤسȻޤ
+        uint64_t result = 0xcbf29ce484222325ULL;
+        const uint64_t prime = 0x100000001b3ULL;
+        if (*p == '\1')
+        {
+                ++p;
+                for (;;)
+                {
+                        int c = *(reinterpret_cast<const unsigned char*>(p++));
+                        if ((c == ' ') || (c == '\0'))
+                        {
+                                break;
+                        }
+                        result = (result ^ static_cast<uint64_t>(c)) * prime;
+                }
+        }
+        else
+        {
+                for (;;)
+                {
+                        result = (result ^ 0xa4) * prime;
+                        int c = *(reinterpret_cast<const unsigned char*>(p++));
+                        if ((c == ' ') || (c == '\0'))
+                        {
+                                break;
+                        }
+                        result = (result ^ static_cast<uint64_t>(c)) * prime;
+                }
+        }
+        result ^= result >> 33;
+        result *= 0xff51afd7ed558ccdULL;
+        result ^= result >> 33;
+        return result;
+}
+
 /// ָФʸ (p + index) ΥХȥ֤ޤüʸȤ ' ' ǧޤХȥ˽üʸϴޤޤޤ󡣼˼Ԥ 0 ֤ޤ
 /**
  * ˼Ԥ DEBUG_ASSERT ͭʤХȤޤ
@@ -629,19 +718,13 @@ inline int getMidasiSize(const char *p, int index, int size)
         DEBUG_ASSERT_POINTER(p);
         DEBUG_ASSERT(index >= 0);
         DEBUG_ASSERT(size > 0);
-        for (int midasi_size = 0;; ++midasi_size, ++index)
+        int end = findCharacter(p, index, size, ' ');
+        if (end < 0)
         {
-                if (index >= size)
-                {
-                        DEBUG_ASSERT(0);
-                        return 0;
-                }
-                if (*(p + index) == ' ')
-                {
-                        return midasi_size;
-                }
+                DEBUG_ASSERT(0);
+                return 0;
         }
-        return 0;       // NOTREACHED
+        return end - index;
 }
 
 /// index Ƭ֤ˤȤơѴʸΥХȥ֤ޤХȥ˲ʸϴޤߤޤ
@@ -650,36 +733,20 @@ inline int getHenkanmojiretsuSize(const char *p, int index, int size)
         DEBUG_ASSERT_POINTER(p);
         DEBUG_ASSERT(index >= 0);
         DEBUG_ASSERT(size > 0);
-        for (;;)
+        index = findCharacter(p, index, size, ' ');
+        if (index < 0)
         {
-                if (index >= size)
-                {
-                        DEBUG_ASSERT(0);
-                        return 0;
-                }
-                if (*(p + index) == ' ')
-                {
-                        ++index;
-                        break;
-                }
-                ++index;
+                DEBUG_ASSERT(0);
+                return 0;
         }
-        int result = 0;
-        for (;;)
+        ++index;
+        int end = findCharacter(p, index, size, '\n');
+        if (end < 0)
         {
-                if (index >= size)
-                {
-                        DEBUG_ASSERT(0);
-                        return 0;
-                }
-                if (*(p + index) == '\n')
-                {
-                        return result;
-                }
-                ++result;
-                ++index;
+                DEBUG_ASSERT(0);
+                return 0;
         }
-        return 0;       // NOTREACHED
+        return end - index;
 }
 
 /// index Ƭ֤ˤȤơ 1 ԤΥХȥ֤ޤХȥ˲ʸϴޤߤޤ
@@ -688,22 +755,13 @@ inline int getLineSize(const char *p, int index, int size)
         DEBUG_ASSERT_POINTER(p);
         DEBUG_ASSERT(index >= 0);
         DEBUG_ASSERT(size > 0);
-        int result = 0;
-        for (;;)
+        int end = findCharacter(p, index, size, '\n');
+        if (end < 0)
         {
-                if (index >= size)
-                {
-                        DEBUG_ASSERT(0);
-                        return 0;
-                }
-                if (*(p + index) == '\n')
-                {
-                        return result;
-                }
-                ++result;
-                ++index;
+                DEBUG_ASSERT(0);
+                return 0;
         }
-        return 0;       // NOTREACHED
+        return end - index;
 }
 
 /// 1 ʸܤбեåɥ쥤ǥå֤ޤ
@@ -768,19 +826,25 @@ inline bool searchBinary(const char *p, int size, const char *search, int &resul
         DEBUG_ASSERT_POINTER(p);
         DEBUG_ASSERT_POINTER(search);
         DEBUG_ASSERT(size > 0);
+        const int search_size = getTerminatedMidasiSize(search);
         int index = getNextLineIndex(p, size / 2, size);
+        if (index < 0)
+        {
+// ǽԤˤûХåեǤƬõޤ
+                index = 0;
+        }
         int before_index = index;
         int diff = index / 2;
         for (;;)
         {
-                int tmp = compareMidasi(p, index, size, search);
+                int tmp = compareMidasi(p, index, size, search, search_size);
                 if (tmp < 0)
                 {
                         index += diff;
                         if (index >= size)
                         {
-// index ǽԤƬ˰ưޤ
-                                result_index = getBeginningOfLineIndex(p, size, size);
+// index ǽԤƬ˰ưޤ p + size - 1 ϺǽԤβԤǤ
+                                result_index = getBeginningOfLineIndex(p, size - 1, size);
                                 return false;
                         }
                 }
@@ -816,16 +880,60 @@ inline bool searchBinary(const char *p, int size, const char *search, int &resul
         return false;   // NOTREACHED
 }
 
+/// ñ̤ΥХʥꥵ search õޤդп֤ޤ result_index ˤϸդǥåդʤä search ʾȤʤǽιԤΥǥå (ʤ size) ֤ޤ
+/**
+ * searchBinary() Ȱۤʤꡢդʤõ䤦ɬפϤ
+ * ޤ
+ */
+inline bool searchLowerBound(const char *p, int size, const char *search, int &result_index)
+{
+        DEBUG_ASSERT_POINTER(p);
+        DEBUG_ASSERT_POINTER(search);
+        DEBUG_ASSERT(size > 0);
+        const int search_size = getTerminatedMidasiSize(search);
+        int low = 0;
+        int high = size;
+        while (low < high)
+        {
+                int index = getBeginningOfLineIndex(p, low + (high - low) / 2, size);
+                if (index < low)
+                {
+                        index = low;
+                }
+                int tmp = compareMidasi(p, index, size, search, search_size);
+                if (tmp == 0)
+                {
+                        result_index = index;
+                        return true;
+                }
+                if (tmp < 0)
+                {
+                        low = getNextLineIndex(p, index, size);
+                        if (low < 0)
+                        {
+                                low = size;
+                        }
+                }
+                else
+                {
+                        high = index;
+                }
+        }
+        result_index = low;
+        return false;
+}
+
 /// õ search õޤդп֤ޤ result_index ˤϸդǥå֤ޤդʤ result_index Ǥ
 inline bool searchLinear(const char *p, int size, const char *search, int &result_index)
 {
         DEBUG_ASSERT_POINTER(p);
         DEBUG_ASSERT_POINTER(search);
         DEBUG_ASSERT(size > 0);
+        const int search_size = getTerminatedMidasiSize(search);
         int direction = 0;
         for (;;)
         {
-                int tmp = compareMidasi(p, result_index, size, search);
+                int tmp = compareMidasi(p, result_index, size, search, search_size);
                 if (tmp == 0)
                 {
                         return true;
@@ -892,10 +1000,7 @@ inline int getStringLength(const void * const string)
 template<char c> const char *getNextPointer(const char *p)
 {
         DEBUG_ASSERT_POINTER(p);
-        while (*p++ != c)
-        {
-        }
-        return p;
+        return findCharacterUnbounded(p, c) + 1;
 }
 
 inline bool getInteger(const void *p, int &result)
@@ -912,6 +1017,26 @@ inline bool getInteger(const void *p, int &result)
         return true;
 }
 
+/// 8 ʿʸ result ֤ޤ 0  7 ʳʸޤϵ֤ޤ
+inline bool getOctalInteger(const void *p, int &result)
+{
+        const char *string = static_cast<const char*>(p);
+        if ((*string == '\0') || (strlen(string) > 8))
+        {
+                return false;
+        }
+        result = 0;
+        for (; *string != '\0'; ++string)
+        {
+                if ((*string < '0') || (*string > '7'))
+                {
+                        return false;
+                }
+                result = result * 8 + (*string - '0');
+        }
+        return true;
+}
+
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wfloat-equal"
 inline bool getFloat(const void *p, float &result)
@@ -954,7 +1079,7 @@ inline void sortMidasi(const char *buffer, int buffer_size, SortKey *p, int leng
                         int j;
                         j = i;
                         while ((j >= h) &&
-                               (compareMidasi(buffer, (p + (j - h))->index, buffer_size, buffer + (p + j)->index) > 0))
+                               (compareMidasi(buffer, (p + (j - h))->index, buffer_size, buffer + (p + j)->index, buffer_size - (p + j)->index) > 0))
                         {
                                 tmp = *(p + j);
                                 *(p + j) = *(p + j - h);
@@ -0,0 +1,1088 @@
+/*
+  Copyright (C) 2005-2021 Tadashi Watanabe <twacc2020@gmail.com>
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "skk_architecture.hpp"
+#include "skk_mmap.hpp"
+#include "skk_jisyo.hpp"
+#include "skk_dictionary.hpp"
+#include "skk_dictionary_reloader.hpp"
+#include "skk_utility.hpp"
+#include "skk_command_line.hpp"
+#include "skk_shared_ring.hpp"
+
+namespace YaSkkServ
+{
+namespace
+{
+double get_time()
+{
+        struct timeval tv;
+        gettimeofday(&tv, 0);
+        return static_cast<double>(tv.tv_sec) + static_cast<double>(tv.tv_usec) / (1000.0 * 1000.0);
+}
+
+/// ñĴäʥä֤ޤ
+int64_t get_time_nanosecond()
+{
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<int64_t>(ts.tv_sec) * 1000 * 1000 * 1000 + static_cast<int64_t>(ts.tv_nsec);
+}
+
+/// SKK ΡָФפ key ء 1 ʸܤ completion_key سǼޤɤ⥹ڡǽüޤ
+/**
+ * key  completion_key ϸФȤ˥եåȤ֤ƤӽФ¦
+ * delete[] ɬפޤ
+ */
+bool get_key(const char *buffer,
+             int filesize,
+             const char *&key,
+             int *&key_offset,
+             char *&completion_key,
+             int *&completion_key_offset,
+             int &key_length)
+{
+        key_length = 0;
+        for (int index = 0; index >= 0; index = SkkUtility::getNextLineIndex(buffer, index, filesize))
+        {
+                if ((*(buffer + index) != ';') && (*(buffer + index) != '\n'))
+                {
+                        ++key_length;
+                }
+        }
+        if (key_length == 0)
+        {
+                return false;
+        }
+
+        key = buffer;
+        key_offset = new int[key_length];
+        completion_key = new char[key_length * 3];
+        completion_key_offset = new int[key_length];
+        int i = 0;
+        for (int index = 0; index >= 0; index = SkkUtility::getNextLineIndex(buffer, index, filesize))
+        {
+                if ((*(buffer + index) != ';') && (*(buffer + index) != '\n'))
+                {
+                        const int c = *(buffer + index) & 0xff;
+                        const int size = ((c & 0x80) && (index + 1 < filesize)) ? 2 : 1;
+                        *(key_offset + i) = index;
+                        *(completion_key_offset + i) = i * 3;
+                        for (int n = 0; n != size; ++n)
+                        {
+                                *(completion_key + i * 3 + n) = *(buffer + index + n);
+                        }
+                        *(completion_key + i * 3 + size) = ' ';
+                        ++i;
+                }
+        }
+        return true;
+}
+
+/// ߤΥȥΡָФפ prefix ǻϤޤп֤ޤ
+bool is_start_with(SkkDictionary &dictionary, const char *prefix)
+{
+        char decode_buffer[SkkUtility::MIDASI_DECODE_HIRAGANA_BUFFER_SIZE];
+        const char *p = dictionary.getMidasiPointer();
+        int size = SkkUtility::decodeHiragana(p, decode_buffer, sizeof(decode_buffer));
+        if (size == 0)
+        {
+                const int raw_code = 1; // \1 ʬ
+                p += raw_code;
+                size = dictionary.getMidasiSize() - raw_code;
+        }
+        else
+        {
+                p = decode_buffer;
+        }
+        for (int i = 0; *(prefix + i) != ' '; ++i)
+        {
+                if ((i >= size) || (*(p + i) != *(prefix + i)))
+                {
+                        return false;
+                }
+        }
+        return true;
+}
+
+void benchmark(const char *filename,
+               const char *key,
+               const int *key_offset,
+               const char *completion_key,
+               const int *completion_key_offset,
+               int key_length,
+               int loop,
+               int completion_length)
+{
+        struct stat stat_buffer;
+        if (stat(filename, &stat_buffer) == -1)
+        {
+                SkkUtility::printf("%s: stat() failed\n", filename);
+                return;
+        }
+        SkkDictionary dictionary;
+        if (!dictionary.open(filename))
+        {
+                SkkUtility::printf("%s: open failed\n", filename);
+                return;
+        }
+
+        int found = 0;
+        double time_start = get_time();
+        for (int n = 0; n != loop; ++n)
+        {
+                for (int i = 0; i != key_length; ++i)
+                {
+                        if (dictionary.search(key + *(key_offset + i)))
+                        {
+                                ++found;
+                        }
+                }
+        }
+        double search_time = get_time() - time_start;
+
+// 䴰 (ץȥ "4") Ʊͤˡդʤ 1 ʸܤ
+// éꡢ prefix ǻϤޤ륨ȥ completion_length Ĥޤǿޤ
+        int entry = 0;
+        time_start = get_time();
+        for (int n = 0; n != loop; ++n)
+        {
+                for (int i = 0; i != key_length; ++i)
+                {
+                        const char *prefix = completion_key + *(completion_key_offset + i);
+                        if (dictionary.search(prefix) || dictionary.searchForFirstCharacter(prefix))
+                        {
+                                bool found_flag = false;
+                                int counter = 0;
+                                do
+                                {
+                                        if (is_start_with(dictionary, prefix))
+                                        {
+                                                found_flag = true;
+                                                ++entry;
+                                                if (++counter >= completion_length)
+                                                {
+                                                        break;
+                                                }
+                                        }
+                                        else if (found_flag)
+                                        {
+                                                break;
+                                        }
+                                }
+                                while (dictionary.searchNextEntry());
+                        }
+                }
+        }
+        double completion_time = get_time() - time_start;
+
+        const double count = static_cast<double>(key_length) * static_cast<double>(loop);
+        SkkUtility::printf("%s\n"
+                           "    file size   %10d bytes\n"
+                           "    search      %10.1f ns/key  (found %d/%d)\n"
+                           "    completion  %10.1f ns/key  (%d entries)\n",
+                           filename,
+                           static_cast<int>(stat_buffer.st_size),
+                           search_time * 1000.0 * 1000.0 * 1000.0 / count,
+                           found / loop,
+                           key_length,
+                           completion_time * 1000.0 * 1000.0 * 1000.0 / count,
+                           entry / loop);
+}
+
+/// size ХȤ p Υϥå (FNV-1a)  hash ˲ä֤ޤ
+uint32_t add_hash(uint32_t hash, const char *p, int size)
+{
+        for (int i = 0; i != size; ++i)
+        {
+                hash ^= static_cast<uint32_t>(*(p + i) & 0xff);
+                hash *= 16777619;
+        }
+        return hash;
+}
+
+/// dictionary  key õѴʸפȼΥȥΡָФפΥϥå֤ޤդʤ 0 ֤ޤ
+uint32_t search_hash(SkkDictionary &dictionary, const char *key)
+{
+        if (!dictionary.search(key))
+        {
+                return 0;
+        }
+        uint32_t hash = add_hash(2166136261U, dictionary.getHenkanmojiretsuPointer(), dictionary.getHenkanmojiretsuSize());
+        if (dictionary.searchNextEntry())
+        {
+                hash = add_hash(hash, dictionary.getMidasiPointer(), dictionary.getMidasiSize());
+        }
+// դä 0 ֤ʤ褦ˤޤ
+        return hash | 1;
+}
+
+#ifdef YASKKSERV_CONFIG_HAVE_PTHREAD
+struct SearchThreadArgument
+{
+        SkkDictionary *dictionary;
+        const char *key;
+        const int *key_offset;
+        const uint32_t *expect;
+        int key_length;
+        int loop;
+        int start;
+        int mismatch;
+};
+
+void *search_thread(void *p)
+{
+        SearchThreadArgument *argument = static_cast<SearchThreadArgument*>(p);
+        for (int n = 0; n != argument->loop; ++n)
+        {
+                for (int i = 0; i != argument->key_length; ++i)
+                {
+                        const int index = (argument->start + i) % argument->key_length;
+                        if (search_hash(*argument->dictionary, argument->key + *(argument->key_offset + index)) != *(argument->expect + index))
+                        {
+                                ++argument->mismatch;
+                        }
+                }
+        }
+        return 0;
+}
+#endif  // YASKKSERV_CONFIG_HAVE_PTHREAD
+
+/// 1 ٤ thread_length ĤΥåɤǶͭõ 1 åɤõ̤Ⱦȹ礷ޤ㤤ʤп֤ޤ
+/**
+ * ƥåɤ SkkDictionary::share() Ʊ᡼ͭ륪֥
+ * Ȥ̡ΰ֤ƤΡָФפ loop õޤ
+ * Ѵʸפ˲ä searchNextEntry() ǼΥȥȹ礹
+ * ǡ֥åɤ߹ߥХåեȰ֤åɴ֤Ǻп㤤
+ * Ȥƿޤ
+ */
+bool benchmark_thread(const char *filename,
+                      const char *key,
+                      const int *key_offset,
+                      int key_length,
+                      int loop,
+                      int thread_length)
+{
+#ifdef YASKKSERV_CONFIG_HAVE_PTHREAD
+        SkkDictionary *dictionary = new SkkDictionary[thread_length];
+        if (!dictionary->open(filename))
+        {
+                SkkUtility::printf("%s: open failed\n", filename);
+                delete[] dictionary;
+                return false;
+        }
+        uint32_t *expect = new uint32_t[key_length];
+        for (int i = 0; i != key_length; ++i)
+        {
+                *(expect + i) = search_hash(*dictionary, key + *(key_offset + i));
+        }
+
+        SearchThreadArgument *argument = new SearchThreadArgument[thread_length];
+        pthread_t *thread = new pthread_t[thread_length];
+        bool *create_flag = new bool[thread_length];
+        bool result = true;
+        const double time_start = get_time();
+        for (int i = 0; i != thread_length; ++i)
+        {
+                if ((i != 0) && !(dictionary + i)->share(*dictionary))
+                {
+                        result = false;
+                }
+                (argument + i)->dictionary = dictionary + i;
+                (argument + i)->key = key;
+                (argument + i)->key_offset = key_offset;
+                (argument + i)->expect = expect;
+                (argument + i)->key_length = key_length;
+                (argument + i)->loop = loop;
+                (argument + i)->start = static_cast<int>(static_cast<int64_t>(key_length) * i / thread_length);
+                (argument + i)->mismatch = 0;
+                *(create_flag + i) = result && (pthread_create(thread + i, 0, search_thread, argument + i) == 0);
+                if (!*(create_flag + i))
+                {
+                        result = false;
+                }
+        }
+        int mismatch = 0;
+        for (int i = 0; i != thread_length; ++i)
+        {
+                if (*(create_flag + i))
+                {
+                        pthread_join(*(thread + i), 0);
+                        mismatch += (argument + i)->mismatch;
+                }
+        }
+        const double search_time = get_time() - time_start;
+
+        if (result)
+        {
+                const double count = static_cast<double>(key_length) * static_cast<double>(loop) * static_cast<double>(thread_length);
+                SkkUtility::printf("%s\n"
+                                   "    thread      %10d\n"
+                                   "    search      %10.1f keys/s  (%d keys x %d loop x %d thread)\n"
+                                   "    mismatch    %10d\n",
+                                   filename,
+                                   thread_length,
+                                   count / search_time,
+                                   key_length,
+                                   loop,
+                                   thread_length,
+                                   mismatch);
+        }
+        else
+        {
+                SkkUtility::printf("%s: thread create failed\n", filename);
+        }
+        delete[] create_flag;
+        delete[] thread;
+        delete[] argument;
+        delete[] expect;
+        delete[] dictionary;
+        return result && (mismatch == 0);
+#else  // YASKKSERV_CONFIG_HAVE_PTHREAD
+        (void)key;
+        (void)key_offset;
+        (void)key_length;
+        (void)loop;
+        (void)thread_length;
+        SkkUtility::printf("%s: thread not supported\n", filename);
+        return false;
+#endif  // YASKKSERV_CONFIG_HAVE_PTHREAD
+}
+
+/// latency 򾺽¤ؤޤ
+void sort_latency(int64_t *latency, int length)
+{
+// ҡץȤǤ
+        for (int i = length / 2 - 1; i >= 0; --i)
+        {
+                for (int parent = i;;)
+                {
+                        int child = parent * 2 + 1;
+                        if (child >= length)
+                        {
+                                break;
+                        }
+                        if ((child + 1 < length) && (*(latency + child) < *(latency + child + 1)))
+                        {
+                                ++child;
+                        }
+                        if (*(latency + parent) >= *(latency + child))
+                        {
+                                break;
+                        }
+                        const int64_t tmp = *(latency + parent);
+                        *(latency + parent) = *(latency + child);
+                        *(latency + child) = tmp;
+                        parent = child;
+                }
+        }
+        for (int last = length - 1; last > 0; --last)
+        {
+                const int64_t top = *(latency + 0);
+                *(latency + 0) = *(latency + last);
+                *(latency + last) = top;
+                for (int parent = 0;;)
+                {
+                        int child = parent * 2 + 1;
+                        if (child >= last)
+                        {
+                                break;
+                        }
+                        if ((child + 1 < last) && (*(latency + child) < *(latency + child + 1)))
+                        {
+                                ++child;
+                        }
+                        if (*(latency + parent) >= *(latency + child))
+                        {
+                                break;
+                        }
+                        const int64_t tmp = *(latency + parent);
+                        *(latency + parent) = *(latency + child);
+                        *(latency + child) = tmp;
+                        parent = child;
+                }
+        }
+}
+
+/// õ 1 󤴤Ȥλ֤¬ꡢδ֤˼ reload 󳫤ľȤʬۤɽޤ
+/**
+ * ľϡФĤƹԤäƤõι֤ close()  open()
+ * (sync) ȡ SkkDictionaryReloader ˤХå饦ɤǤγľ
+ * Ⱥؤ (background)  2 ̤Ǥľʤ (none) 
+ * ӤΤɽޤ
+ */
+void benchmark_reload(const char *filename,
+                      const char *key,
+                      const int *key_offset,
+                      int key_length,
+                      int loop,
+                      int reload)
+{
+        enum Mode
+        {
+                MODE_NONE,
+                MODE_SYNC,
+                MODE_BACKGROUND,
+
+                MODE_LENGTH
+        };
+        const char * const mode_name_table[MODE_LENGTH] =
+        {
+                "none",
+                "sync",
+                "background",
+        };
+        const char * const filename_table[1] =
+        {
+                filename,
+        };
+        const int length = key_length * loop;
+        const int interval = (length / (reload + 1) > 0) ? length / (reload + 1) : 1;
+        int64_t *latency = new int64_t[length];
+        SkkUtility::printf("%s\n", filename);
+        for (int mode = 0; mode != MODE_LENGTH; ++mode)
+        {
+                SkkDictionary dictionary;
+                if (!dictionary.open(filename))
+                {
+                        SkkUtility::printf("%s: open failed\n", filename);
+                        break;
+                }
+                SkkDictionaryReloader reloader;
+                if ((mode == MODE_BACKGROUND) && !reloader.initialize(1))
+                {
+                        SkkUtility::printf("%s: reloader initialize failed\n", filename);
+                        break;
+                }
+                int reload_counter = 0;
+                int swap_counter = 0;
+                for (int i = 0; i != length; ++i)
+                {
+                        const int64_t time_start = get_time_nanosecond();
+// ľϼõα֤˴ޤޤ
+                        if ((i != 0) && (i % interval == 0) && (reload_counter < reload))
+                        {
+                                ++reload_counter;
+                                if (mode == MODE_SYNC)
+                                {
+                                        dictionary.close();
+                                        dictionary.open(filename);
+                                        ++swap_counter;
+                                }
+                                else if (mode == MODE_BACKGROUND)
+                                {
+                                        reloader.request(0);
+                                }
+                        }
+                        if (reloader.isRunning())
+                        {
+                                if (reloader.isFinished())
+                                {
+                                        reloader.finish(&dictionary);
+                                        if (reloader.getResult(0) == SkkDictionaryReloader::RESULT_SWAPPED)
+                                        {
+                                                ++swap_counter;
+                                        }
+                                }
+                        }
+                        else if (mode == MODE_BACKGROUND)
+                        {
+// ľ褿׵ϡľ򽪤ƤϤޤ
+                                reloader.start(filename_table);
+                        }
+                        dictionary.search(key + *(key_offset + i % key_length));
+                        *(latency + i) = get_time_nanosecond() - time_start;
+                }
+                while (reloader.isRunning() || reloader.start(filename_table))
+                {
+                        reloader.finish(&dictionary);
+                        if (reloader.getResult(0) == SkkDictionaryReloader::RESULT_SWAPPED)
+                        {
+                                ++swap_counter;
+                        }
+                }
+                sort_latency(latency, length);
+                SkkUtility::printf("    %-10s  p50 %10.3f us  p99 %10.3f us  max %10.3f us  (reload %d)\n",
+                                   mode_name_table[mode],
+                                   static_cast<double>(*(latency + length / 2)) / 1000.0,
+                                   static_cast<double>(*(latency + length - 1 - length / 100)) / 1000.0,
+                                   static_cast<double>(*(latency + length - 1)) / 1000.0,
+                                   swap_counter);
+        }
+        delete[] latency;
+}
+
+/// key ΡָФפ "1" դ׵ request ˺ä send() ޤ
+bool send_request(int file_descriptor, const char *key, char *request)
+{
+        int size = 0;
+        *(request + size) = '1';
+        ++size;
+        for (int i = 0; size != 1 + 512; ++i)
+        {
+                *(request + size) = *(key + i);
+                ++size;
+                if (*(key + i) == ' ')
+                {
+                        break;
+                }
+        }
+        return send(file_descriptor, request, static_cast<size_t>(size), 0) == static_cast<ssize_t>(size);
+}
+
+/// 127.0.0.1  port ưƤ륵Ф connection ܤ³ "1" ꡢ֤ʬۤ 1 ä׵ɽޤ
+/**
+ * unix_socket  0 Ǥʤ port  unix_socket Υѥ³
+ * ޤ
+ *
+ * ³ϱäƤ鼡׵ޤƱꤷ
+ * Ф --io-uring ̵ͭǵưľƼ¹ԤС select() 
+ * io_uring ٤ޤ
+ */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wold-style-cast"
+bool benchmark_server(int port,
+                      const char *unix_socket,
+                      int connection,
+                      const char *key,
+                      const int *key_offset,
+                      int key_length,
+                      int loop)
+{
+        bool result = true;
+        const int length = key_length * loop;
+        int *file_descriptor = new int[connection];
+        int64_t *send_time = new int64_t[connection];
+        int64_t *latency = new int64_t[length];
+        char request[1 + 512];
+        char name[128];
+        const int reply_size = 64 * 1024;
+        char *reply = new char[reply_size];
+        int file_descriptor_maximum = 0;
+        int sent = 0;
+        int received = 0;
+        int64_t time_start;
+        for (int i = 0; i != connection; ++i)
+        {
+                *(file_descriptor + i) = -1;
+        }
+        if (unix_socket)
+        {
+                snprintf(name, sizeof(name), "unix %s", unix_socket);
+        }
+        else
+        {
+                snprintf(name, sizeof(name), "port %d", port);
+        }
+        for (int i = 0; i != connection; ++i)
+        {
+                int connect_result = -1;
+                if (unix_socket)
+                {
+                        struct sockaddr_un socket_connect;
+                        SkkUtility::clearMemory(&socket_connect, sizeof(socket_connect));
+                        socket_connect.sun_family = AF_UNIX;
+                        strncpy(socket_connect.sun_path, unix_socket, sizeof(socket_connect.sun_path) - 1);
+                        *(file_descriptor + i) = socket(AF_UNIX, SOCK_STREAM, 0);
+                        if (*(file_descriptor + i) != -1)
+                        {
+                                connect_result = connect(*(file_descriptor + i), reinterpret_cast<struct sockaddr*>(&socket_connect), sizeof(socket_connect));
+                        }
+                }
+                else
+                {
+                        struct sockaddr_in socket_connect;
+                        SkkUtility::clearMemory(&socket_connect, sizeof(socket_connect));
+                        socket_connect.sin_family = AF_INET;
+                        socket_connect.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+                        socket_connect.sin_port = htons(static_cast<uint16_t>(port));
+                        *(file_descriptor + i) = socket(AF_INET, SOCK_STREAM, 0);
+                        if (*(file_descriptor + i) != -1)
+                        {
+                                connect_result = connect(*(file_descriptor + i), reinterpret_cast<struct sockaddr*>(&socket_connect), sizeof(socket_connect));
+                        }
+                }
+                if (connect_result == -1)
+                {
+                        SkkUtility::printf("%s: connect failed\n", name);
+                        result = false;
+                        goto ERROR_BREAK;
+                }
+                if (*(file_descriptor + i) > file_descriptor_maximum)
+                {
+                        file_descriptor_maximum = *(file_descriptor + i);
+                }
+        }
+        time_start = get_time_nanosecond();
+        for (int i = 0; (i != connection) && (sent != length); ++i)
+        {
+                if (!send_request(*(file_descriptor + i), key + *(key_offset + sent % key_length), request))
+                {
+                        SkkUtility::printf("%s: send failed\n", name);
+                        result = false;
+                        goto ERROR_BREAK;
+                }
+                *(send_time + i) = get_time_nanosecond();
+                ++sent;
+        }
+        while (received != sent)
+        {
+                fd_set fd_set_read;
+                FD_ZERO(&fd_set_read);
+                for (int i = 0; i != connection; ++i)
+                {
+                        FD_SET(*(file_descriptor + i), &fd_set_read);
+                }
+                if (select(file_descriptor_maximum + 1, &fd_set_read, 0, 0, 0) == -1)
+                {
+                        if (errno == EINTR)
+                        {
+                                continue;
+                        }
+                        result = false;
+                        goto ERROR_BREAK;
+                }
+                for (int i = 0; i != connection; ++i)
+                {
+                        if (FD_ISSET(*(file_descriptor + i), &fd_set_read))
+                        {
+                                const ssize_t recv_result = recv(*(file_descriptor + i), reply, reply_size, 0);
+                                if (recv_result <= 0)
+                                {
+                                        SkkUtility::printf("%s: disconnected\n", name);
+                                        result = false;
+                                        goto ERROR_BREAK;
+                                }
+//  '\n' ǽޤ
+                                if (reply[recv_result - 1] == '\n')
+                                {
+                                        *(latency + received) = get_time_nanosecond() - *(send_time + i);
+                                        ++received;
+                                        if (sent != length)
+                                        {
+                                                if (!send_request(*(file_descriptor + i), key + *(key_offset + sent % key_length), request))
+                                                {
+                                                        SkkUtility::printf("%s: send failed\n", name);
+                                                        result = false;
+                                                        goto ERROR_BREAK;
+                                                }
+                                                *(send_time + i) = get_time_nanosecond();
+                                                ++sent;
+                                        }
+                                }
+                        }
+                }
+        }
+        {
+                const int64_t time = get_time_nanosecond() - time_start;
+                sort_latency(latency, length);
+                SkkUtility::printf("%s  connection %d\n"
+                                   "    %10.0f requests/s  p50 %10.3f us  p99 %10.3f us  max %10.3f us\n",
+                                   name,
+                                   connection,
+                                   static_cast<double>(length) * 1000.0 * 1000.0 * 1000.0 / static_cast<double>(time),
+                                   static_cast<double>(*(latency + length / 2)) / 1000.0,
+                                   static_cast<double>(*(latency + length - 1 - length / 100)) / 1000.0,
+                                   static_cast<double>(*(latency + length - 1)) / 1000.0);
+        }
+ERROR_BREAK:
+        for (int i = 0; i != connection; ++i)
+        {
+                if (*(file_descriptor + i) != -1)
+                {
+                        close(*(file_descriptor + i));
+                }
+        }
+        delete[] reply;
+        delete[] latency;
+        delete[] send_time;
+        delete[] file_descriptor;
+        return result;
+}
+#pragma GCC diagnostic pop
+
+/// unix_socket ԤäƤ륵Ф SkkSharedRing ꡢ "1" α֤ʬۤ 1 ä׵ɽޤ
+/**
+ * äƤ鼡׵Τǡ --connection=1 
+ * benchmark_server() ٤ޤ
+ */
+bool benchmark_shared_ring(const char *unix_socket,
+                           const char *key,
+                           const int *key_offset,
+                           int key_length,
+                           int loop)
+{
+#ifdef YASKKSERV_CONFIG_HAVE_SHARED_RING
+        SkkSharedRingClient client;
+        if (!client.connect(unix_socket))
+        {
+                SkkUtility::printf("shared ring %s: connect failed\n", unix_socket);
+                return false;
+        }
+        bool result = true;
+        const int length = key_length * loop;
+        int64_t *latency = new int64_t[length];
+        char request[1 + 512];
+        const int reply_size = 64 * 1024;
+        char *reply = new char[reply_size];
+        const int64_t time_start = get_time_nanosecond();
+        for (int i = 0; i != length; ++i)
+        {
+                const char *p = key + *(key_offset + i % key_length);
+                int size = 0;
+                *(request + size) = '1';
+                ++size;
+                for (int n = 0; size != 1 + 512; ++n)
+                {
+                        *(request + size) = *(p + n);
+                        ++size;
+                        if (*(p + n) == ' ')
+                        {
+                                break;
+                        }
+                }
+                const int64_t send_time = get_time_nanosecond();
+                if (client.request(request, size, reply, reply_size) <= 0)
+                {
+                        SkkUtility::printf("shared ring %s: request failed\n", unix_socket);
+                        result = false;
+                        break;
+                }
+                *(latency + i) = get_time_nanosecond() - send_time;
+        }
+        if (result)
+        {
+                const int64_t time = get_time_nanosecond() - time_start;
+                sort_latency(latency, length);
+                SkkUtility::printf("shared ring %s\n"
+                                   "    %10.0f requests/s  p50 %10.3f us  p99 %10.3f us  max %10.3f us\n",
+                                   unix_socket,
+                                   static_cast<double>(length) * 1000.0 * 1000.0 * 1000.0 / static_cast<double>(time),
+                                   static_cast<double>(*(latency + length / 2)) / 1000.0,
+                                   static_cast<double>(*(latency + length - 1 - length / 100)) / 1000.0,
+                                   static_cast<double>(*(latency + length - 1)) / 1000.0);
+        }
+        delete[] reply;
+        delete[] latency;
+        return result;
+#else  // YASKKSERV_CONFIG_HAVE_SHARED_RING
+        (void)key;
+        (void)key_offset;
+        (void)key_length;
+        (void)loop;
+        SkkUtility::printf("shared ring %s: not supported\n", unix_socket);
+        return false;
+#endif  // YASKKSERV_CONFIG_HAVE_SHARED_RING
+}
+
+int print_usage()
+{
+        SkkUtility::printf("Usage: yaskkserv_benchmark [OPTION] skk-dictionary dictionary...\n"
+                           "       yaskkserv_benchmark [OPTION] --server=PORT skk-dictionary\n"
+                           "       yaskkserv_benchmark [OPTION] --unix-socket=PATH skk-dictionary\n"
+                           "  -c, --completion-length=LENGTH  set completion length (default 2048)\n"
+                           "  -h, --help               print this help and exit\n"
+                           "  -l, --loop=LOOP          set loop count (default 3)\n"
+                           "  -n, --connection=N       set connection count for --server and --unix-socket (default 4)\n"
+                           "  -r, --reload=COUNT       measure search latency while reloading dictionary COUNT times\n"
+                           "  -R, --shared-ring        also measure shared memory ring of --unix-socket (compare with --connection=1)\n"
+                           "  -s, --server=PORT        measure request latency of server running on 127.0.0.1:PORT\n"
+                           "  -t, --thread=N           search from N threads sharing one opened dictionary and check results\n"
+                           "  -u, --unix-socket=PATH   measure request latency of server listening on unix domain socket PATH\n"
+                           "  -v, --version            print version\n");
+        return -1;
+}
+
+int print_version()
+{
+        SkkUtility::printf("yaskkserv_benchmark version " YASKKSERV_VERSION "\n");
+        SkkUtility::printf("Copyright (C) 2005, 2006, 2007, 2008, 2011, 2012, 2013, 2014 Tadashi Watanabe\n");
+        SkkUtility::printf("https://github.com/wachikun/yaskkserv\n");
+        return -1;
+}
+}
+
+int local_main(int argc, char *argv[])
+{
+        enum
+        {
+                OPTION_TABLE_COMPLETION_LENGTH,
+                OPTION_TABLE_HELP,
+                OPTION_TABLE_LOOP,
+                OPTION_TABLE_CONNECTION,
+                OPTION_TABLE_RELOAD,
+                OPTION_TABLE_SHARED_RING,
+                OPTION_TABLE_SERVER,
+                OPTION_TABLE_THREAD,
+                OPTION_TABLE_UNIX_SOCKET,
+                OPTION_TABLE_VERSION,
+
+                OPTION_TABLE_LENGTH
+        };
+
+        const SkkCommandLine::Option option_table[] =
+        {
+                {
+                        "c", "completion-length",
+                        SkkCommandLine::OPTION_ARGUMENT_INTEGER,
+                },
+                {
+                        "h", "help",
+                        SkkCommandLine::OPTION_ARGUMENT_NONE,
+                },
+                {
+                        "l", "loop",
+                        SkkCommandLine::OPTION_ARGUMENT_INTEGER,
+                },
+                {
+                        "n", "connection",
+                        SkkCommandLine::OPTION_ARGUMENT_INTEGER,
+                },
+                {
+                        "r", "reload",
+                        SkkCommandLine::OPTION_ARGUMENT_INTEGER,
+                },
+                {
+                        "R", "shared-ring",
+                        SkkCommandLine::OPTION_ARGUMENT_NONE,
+                },
+                {
+                        "s", "server",
+                        SkkCommandLine::OPTION_ARGUMENT_INTEGER,
+                },
+                {
+                        "t", "thread",
+                        SkkCommandLine::OPTION_ARGUMENT_INTEGER,
+                },
+                {
+                        "u", "unix-socket",
+                        SkkCommandLine::OPTION_ARGUMENT_STRING,
+                },
+                {
+                        "v", "version",
+                        SkkCommandLine::OPTION_ARGUMENT_NONE,
+                },
+                {
+                        0, 0,
+                        SkkCommandLine::OPTION_ARGUMENT_TERMINATOR,
+                },
+        };
+
+        struct Option
+        {
+                int completion_length;
+                int loop;
+                int connection;
+                int reload;
+                int server;
+                int thread;
+                const char *unix_socket;
+        }
+        option =
+        {
+                2048,
+                3,
+                4,
+                0,
+                0,
+                0,
+                0,
+        };
+        SkkCommandLine command_line;
+        if (command_line.parse(argc, argv, option_table))
+        {
+                if (command_line.isOptionDefined(OPTION_TABLE_HELP))
+                {
+                        return print_usage();
+                }
+                if (command_line.isOptionDefined(OPTION_TABLE_VERSION))
+                {
+                        return print_version();
+                }
+                if (command_line.isOptionDefined(OPTION_TABLE_SERVER))
+                {
+                        option.server = command_line.getOptionArgumentInteger(OPTION_TABLE_SERVER);
+                        if ((option.server < 1) || (option.server > 65535) || (command_line.getArgumentLength() != 1))
+                        {
+                                return print_usage();
+                        }
+                }
+                if (command_line.isOptionDefined(OPTION_TABLE_UNIX_SOCKET))
+                {
+                        option.unix_socket = command_line.getOptionArgumentString(OPTION_TABLE_UNIX_SOCKET);
+                        if (command_line.getArgumentLength() != 1)
+                        {
+                                return print_usage();
+                        }
+                }
+                if (command_line.isOptionDefined(OPTION_TABLE_SHARED_RING) && (option.unix_socket == 0))
+                {
+                        return print_usage();
+                }
+                if ((option.server == 0) && (option.unix_socket == 0) && (command_line.getArgumentLength() < 2))
+                {
+                        return print_usage();
+                }
+                if (command_line.isOptionDefined(OPTION_TABLE_CONNECTION))
+                {
+                        option.connection = command_line.getOptionArgumentInteger(OPTION_TABLE_CONNECTION);
+                        if ((option.connection < 1) || (option.connection > 1024))
+                        {
+                                return print_usage();
+                        }
+                }
+                if (command_line.isOptionDefined(OPTION_TABLE_COMPLETION_LENGTH))
+                {
+                        option.completion_length = command_line.getOptionArgumentInteger(OPTION_TABLE_COMPLETION_LENGTH);
+                        if (option.completion_length <= 0)
+                        {
+                                return print_usage();
+                        }
+                }
+                if (command_line.isOptionDefined(OPTION_TABLE_LOOP))
+                {
+                        option.loop = command_line.getOptionArgumentInteger(OPTION_TABLE_LOOP);
+                        if (option.loop <= 0)
+                        {
+                                return print_usage();
+                        }
+                }
+                if (command_line.isOptionDefined(OPTION_TABLE_RELOAD))
+                {
+                        option.reload = command_line.getOptionArgumentInteger(OPTION_TABLE_RELOAD);
+                        if (option.reload <= 0)
+                        {
+                                return print_usage();
+                        }
+                }
+                if (command_line.isOptionDefined(OPTION_TABLE_THREAD))
+                {
+                        option.thread = command_line.getOptionArgumentInteger(OPTION_TABLE_THREAD);
+                        if ((option.thread < 1) || (option.thread > 1024))
+                        {
+                                return print_usage();
+                        }
+                }
+        }
+        else
+        {
+                SkkUtility::printf("error \"%s\"\n\n",
+                                   command_line.getErrorString());
+                return print_usage();
+        }
+
+        SkkMmap mmap;
+        const char *buffer = static_cast<const char*>(mmap.map(command_line.getArgumentPointer(0)));
+        if (buffer == 0)
+        {
+                SkkUtility::printf("%s: open failed\n", command_line.getArgumentPointer(0));
+                return EXIT_FAILURE;
+        }
+        const char *key = 0;
+        int *key_offset = 0;
+        char *completion_key = 0;
+        int *completion_key_offset = 0;
+        int key_length = 0;
+        if (!get_key(buffer, mmap.getFilesize(), key, key_offset, completion_key, completion_key_offset, key_length))
+        {
+                SkkUtility::printf("%s: no entry\n", command_line.getArgumentPointer(0));
+                return EXIT_FAILURE;
+        }
+
+        if ((option.server > 0) || option.unix_socket)
+        {
+// ξꤷ TCP  unix domain socket ³¬ޤ
+// --shared-ring Ϥθ¬ޤ
+                bool result = true;
+                if (option.server > 0)
+                {
+                        result = benchmark_server(option.server,
+                                                  0,
+                                                  option.connection,
+                                                  key,
+                                                  key_offset,
+                                                  key_length,
+                                                  option.loop);
+                }
+                if (result && option.unix_socket)
+                {
+                        result = benchmark_server(0,
+                                                  option.unix_socket,
+                                                  option.connection,
+                                                  key,
+                                                  key_offset,
+                                                  key_length,
+                                                  option.loop);
+                }
+                if (result && command_line.isOptionDefined(OPTION_TABLE_SHARED_RING))
+                {
+                        result = benchmark_shared_ring(option.unix_socket,
+                                                       key,
+                                                       key_offset,
+                                                       key_length,
+                                                       option.loop);
+                }
+                delete[] completion_key_offset;
+                delete[] completion_key;
+                delete[] key_offset;
+                return result ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+
+        bool result = true;
+        for (int i = 1; i != command_line.getArgumentLength(); ++i)
+        {
+                if (option.thread > 0)
+                {
+                        if (!benchmark_thread(command_line.getArgumentPointer(i),
+                                              key,
+                                              key_offset,
+                                              key_length,
+                                              option.loop,
+                                              option.thread))
+                        {
+                                result = false;
+                        }
+                        continue;
+                }
+                if (option.reload > 0)
+                {
+                        benchmark_reload(command_line.getArgumentPointer(i),
+                                         key,
+                                         key_offset,
+                                         key_length,
+                                         option.loop,
+                                         option.reload);
+                        continue;
+                }
+                benchmark(command_line.getArgumentPointer(i),
+                          key,
+                          key_offset,
+                          completion_key,
+                          completion_key_offset,
+                          key_length,
+                          option.loop,
+                          option.completion_length);
+        }
+
+        delete[] completion_key_offset;
+        delete[] completion_key;
+        delete[] key_offset;
+
+        return result ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+}
@@ -17,10 +17,12 @@
  */
 
 #include "skk_dictionary.hpp"
+#include "skk_lookup.hpp"
 #include "skk_server.hpp"
 #include "skk_utility.hpp"
 #include "skk_command_line.hpp"
 #include "skk_simple_string.hpp"
+#include "skk_event.hpp"
 
 // #define YASKKSERV_HAIRY_TEST
 
@@ -1931,6 +1933,7 @@ public:
 
         virtual ~LocalSkkServer()
         {
+                delete[] completion_dictionary_table_;
         }
 
         LocalSkkServer(int port = 1178, int log_level = 0, const char *address = "0.0.0.0") :
@@ -1938,6 +1941,8 @@ public:
 
                 skk_dictionary_(0),
                 dictionary_filename_table_(0),
+                completion_dictionary_table_(0),
+                completion_dictionary_length_(0),
 
 #ifdef YASKKSERV_CONFIG_ENABLE_GOOGLE_JAPANESE_INPUT
                 google_japanese_input_(),
@@ -1948,6 +1953,7 @@ public:
 #endif  // YASKKSERV_CONFIG_ENABLE_GOOGLE_SUGGEST
                 google_suggest_flag_(false),
                 google_cache_file_(0),
+                google_cache_save_interval_(0),
 #endif  // YASKKSERV_CONFIG_ENABLE_GOOGLE_JAPANESE_INPUT
                 skk_dictionary_length_(0),
                 max_connection_(0),
@@ -1959,7 +1965,8 @@ public:
 
                 dictionary_check_update_flag_(false),
                 no_daemonize_flag_(false),
-                use_http_flag_(false)
+                use_http_flag_(false),
+                io_uring_flag_(false)
         {
         }
 
@@ -1968,6 +1975,9 @@ public:
                         int skk_dictionary_length,
                         int max_connection,
                         int listen_queue,
+                        int idle_timeout,
+                        const char *unix_socket_path,
+                        int unix_socket_mode,
                         int server_completion_midasi_length,
                         int server_completion_midasi_string_size,
                         int server_completion_test,
@@ -1978,7 +1988,8 @@ public:
                         bool dictionary_check_update_flag,
                         bool no_daemonize_flag,
                         bool use_http_flag,
-                        bool use_ipv6_flag)
+                        bool use_ipv6_flag,
+                        bool io_uring_flag)
         {
 #ifndef YASKKSERV_CONFIG_ENABLE_GOOGLE_JAPANESE_INPUT
                 (void)use_ipv6_flag;
@@ -1987,8 +1998,21 @@ public:
                 dictionary_filename_table_ = dictionary_filename_table;
 
                 skk_dictionary_length_ = skk_dictionary_length;
+// 䴰 Google μ SkkLookup õޤ
+                completion_dictionary_table_ = new SkkDictionary*[skk_dictionary_length];
+                for (int i = 0; i != skk_dictionary_length; ++i)
+                {
+                        if (!(skk_dictionary_ + i)->isGoogleJapaneseInput() &&
+                            !(skk_dictionary_ + i)->isGoogleSuggest())
+                        {
+                                *(completion_dictionary_table_ + completion_dictionary_length_) = skk_dictionary_ + i;
+                                ++completion_dictionary_length_;
+                        }
+                }
                 max_connection_ = max_connection;
                 listen_queue_ = listen_queue;
+                main_loop_set_idle_timeout(idle_timeout);
+                main_loop_set_unix_socket(unix_socket_path, unix_socket_mode);
                 server_completion_midasi_length_ = server_completion_midasi_length;
                 server_completion_midasi_string_size_ = server_completion_midasi_string_size;
                 server_completion_test_ = server_completion_test;
@@ -1996,6 +2020,7 @@ public:
                 dictionary_check_update_flag_ = dictionary_check_update_flag;
                 no_daemonize_flag_ = no_daemonize_flag;
                 use_http_flag_ = use_http_flag;
+                io_uring_flag_ = io_uring_flag;
 #ifdef YASKKSERV_CONFIG_ENABLE_GOOGLE_JAPANESE_INPUT
                 google_japanese_input_.createCache(google_cache_entries);
                 google_japanese_input_.setIpv6Flag(use_ipv6_flag);
@@ -2062,6 +2087,12 @@ public:
                 google_suggest_flag_ = flag;
         }
 #endif  // YASKKSERV_CONFIG_ENABLE_GOOGLE_SUGGEST
+
+/// second äȤ˥åե¸ޤ 0 ʤ SIGHUP Ȥ¸ޤ
+        void setGoogleCacheSaveInterval(int second)
+        {
+                google_cache_save_interval_ = second;
+        }
 #endif  // YASKKSERV_CONFIG_ENABLE_GOOGLE_JAPANESE_INPUT
 
         bool mainLoop()
@@ -2097,6 +2128,7 @@ public:
 
 private:
         bool local_main_loop_loop(fd_set &fd_set_read);
+        void main_loop_process(int work_index, int recv_result);
         void local_main_loop_sighup();
         bool local_main_loop();
 
@@ -2132,10 +2164,6 @@ private:
 #endif  // YASKKSERV_CONFIG_ENABLE_GOOGLE_JAPANESE_INPUT
 /// ХåեꥻåȤ٤ʤп֤ޤ
         bool local_main_loop_1(int work_index, int recv_result);
-        bool local_main_loop_4_search_core(int work_index,
-                                           int recv_result,
-                                           SkkUtility::Hash<SkkUtility::HASH_TYPE_CANDIDATE> *hash,
-                                           SkkSimpleString &string);
         bool local_main_loop_4_search(int work_index, int recv_result);
 /// ХåեꥻåȤ٤ʤп֤ޤ
         bool local_main_loop_4(int work_index, int recv_result);
@@ -2150,6 +2178,8 @@ private:
 private:
         LocalSkkDictionary *skk_dictionary_;
         const char * const *dictionary_filename_table_;
+        SkkDictionary **completion_dictionary_table_;
+        int completion_dictionary_length_;
 
 #ifdef YASKKSERV_CONFIG_ENABLE_GOOGLE_JAPANESE_INPUT
         GoogleJapaneseInput google_japanese_input_;
@@ -2160,6 +2190,7 @@ private:
 #endif  // YASKKSERV_CONFIG_ENABLE_GOOGLE_SUGGEST
         bool google_suggest_flag_;
         const char *google_cache_file_;
+        int google_cache_save_interval_;
 #endif  // YASKKSERV_CONFIG_ENABLE_GOOGLE_JAPANESE_INPUT
         int skk_dictionary_length_;
         int max_connection_;
@@ -2172,6 +2203,7 @@ private:
         bool dictionary_check_update_flag_;
         bool no_daemonize_flag_;
         bool use_http_flag_;
+        bool io_uring_flag_;
 };
 
 #ifdef YASKKSERV_CONFIG_ENABLE_GOOGLE_JAPANESE_INPUT
@@ -2183,7 +2215,7 @@ bool LocalSkkServer::local_main_loop_1_google_japanese_input(int work_index)
         {
                 if (!send((work_ + work_index)->file_descriptor, candidates, GoogleJapaneseInput::getByteSize(candidates)))
                 {
-                        (work_ + work_index)->closeAndReset();
+                        main_loop_close(work_index);
                 }
                 result = true;
         }
@@ -2198,7 +2230,7 @@ bool LocalSkkServer::local_main_loop_1_google_suggest(int work_index)
         {
                 if (!send((work_ + work_index)->file_descriptor, candidates, GoogleJapaneseInput::getByteSize(candidates)))
                 {
-                        (work_ + work_index)->closeAndReset();
+                        main_loop_close(work_index);
                 }
                 result = true;
         }
@@ -2222,7 +2254,7 @@ bool LocalSkkServer::local_main_loop_1_search_single_dictionary(int work_index)
                 {
                         if (!send((work_ + work_index)->file_descriptor, candidates, GoogleJapaneseInput::getByteSize(candidates)))
                         {
-                                (work_ + work_index)->closeAndReset();
+                                main_loop_close(work_index);
                         }
                         result = true;
                 }
@@ -2236,7 +2268,7 @@ bool LocalSkkServer::local_main_loop_1_search_single_dictionary(int work_index)
                 {
                         if (!send((work_ + work_index)->file_descriptor, candidates, GoogleJapaneseInput::getByteSize(candidates)))
                         {
-                                (work_ + work_index)->closeAndReset();
+                                main_loop_close(work_index);
                         }
                         result = true;
                 }
@@ -2426,7 +2458,7 @@ bool LocalSkkServer::local_main_loop_1_search_plural_dictionary(int work_index,
 
         if (!send((work_ + work_index)->file_descriptor, string.getBuffer(), string.getSize()))
         {
-                (work_ + work_index)->closeAndReset();
+                main_loop_close(work_index);
         }
         return true;
 }
@@ -2481,7 +2513,7 @@ bool LocalSkkServer::local_main_loop_1_search(int work_index)
                         {
                                 if (!send((work_ + work_index)->file_descriptor, google_japanese_input_candidates, GoogleJapaneseInput::getByteSize(google_japanese_input_candidates)))
                                 {
-                                        (work_ + work_index)->closeAndReset();
+                                        main_loop_close(work_index);
                                 }
                         }
 #ifdef YASKKSERV_CONFIG_ENABLE_GOOGLE_SUGGEST
@@ -2489,7 +2521,7 @@ bool LocalSkkServer::local_main_loop_1_search(int work_index)
                         {
                                 if (!send((work_ + work_index)->file_descriptor, google_suggest_candidates, GoogleJapaneseInput::getByteSize(google_suggest_candidates)))
                                 {
-                                        (work_ + work_index)->closeAndReset();
+                                        main_loop_close(work_index);
                                 }
                         }
 #endif  // YASKKSERV_CONFIG_ENABLE_GOOGLE_SUGGEST
@@ -2564,7 +2596,7 @@ bool LocalSkkServer::local_main_loop_1_notfound_first_second(int work_index, con
                 {
                         if (!send((work_ + work_index)->file_descriptor, candidates, GoogleJapaneseInput::getByteSize(candidates)))
                         {
-                                (work_ + work_index)->closeAndReset();
+                                main_loop_close(work_index);
                         }
                         result = true;
                 }
@@ -2604,7 +2636,7 @@ bool LocalSkkServer::local_main_loop_1_notfound_first_second(int work_index, con
                 }
                 if (!send((work_ + work_index)->file_descriptor, string.getBuffer(), string.getSize()))
                 {
-                        (work_ + work_index)->closeAndReset();
+                        main_loop_close(work_index);
                 }
         }
         return true;
@@ -2685,237 +2717,47 @@ bool LocalSkkServer::local_main_loop_1(int work_index, int recv_result)
         return result;
 }
 
-bool LocalSkkServer::local_main_loop_4_search_core(int work_index,
-                                                   int recv_result,
-                                                   SkkUtility::Hash<SkkUtility::HASH_TYPE_CANDIDATE> *hash,
-                                                   SkkSimpleString &string)
-{
-// դäΡָФפޤȤޤ
-// ָФפϡ֤Ҥ餬ʥ󥳡ɡפƤ뤳ȤդɬפǤ
-        char decode_buffer[SkkUtility::MIDASI_DECODE_HIRAGANA_BUFFER_SIZE];
-        switch (server_completion_test_)
-        {
-        default:
-                // FALLTHROUGH
-                DEBUG_ASSERT(0);
-        case 2:
-                // FALLTHROUGH
-        case 1:
-                string.appendFast("1/");
-                break;
-
-        case 3:
-                string.appendFast("1 ");
-                break;
-
-        case 4:
-                if (server_completion_test_protocol_ == '4')
-                {
-                        string.appendFast("1/");
-                }
-                else
-                {
-                        string.appendFast("1 ");
-                }
-                break;
-        }
-
-        int add_counter = 0;
-        for (int h = 0; h != skk_dictionary_length_; ++h)
-        {
-                if (!(skk_dictionary_ + h)->isGoogleJapaneseInput() &&
-                    !(skk_dictionary_ + h)->isGoogleSuggest() &&
-                    (skk_dictionary_ + h)->isSuccess())
-                {
-                        bool found_flag = false;
-                        do
-                        {
-                                const char *p = (skk_dictionary_ + h)->getMidasiPointer();
-// DecodeHiragana() ϥߥ͡¸ߤʤȤդɬפǤ
-// size ⥿ߥ͡ޤޤʤǤ
-                                int size = SkkUtility::decodeHiragana(p, decode_buffer, sizeof(decode_buffer));
-                                if (size == 0)
-                                {
-                                        const int raw_code = 1; // \1 ʬ
-                                        p += raw_code;
-                                        size = (skk_dictionary_ + h)->getMidasiSize() - raw_code;
-                                }
-                                else
-                                {
-                                        p = decode_buffer;
-                                }
-
-                                if (SkkSimpleString::startWith(p,
-                                                               (work_ + work_index)->read_buffer + 1,
-                                                               size,
-                                                               (work_ + work_index)->read_process_index + recv_result - 1))
-                                {
-                                        found_flag = true;
-                                }
-                                else
-                                {
-                                        if (found_flag)
-                                        {
-                                                break;
-                                        }
-                                        else
-                                        {
-                                                continue;
-                                        }
-                                }
-
-                                if (SkkUtility::isOkuriNasiOrAbbrev(p, size))
-                                {
-                                        if ((hash == 0) || !hash->contain(p, size))
-                                        {
-                                                if ((server_completion_test_ == 2) && SkkSimpleString::search(p, '/', size))
-                                                {
-                                                        // ignore slash
-                                                }
-                                                else
-                                                {
-                                                        const int separator_size = 1;
-                                                        if (!string.isAppendSize(size + separator_size))
-                                                        {
-                                                                return false;
-                                                        }
-                                                        const char *current = string.getCurrentBuffer();
-                                                        string.append(p, size);
-                                                        switch (server_completion_test_)
-                                                        {
-                                                        default:
-                                                                DEBUG_ASSERT(0);
-                                                                // FALLTHROUGH
-                                                        case 1:
-                                                                string.appendFast('/'); // + separator_size
-                                                                break;
-                                                        case 3:
-                                                                string.appendFast(' '); // + separator_size
-                                                                break;
-                                                        case 4:
-                                                                if (server_completion_test_protocol_ == '4')
-                                                                {
-                                                                        string.appendFast('/'); // + separator_size
-                                                                }
-                                                                else
-                                                                {
-                                                                        string.appendFast(' '); // + separator_size
-                                                                }
-                                                                break;
-                                                        }
-// ץȥ "4" Ǥϥ꡼ɥХåեưŪ˽񤭴뤿ᡢľܥ꡼
-// ɥХåե򻲾ȤƤϤʤޤ󡣤μǤ string ХåեȤ
-// ѤƤޤ
-                                                        if (hash)
-                                                        {
-                                                                if (!hash->add(current, size))
-                                                                {
-                                                                        return false;
-                                                                }
-                                                        }
-
-                                                        if (++add_counter >= server_completion_midasi_length_)
-                                                        {
-                                                                return false;
-                                                        }
-                                                }
-                                        }
-                                }
-                        }
-                        while ((skk_dictionary_ + h)->searchNextEntry());
-                }
-        }
-
-#ifdef YASKKSERV_DEBUG
-        if (hash)
-        {
-                int counter;
-                int offset_max;
-                double average;
-                hash->getDebugBuildInformation(counter, offset_max, average);
-                DEBUG_PRINTF("counter=%d\n"
-                             "offset_max=%d\n"
-                             "average=%f\n"
-                             ,
-                             counter,
-                             offset_max,
-                             average);
-        }
-#endif  // YASKKSERV_DEBUG
-
-        if (add_counter == 0)
-        {
-                return false;
-        }
-
-        if (!string.append('\n'))
-        {
-                return false;
-        }
-
-        return true;
-}
-
 bool LocalSkkServer::local_main_loop_4_search(int work_index, int recv_result)
 {
 //
-// 1. ָФפꤢפʤ¨¤˵֤ޤ
+// ָФפꤢפǤʤСդäΡָФפ
+// SkkLookup::appendCompletion() ǤޤȤޤ
 //
-// 2. ָФפõޤ
-//
-// 3. ָФפդä硢Υȥ꤫ SearchNextEntry() 
-//    Ϥޤ
-//
-// 4. ָФפդʤä硢Υȥ꤬ޤޤƤǤ
-//    ֥åƬ SearchNextEntry() 򳫻Ϥޤ
+// ץȥ "4" Ǥϥ꡼ɥХåեưŪ˽񤭴뤿ᡢľܥ꡼
+// ɥХåե򻲾ȤƤϤʤޤ󡣤μǤ string ХåեȤ
+// ѤƤޤ
 //
-        if (SkkUtility::isOkuriAri((work_ + work_index)->read_buffer + 1, recv_result - 1))
+        char separator = '/';
+        if ((server_completion_test_ == 3) ||
+            ((server_completion_test_ == 4) && (server_completion_test_protocol_ != '4')))
         {
-                return false;
+                separator = ' ';
         }
-
-        int found_times = 0;
-        for (int h = 0; h != skk_dictionary_length_; ++h)
-        {
-                if (!(skk_dictionary_ + h)->isGoogleJapaneseInput() &&
-                    !(skk_dictionary_ + h)->isGoogleSuggest())
-                {
-                        if ((skk_dictionary_ + h)->search((work_ + work_index)->read_buffer + 1) ||
-                            (skk_dictionary_ + h)->searchForFirstCharacter((work_ + work_index)->read_buffer + 1))
-                        {
-                                ++found_times;
-                        }
-                }
+        SkkSimpleString string(server_completion_midasi_string_size_);
+        string.appendFast('1');
+        SkkLookup lookup(completion_dictionary_table_, completion_dictionary_length_);
+        int length;
+        if (!lookup.appendCompletion((work_ + work_index)->read_buffer + 1,
+                                     (work_ + work_index)->read_process_index + recv_result - 1,
+                                     server_completion_midasi_length_,
+                                     separator,
+                                     string,
+                                     length,
+                                     server_completion_test_ == 2) ||
+            ((length > 0) && !string.append('\n')))
+        {
+                syslog_.printf(1, SkkSyslog::LEVEL_WARNING, "server completion failed");
+                return false;
         }
-
-        if (found_times == 0)
+        if (length == 0)
         {
 // դʤä
                 return false;
         }
 
-        SkkSimpleString string(server_completion_midasi_string_size_);
-        {
-                SkkUtility::Hash<SkkUtility::HASH_TYPE_CANDIDATE> *hash = 0;
-                if (found_times > 1)
-                {
-// ʣåɬפʤΤʣμǤ
-                        int prime_length = SkkUtility::Hash<SkkUtility::HASH_TYPE_CANDIDATE>::getPrimeHashTableLength(server_completion_midasi_length_);
-                        hash = new SkkUtility::Hash<SkkUtility::HASH_TYPE_CANDIDATE>(prime_length);
-                }
-                bool core_result = local_main_loop_4_search_core(work_index, recv_result, hash, string);
-                delete hash;
-
-                if (!core_result)
-                {
-                        syslog_.printf(1, SkkSyslog::LEVEL_WARNING, "server completion failed");
-                        return false;
-                }
-        }
-
         if (!send((work_ + work_index)->file_descriptor, string.getBuffer(), string.getSize()))
         {
-                (work_ + work_index)->closeAndReset();
+                main_loop_close(work_index);
         }
         return true;
 }
@@ -3216,10 +3058,64 @@ void LocalSkkServer::load_cache_file(const char *filename)
 }
 #endif // defined(YASKKSERV_CONFIG_ENABLE_GOOGLE_JAPANESE_INPUT) && (defined(YASKKSERV_CONFIG_HEADER_HAVE_GNUTLS_OPENSSL) || defined(YASKKSERV_CONFIG_HEADER_HAVE_OPENSSL))
 
+void LocalSkkServer::main_loop_process(int work_index, int recv_result)
+{
+        bool buffer_reset_flag;
+        if ((work_ + work_index)->read_process_index == 0)
+        {
+                server_completion_test_protocol_ = *(work_ + work_index)->read_buffer;
+                switch (*(work_ + work_index)->read_buffer)
+                {
+                default:
+                        buffer_reset_flag = true;
+                        main_loop_illegal_command(work_index);
+                        break;
+                case '0':
+                        buffer_reset_flag = true;
+                        main_loop_0(work_index);
+                        break;
+                case '1':
+                        buffer_reset_flag = local_main_loop_1(work_index, recv_result);
+                        break;
+                case '2':
+                        buffer_reset_flag = true;
+                        main_loop_2(work_index, version_string, sizeof(version_string));
+                        break;
+                case '3':
+                        buffer_reset_flag = true;
+                        main_loop_3(work_index);
+                        break;
+                case '4':
+                        buffer_reset_flag = local_main_loop_4(work_index, recv_result);
+                        break;
+                case 'c':
+                        if (server_completion_test_ == 4)
+                        {
+                                buffer_reset_flag = local_main_loop_4(work_index, recv_result);
+                        }
+                        else
+                        {
+                                buffer_reset_flag = true;
+                                main_loop_illegal_command(work_index);
+                        }
+                        break;
+                case 'R':
+                        buffer_reset_flag = true;
+                        main_loop_shared_ring(work_index);
+                        break;
+                }
+        }
+        else
+        {
+                buffer_reset_flag = local_main_loop_1(work_index, recv_result);
+        }
+        main_loop_check_buffer_reset(work_index, recv_result, buffer_reset_flag);
+}
+
 // main_loop_recv() ˼Ԥ error break ٤ʤе֤ޤ
 bool LocalSkkServer::local_main_loop_loop(fd_set &fd_set_read)
 {
-        for (int i = 0; i != max_connection_; ++i)
+        for (int i = 0; i != work_length_; ++i)
         {
                 if (main_loop_is_recv(i, fd_set_read))
                 {
@@ -3235,52 +3131,7 @@ bool LocalSkkServer::local_main_loop_loop(fd_set &fd_set_read)
                         }
                         else
                         {
-                                bool buffer_reset_flag;
-                                if ((work_ + i)->read_process_index == 0)
-                                {
-                                        server_completion_test_protocol_ = *(work_ + i)->read_buffer;
-                                        switch (*(work_ + i)->read_buffer)
-                                        {
-                                        default:
-                                                buffer_reset_flag = true;
-                                                main_loop_illegal_command(i);
-                                                break;
-                                        case '0':
-                                                buffer_reset_flag = true;
-                                                main_loop_0(i);
-                                                break;
-                                        case '1':
-                                                buffer_reset_flag = local_main_loop_1(i, recv_result);
-                                                break;
-                                        case '2':
-                                                buffer_reset_flag = true;
-                                                main_loop_2(i, version_string, sizeof(version_string));
-                                                break;
-                                        case '3':
-                                                buffer_reset_flag = true;
-                                                main_loop_3(i);
-                                                break;
-                                        case '4':
-                                                buffer_reset_flag = local_main_loop_4(i, recv_result);
-                                                break;
-                                        case 'c':
-                                                if (server_completion_test_ == 4)
-                                                {
-                                                        buffer_reset_flag = local_main_loop_4(i, recv_result);
-                                                }
-                                                else
-                                                {
-                                                        buffer_reset_flag = true;
-                                                        main_loop_illegal_command(i);
-                                                }
-                                                break;
-                                        }
-                                }
-                                else
-                                {
-                                        buffer_reset_flag = local_main_loop_1(i, recv_result);
-                                }
-                                main_loop_check_buffer_reset(i, recv_result, buffer_reset_flag);
+                                main_loop_process(i, recv_result);
                         }
                 }
         }
@@ -3289,6 +3140,11 @@ bool LocalSkkServer::local_main_loop_loop(fd_set &fd_set_read)
 
 void LocalSkkServer::local_main_loop_sighup()
 {
+        syslog_.printf(1,
+                       SkkSyslog::LEVEL_INFO,
+                       "connection status    connection : %d    idle timeout : %d",
+                       main_loop_get_connection_count(),
+                       main_loop_get_idle_reap_count());
         char buffer[1024];
         SkkSimpleString string(buffer);
 #ifdef YASKKSERV_CONFIG_ENABLE_GOOGLE_JAPANESE_INPUT
@@ -3311,66 +3167,42 @@ void LocalSkkServer::local_main_loop_sighup()
 #endif  // YASKKSERV_CONFIG_ENABLE_GOOGLE_SUGGEST
         syslog_.printf(1, SkkSyslog::LEVEL_INFO, string.getBuffer());
 #endif  // YASKKSERV_CONFIG_ENABLE_GOOGLE_JAPANESE_INPUT
-        global_sighup_flag = 0;
-}
-
-#ifdef YASKKSERV_CONFIG_HAVE_PTHREAD
-void *signal_thread(void *args)
-{
-        (void)args;
-        sigset_t sigset;
-        sigfillset(&sigset);
-        sigdelset(&sigset, SIGTERM);
-        sigdelset(&sigset, SIGINT);
-        pthread_sigmask(SIG_SETMASK, &sigset, 0);
-        for (;;)
-        {
-                siginfo_t siginfo;
-                int result = sigwaitinfo(&sigset, &siginfo);
-                // DEBUG_PRINTF("thread result=%d  errno=%d  siginfo.si_signo=%d\n", result, errno, siginfo.si_signo);
-                if (result < 0)
-                {
-                        if (errno != EINTR)
-                        {
-                                break;
-                        }
-                }
-                else
-                {
-                        switch (siginfo.si_signo)
-                        {
-                        default:
-                                break;
-
-                        case SIGHUP:
-                                global_sighup_flag = 2;
-                                break;
-                        }
-                }
-        }
-        return 0;
 }
-#endif  // YASKKSERV_CONFIG_HAVE_PTHREAD
 
+/// SIGPIPE ̵뤷ޤ
+/**
+ * SSL_write()  MSG_NOSIGNAL ꤻ˽񤭹Τǡ google ؤ
+ * ³񤭹ߤڤƤץλʤ褦ˤޤ
+ * SIGHUP  SkkSignalEvent ǼΤǡǤ̵뤷ƤϤʤޤ
+ */
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wold-style-cast"
 void setup_signal()
 {
-        signal(SIGHUP, SIG_IGN);
+        signal(SIGPIPE, SIG_IGN);
 }
 #pragma GCC diagnostic pop
 
 bool LocalSkkServer::local_main_loop()
 {
-#ifdef YASKKSERV_CONFIG_HAVE_PTHREAD
-        sigset_t sigset;
-        sigfillset(&sigset);
-        sigdelset(&sigset, SIGTERM);
-        sigdelset(&sigset, SIGINT);
-        pthread_sigmask(SIG_SETMASK, &sigset, 0);
-        pthread_t pthread;
-        pthread_create(&pthread, 0, signal_thread, 0);
-#endif  // YASKKSERV_CONFIG_HAVE_PTHREAD
+        setup_signal();
+// SIGHUP Ūʽ select() Ԥޤʥ֥å
+// ǡ򳫤ľåɤ˽ɬפޤ
+        SkkSignalEvent sighup_event;
+        if (!sighup_event.initialize(SIGHUP))
+        {
+                syslog_.printf(1, SkkSyslog::LEVEL_WARNING, "SIGHUP event initialize failed");
+        }
+        SkkTimerEvent timer_event;
+#if defined(YASKKSERV_CONFIG_ENABLE_GOOGLE_JAPANESE_INPUT) && (defined(YASKKSERV_CONFIG_HEADER_HAVE_GNUTLS_OPENSSL) || defined(YASKKSERV_CONFIG_HEADER_HAVE_OPENSSL))
+        if (google_cache_file_ && (google_cache_save_interval_ > 0))
+        {
+                if (!timer_event.initialize(google_cache_save_interval_))
+                {
+                        syslog_.printf(1, SkkSyslog::LEVEL_WARNING, "timer event initialize failed");
+                }
+        }
+#endif // defined(YASKKSERV_CONFIG_ENABLE_GOOGLE_JAPANESE_INPUT) && (defined(YASKKSERV_CONFIG_HEADER_HAVE_GNUTLS_OPENSSL) || defined(YASKKSERV_CONFIG_HEADER_HAVE_OPENSSL))
 
 #if defined(YASKKSERV_CONFIG_ENABLE_GOOGLE_JAPANESE_INPUT) && (defined(YASKKSERV_CONFIG_HEADER_HAVE_GNUTLS_OPENSSL) || defined(YASKKSERV_CONFIG_HEADER_HAVE_OPENSSL))
         if (google_cache_file_)
@@ -3381,21 +3213,52 @@ bool LocalSkkServer::local_main_loop()
 #endif // defined(YASKKSERV_CONFIG_ENABLE_GOOGLE_JAPANESE_INPUT) && (defined(YASKKSERV_CONFIG_HEADER_HAVE_GNUTLS_OPENSSL) || defined(YASKKSERV_CONFIG_HEADER_HAVE_OPENSSL))
 
         bool result = true;
+        main_loop_initialize_reload_dictionary(skk_dictionary_length_, dictionary_filename_table_, dictionary_check_update_flag_);
+        if (io_uring_flag_ && !main_loop_initialize_io_uring())
+        {
+                syslog_.printf(1, SkkSyslog::LEVEL_WARNING, "io_uring is not available (select() is used)");
+        }
         for (;;)
         {
                 fd_set fd_set_read;
-                int select_result = main_loop_select_polling(fd_set_read);
+                const int file_descriptor_table[] =
+                {
+                        sighup_event.getFileDescriptor(),
+                        timer_event.getFileDescriptor(),
+                };
+                struct timeval timeout;
+                int select_result;
+                if (main_loop_is_io_uring())
+                {
+                        select_result = main_loop_io_uring(fd_set_read,
+                                                           file_descriptor_table,
+                                                           static_cast<int>(sizeof(file_descriptor_table) / sizeof(file_descriptor_table[0])),
+                                                           timer_event.getTimeout(timeout) ? &timeout : 0);
+                }
+                else
+                {
+                        select_result = main_loop_select(fd_set_read,
+                                                         file_descriptor_table,
+                                                         static_cast<int>(sizeof(file_descriptor_table) / sizeof(file_descriptor_table[0])),
+                                                         timer_event.getTimeout(timeout) ? &timeout : 0);
+                }
                 DEBUG_PRINTF("select_result=%d\n", select_result);
-                if (global_sighup_flag)
+                if (select_result >= 0)
                 {
-                        local_main_loop_sighup();
+// Ūʽ SIGHUP Ʊå¸Ⱦ֤νϤǤ
+                        const bool sighup_flag = sighup_event.isCaught(fd_set_read);
+                        const bool timer_flag = timer_event.isExpired(fd_set_read);
+                        if (sighup_flag || timer_flag)
+                        {
+                                local_main_loop_sighup();
+                        }
                 }
                 if (select_result == 0)
                 {
                 }
                 else
                 {
-                        main_loop_check_reload_dictionary(skk_dictionary_, skk_dictionary_length_, dictionary_filename_table_, dictionary_check_update_flag_);
+                        main_loop_check_reload_dictionary(skk_dictionary_, skk_dictionary_length_, dictionary_filename_table_, fd_set_read);
                         if (select_result == -1)
                         {
                                 if (errno == EINTR)
@@ -3403,6 +3266,16 @@ bool LocalSkkServer::local_main_loop()
                                         continue;
                                 }
                         }
+                        if (main_loop_is_io_uring())
+                        {
+// io_uring Ǥ accept ȼ׵ν main_loop_io_uring() 
+// ѤޤƤޤ
+                                if (select_result == -1)
+                                {
+                                        goto ERROR_BREAK;
+                                }
+                                continue;
+                        }
                         if (!main_loop_accept(fd_set_read, select_result))
                         {
                                 goto ERROR_BREAK;
@@ -3416,10 +3289,6 @@ bool LocalSkkServer::local_main_loop()
 ERROR_BREAK:
         result = false;
 
-#ifdef YASKKSERV_CONFIG_HAVE_PTHREAD
-        pthread_join(pthread, 0);
-#endif  // YASKKSERV_CONFIG_HAVE_PTHREAD
-
         return result;
 }
 
@@ -3430,10 +3299,16 @@ int print_usage()
                            "  -c, --check-update       check update dictionary (default disable)\n"
                            "  -d, --debug              enable debug mode (default disable)\n"
                            "  -h, --help               print this help and exit\n"
+                           "      --idle-timeout=SECOND\n"
+                           "                           close connection idle for SECOND (range [0 - 604800]  default 0(disable))\n"
+                           "      --io-uring           use io_uring instead of select() (default disable)\n"
                            "  -l, --log-level=LEVEL    loglevel (range [0 - 9]  default 1)\n"
                            "  -m, --max-connection=N   max connection (default 8)\n"
                            "  -p, --port=PORT          set port (default 1178)\n"
                            "  -f, --no-daemonize       not daemonize\n"
+                           "      --unix-socket=PATH   also listen on unix domain socket PATH (absolute path)\n"
+                           "      --unix-socket-mode=MODE\n"
+                           "                           set permission of --unix-socket (octal  default 600)\n"
                            "      --server-completion-midasi-length=LENGTH\n"
                            "                           set midasi length (range [256 - 32768]  default 2048)\n"
                            "      --server-completion-midasi-string-size=SIZE\n"
@@ -3485,6 +3360,8 @@ int print_usage()
 #if defined(YASKKSERV_CONFIG_HEADER_HAVE_GNUTLS_OPENSSL) || defined(YASKKSERV_CONFIG_HEADER_HAVE_OPENSSL)
                            "      --google-cache-file=filename\n"
                            "                           save/load cache filename\n"
+                           "      --google-cache-save-interval=SECOND\n"
+                           "                           save cache file every SECOND (range [0 - 86400]  default 0(only SIGHUP))\n"
 #endif // defined(YASKKSERV_CONFIG_HEADER_HAVE_GNUTLS_OPENSSL) || defined(YASKKSERV_CONFIG_HEADER_HAVE_OPENSSL)
 #endif  // YASKKSERV_CONFIG_ENABLE_GOOGLE_JAPANESE_INPUT
                            "  -v, --version            print version\n");
@@ -3505,6 +3382,8 @@ enum
         OPTION_TABLE_CHECK_UPDATE,
         OPTION_TABLE_DEBUG,
         OPTION_TABLE_HELP,
+        OPTION_TABLE_IDLE_TIMEOUT,
+        OPTION_TABLE_IO_URING,
         OPTION_TABLE_LOG_LEVEL,
         OPTION_TABLE_MAX_CONNECTION,
         OPTION_TABLE_PORT,
@@ -3525,8 +3404,11 @@ enum
 #endif  // YASKKSERV_CONFIG_ENABLE_GOOGLE_SUGGEST
 #if defined(YASKKSERV_CONFIG_HEADER_HAVE_GNUTLS_OPENSSL) || defined(YASKKSERV_CONFIG_HEADER_HAVE_OPENSSL)
         OPTION_TABLE_GOOGLE_CACHE_FILE,
+        OPTION_TABLE_GOOGLE_CACHE_SAVE_INTERVAL,
 #endif // defined(YASKKSERV_CONFIG_HEADER_HAVE_GNUTLS_OPENSSL) || defined(YASKKSERV_CONFIG_HEADER_HAVE_OPENSSL)
 #endif  // YASKKSERV_CONFIG_ENABLE_GOOGLE_JAPANESE_INPUT
+        OPTION_TABLE_UNIX_SOCKET,
+        OPTION_TABLE_UNIX_SOCKET_MODE,
         OPTION_TABLE_VERSION,
 
         OPTION_TABLE_LENGTH
@@ -3550,6 +3432,14 @@ const SkkCommandLine::Option option_table[] =
                 "h", "help",
                 SkkCommandLine::OPTION_ARGUMENT_NONE,
         },
+        {
+                0, "idle-timeout",
+                SkkCommandLine::OPTION_ARGUMENT_INTEGER,
+        },
+        {
+                0, "io-uring",
+                SkkCommandLine::OPTION_ARGUMENT_NONE,
+        },
         {
                 "l", "log-level",
                 SkkCommandLine::OPTION_ARGUMENT_INTEGER,
@@ -3612,8 +3502,20 @@ const SkkCommandLine::Option option_table[] =
                 0, "google-cache-file",
                 SkkCommandLine::OPTION_ARGUMENT_STRING,
         },
+        {
+                0, "google-cache-save-interval",
+                SkkCommandLine::OPTION_ARGUMENT_INTEGER,
+        },
 #endif // defined(YASKKSERV_CONFIG_HEADER_HAVE_GNUTLS_OPENSSL) || defined(YASKKSERV_CONFIG_HEADER_HAVE_OPENSSL)
 #endif  // YASKKSERV_CONFIG_ENABLE_GOOGLE_JAPANESE_INPUT
+        {
+                0, "unix-socket",
+                SkkCommandLine::OPTION_ARGUMENT_STRING,
+        },
+        {
+                0, "unix-socket-mode",
+                SkkCommandLine::OPTION_ARGUMENT_STRING,
+        },
         {
                 "v", "version",
                 SkkCommandLine::OPTION_ARGUMENT_NONE,
@@ -3630,6 +3532,9 @@ struct Option
         int log_level;
         int max_connection;
         int port;
+        int idle_timeout;
+        const char *unix_socket;
+        int unix_socket_mode;
         int server_completion_midasi_length;
         int server_completion_midasi_string_size;
         int server_completion_test;
@@ -3643,10 +3548,12 @@ struct Option
         bool google_suggest_flag;
 #endif  // YASKKSERV_CONFIG_ENABLE_GOOGLE_SUGGEST
         const char *google_cache_file;
+        int google_cache_save_interval;
 #endif  // YASKKSERV_CONFIG_ENABLE_GOOGLE_JAPANESE_INPUT
         bool no_daemonize_flag;
         bool check_update_flag;
         bool debug_flag;
+        bool io_uring_flag;
 }
 option =
 {
@@ -3654,6 +3561,9 @@ option =
         1,
         8,
         1178,
+        0,
+        0,
+        0600,
         2048,
         262144,
         1,
@@ -3667,10 +3577,12 @@ option =
         false,
 #endif  // YASKKSERV_CONFIG_ENABLE_GOOGLE_SUGGEST
         0,
+        0,
 #endif  // YASKKSERV_CONFIG_ENABLE_GOOGLE_JAPANESE_INPUT
         false,
         false,
         false,
+        false,
 };
 
 // ͤʤиƤӽФ¦ return ٤ǤΤȤ result ֤ͤޤͤξ result ˤϿޤ
@@ -3702,6 +3614,10 @@ bool local_main_core_command_line(SkkCommandLine &command_line, int &result, int
                 {
                         option.debug_flag = true;
                 }
+                if (command_line.isOptionDefined(OPTION_TABLE_IO_URING))
+                {
+                        option.io_uring_flag = true;
+                }
                 if (command_line.isOptionDefined(OPTION_TABLE_ADDRESS))
                 {
                         option.address = command_line.getOptionArgumentString(OPTION_TABLE_ADDRESS);
@@ -3719,9 +3635,33 @@ bool local_main_core_command_line(SkkCommandLine &command_line, int &result, int
                 if (command_line.isOptionDefined(OPTION_TABLE_MAX_CONNECTION))
                 {
                         option.max_connection = command_line.getOptionArgumentInteger(OPTION_TABLE_MAX_CONNECTION);
-                        if ((option.max_connection < 1) || (option.max_connection > 1024))
+                        if ((option.max_connection < 1) || (option.max_connection > 65536))
+                        {
+                                SkkUtility::printf("Illegal max-connection %d (1 - 65536)\n\n", option.max_connection);
+                                result = print_usage();
+                                return true;
+                        }
+                }
+                if (command_line.isOptionDefined(OPTION_TABLE_IDLE_TIMEOUT))
+                {
+                        option.idle_timeout = command_line.getOptionArgumentInteger(OPTION_TABLE_IDLE_TIMEOUT);
+                        if ((option.idle_timeout < 0) || (option.idle_timeout > 604800))
                         {
-                                SkkUtility::printf("Illegal max-connection %d (1 - 1024)\n\n", option.max_connection);
+                                SkkUtility::printf("Illegal idle-timeout %d (0 - 604800)\n\n", option.idle_timeout);
+                                result = print_usage();
+                                return true;
+                        }
+                }
+                if (command_line.isOptionDefined(OPTION_TABLE_UNIX_SOCKET))
+                {
+                        option.unix_socket = command_line.getOptionArgumentString(OPTION_TABLE_UNIX_SOCKET);
+                }
+                if (command_line.isOptionDefined(OPTION_TABLE_UNIX_SOCKET_MODE))
+                {
+                        const char *p = command_line.getOptionArgumentString(OPTION_TABLE_UNIX_SOCKET_MODE);
+                        if (!SkkUtility::getOctalInteger(p, option.unix_socket_mode) || (option.unix_socket_mode > 0777))
+                        {
+                                SkkUtility::printf("Illegal unix-socket-mode %s (0 - 777)\n\n", p);
                                 result = print_usage();
                                 return true;
                         }
@@ -3856,6 +3796,16 @@ bool local_main_core_command_line(SkkCommandLine &command_line, int &result, int
                 {
                         option.google_cache_file = command_line.getOptionArgumentString(OPTION_TABLE_GOOGLE_CACHE_FILE);
                 }
+                if (command_line.isOptionDefined(OPTION_TABLE_GOOGLE_CACHE_SAVE_INTERVAL))
+                {
+                        option.google_cache_save_interval = command_line.getOptionArgumentInteger(OPTION_TABLE_GOOGLE_CACHE_SAVE_INTERVAL);
+                        if ((option.google_cache_save_interval < 0) || (option.google_cache_save_interval > 86400))
+                        {
+                                SkkUtility::printf("Illegal second %d (0 - 86400)\n\n", option.google_cache_save_interval);
+                                result = print_usage();
+                                return true;
+                        }
+                }
 #endif // defined(YASKKSERV_CONFIG_HEADER_HAVE_GNUTLS_OPENSSL) || defined(YASKKSERV_CONFIG_HEADER_HAVE_OPENSSL)
 #endif  // YASKKSERV_CONFIG_ENABLE_GOOGLE_JAPANESE_INPUT
         }
@@ -4029,6 +3979,9 @@ int local_main_core(int argc, char *argv[])
                                        skk_dictionary_length,
                                        option.max_connection,
                                        listen_queue,
+                                       option.idle_timeout,
+                                       option.unix_socket,
+                                       option.unix_socket_mode,
                                        option.server_completion_midasi_length,
                                        option.server_completion_midasi_string_size,
                                        option.server_completion_test,
@@ -4039,12 +3992,14 @@ int local_main_core(int argc, char *argv[])
                                        option.check_update_flag,
                                        option.no_daemonize_flag,
                                        option.use_http_flag,
-                                       option.use_ipv6_flag);
+                                       option.use_ipv6_flag,
+                                       option.io_uring_flag);
 #ifdef YASKKSERV_CONFIG_ENABLE_GOOGLE_JAPANESE_INPUT
                 skk_server->setGoogleJapaneseInputParameter(option.google_japanese_input_type, option.google_japanese_input_timeout);
 #ifdef YASKKSERV_CONFIG_ENABLE_GOOGLE_SUGGEST
                 skk_server->setGoogleSuggestParameter(option.google_suggest_flag);
 #endif  // YASKKSERV_CONFIG_ENABLE_GOOGLE_SUGGEST
+                skk_server->setGoogleCacheSaveInterval(option.google_cache_save_interval);
 #endif  // YASKKSERV_CONFIG_ENABLE_GOOGLE_JAPANESE_INPUT
                 if (!skk_server->mainLoop())
                 {
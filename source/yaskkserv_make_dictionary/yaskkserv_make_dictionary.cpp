@@ -28,6 +28,12 @@ namespace YaSkkServ
 {
 namespace
 {
+enum
+{
+// --analyze  read() 1 ΥȤ 1 ڡɤΤƱȤߤʤޤ
+        READ_COST_SIZE = 4096
+};
+
 void print_debug_information(const char *destination)
 {
         SkkUtility::printf("DICTIONARY INFORMATION\n");
@@ -45,10 +51,10 @@ void print_debug_information(const char *destination)
                         {
                                 "ID_BIT_FLAG",
 
-                                "ID_RESERVE_1",
-                                "ID_RESERVE_2",
-                                "ID_RESERVE_3",
-                                "ID_RESERVE_4",
+                                "ID_EXTENSION_DATA_OFFSET",
+                                "ID_EXTENSION_DATA_SIZE",
+                                "ID_TRIE_DATA_OFFSET",
+                                "ID_TRIE_DATA_SIZE",
                                 "ID_RESERVE_5",
 
                                 "ID_INDEX_DATA_OFFSET",
@@ -96,16 +102,353 @@ void print_debug_information(const char *destination)
                                            index_data_header.get(static_cast<SkkJisyo::IndexDataHeader::Id>(i)));
                 }
         }
+
+        SkkUtility::printf("EXTENSION DATA HEADER\n");
+
+        SkkJisyo::ExtensionDataHeader extension_data_header;
+        if (!SkkJisyo::getExtensionDataHeader(destination, extension_data_header))
+        {
+                DEBUG_PRINTF("getExtensionDataHeader() failed \n");
+        }
+        else
+        {
+                const char * const table[] =
+                {
+                        "ID_BIT_FLAG",
+
+                        "ID_SIZE",
+                        "ID_KEY_PREFIX_OFFSET",
+                        "ID_KEY_PREFIX_SIZE",
+                        "ID_KEY_OFFSET_OFFSET",
+                        "ID_KEY_OFFSET_SIZE",
+                        "ID_DISPATCH_OFFSET",
+                        "ID_DISPATCH_SIZE",
+                        "ID_SPECIAL_ARRAY_OFFSET",
+                        "ID_SPECIAL_ARRAY_SIZE",
+                        "ID_BLOOM_FILTER_OFFSET",
+                        "ID_BLOOM_FILTER_SIZE",
+                        "ID_BLOOM_FILTER_HASH_LENGTH",
+                        "ID_PERFECT_HASH_PILOT_OFFSET",
+                        "ID_PERFECT_HASH_PILOT_SIZE",
+                        "ID_PERFECT_HASH_TABLE_OFFSET",
+                        "ID_PERFECT_HASH_TABLE_SIZE",
+                        "ID_SUB_BLOCK_INDEX_OFFSET",
+                        "ID_SUB_BLOCK_INDEX_SIZE",
+                        "ID_SUB_BLOCK_OFFSET",
+                        "ID_SUB_BLOCK_SIZE",
+                        "ID_SUB_BLOCK_STRING_OFFSET",
+                        "ID_SUB_BLOCK_STRING_SIZE",
+                };
+                for (int i = 0; i != static_cast<int>(sizeof(table) / sizeof(table[0])); ++i)
+                {
+                        SkkUtility::printf("id = %s  v = %d\n",
+                                           table[i],
+                                           extension_data_header.get(static_cast<SkkJisyo::ExtensionDataHeader::Id>(i)));
+                }
+        }
+}
+
+double get_time()
+{
+        struct timeval tv;
+        gettimeofday(&tv, 0);
+        return static_cast<double>(tv.tv_sec) + static_cast<double>(tv.tv_usec) / (1000.0 * 1000.0);
+}
+
+/// buffer γƹԤκǽθָФפȤƥڡǽü key سǼޤ ';' ǻϤޤԤȶԤ̵뤷ޤ
+/**
+ * SKK ȡ 1 Ԥ 1 ĤθФ񤤤䤤碌Τɤ
+ * ޤ key  key_offset ϸƤӽФ¦ delete[] ɬפ
+ * 
+ */
+bool get_key(const char *buffer, int filesize, char *&key, int *&key_offset, int &key_length)
+{
+        key_length = 0;
+        for (int index = 0; index >= 0; index = SkkUtility::getNextLineIndex(buffer, index, filesize))
+        {
+                if ((*(buffer + index) != ';') && (*(buffer + index) != '\n') && (*(buffer + index) != ' '))
+                {
+                        ++key_length;
+                }
+        }
+        if (key_length == 0)
+        {
+                return false;
+        }
+
+        const int terminator_size = 1;
+        key = new char[filesize + terminator_size];
+        key_offset = new int[key_length];
+        int i = 0;
+        int size = 0;
+        for (int index = 0; index >= 0; index = SkkUtility::getNextLineIndex(buffer, index, filesize))
+        {
+                if ((*(buffer + index) != ';') && (*(buffer + index) != '\n') && (*(buffer + index) != ' '))
+                {
+                        *(key_offset + i) = size;
+                        for (int n = index; (n < filesize) && (*(buffer + n) != ' ') && (*(buffer + n) != '\n'); ++n)
+                        {
+                                *(key + size) = *(buffer + n);
+                                ++size;
+                        }
+                        *(key + size) = ' ';
+                        ++size;
+                        ++i;
+                }
+        }
+        return true;
+}
+
+/// key_offset ¤Ӥμˤ뵼¤ؤޤ
+void shuffle_key(int *key_offset, int key_length)
+{
+        uint32_t seed = 1;
+        for (int i = key_length - 1; i > 0; --i)
+        {
+                seed = seed * 1103515245 + 12345;
+                int j = static_cast<int>((seed >> 8) % static_cast<uint32_t>(i + 1));
+                int tmp = *(key_offset + i);
+                *(key_offset + i) = *(key_offset + j);
+                *(key_offset + j) = tmp;
+        }
+}
+
+///  filename  key  loop 䤤碌ޤԤϵ֤ޤ
+/**
+ * index_memory ˤϥǥåǡȳĥǡɤ߹ߥХåե
+ * 碌̤ read_size, read_count  time ˤ 1 䤤
+ * 碌ɤ߹ߥХȿ read() βȻ (ʥ) 
+ * ޤ cost ˤϤ٤Ƥ䤤碌ɤ߹ߥХȿˡ read()
+ * 1  READ_COST_SIZE ХȤȤƲäΤ֤ޤ
+ */
+bool replay(const char *filename,
+            int block_size,
+            const char *key,
+            const int *key_offset,
+            int key_length,
+            int loop,
+            int &index_memory,
+            double &read_size,
+            double &read_count,
+            double &time,
+            int64_t &cost)
+{
+        SkkJisyo::Information information;
+        if (!SkkJisyo::getInformation(filename, information))
+        {
+                return false;
+        }
+        index_memory = information.get(SkkJisyo::Information::ID_INDEX_DATA_SIZE) +
+                information.get(SkkJisyo::Information::ID_EXTENSION_DATA_SIZE) +
+                block_size;
+
+        SkkDictionary dictionary;
+        if (!dictionary.open(filename))
+        {
+                return false;
+        }
+        double time_start = get_time();
+        for (int n = 0; n != loop; ++n)
+        {
+                for (int i = 0; i != key_length; ++i)
+                {
+                        dictionary.search(key + *(key_offset + i));
+                }
+        }
+        time = get_time() - time_start;
+        int64_t count;
+        int64_t byte_size;
+        dictionary.getReadStatistics(count, byte_size);
+        const double lookup = static_cast<double>(key_length) * static_cast<double>(loop);
+        read_size = static_cast<double>(byte_size) / lookup;
+        read_count = static_cast<double>(count) / lookup;
+        cost = byte_size + count * READ_COST_SIZE;
+        time = time * 1000.0 * 1000.0 * 1000.0 / lookup;
+        return true;
+}
+
+/// ֥åΥ쥤ȤθǤ
+struct Layout
+{
+        int block_size;
+        bool alignment_flag;
+        int sub_block_size;
+};
+
+/// 쥤Ȥθ䤴Ȥ˼䤤碌 memory_budget ǺǤ⥳Ȥξ쥤Ȥ filename_destination ޤ
+/**
+ * Ȥ replay()  cost ǡȤХǥåΥ
+ * ̤ΤӤޤɤ䤤碌κޤΤǡ
+ * ƱʤоƱ쥤ȤӤޤ֤ϻͤȤɽ
+ * Ǥ
+ *
+ * filename_query_log  0 ʤ SKK Τ٤ƤθФ򵼻
+ * ν䤤碌ޤ memory_budget  0 ʤХ̤¤
+ * 󡣥饤Ȥ --short-block ꤷΤȤƺ
+ * 뤿ᡢ֥å int16_t ˼ޤ˸¤ޤ
+ */
+int analyze(const char *filename_source,
+            const char *filename_destination,
+            const char *filename_query_log,
+            int memory_budget,
+            int loop,
+            bool dispatch_flag,
+            bool perfect_hash_flag,
+            bool reply_record_flag)
+{
+        SkkMmap mmap;
+        const char *filename_key = filename_query_log ? filename_query_log : filename_source;
+        const char *buffer = static_cast<const char*>(mmap.map(filename_key));
+        char *key = 0;
+        int *key_offset = 0;
+        int key_length = 0;
+        if ((buffer == 0) || !get_key(buffer, mmap.getFilesize(), key, key_offset, key_length))
+        {
+                SkkUtility::printf("%s: no entry\n", filename_key);
+                return EXIT_FAILURE;
+        }
+        if (filename_query_log == 0)
+        {
+                shuffle_key(key_offset, key_length);
+        }
+
+        char tmp_filename[] = "/tmp/skkdictionary.XXXXXX";
+        int tmp_fd = mkstemp(tmp_filename);
+        if (tmp_fd == -1)
+        {
+                delete[] key_offset;
+                delete[] key;
+                return EXIT_FAILURE;
+        }
+        ::close(tmp_fd);
+
+        const Layout layout_table[] =
+        {
+                { 1024, false, 0, }, { 1024, false, 512, }, { 1024, true, 0, }, { 1024, true, 512, },
+                { 2048, false, 0, }, { 2048, false, 512, }, { 2048, true, 0, }, { 2048, true, 512, },
+                { 4096, false, 0, }, { 4096, false, 512, }, { 4096, true, 0, }, { 4096, true, 512, },
+                { 8192, false, 0, }, { 8192, false, 512, }, { 8192, true, 0, }, { 8192, true, 512, },
+                { 16384, false, 0, }, { 16384, false, 512, }, { 16384, true, 0, }, { 16384, true, 512, },
+                { 32768, false, 0, }, { 32768, false, 512, },
+                { 65536, false, 0, }, { 65536, false, 512, },
+        };
+        const int layout_length = static_cast<int>(sizeof(layout_table) / sizeof(layout_table[0]));
+        int best = -1;
+        int64_t best_cost = 0;
+        int best_index_memory = 0;
+        SkkUtility::printf("%d queries x %d loop\n"
+                           "     block  align  sub-block  index memory  bytes/lookup  reads/lookup   cost/lookup   ns/lookup\n",
+                           key_length,
+                           loop);
+        for (int i = 0; i != layout_length; ++i)
+        {
+                const Layout *layout = layout_table + i;
+                int index_memory = 0;
+                double read_size = 0.0;
+                double read_count = 0.0;
+                double time = 0.0;
+                int64_t cost = 0;
+                if (!SkkJisyo::createDictionaryForClassSkkDictionary(filename_source,
+                                                                     tmp_filename,
+                                                                     layout->block_size,
+                                                                     layout->alignment_flag,
+                                                                     layout->alignment_flag,
+                                                                     dispatch_flag,
+                                                                     perfect_hash_flag,
+                                                                     reply_record_flag,
+                                                                     layout->sub_block_size) ||
+                    !replay(tmp_filename,
+                            layout->block_size,
+                            key,
+                            key_offset,
+                            key_length,
+                            loop,
+                            index_memory,
+                            read_size,
+                            read_count,
+                            time,
+                            cost))
+                {
+// ǥå礭᤮롢ޤϾ᤮뼭ϳʤΤǸ䤫
+// ޤ
+                        SkkUtility::printf("    %6d  %5s  %9d  failed\n",
+                                           layout->block_size,
+                                           layout->alignment_flag ? "yes" : "no",
+                                           layout->sub_block_size);
+                        continue;
+                }
+                bool in_budget = (memory_budget == 0) || (index_memory <= memory_budget);
+                SkkUtility::printf("    %6d  %5s  %9d  %12d  %12.1f  %12.3f  %12.1f  %10.1f%s\n",
+                                   layout->block_size,
+                                   layout->alignment_flag ? "yes" : "no",
+                                   layout->sub_block_size,
+                                   index_memory,
+                                   read_size,
+                                   read_count,
+                                   static_cast<double>(cost) / (static_cast<double>(key_length) * static_cast<double>(loop)),
+                                   time,
+                                   in_budget ? "" : "  (over budget)");
+                if (in_budget &&
+                    ((best < 0) ||
+                     (cost < best_cost) ||
+                     ((cost == best_cost) && (index_memory < best_index_memory))))
+                {
+                        best = i;
+                        best_cost = cost;
+                        best_index_memory = index_memory;
+                }
+        }
+        unlink(tmp_filename);
+        delete[] key_offset;
+        delete[] key;
+
+        if (best < 0)
+        {
+                SkkUtility::printf("no layout fits in the memory budget\n");
+                return EXIT_FAILURE;
+        }
+        const Layout *layout = layout_table + best;
+        SkkUtility::printf("selected: --block-size=%d%s",
+                           layout->block_size,
+                           layout->alignment_flag ? " --alignment --short-block" : "");
+        if (layout->sub_block_size > 0)
+        {
+                SkkUtility::printf(" --sub-block-size=%d", layout->sub_block_size);
+        }
+        SkkUtility::printf("\n");
+        if (!SkkJisyo::createDictionaryForClassSkkDictionary(filename_source,
+                                                             filename_destination,
+                                                             layout->block_size,
+                                                             layout->alignment_flag,
+                                                             layout->alignment_flag,
+                                                             dispatch_flag,
+                                                             perfect_hash_flag,
+                                                             reply_record_flag,
+                                                             layout->sub_block_size))
+        {
+                SkkUtility::printf("createDictionary() failed\n");
+                return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
 }
 
 int print_usage()
 {
         SkkUtility::printf("Usage: yaskkserv_make_dictionary [OPTION] skk-dictionary output-dictionary\n"
                            "  -a, --alignment          enable alignment (default disable)\n"
+                           "  -z, --analyze            compare block layouts and use the cheapest one\n"
                            "  -b, --block-size=SIZE    set block size (default 8192)\n"
+                           "  -c, --candidate-pool     share candidate strings (must set --trie) (default disable)\n"
                            "  -d, --debug              print debug information\n"
+                           "  -t, --dispatch-table     enable two-character dispatch table (default disable)\n"
                            "  -h, --help               print this help and exit\n"
-                           "  -s, --short-block        enable short block (must set --alignment) (default disable)\n"
+                           "  -m, --memory-budget=SIZE  limit index memory for --analyze (default unlimited)\n"
+                           "  -p, --perfect-hash       enable minimal perfect hash (default disable)\n"
+                           "  -q, --query-log=FILE     replay queries (one midasi per line) for --analyze\n"
+                           "  -e, --reply-record       store entries as ready-to-send replies (default disable)\n"
+                           "  -r, --trie               use double-array trie instead of block index (default disable)\n"
+                           "  -s, --short-block        enable short block (must set --alignment, block size < 32768) (default disable)\n"
+                           "  -u, --sub-block-size=SIZE  set sub-block index interval (64 - block size) (default disable)\n"
                            "  -v, --version            print version\n");
         return -1;
 }
@@ -124,10 +467,19 @@ int local_main(int argc, char *argv[])
         enum
         {
                 OPTION_TABLE_ALIGNMENT,
+                OPTION_TABLE_ANALYZE,
                 OPTION_TABLE_BLOCK_SIZE,
+                OPTION_TABLE_CANDIDATE_POOL,
                 OPTION_TABLE_DEBUG,
+                OPTION_TABLE_DISPATCH_TABLE,
                 OPTION_TABLE_HELP,
+                OPTION_TABLE_MEMORY_BUDGET,
+                OPTION_TABLE_PERFECT_HASH,
+                OPTION_TABLE_QUERY_LOG,
+                OPTION_TABLE_REPLY_RECORD,
+                OPTION_TABLE_TRIE,
                 OPTION_TABLE_SHORT_BLOCK,
+                OPTION_TABLE_SUB_BLOCK_SIZE,
                 OPTION_TABLE_VERSION,
 
                 OPTION_TABLE_LENGTH
@@ -139,22 +491,58 @@ int local_main(int argc, char *argv[])
                         "a", "alignment",
                         SkkCommandLine::OPTION_ARGUMENT_NONE,
                 },
+                {
+                        "z", "analyze",
+                        SkkCommandLine::OPTION_ARGUMENT_NONE,
+                },
                 {
                         "b", "block-size",
                         SkkCommandLine::OPTION_ARGUMENT_INTEGER,
                 },
+                {
+                        "c", "candidate-pool",
+                        SkkCommandLine::OPTION_ARGUMENT_NONE,
+                },
                 {
                         "d", "debug",
                         SkkCommandLine::OPTION_ARGUMENT_NONE,
                 },
+                {
+                        "t", "dispatch-table",
+                        SkkCommandLine::OPTION_ARGUMENT_NONE,
+                },
                 {
                         "h", "help",
                         SkkCommandLine::OPTION_ARGUMENT_NONE,
                 },
+                {
+                        "m", "memory-budget",
+                        SkkCommandLine::OPTION_ARGUMENT_INTEGER,
+                },
+                {
+                        "p", "perfect-hash",
+                        SkkCommandLine::OPTION_ARGUMENT_NONE,
+                },
+                {
+                        "q", "query-log",
+                        SkkCommandLine::OPTION_ARGUMENT_STRING,
+                },
+                {
+                        "e", "reply-record",
+                        SkkCommandLine::OPTION_ARGUMENT_NONE,
+                },
+                {
+                        "r", "trie",
+                        SkkCommandLine::OPTION_ARGUMENT_NONE,
+                },
                 {
                         "s", "short-block",
                         SkkCommandLine::OPTION_ARGUMENT_NONE,
                 },
+                {
+                        "u", "sub-block-size",
+                        SkkCommandLine::OPTION_ARGUMENT_INTEGER,
+                },
                 {
                         "v", "version",
                         SkkCommandLine::OPTION_ARGUMENT_NONE,
@@ -168,13 +556,31 @@ int local_main(int argc, char *argv[])
         struct Option
         {
                 int block_size;
+                int sub_block_size;
+                int memory_budget;
+                const char *query_log;
                 bool alignment_flag;
+                bool analyze_flag;
                 bool block_short_flag;
+                bool candidate_pool_flag;
                 bool debug_flag;
+                bool dispatch_flag;
+                bool perfect_hash_flag;
+                bool reply_record_flag;
+                bool trie_flag;
         }
         option =
         {
                 8 * 1024,
+                0,
+                0,
+                0,
+                false,
+                false,
+                false,
+                false,
+                false,
+                false,
                 false,
                 false,
                 false,
@@ -205,13 +611,33 @@ int local_main(int argc, char *argv[])
                         {
                                 option.alignment_flag = true;
                         }
+                        if (command_line.isOptionDefined(OPTION_TABLE_ANALYZE))
+                        {
+                                option.analyze_flag = true;
+                        }
+                        if (command_line.isOptionDefined(OPTION_TABLE_MEMORY_BUDGET))
+                        {
+                                option.memory_budget = command_line.getOptionArgumentInteger(OPTION_TABLE_MEMORY_BUDGET);
+                                if (!option.analyze_flag || (option.memory_budget <= 0))
+                                {
+                                        return print_usage();
+                                }
+                        }
+                        if (command_line.isOptionDefined(OPTION_TABLE_QUERY_LOG))
+                        {
+                                if (!option.analyze_flag)
+                                {
+                                        return print_usage();
+                                }
+                                option.query_log = command_line.getOptionArgumentString(OPTION_TABLE_QUERY_LOG);
+                        }
                         if (command_line.isOptionDefined(OPTION_TABLE_BLOCK_SIZE))
                         {
                                 option.block_size = command_line.getOptionArgumentInteger(OPTION_TABLE_BLOCK_SIZE);
                         }
                         if (command_line.isOptionDefined(OPTION_TABLE_SHORT_BLOCK))
                         {
-                                if (!option.alignment_flag)
+                                if (!option.alignment_flag || (option.block_size > 0x7fff))
                                 {
                                         return print_usage();
                                 }
@@ -221,6 +647,43 @@ int local_main(int argc, char *argv[])
                         {
                                 option.debug_flag = true;
                         }
+                        if (command_line.isOptionDefined(OPTION_TABLE_DISPATCH_TABLE))
+                        {
+                                option.dispatch_flag = true;
+                        }
+                        if (command_line.isOptionDefined(OPTION_TABLE_PERFECT_HASH))
+                        {
+                                option.perfect_hash_flag = true;
+                        }
+                        if (command_line.isOptionDefined(OPTION_TABLE_REPLY_RECORD))
+                        {
+                                option.reply_record_flag = true;
+                        }
+                        if (command_line.isOptionDefined(OPTION_TABLE_TRIE))
+                        {
+                                if (option.analyze_flag)
+                                {
+                                        return print_usage();
+                                }
+                                option.trie_flag = true;
+                        }
+                        if (command_line.isOptionDefined(OPTION_TABLE_CANDIDATE_POOL))
+                        {
+                                if (!option.trie_flag)
+                                {
+                                        return print_usage();
+                                }
+                                option.candidate_pool_flag = true;
+                        }
+                        if (command_line.isOptionDefined(OPTION_TABLE_SUB_BLOCK_SIZE))
+                        {
+                                option.sub_block_size = command_line.getOptionArgumentInteger(OPTION_TABLE_SUB_BLOCK_SIZE);
+                                if ((option.sub_block_size < SkkJisyo::SUB_BLOCK_SIZE_MINIMUM) ||
+                                    (option.sub_block_size > option.block_size))
+                                {
+                                        return print_usage();
+                                }
+                        }
                 }
                 else
                 {
@@ -230,13 +693,46 @@ int local_main(int argc, char *argv[])
                 }
         }
 
-        if (!SkkJisyo::createDictionaryForClassSkkDictionary(filename_input_skk_jisyo,
-                                                             filename_output_dictionary,
-                                                             option.block_size,
-                                                             option.alignment_flag,
-                                                             option.block_short_flag))
+        if (option.analyze_flag)
         {
-                SkkUtility::printf("createDictionary() failed\n");
+                const int loop = 3;
+                int result = analyze(filename_input_skk_jisyo,
+                                     filename_output_dictionary,
+                                     option.query_log,
+                                     option.memory_budget,
+                                     loop,
+                                     option.dispatch_flag,
+                                     option.perfect_hash_flag,
+                                     option.reply_record_flag);
+                if (result != EXIT_SUCCESS)
+                {
+                        return result;
+                }
+        }
+        else if (option.trie_flag)
+        {
+                if (!SkkJisyo::createDictionaryForClassSkkTrie(filename_input_skk_jisyo,
+                                                               filename_output_dictionary,
+                                                               option.candidate_pool_flag,
+                                                               option.reply_record_flag))
+                {
+                        SkkUtility::printf("createDictionary() failed\n");
+                }
+        }
+        else
+        {
+                if (!SkkJisyo::createDictionaryForClassSkkDictionary(filename_input_skk_jisyo,
+                                                                     filename_output_dictionary,
+                                                                     option.block_size,
+                                                                     option.alignment_flag,
+                                                                     option.block_short_flag,
+                                                                     option.dispatch_flag,
+                                                                     option.perfect_hash_flag,
+                                                                     option.reply_record_flag,
+                                                                     option.sub_block_size))
+                {
+                        SkkUtility::printf("createDictionary() failed\n");
+                }
         }
 
         if (option.debug_flag)
@@ -17,6 +17,7 @@
  */
 
 #include "skk_dictionary.hpp"
+#include "skk_lookup.hpp"
 #include "skk_server.hpp"
 #include "skk_utility.hpp"
 #include "skk_command_line.hpp"
@@ -49,9 +50,11 @@ public:
                 skk_dictionary_length_(0),
                 max_connection_(0),
                 listen_queue_(0),
+                worker_length_(0),
 
                 dictionary_check_update_flag_(false),
-                no_daemonize_flag_(false)
+                no_daemonize_flag_(false),
+                io_uring_flag_(false)
         {
         }
 
@@ -60,8 +63,13 @@ public:
                         int skk_dictionary_length,
                         int max_connection,
                         int listen_queue,
+                        int idle_timeout,
+                        const char *unix_socket_path,
+                        int unix_socket_mode,
+                        int worker_length,
                         bool dictionary_check_update_flag,
-                        bool no_daemonize_flag)
+                        bool no_daemonize_flag,
+                        bool io_uring_flag)
         {
                 skk_dictionary_ = skk_dictionary;
                 dictionary_filename_table_ = dictionary_filename_table;
@@ -69,9 +77,13 @@ public:
                 skk_dictionary_length_ = skk_dictionary_length;
                 max_connection_ = max_connection;
                 listen_queue_ = listen_queue;
+                main_loop_set_idle_timeout(idle_timeout);
+                main_loop_set_unix_socket(unix_socket_path, unix_socket_mode);
+                worker_length_ = worker_length;
 
                 dictionary_check_update_flag_ = dictionary_check_update_flag;
                 no_daemonize_flag_ = no_daemonize_flag;
+                io_uring_flag_ = io_uring_flag;
         }
 
         bool mainLoop()
@@ -97,6 +109,19 @@ public:
                                 printFirstSyslog();
                         }
 #endif  // YASKKSERV_DEBUG
+                        if (worker_length_ > 0)
+                        {
+// ƥץϻҥץƻ뤷λؼƤޤ
+                                bool parent_flag;
+                                if (!main_loop_prefork(worker_length_, parent_flag))
+                                {
+                                        return false;
+                                }
+                                if (parent_flag)
+                                {
+                                        return main_loop_finalize();
+                                }
+                        }
                         result = local_main_loop();
                         if (result)
                         {
@@ -108,14 +133,9 @@ public:
 
 private:
         bool local_main_loop();
+        void main_loop_process(int work_index, int recv_result);
         bool local_main_loop_1_search_single_dictionary(int work_index);
-        void main_loop_get_plural_dictionary_information(int work_index,
-                                                         SkkDictionary *skk_dictionary,
-                                                         int skk_dictionary_length,
-                                                         int &found_times,
-                                                         int &candidate_length,
-                                                         int &total_henkanmojiretsu_size);
-        bool local_main_loop_1_search_plural_dictionary(int work_index, int candidate_length, int total_henkanmojiretsu_size);
+        bool local_main_loop_1_search_plural_dictionary(int work_index, SkkLookup &lookup);
         bool local_main_loop_1_search(int work_index);
 /// ХåեꥻåȤ٤ʤп֤ޤ
         bool local_main_loop_1(int work_index, int recv_result);
@@ -127,9 +147,11 @@ private:
         int skk_dictionary_length_;
         int max_connection_;
         int listen_queue_;
+        int worker_length_;
 
         bool dictionary_check_update_flag_;
         bool no_daemonize_flag_;
+        bool io_uring_flag_;
 };
 
 bool LocalSkkServer::local_main_loop_1_search_single_dictionary(int work_index)
@@ -145,43 +167,13 @@ bool LocalSkkServer::local_main_loop_1_search_single_dictionary(int work_index)
         }
 }
 
-void LocalSkkServer::main_loop_get_plural_dictionary_information(int work_index,
-                                                                 SkkDictionary *skk_dictionary,
-                                                                 int skk_dictionary_length,
-                                                                 int &found_times,
-                                                                 int &candidate_length,
-                                                                 int &total_henkanmojiretsu_size)
-{
-        found_times = 0;
-        candidate_length = 0;
-        total_henkanmojiretsu_size = 0;
-        for (int h = 0; h != skk_dictionary_length; ++h)
-        {
-                if ((skk_dictionary + h)->search((work_ + work_index)->read_buffer + 1))
-                {
-                        const int cr_size = 1;
-                        total_henkanmojiretsu_size += (skk_dictionary + h)->getHenkanmojiretsuSize() + cr_size;
-                        candidate_length += SkkUtility::getCandidateLength((skk_dictionary + h)->getHenkanmojiretsuPointer());
-                        ++found_times;
-                }
-        }
-}
-
-bool LocalSkkServer::local_main_loop_1_search_plural_dictionary(int work_index, int candidate_length, int total_henkanmojiretsu_size)
+bool LocalSkkServer::local_main_loop_1_search_plural_dictionary(int work_index, SkkLookup &lookup)
 {
-// candidate_length Ŭ hash_table_length Ѵޤ
-        int hash_table_length = SkkUtility::Hash<SkkUtility::HASH_TYPE_CANDIDATE>::getPrimeHashTableLength(candidate_length);
-        if (hash_table_length == 0)
-        {
-                return false;
-        }
-
 // դäʣμ candidate ʬ򡢹ޤ
 
-// ʸ string ɲäޤʣå hash Ǥʤޤ
 // Ѵʸ󥵥˥ޡäΤ temporary_buffer_size Ȥ
 // ޤ
-        int temporary_buffer_size = total_henkanmojiretsu_size;
+        int temporary_buffer_size = lookup.getTotalHenkanmojiretsuSize();
         {
                 const int protocol_header_margin_size = 8;
                 const int terminator_size = 1;
@@ -192,46 +184,20 @@ bool LocalSkkServer::local_main_loop_1_search_plural_dictionary(int work_index,
         }
 
         SkkSimpleString string(temporary_buffer_size);
-        SkkUtility::Hash<SkkUtility::HASH_TYPE_CANDIDATE> hash(hash_table_length);
 
-// protocol header + first slash
-        string.appendFast("1/");
+// protocol header
+        string.appendFast('1');
 
-        for (int h = 0; h != skk_dictionary_length_; ++h)
+        if (!lookup.appendMergedHenkanmojiretsu(string))
         {
-                if ((skk_dictionary_ + h)->isSuccess())
-                {
-                        char *p = const_cast<char*>((skk_dictionary_ + h)->getHenkanmojiretsuPointer());
-                        int length = SkkUtility::getCandidateLength(p);
-                        for (int g = 0; g != length; ++g)
-                        {
-                                const char *start;
-                                int size;
-                                if (SkkUtility::getCandidateInformation(p, g, start, size))
-                                {
-                                        if (!hash.contain(start, size))
-                                        {
-                                                hash.add(start, size);
-                                                const int tail_slash_size = 1;
-                                                if (!string.append(start, size + tail_slash_size))
-                                                {
-                                                        return false;
-                                                }
-                                        }
-                                }
-                                else
-                                {
-                                        return false;
-                                }
-                        }
-                }
+                return false;
         }
 
         string.append('\n');
 
         if (!send((work_ + work_index)->file_descriptor, string.getBuffer(), string.getSize()))
         {
-                (work_ + work_index)->closeAndReset();
+                main_loop_close(work_index);
         }
         return true;
 }
@@ -256,15 +222,8 @@ bool LocalSkkServer::local_main_loop_1_search(int work_index)
         }
 
 // ꤵ줿ʣ
-        int found_times;
-        int candidate_length;
-        int total_henkanmojiretsu_size;
-        main_loop_get_plural_dictionary_information(work_index,
-                                                    skk_dictionary_,
-                                                    skk_dictionary_length_,
-                                                    found_times,
-                                                    candidate_length,
-                                                    total_henkanmojiretsu_size);
+        SkkLookup lookup(skk_dictionary_, skk_dictionary_length_);
+        int found_times = lookup.search((work_ + work_index)->read_buffer + 1);
         if (found_times == 0)
         {
 // դʤä
@@ -274,20 +233,12 @@ bool LocalSkkServer::local_main_loop_1_search(int work_index)
         if (found_times == 1)
         {
 // ȥ꤬ 1 ĤμǤդʤä
-                for (int h = 0; h != skk_dictionary_length_; ++h)
-                {
-                        if ((skk_dictionary_ + h)->isSuccess())
-                        {
-                                main_loop_send_found(work_index,
-                                                     skk_dictionary_ + h);
-                        }
-                }
-
+                main_loop_send_found(work_index, lookup.getFoundDictionary());
                 return true;
         }
  
 // ȥ꤬ʣμǸդä
-        return local_main_loop_1_search_plural_dictionary(work_index, candidate_length, total_henkanmojiretsu_size);
+        return local_main_loop_1_search_plural_dictionary(work_index, lookup);
 }
 
 bool LocalSkkServer::local_main_loop_1(int work_index, int recv_result)
@@ -300,6 +251,7 @@ bool LocalSkkServer::local_main_loop_1(int work_index, int recv_result)
                 if (!illegal_protocol_flag)
                 {
                         found_flag = local_main_loop_1_search(work_index);
+                        main_loop_count_request(found_flag);
                 }
 
                 if (!found_flag)
@@ -310,14 +262,67 @@ bool LocalSkkServer::local_main_loop_1(int work_index, int recv_result)
         return result;
 }
 
+void LocalSkkServer::main_loop_process(int work_index, int recv_result)
+{
+        bool buffer_reset_flag;
+        if ((work_ + work_index)->read_process_index == 0)
+        {
+                switch (*(work_ + work_index)->read_buffer)
+                {
+                default:
+                        buffer_reset_flag = true;
+                        main_loop_illegal_command(work_index);
+                        break;
+                case '0':
+                        buffer_reset_flag = true;
+                        main_loop_0(work_index);
+                        break;
+                case '1':
+                        buffer_reset_flag = local_main_loop_1(work_index, recv_result);
+                        break;
+                case '2':
+                        buffer_reset_flag = true;
+                        main_loop_2(work_index, version_string, sizeof(version_string));
+                        break;
+                case '3':
+                        buffer_reset_flag = true;
+                        main_loop_3(work_index);
+                        break;
+                case 'R':
+                        buffer_reset_flag = true;
+                        main_loop_shared_ring(work_index);
+                        break;
+                }
+        }
+        else
+        {
+                buffer_reset_flag = local_main_loop_1(work_index, recv_result);
+        }
+
+        main_loop_check_buffer_reset(work_index, recv_result, buffer_reset_flag);
+}
+
 bool LocalSkkServer::local_main_loop()
 {
         bool result = true;
+        main_loop_initialize_reload_dictionary(skk_dictionary_length_, dictionary_filename_table_, dictionary_check_update_flag_);
+        if (io_uring_flag_ && !main_loop_initialize_io_uring())
+        {
+                syslog_.printf(1, SkkSyslog::LEVEL_WARNING, "io_uring is not available (select() is used)");
+        }
         for (;;)
         {
                 fd_set fd_set_read;
-                int select_result = main_loop_select(fd_set_read);
-                main_loop_check_reload_dictionary(skk_dictionary_, skk_dictionary_length_, dictionary_filename_table_, dictionary_check_update_flag_);
+                int select_result;
+                if (main_loop_is_io_uring())
+                {
+                        select_result = main_loop_io_uring(fd_set_read, 0, 0, 0);
+                }
+                else
+                {
+                        select_result = main_loop_select(fd_set_read);
+                }
+                main_loop_check_reload_dictionary(skk_dictionary_, skk_dictionary_length_, dictionary_filename_table_, fd_set_read);
                 if (select_result == -1)
                 {
                         if (errno == EINTR)
@@ -325,11 +330,21 @@ bool LocalSkkServer::local_main_loop()
                                 continue;
                         }
                 }
+                if (main_loop_is_io_uring())
+                {
+// io_uring Ǥ accept ȼ׵ν main_loop_io_uring() 
+// ѤޤƤޤ
+                        if (select_result == -1)
+                        {
+                                goto ERROR_BREAK;
+                        }
+                        continue;
+                }
                 if (!main_loop_accept(fd_set_read, select_result))
                 {
                         goto ERROR_BREAK;
                 }
-                for (int i = 0; i != max_connection_; ++i)
+                for (int i = 0; i != work_length_; ++i)
                 {
                         if (main_loop_is_recv(i, fd_set_read))
                         {
@@ -344,38 +359,7 @@ bool LocalSkkServer::local_main_loop()
                                 }
                                 else
                                 {
-                                        bool buffer_reset_flag;
-                                        if ((work_ + i)->read_process_index == 0)
-                                        {
-                                                switch (*(work_ + i)->read_buffer)
-                                                {
-                                                default:
-                                                        buffer_reset_flag = true;
-                                                        main_loop_illegal_command(i);
-                                                        break;
-                                                case '0':
-                                                        buffer_reset_flag = true;
-                                                        main_loop_0(i);
-                                                        break;
-                                                case '1':
-                                                        buffer_reset_flag = local_main_loop_1(i, recv_result);
-                                                        break;
-                                                case '2':
-                                                        buffer_reset_flag = true;
-                                                        main_loop_2(i, version_string, sizeof(version_string));
-                                                        break;
-                                                case '3':
-                                                        buffer_reset_flag = true;
-                                                        main_loop_3(i);
-                                                        break;
-                                                }
-                                        }
-                                        else
-                                        {
-                                                buffer_reset_flag = local_main_loop_1(i, recv_result);
-                                        }
-
-                                        main_loop_check_buffer_reset(i, recv_result, buffer_reset_flag);
+                                        main_loop_process(i, recv_result);
                                 }
                         }
                 }
@@ -394,11 +378,18 @@ int print_usage()
                            "  -c, --check-update       check update dictionary (default disable)\n"
                            "  -d, --debug              enable debug mode (default disable)\n"
                            "  -h, --help               print this help and exit\n"
+                           "      --idle-timeout=SECOND\n"
+                           "                           close connection idle for SECOND (range [0 - 604800]  default 0(disable))\n"
+                           "      --io-uring           use io_uring instead of select() (default disable)\n"
                            "  -l, --log-level=LEVEL    loglevel (range [0 - 9]  default 1)\n"
                            "  -m, --max-connection=N   max connection (default 8)\n"
                            "  -p, --port=PORT          set port (default 1178)\n"
                            "  -f, --no-daemonize       not daemonize\n"
-                           "  -v, --version            print version\n");
+                           "      --unix-socket=PATH   also listen on unix domain socket PATH (absolute path)\n"
+                           "      --unix-socket-mode=MODE\n"
+                           "                           set permission of --unix-socket (octal  default 600)\n"
+                           "  -v, --version            print version\n"
+                           "      --workers=N          prefork N worker processes sharing dictionaries (range [0 - 256]  default 0(disable))\n");
         return EXIT_FAILURE;
 }
 
@@ -412,15 +403,20 @@ int print_version()
 
 enum
 {
+        OPTION_TABLE_ADDRESS,
         OPTION_TABLE_CHECK_UPDATE,
         OPTION_TABLE_DEBUG,
         OPTION_TABLE_HELP,
-        OPTION_TABLE_ADDRESS,
+        OPTION_TABLE_IDLE_TIMEOUT,
+        OPTION_TABLE_IO_URING,
         OPTION_TABLE_LOG_LEVEL,
         OPTION_TABLE_MAX_CONNECTION,
         OPTION_TABLE_PORT,
         OPTION_TABLE_NO_DAEMONIZE,
+        OPTION_TABLE_UNIX_SOCKET,
+        OPTION_TABLE_UNIX_SOCKET_MODE,
         OPTION_TABLE_VERSION,
+        OPTION_TABLE_WORKERS,
 
         OPTION_TABLE_LENGTH
 };
@@ -443,6 +439,14 @@ const SkkCommandLine::Option option_table[] =
                 "h", "help",
                 SkkCommandLine::OPTION_ARGUMENT_NONE,
         },
+        {
+                0, "idle-timeout",
+                SkkCommandLine::OPTION_ARGUMENT_INTEGER,
+        },
+        {
+                0, "io-uring",
+                SkkCommandLine::OPTION_ARGUMENT_NONE,
+        },
         {
                 "l", "log-level",
                 SkkCommandLine::OPTION_ARGUMENT_INTEGER,
@@ -459,10 +463,22 @@ const SkkCommandLine::Option option_table[] =
                 "f", "no-daemonize",
                 SkkCommandLine::OPTION_ARGUMENT_NONE,
         },
+        {
+                0, "unix-socket",
+                SkkCommandLine::OPTION_ARGUMENT_STRING,
+        },
+        {
+                0, "unix-socket-mode",
+                SkkCommandLine::OPTION_ARGUMENT_STRING,
+        },
         {
                 "v", "version",
                 SkkCommandLine::OPTION_ARGUMENT_NONE,
         },
+        {
+                0, "workers",
+                SkkCommandLine::OPTION_ARGUMENT_INTEGER,
+        },
         {
                 0, 0,
                 SkkCommandLine::OPTION_ARGUMENT_TERMINATOR,
@@ -475,9 +491,14 @@ struct Option
         int log_level;
         int max_connection;
         int port;
+        int idle_timeout;
+        const char *unix_socket;
+        int unix_socket_mode;
+        int workers;
         bool no_daemonize_flag;
         bool check_update_flag;
         bool debug_flag;
+        bool io_uring_flag;
 }
 option =
 {
@@ -485,6 +506,11 @@ option =
         1,
         8,
         1178,
+        0,
+        0,
+        0600,
+        0,
+        false,
         false,
         false,
         false,
@@ -519,6 +545,10 @@ bool local_main_core_command_line(SkkCommandLine &command_line, int &result, int
                 {
                         option.debug_flag = true;
                 }
+                if (command_line.isOptionDefined(OPTION_TABLE_IO_URING))
+                {
+                        option.io_uring_flag = true;
+                }
                 if (command_line.isOptionDefined(OPTION_TABLE_ADDRESS))
                 {
                         option.address = command_line.getOptionArgumentString(OPTION_TABLE_ADDRESS);
@@ -536,9 +566,43 @@ bool local_main_core_command_line(SkkCommandLine &command_line, int &result, int
                 if (command_line.isOptionDefined(OPTION_TABLE_MAX_CONNECTION))
                 {
                         option.max_connection = command_line.getOptionArgumentInteger(OPTION_TABLE_MAX_CONNECTION);
-                        if ((option.max_connection < 1) || (option.max_connection > 1024))
+                        if ((option.max_connection < 1) || (option.max_connection > 65536))
+                        {
+                                SkkUtility::printf("Illegal max-connection %d (1 - 65536)\n", option.max_connection);
+                                result = print_usage();
+                                return true;
+                        }
+                }
+                if (command_line.isOptionDefined(OPTION_TABLE_IDLE_TIMEOUT))
+                {
+                        option.idle_timeout = command_line.getOptionArgumentInteger(OPTION_TABLE_IDLE_TIMEOUT);
+                        if ((option.idle_timeout < 0) || (option.idle_timeout > 604800))
+                        {
+                                SkkUtility::printf("Illegal idle-timeout %d (0 - 604800)\n", option.idle_timeout);
+                                result = print_usage();
+                                return true;
+                        }
+                }
+                if (command_line.isOptionDefined(OPTION_TABLE_UNIX_SOCKET))
+                {
+                        option.unix_socket = command_line.getOptionArgumentString(OPTION_TABLE_UNIX_SOCKET);
+                }
+                if (command_line.isOptionDefined(OPTION_TABLE_UNIX_SOCKET_MODE))
+                {
+                        const char *p = command_line.getOptionArgumentString(OPTION_TABLE_UNIX_SOCKET_MODE);
+                        if (!SkkUtility::getOctalInteger(p, option.unix_socket_mode) || (option.unix_socket_mode > 0777))
+                        {
+                                SkkUtility::printf("Illegal unix-socket-mode %s (0 - 777)\n", p);
+                                result = print_usage();
+                                return true;
+                        }
+                }
+                if (command_line.isOptionDefined(OPTION_TABLE_WORKERS))
+                {
+                        option.workers = command_line.getOptionArgumentInteger(OPTION_TABLE_WORKERS);
+                        if ((option.workers < 0) || (option.workers > 256))
                         {
-                                SkkUtility::printf("Illegal max-connection %d (1 - 1024)\n", option.max_connection);
+                                SkkUtility::printf("Illegal workers %d (0 - 256)\n", option.workers);
                                 result = print_usage();
                                 return true;
                         }
@@ -623,8 +687,13 @@ int local_main_core(int argc, char *argv[])
                                        skk_dictionary_length,
                                        option.max_connection,
                                        listen_queue,
+                                       option.idle_timeout,
+                                       option.unix_socket,
+                                       option.unix_socket_mode,
+                                       option.workers,
                                        option.check_update_flag,
-                                       option.no_daemonize_flag);
+                                       option.no_daemonize_flag,
+                                       option.io_uring_flag);
                 if (!skk_server->mainLoop())
                 {
                         result = EXIT_FAILURE;
@@ -149,7 +149,7 @@ bool LocalSkkServer::local_main_loop()
                 {
                         goto ERROR_BREAK;
                 }
-                for (int i = 0; i != max_connection_; ++i)
+                for (int i = 0; i != work_length_; ++i)
                 {
                         if (main_loop_is_recv(i, fd_set_read))
                         {